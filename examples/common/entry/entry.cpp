@@ -28,6 +28,9 @@ namespace entry
 	static uint32_t s_height = ENTRY_DEFAULT_HEIGHT;
 	static bool s_exit = false;
 
+	static EventObserverFn s_eventObserver = NULL;
+	static void* s_eventObserverUserData = NULL;
+
 	static bx::FileReaderI* s_fileReader = NULL;
 	static bx::FileWriterI* s_fileWriter = NULL;
 
@@ -654,6 +657,12 @@ restart:
 
 	WindowState s_window[ENTRY_CONFIG_MAX_WINDOWS];
 
+	void setEventObserver(EventObserverFn _fn, void* _userData)
+	{
+		s_eventObserver = _fn;
+		s_eventObserverUserData = _userData;
+	}
+
 	bool processEvents(uint32_t& _width, uint32_t& _height, uint32_t& _debug, uint32_t& _reset, MouseState* _mouse)
 	{
 		s_debug = _debug;
@@ -671,6 +680,11 @@ restart:
 
 			if (NULL != ev)
 			{
+				if (NULL != s_eventObserver)
+				{
+					s_eventObserver(*ev, s_eventObserverUserData);
+				}
+
 				switch (ev->m_type)
 				{
 				case Event::Axis:
@@ -819,6 +833,11 @@ restart:
 
 			if (NULL != ev)
 			{
+				if (NULL != s_eventObserver)
+				{
+					s_eventObserver(*ev, s_eventObserverUserData);
+				}
+
 				handle = ev->m_handle;
 				WindowState& win = s_window[handle.idx];
 
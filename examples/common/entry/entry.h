@@ -244,6 +244,15 @@ namespace entry
 
 	bool processEvents(uint32_t& _width, uint32_t& _height, uint32_t& _debug, uint32_t& _reset, MouseState* _mouse = NULL);
 
+	struct Event;
+
+	/// Called with each event taken from the queue by processEvents or processWindowEvents, before it is
+	/// applied, on the thread processing events.
+	typedef void (*EventObserverFn)(const Event& _event, void* _userData);
+
+	///
+	void setEventObserver(EventObserverFn _fn, void* _userData);
+
 	bx::FileReaderI* getFileReader();
 	bx::FileWriterI* getFileWriter();
 	bx::AllocatorI*  getAllocator();
@@ -161,7 +161,7 @@ struct OcornutImguiContext
 		}
 	}
 
-	void create(float _fontSize, bx::AllocatorI* _allocator)
+	void create(float _fontSize, bx::AllocatorI* _allocator, bool _createResources)
 	{
 		m_allocator = _allocator;
 
@@ -233,20 +233,6 @@ struct OcornutImguiContext
 //		io.NavInputs[ImGuiNavInput_TweakFast]   = (int)entry::Key::;
 #endif // USE_ENTRY
 
-		bgfx::RendererType::Enum type = bgfx::getRendererType();
-		m_program = bgfx::createProgram(
-			  bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_ocornut_imgui")
-			, bgfx::createEmbeddedShader(s_embeddedShaders, type, "fs_ocornut_imgui")
-			, true
-			);
-
-		u_imageLodEnabled = bgfx::createUniform("u_imageLodEnabled", bgfx::UniformType::Vec4);
-		m_imageProgram = bgfx::createProgram(
-			  bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_imgui_image")
-			, bgfx::createEmbeddedShader(s_embeddedShaders, type, "fs_imgui_image")
-			, true
-			);
-
 		m_layout
 			.begin()
 			.add(bgfx::Attrib::Position,  2, bgfx::AttribType::Float)
@@ -254,11 +240,6 @@ struct OcornutImguiContext
 			.add(bgfx::Attrib::Color0,    4, bgfx::AttribType::Uint8, true)
 			.end();
 
-		s_tex = bgfx::createUniform("s_tex", bgfx::UniformType::Sampler);
-
-		uint8_t* data;
-		int32_t width;
-		int32_t height;
 		{
 			ImFontConfig config;
 			config.FontDataOwnedByAtlas = false;
@@ -285,7 +266,42 @@ struct OcornutImguiContext
 			}
 		}
 
-		io.Fonts->GetTexDataAsRGBA32(&data, &width, &height);
+		m_program           = BGFX_INVALID_HANDLE;
+		m_imageProgram      = BGFX_INVALID_HANDLE;
+		m_texture           = BGFX_INVALID_HANDLE;
+		s_tex               = BGFX_INVALID_HANDLE;
+		u_imageLodEnabled   = BGFX_INVALID_HANDLE;
+
+		if (_createResources)
+		{
+			createResources();
+		}
+
+		ImGui::InitDockContext();
+	}
+
+	void createResources()
+	{
+		bgfx::RendererType::Enum type = bgfx::getRendererType();
+		m_program = bgfx::createProgram(
+			  bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_ocornut_imgui")
+			, bgfx::createEmbeddedShader(s_embeddedShaders, type, "fs_ocornut_imgui")
+			, true
+			);
+
+		u_imageLodEnabled = bgfx::createUniform("u_imageLodEnabled", bgfx::UniformType::Vec4);
+		m_imageProgram = bgfx::createProgram(
+			  bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_imgui_image")
+			, bgfx::createEmbeddedShader(s_embeddedShaders, type, "fs_imgui_image")
+			, true
+			);
+
+		s_tex = bgfx::createUniform("s_tex", bgfx::UniformType::Sampler);
+
+		uint8_t* data;
+		int32_t width;
+		int32_t height;
+		ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&data, &width, &height);
 
 		m_texture = bgfx::createTexture2D(
 			  (uint16_t)width
@@ -296,8 +312,6 @@ struct OcornutImguiContext
 			, 0
 			, bgfx::copy(data, width*height*4)
 			);
-
-		ImGui::InitDockContext();
 	}
 
 	void destroy()
@@ -305,12 +319,15 @@ struct OcornutImguiContext
 		ImGui::ShutdownDockContext();
 		ImGui::DestroyContext(m_imgui);
 
-		bgfx::destroy(s_tex);
-		bgfx::destroy(m_texture);
+		if (bgfx::isValid(m_program) )
+		{
+			bgfx::destroy(s_tex);
+			bgfx::destroy(m_texture);
 
-		bgfx::destroy(u_imageLodEnabled);
-		bgfx::destroy(m_imageProgram);
-		bgfx::destroy(m_program);
+			bgfx::destroy(u_imageLodEnabled);
+			bgfx::destroy(m_imageProgram);
+			bgfx::destroy(m_program);
+		}
 
 		m_allocator = NULL;
 	}
@@ -419,7 +436,12 @@ static void memFree(void* _ptr, void* _userData)
 
 void imguiCreate(float _fontSize, bx::AllocatorI* _allocator)
 {
-	s_ctx.create(_fontSize, _allocator);
+	s_ctx.create(_fontSize, _allocator, true);
+}
+
+void imguiCreateContext(float _fontSize, bx::AllocatorI* _allocator)
+{
+	s_ctx.create(_fontSize, _allocator, false);
 }
 
 void imguiDestroy()
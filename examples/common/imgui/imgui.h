@@ -28,6 +28,11 @@ inline uint32_t imguiRGBA(uint8_t _r, uint8_t _g, uint8_t _b, uint8_t _a = 255)
 namespace bx { struct AllocatorI; }
 
 void imguiCreate(float _fontSize = 18.0f, bx::AllocatorI* _allocator = NULL);
+
+// Creates the context, style and fonts without any bgfx resources, for applications which render the draw
+// data themselves. imguiEndFrame() must not be called.
+void imguiCreateContext(float _fontSize = 18.0f, bx::AllocatorI* _allocator = NULL);
+
 void imguiDestroy();
 
 void imguiBeginFrame(int32_t _mx, int32_t _my, uint8_t _button, int32_t _scroll, uint16_t _width, uint16_t _height, int _inputChar = -1, bgfx::ViewId _view = 255);
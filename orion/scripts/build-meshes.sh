@@ -0,0 +1,33 @@
+#!/bin/bash
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" >/dev/null 2>&1 && pwd )"
+cd $DIR
+
+# Compiles all mesh sources (OBJ or glTF) to the geometryc binary format loaded by MeshLoader.  Meshes are optimised
+# for vertex cache, overdraw and vertex fetch, normals and UVs are quantised, and vertex and index data are
+# compressed with the meshoptimizer codecs.  A chain of simplified LODs is generated for distance-based selection
+main() {
+	echo "Starting mesh compilation (`pwd`/`basename $0`)"
+
+	MESH_DIR="../meshes"
+	mkdir -p ../runtime/meshes
+
+	for f in $MESH_DIR/*.obj $MESH_DIR/*.gltf $MESH_DIR/*.glb ; do
+		if [[ -f "$f" ]]; then
+			build_mesh "$f" "$@"
+		fi
+	done
+}
+
+build_mesh() {
+	MESH_PATH=$1
+	MESH_NAME=$(basename "$MESH_PATH")
+	MESH_NAME=${MESH_NAME%.*}
+	TARGET="../runtime/meshes/$MESH_NAME.bin"
+
+	echo "Compiling mesh '$MESH_NAME' ($MESH_PATH) to '$TARGET'"
+	../../tool-bin/geometrycRelease.exe -f "$MESH_PATH" -o "$TARGET" --packnormal 1 --packuv 1 --compress --lod 4
+}
+
+
+main "$@"
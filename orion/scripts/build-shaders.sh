@@ -27,6 +27,8 @@ main() {
 			fi
 		fi
 	done
+
+	pack_all_if_present "$@"
 }
 
 build_if_present() {
@@ -56,6 +58,70 @@ build_all_if_present() {
 }
 
 
+# Packs the compiled shaders registered by ShaderManager for a profile into a single indexed archive, loaded by ShaderArchive at runtime.
+# Layout: header { magic "ORSA", version, entry count, reserved }, then one 64-byte index entry per shader
+# { null-padded name[56], data offset, data size }, then the shader data.  All values are 32-bit little-endian
+write_u32() {
+	printf '\\x%02x\\x%02x\\x%02x\\x%02x' $(( $1 & 0xff )) $(( ($1 >> 8) & 0xff )) $(( ($1 >> 16) & 0xff )) $(( ($1 >> 24) & 0xff ))
+}
+
+# Names of all vertex and fragment shaders used by programs registered in ShaderManager::initialiseShaderPrograms, so that
+# stale or unrelated binaries in the runtime directory are never packed
+registered_shaders() {
+	grep -oE 'initialiseShaderProgram\("[^"]+", "[^"]+"(, "[^"]+")?' ../src/engine/renderer/shader/shader_manager.cpp \
+		| sed -E 's/^initialiseShaderProgram\("[^"]+"//' | grep -oE '[^", ]+' | sort -u
+}
+
+pack_if_present() {
+	SHADER_PROFILE=$1
+	ARGS="$@"
+
+	if [[ "$ARGS" == *"profile::$SHADER_PROFILE"* ]] || [[ "$ARGS" == *"profile::all"* ]] ; then
+		PROFILE_DIR="../runtime/shaders/$SHADER_PROFILE"
+		TARGET="$PROFILE_DIR/shaders.pak"
+
+		# Shaders missing from the archive are loaded from their loose binary at runtime, if present
+		SHADERS=()
+		for NAME in $(registered_shaders); do
+			if [[ -f "$PROFILE_DIR/$NAME.bin" ]]; then
+				SHADERS+=( "$PROFILE_DIR/$NAME.bin" )
+			else
+				echo "Registered shader '$NAME' has not been compiled for $SHADER_PROFILE; not packed" >&2
+			fi
+		done
+		if [[ ${#SHADERS[@]} -eq 0 ]]; then return; fi
+
+		echo "Packing ${#SHADERS[@]} $SHADER_PROFILE shaders to '$TARGET'"
+
+		COUNT=${#SHADERS[@]}
+		OFFSET=$(( 16 + COUNT * 64 ))
+		{
+			printf "ORSA"
+			printf "$(write_u32 1)$(write_u32 $COUNT)$(write_u32 0)"
+
+			for SHADER in "${SHADERS[@]}"; do
+				NAME=$(basename "$SHADER" .bin)
+				if [[ ${#NAME} -ge 56 ]]; then echo "Shader name '$NAME' is too long to pack" >&2; exit 1; fi
+				SIZE=$(wc -c < "$SHADER")
+
+				printf "%s" "$NAME"
+				head -c $(( 56 - ${#NAME} )) /dev/zero
+				printf "$(write_u32 $OFFSET)$(write_u32 $SIZE)"
+				OFFSET=$(( OFFSET + SIZE ))
+			done
+
+			cat "${SHADERS[@]}"
+		} > "$TARGET"
+	fi
+}
+
+pack_all_if_present() {
+	pack_if_present dx9 $@
+	pack_if_present dx11 $@
+	pack_if_present glsl $@
+	pack_if_present metal $@
+}
+
 build_all_vs_if_present() {
 	build_all_if_present "v" $@
 }
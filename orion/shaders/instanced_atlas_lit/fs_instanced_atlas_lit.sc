@@ -0,0 +1,53 @@
+$input v_texcoord0, v_worldpos
+
+
+
+#include "../../../examples/common/common.sh"
+
+// Must match the layout of the LightingManager textures
+#define LIGHT_TEXTURE_WIDTH		128.0
+#define LIGHT_DATA_HEIGHT		16.0
+#define LIGHT_GRID_HEIGHT		128.0
+#define LIGHT_INDEX_HEIGHT		128.0
+#define MAX_LIGHTS_PER_TILE		32
+
+SAMPLER2D(s_texColor,  0);
+SAMPLER2D(s_lightData, 1);
+SAMPLER2D(s_lightGrid, 2);
+SAMPLER2D(s_lightIndices, 3);
+
+uniform vec4 u_lightGrid;		// Tile size in pixels, grid width and height in tiles
+uniform vec4 u_ambient;
+
+// Texture coordinate of an element within a lighting texture, stored row-major
+vec2 lightTexel(float index, float height)
+{
+	return vec2(mod(index, LIGHT_TEXTURE_WIDTH) + 0.5, floor(index / LIGHT_TEXTURE_WIDTH) + 0.5) / vec2(LIGHT_TEXTURE_WIDTH, height);
+}
+
+void main()
+{
+	// Screen tile containing this fragment, with the origin at the bottom-left of the view
+	vec4 clip = mul(u_viewProj, vec4(v_worldpos, 1.0));
+	vec2 screen = (clip.xy / clip.w * 0.5 + 0.5) * u_viewRect.zw;
+	vec2 tile = clamp(floor(screen / u_lightGrid.x), vec2(0.0, 0.0), u_lightGrid.yz - 1.0);
+
+	// Offset and count of this tile's lights within the index list
+	vec2 range = texture2DLod(s_lightGrid, lightTexel(tile.y * u_lightGrid.y + tile.x, LIGHT_GRID_HEIGHT), 0.0).xy;
+
+	vec3 light = u_ambient.rgb;
+	for (int i = 0; i < MAX_LIGHTS_PER_TILE; ++i)
+	{
+		if (float(i) >= range.y) break;
+
+		float index = texture2DLod(s_lightIndices, lightTexel(range.x + float(i), LIGHT_INDEX_HEIGHT), 0.0).x;
+		vec4 data = texture2DLod(s_lightData, lightTexel(index * 2.0, LIGHT_DATA_HEIGHT), 0.0);
+		vec3 colour = texture2DLod(s_lightData, lightTexel(index * 2.0 + 1.0, LIGHT_DATA_HEIGHT), 0.0).rgb;
+
+		float falloff = saturate(1.0 - length(v_worldpos.xy - data.xy) / data.z);
+		light += colour * (data.w * falloff * falloff);
+	}
+
+	vec4 albedo = texture2D(s_texColor, v_texcoord0);
+	gl_FragColor = vec4(albedo.rgb * light, albedo.a);
+}
@@ -0,0 +1,15 @@
+$input v_color0, v_texcoord0
+
+
+
+#include "../../../examples/common/common.sh"
+
+void main()
+{
+	// Soft circular falloff towards the edge of the quad
+	float falloff = 1.0 - smoothstep(0.5, 1.0, length(v_texcoord0 * 2.0 - 1.0));
+	float alpha = v_color0.a * falloff;
+
+	// Premultiplied, so that the same output serves both additive and alpha blending
+	gl_FragColor = vec4(v_color0.rgb * alpha, alpha);
+}
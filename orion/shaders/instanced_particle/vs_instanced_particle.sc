@@ -0,0 +1,15 @@
+$input a_position, a_texcoord0, i_data0, i_data1
+$output v_color0, v_texcoord0
+
+
+#include "../../../examples/common/common.sh"
+
+void main()
+{
+	// i_data0 holds the particle position and radius; the unit quad lies in the ground plane, facing the top-down camera
+	vec3 worldPos = i_data0.xyz + vec3(a_position.xy * i_data0.w, 0.0);
+	gl_Position = mul(u_viewProj, vec4(worldPos, 1.0) );
+
+	v_color0 = i_data1;
+	v_texcoord0 = a_texcoord0;
+}
@@ -0,0 +1,14 @@
+$input a_position, a_color0, a_texcoord0
+$output v_color0, v_texcoord0
+
+
+#include "../../../examples/common/common.sh"
+
+void main()
+{
+	// Label glyphs are already transformed into the ground plane
+	gl_Position = mul(u_viewProj, vec4(a_position, 1.0) );
+
+	v_color0 = a_color0;
+	v_texcoord0 = a_texcoord0;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include "../util/log.h"
+
+namespace Orion
+{
+	// Minimal harness for in-engine micro-benchmarks, which are run via the --benchmark command-line option.  Each
+	// case is repeated several times and the fastest run is reported, to reduce the effect of scheduling noise
+	class Benchmark
+	{
+	public:
+
+		static const size_t DEFAULT_REPEATS = 5U;
+
+		struct Result
+		{
+			std::string		name;
+			size_t			operations;
+			double			total_ms;
+
+			inline double getNsPerOperation() const { return (operations != 0U ? (total_ms * 1000000.0) / double(operations) : 0.0); }
+		};
+
+		// Executes fn(), which should perform the given number of operations, and reports the fastest repeat
+		template <typename Fn>
+		static Result run(const std::string& name, size_t operations, Fn&& fn, size_t repeats = DEFAULT_REPEATS);
+
+		static inline void report(const Result& result)
+		{
+			LOG_INFO("Benchmark \"" << result.name << "\": " << result.total_ms << "ms for " << result.operations << " operations (" << result.getNsPerOperation() << "ns/op)");
+		}
+
+		// Prevents the compiler from discarding a value computed only for benchmarking
+		template <typename T>
+		static inline void consume(T value) { s_sink = s_sink + static_cast<uint64_t>(value); }
+
+	private:
+
+		static inline volatile uint64_t s_sink = 0U;
+	};
+
+
+	template <typename Fn>
+	inline Benchmark::Result Benchmark::run(const std::string& name, size_t operations, Fn&& fn, size_t repeats)
+	{
+		typedef std::chrono::steady_clock Clock;
+
+		double best_ms = std::numeric_limits<double>::max();
+		for (size_t i = 0; i < std::max<size_t>(repeats, 1U); ++i)
+		{
+			const auto start = Clock::now();
+			fn();
+			best_ms = std::min(best_ms, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		}
+
+		Result result { name, operations, best_ms };
+		report(result);
+
+		return result;
+	}
+}
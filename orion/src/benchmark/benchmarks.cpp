@@ -0,0 +1,27 @@
+#include "../util/log.h"
+#include "resource_lookup_benchmark.h"
+#include "field_of_view_benchmark.h"
+#include "particle_benchmark.h"
+#include "thread_pool_benchmark.h"
+
+#include "benchmarks.h"
+
+namespace Orion
+{
+	namespace Benchmarks
+	{
+		ResultCode runAll()
+		{
+			LOG_INFO("Running benchmarks");
+
+			ResultCode aggregate = ResultCodes::Success;
+			aggregate = ResultCodes::aggregate(aggregate, runResourceLookupBenchmark());
+			aggregate = ResultCodes::aggregate(aggregate, runFieldOfViewBenchmark());
+			aggregate = ResultCodes::aggregate(aggregate, runParticleBenchmark());
+			aggregate = ResultCodes::aggregate(aggregate, runThreadPoolBenchmark());
+
+			LOG_INFO("Benchmarks complete (" << aggregate << ")");
+			return aggregate;
+		}
+	}
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "../util/result_code.h"
+
+namespace Orion
+{
+	namespace Benchmarks
+	{
+		// Runs all micro-benchmarks and logs their results
+		ResultCode runAll();
+	}
+}
@@ -0,0 +1,102 @@
+#include <vector>
+#include "../grid/field_of_view.h"
+#include "../util/thread_pool.h"
+#include "benchmark.h"
+
+#include "field_of_view_benchmark.h"
+
+namespace Orion
+{
+	namespace Benchmarks
+	{
+		namespace
+		{
+			const int GRID_SIZE = 256;
+			const int ROOM_SIZE = 16;				// Walls are placed on a regular grid of rooms, each with a door on every side
+			const size_t VIEWER_COUNT = 2048U;
+			const int VIEWER_RADIUS = 16;
+
+			// Rooms bounded by walls, with a door in the middle of each wall segment
+			void buildRooms(FieldOfView<int>& fov)
+			{
+				for (int y = 0; y < GRID_SIZE; ++y)
+				{
+					for (int x = 0; x < GRID_SIZE; ++x)
+					{
+						const bool wall = (x % ROOM_SIZE == 0 || y % ROOM_SIZE == 0);
+						const bool door = (x % ROOM_SIZE == ROOM_SIZE / 2 || y % ROOM_SIZE == ROOM_SIZE / 2);
+						fov.setOpaque({ x, y }, wall && !door);
+					}
+				}
+			}
+
+			double viewersPerMs(const Benchmark::Result& result)
+			{
+				return (result.total_ms > 0.0 ? double(result.operations) / result.total_ms : 0.0);
+			}
+		}
+
+		ResultCode runFieldOfViewBenchmark()
+		{
+			LOG_INFO("Benchmarking field of view (" << GRID_SIZE << "x" << GRID_SIZE << " grid, " << VIEWER_COUNT << " viewers, radius " << VIEWER_RADIUS << ")");
+
+			ThreadPool pool;
+			RETURN_ON_ERROR(pool.initialise());
+
+			FieldOfView<int> fov({ GRID_SIZE, GRID_SIZE });
+			buildRooms(fov);
+
+			// Viewers are distributed deterministically over the grid
+			std::vector<FieldOfView<int>::Viewer> viewers;
+			uint32_t seed = 12345U;
+			for (size_t i = 0; i < VIEWER_COUNT; ++i)
+			{
+				seed = seed * 1664525U + 1013904223U;
+				const int x = int((seed >> 8) % uint32_t(GRID_SIZE));
+				seed = seed * 1664525U + 1013904223U;
+				const int y = int((seed >> 8) % uint32_t(GRID_SIZE));
+
+				viewers.push_back({ { x, y }, VIEWER_RADIUS });
+			}
+
+			FieldOfView<int>::Mask visible;
+			const auto single = Benchmark::run("Field of view, single thread", VIEWER_COUNT, [&]()
+			{
+				for (const auto& viewer : viewers)
+				{
+					fov.compute(viewer.position, viewer.radius, visible);
+					Benchmark::consume(visible.row(viewer.position.y)[0]);
+				}
+			});
+
+			std::vector<FieldOfView<int>::Mask> batch_visible;
+			const auto batched = Benchmark::run("Field of view, batched", VIEWER_COUNT, [&]()
+			{
+				fov.computeBatch(viewers, batch_visible, pool);
+				Benchmark::consume(batch_visible.back().row(0)[0]);
+			});
+
+			LOG_INFO("Field of view throughput: " << viewersPerMs(single) << " viewers/ms single-threaded, " << viewersPerMs(batched)
+				<< " viewers/ms batched across " << (pool.getThreadCount() + 1U) << " threads");
+
+			// Incremental update; opening and closing a door should only recompute the viewers within range of it
+			for (const auto& viewer : viewers) fov.addViewer(viewer);
+			fov.update(pool);
+
+			// The door is initially open, and is toggled on each repeat so that every update sees a change
+			size_t recomputed = 0U;
+			bool open = true;
+			const auto incremental = Benchmark::run("Field of view, incremental update", 1U, [&]()
+			{
+				open = !open;
+				fov.setOpaque({ GRID_SIZE / 2, GRID_SIZE / 2 + ROOM_SIZE / 2 }, !open);
+				recomputed = fov.update(pool);
+			});
+
+			LOG_INFO("Incremental field of view update recomputed " << recomputed << "/" << VIEWER_COUNT << " viewers in " << incremental.total_ms << "ms");
+
+			pool.shutdown();
+			return ResultCodes::Success;
+		}
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "../util/result_code.h"
+
+namespace Orion
+{
+	namespace Benchmarks
+	{
+		// Measures field of view throughput, in viewers per millisecond, for viewers computed on a single thread and
+		// batched across a thread pool, and the cost of an incremental update following a small opacity change
+		ResultCode runFieldOfViewBenchmark();
+	}
+}
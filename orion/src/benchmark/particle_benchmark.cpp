@@ -0,0 +1,106 @@
+#include <vector>
+#include <string>
+#include "../engine/renderer/particles/particle_system.h"
+#include "../engine/renderer/particles/particle_effects.h"
+#include "../util/thread_pool.h"
+#include "benchmark.h"
+
+#include "particle_benchmark.h"
+
+namespace Orion
+{
+	namespace Benchmarks
+	{
+		namespace
+		{
+			const uint32_t EXPLOSION_COUNT = 4U;
+			const uint32_t EXPLOSION_PARTICLES = 15000U;
+			const uint32_t VENT_COUNT = 4U;
+			const uint32_t VENT_PARTICLES = 10000U;
+			const float TIME_STEP = 1.0f / 60.0f;
+			const double FRAME_BUDGET_MS = 1.0;
+			const size_t REPEATS = 20U;				// Each repeat is short, so more are taken than by default to reduce noise
+
+			// Lifetimes are extended well beyond the benchmark duration so that the particle count remains constant
+			void addEmitters(ParticleSystem& particles)
+			{
+				for (uint32_t i = 0U; i < EXPLOSION_COUNT; ++i)
+				{
+					auto desc = ParticleEffects::explosion({ float(i) * 100.0f, 0.0f, 0.0f }, EXPLOSION_PARTICLES);
+					desc.lifetime[0] = desc.lifetime[1] = 1000.0f;
+					particles.addEmitter(desc);
+				}
+
+				for (uint32_t i = 0U; i < VENT_COUNT; ++i)
+				{
+					auto desc = ParticleEffects::venting({ float(i) * 100.0f, 200.0f, 0.0f }, { 0.0f, 1.0f }, 1.0f);
+					desc.lifetime[0] = desc.lifetime[1] = 1000.0f;
+					desc.burst = desc.max_particles = VENT_PARTICLES;
+					particles.addEmitter(desc);
+				}
+			}
+
+			// Measures update and instance generation on the given pool, returning the total CPU time per frame
+			double measureFrame(ThreadPool& pool, const std::string& name)
+			{
+				ParticleSystem particles;
+				addEmitters(particles);
+
+				// The first update spawns all particles; the next separates them in depth so that blended particles require sorting
+				particles.update(TIME_STEP, pool);
+				particles.update(TIME_STEP, pool);
+
+				std::vector<ParticleInstanceData> additive(particles.getParticleCount(ParticleBlend::Additive));
+				std::vector<ParticleInstanceData> alpha(particles.getParticleCount(ParticleBlend::Alpha));
+
+				// Perspective view from above, as used by the top-down camera
+				const float view_proj[16] = {
+					1.0f, 0.0f, 0.0f, 0.0f,
+					0.0f, 1.0f, 0.0f, 0.0f,
+					0.0f, 0.0f, 1.0f, 1.0f,
+					0.0f, 0.0f, 0.0f, 500.0f
+				};
+
+				const size_t particle_count = particles.getStats().particles;
+				const auto update = Benchmark::run("Particle update, " + name, particle_count, [&]()
+				{
+					particles.update(TIME_STEP, pool);
+					Benchmark::consume(particles.getStats().particles);
+				}, REPEATS);
+
+				const auto instances = Benchmark::run("Particle instance generation, " + name, particle_count, [&]()
+				{
+					particles.writeInstances(view_proj, additive.data(), alpha.data(), pool);
+					Benchmark::consume(alpha.back().position_size[2]);
+				}, REPEATS);
+
+				const double frame_ms = update.total_ms + instances.total_ms;
+				LOG_INFO("Particle CPU time per frame, " << name << ": " << frame_ms << "ms for " << particle_count << " particles ("
+					<< particles.getStats().sorted << " sorted); " << (frame_ms <= FRAME_BUDGET_MS ? "within" : "exceeds") << " " << FRAME_BUDGET_MS << "ms budget");
+
+				return frame_ms;
+			}
+		}
+
+		ResultCode runParticleBenchmark()
+		{
+			const size_t particle_count = (EXPLOSION_COUNT * EXPLOSION_PARTICLES) + (VENT_COUNT * VENT_PARTICLES);
+			LOG_INFO("Benchmarking particles (" << particle_count << " particles; " << (EXPLOSION_COUNT * EXPLOSION_PARTICLES) << " additive, "
+				<< (VENT_COUNT * VENT_PARTICLES) << " alpha-blended)");
+
+			// A pool which has not been initialised executes all work inline on the calling thread
+			ThreadPool serial;
+			const double serial_ms = measureFrame(serial, "single thread");
+
+			ThreadPool pool;
+			RETURN_ON_ERROR(pool.initialise());
+
+			const size_t threads = pool.getThreadCount() + 1U;
+			const double pooled_ms = measureFrame(pool, std::to_string(threads) + " threads");
+			LOG_INFO("Particle speedup with " << threads << " threads: " << (pooled_ms > 0.0 ? serial_ms / pooled_ms : 0.0) << "x");
+
+			pool.shutdown();
+			return ResultCodes::Success;
+		}
+	}
+}
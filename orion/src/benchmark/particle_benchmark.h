@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../util/result_code.h"
+
+namespace Orion
+{
+	namespace Benchmarks
+	{
+		// Measures the CPU cost per frame of simulating and generating render instances for a large particle load,
+		// split between additive explosions and alpha-blended venting which must be sorted back-to-front.  Measured on
+		// the calling thread alone, and then across the thread pool
+		ResultCode runParticleBenchmark();
+	}
+}
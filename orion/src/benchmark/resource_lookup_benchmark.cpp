@@ -0,0 +1,117 @@
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "bgfx/bgfx.h"
+#include "../engine/renderer/core/resource_id.h"
+#include "benchmark.h"
+
+#include "resource_lookup_benchmark.h"
+
+namespace Orion
+{
+	namespace Benchmarks
+	{
+		namespace
+		{
+			const size_t RESOURCE_COUNT = 256U;		// Per resource type
+			const size_t DRAWS_PER_FRAME = 1000U;
+			const size_t FRAMES = 200U;
+
+			// Each draw resolves a program, mesh, uniform and texture
+			const size_t LOOKUPS_PER_DRAW = 4U;
+		}
+
+		ResultCode runResourceLookupBenchmark()
+		{
+			LOG_INFO("Benchmarking resource lookup (" << RESOURCE_COUNT << " resources of each type, " << DRAWS_PER_FRAME << " draws/frame)");
+
+			std::vector<std::string> names;
+			for (size_t i = 0; i < RESOURCE_COUNT; ++i) names.push_back("resource_name_" + std::to_string(i));
+
+			// Name-keyed storage, as previously held by each resource manager
+			std::unordered_map<std::string, bgfx::ProgramHandle> programs_by_name;
+			std::unordered_map<std::string, bgfx::UniformHandle> uniforms_by_name;
+			std::unordered_map<std::string, bgfx::TextureHandle> textures_by_name;
+			std::unordered_map<std::string, bgfx::VertexBufferHandle> meshes_by_name;
+
+			// Interned storage, indexed by ID
+			ResourceNameTable<ProgramId> program_names;
+			ResourceNameTable<UniformId> uniform_names;
+			ResourceNameTable<TextureId> texture_names;
+			ResourceNameTable<MeshId> mesh_names;
+			std::vector<bgfx::ProgramHandle> programs;
+			std::vector<bgfx::UniformHandle> uniforms;
+			std::vector<bgfx::TextureHandle> textures;
+			std::vector<bgfx::VertexBufferHandle> meshes;
+
+			for (size_t i = 0; i < RESOURCE_COUNT; ++i)
+			{
+				const auto handle = static_cast<uint16_t>(i);
+				programs_by_name[names[i]] = { handle };
+				uniforms_by_name[names[i]] = { handle };
+				textures_by_name[names[i]] = { handle };
+				meshes_by_name[names[i]] = { handle };
+
+				program_names.add(names[i]);	programs.push_back({ handle });
+				uniform_names.add(names[i]);	uniforms.push_back({ handle });
+				texture_names.add(names[i]);	textures.push_back({ handle });
+				mesh_names.add(names[i]);		meshes.push_back({ handle });
+			}
+
+			// Each draw uses a different combination of resources, selected deterministically
+			std::vector<size_t> draw_resources(DRAWS_PER_FRAME);
+			for (size_t i = 0; i < DRAWS_PER_FRAME; ++i) draw_resources[i] = (i * 7919U) % RESOURCE_COUNT;
+
+			// Callers previously passed string literals, constructing a temporary string for every lookup
+			std::vector<const char*> draw_names(DRAWS_PER_FRAME);
+			for (size_t i = 0; i < DRAWS_PER_FRAME; ++i) draw_names[i] = names[draw_resources[i]].c_str();
+
+			const size_t operations = FRAMES * DRAWS_PER_FRAME * LOOKUPS_PER_DRAW;
+
+			const auto by_name = Benchmark::run("Resource lookup by name", operations, [&]()
+			{
+				for (size_t frame = 0; frame < FRAMES; ++frame)
+				{
+					for (size_t draw = 0; draw < DRAWS_PER_FRAME; ++draw)
+					{
+						const char* name = draw_names[draw];
+						Benchmark::consume(programs_by_name.at(name).idx + uniforms_by_name.at(name).idx +
+										   textures_by_name.at(name).idx + meshes_by_name.at(name).idx);
+					}
+				}
+			});
+
+			// Names are resolved to IDs once, outside the frame loop
+			std::vector<ProgramId> draw_programs;
+			std::vector<UniformId> draw_uniforms;
+			std::vector<TextureId> draw_textures;
+			std::vector<MeshId> draw_meshes;
+			for (const auto resource : draw_resources)
+			{
+				draw_programs.push_back(program_names.find(names[resource]));
+				draw_uniforms.push_back(uniform_names.find(names[resource]));
+				draw_textures.push_back(texture_names.find(names[resource]));
+				draw_meshes.push_back(mesh_names.find(names[resource]));
+			}
+
+			const auto by_id = Benchmark::run("Resource lookup by interned ID", operations, [&]()
+			{
+				for (size_t frame = 0; frame < FRAMES; ++frame)
+				{
+					for (size_t draw = 0; draw < DRAWS_PER_FRAME; ++draw)
+					{
+						Benchmark::consume(programs[draw_programs[draw].index].idx + uniforms[draw_uniforms[draw].index].idx +
+										   textures[draw_textures[draw].index].idx + meshes[draw_meshes[draw].index].idx);
+					}
+				}
+			});
+
+			const double frame_cost_by_name_us = (by_name.total_ms * 1000.0) / double(FRAMES);
+			const double frame_cost_by_id_us = (by_id.total_ms * 1000.0) / double(FRAMES);
+			LOG_INFO("Per-frame resource lookup cost: " << frame_cost_by_name_us << "us by name, " << frame_cost_by_id_us << "us by ID ("
+				<< (by_id.total_ms > 0.0 ? by_name.total_ms / by_id.total_ms : 0.0) << "x)");
+
+			return ResultCodes::Success;
+		}
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "../util/result_code.h"
+
+namespace Orion
+{
+	namespace Benchmarks
+	{
+		// Compares per-frame resource resolution by name (string-keyed map lookups, as previously performed by the
+		// resource managers) against interned resource IDs resolved once and indexed directly
+		ResultCode runResourceLookupBenchmark();
+	}
+}
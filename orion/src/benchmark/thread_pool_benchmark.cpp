@@ -0,0 +1,112 @@
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include "../util/thread_pool.h"
+#include "benchmark.h"
+
+#include "thread_pool_benchmark.h"
+
+namespace Orion
+{
+	namespace Benchmarks
+	{
+		namespace
+		{
+			const size_t JOB_COUNT = 100000U;
+			const size_t SPAWNING_JOBS = 1000U;
+			const size_t SPAWNED_PER_JOB = 100U;
+			const size_t PARALLEL_FOR_CALLS = 1000U;
+			const size_t PARALLEL_FOR_ITEMS = 1024U;
+
+			const size_t SCALING_ITEMS = 1U << 16;
+			const size_t SCALING_GRAIN = 256U;
+			const uint32_t SCALING_ITERATIONS = 512U;		// Work per item, of roughly a microsecond
+
+			// Compute-bound work with no shared memory traffic
+			uint64_t work(size_t item)
+			{
+				uint64_t x = item + 1U;
+				for (uint32_t i = 0U; i < SCALING_ITERATIONS; ++i)
+				{
+					x ^= x << 13;
+					x ^= x >> 7;
+					x ^= x << 17;
+				}
+
+				return x;
+			}
+
+			Benchmark::Result runScaling(ThreadPool* pool, size_t threads)
+			{
+				std::vector<uint64_t> results(SCALING_ITEMS);
+				const auto range = [&results](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i) results[i] = work(i);
+				};
+
+				return Benchmark::run("Parallel-for scaling, " + std::to_string(threads) + " threads", SCALING_ITEMS, [&]()
+				{
+					if (pool) pool->parallelForRange(SCALING_ITEMS, SCALING_GRAIN, range); else range(0U, SCALING_ITEMS);
+					Benchmark::consume(results.back());
+				});
+			}
+		}
+
+		ResultCode runThreadPoolBenchmark()
+		{
+			LOG_INFO("Benchmarking thread pool");
+
+			{
+				ThreadPool pool;
+				RETURN_ON_ERROR(pool.initialise());
+
+				Benchmark::run("Job enqueue and wait", JOB_COUNT, [&]()
+				{
+					JobCounter counter;
+					for (size_t i = 0U; i < JOB_COUNT; ++i) pool.enqueue([]() { }, &counter);
+					pool.wait(counter);
+				});
+
+				// Jobs queued from workers go to their own queues, and are distributed by stealing
+				const auto stolen = pool.getStats().stolen;
+				Benchmark::run("Job spawn from workers", SPAWNING_JOBS * SPAWNED_PER_JOB, [&]()
+				{
+					JobCounter counter;
+					for (size_t i = 0U; i < SPAWNING_JOBS; ++i)
+					{
+						pool.enqueue([&pool, &counter]()
+						{
+							for (size_t j = 0U; j < SPAWNED_PER_JOB; ++j) pool.enqueue([]() { }, &counter);
+						}, &counter);
+					}
+					pool.wait(counter);
+				});
+				LOG_INFO("Jobs stolen while spawning from workers: " << (pool.getStats().stolen - stolen));
+
+				Benchmark::run("Parallel-for of " + std::to_string(PARALLEL_FOR_ITEMS) + " empty items", PARALLEL_FOR_CALLS, [&]()
+				{
+					for (size_t i = 0U; i < PARALLEL_FOR_CALLS; ++i) pool.parallelFor(PARALLEL_FOR_ITEMS, [](size_t) { });
+				});
+
+				pool.shutdown();
+			}
+
+			// Pools are sized to include the calling thread, which participates in each parallel-for
+			const size_t hardware_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1U);
+			const auto serial = runScaling(nullptr, 1U);
+			for (size_t threads = 2U; threads <= hardware_threads; ++threads)
+			{
+				ThreadPool pool(threads - 1U);
+				RETURN_ON_ERROR(pool.initialise());
+
+				const auto result = runScaling(&pool, threads);
+				const double speedup = (result.total_ms > 0.0 ? serial.total_ms / result.total_ms : 0.0);
+				LOG_INFO("Parallel-for speedup with " << threads << " threads: " << speedup << "x (" << (100.0 * speedup / double(threads)) << "% efficiency)");
+
+				pool.shutdown();
+			}
+
+			return ResultCodes::Success;
+		}
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "../util/result_code.h"
+
+namespace Orion
+{
+	namespace Benchmarks
+	{
+		// Measures the scheduling overhead of the thread pool for empty jobs queued from outside and inside the pool,
+		// and of parallel-for, and the scaling of a compute-bound parallel-for from one thread to all hardware threads
+		ResultCode runThreadPoolBenchmark();
+	}
+}
@@ -6,8 +6,11 @@ namespace Orion
 		:
 		m_size(size),
 		m_count(Index(size.x) * Index(size.y)),
-		m_grid(size, NO_INDEX, NO_INDEX)
+		m_grid(size, NO_INDEX, NO_INDEX),
+		m_delta_sequence(0U),
+		m_version(0U)
 	{
+		markAllDirty();
 	}
 
     const Tile * Container::getTileAt(Vec2<Coord> location) const
@@ -21,23 +24,30 @@ namespace Orion
         return m_tiles[m_grid.get(location)];
     }
 
-    bool Container::addTile(const Tile& tile)
+    TileHandle Container::getHandleAt(Vec2<Coord> location) const
     {
-        auto grid_ix = m_grid.getIndex(tile.getLocation());
-        if (grid_ix != TileGrid::NO_INDEX)
-        {
-            auto tile_ix = addTileAtNextFreeIndex(tile);
-            m_grid.set(grid_ix, tile_ix);
-            return true;
-        }
+        const auto ix = m_grid.getOrDefault(location);
+        if (ix == NO_INDEX) return TileHandle();
 
-        return false;
+        const auto slot = m_tile_slots[ix];
+        return TileHandle(slot, m_slots[slot].generation);
     }
 
-    void Container::addTileUnchecked(const Tile& tile)
+    const Tile * Container::getTile(TileHandle handle) const
     {
-        auto ix = addTileAtNextFreeIndex(tile);
-        m_grid.set(tile.getLocation(), std::move(ix));
+        return isValid(handle) ? &(m_tiles[m_slots[handle.slot].tile_index]) : nullptr;
+    }
+
+    TileHandle Container::addTile(const Tile& tile)
+    {
+        if (!canPlace(tile)) return TileHandle();
+
+        return insertTile(tile);
+    }
+
+    TileHandle Container::addTileUnchecked(const Tile& tile)
+    {
+        return insertTile(tile);
     }
 
     bool Container::removeTileAt(Vec2<Coord> location)
@@ -48,37 +58,172 @@ namespace Orion
         auto tile_ix = m_grid.get(grid_ix);
         if (tile_ix == NO_INDEX) return false;
 
-        // We DO NOT remove the tile from the tile collection; add to the free list instead
-        moveTileIndexToFreeList(tile_ix);
+        eraseTile(tile_ix);
         return true;
     }
 
     void Container::removeTileAtUnchecked(Vec2<Coord> location)
     {
-        auto removed_tile_ix = m_grid.setAndReturnPrevious(location, NO_INDEX);
-        moveTileIndexToFreeList(removed_tile_ix);
+        eraseTile(m_grid.get(m_grid.getIndexUnchecked(location)));
+    }
+
+    bool Container::removeTile(TileHandle handle)
+    {
+        if (!isValid(handle)) return false;
+
+        eraseTile(m_slots[handle.slot].tile_index);
+        return true;
+    }
+
+    bool Container::isAreaFree(Vec2<Coord> location, Vec2<Coord> extent) const
+    {
+        if (location.x < 0 || location.y < 0 || extent.x <= 0 || extent.y <= 0 ||
+            location.x + extent.x > m_size.x || location.y + extent.y > m_size.y)
+        {
+            return false;
+        }
+
+        // Rows of the footprint are contiguous in the grid
+        const auto* cells = m_grid.data();
+        for (Coord y = location.y; y < location.y + extent.y; ++y)
+        {
+            const auto* row = cells + m_grid.getIndexUnchecked(Vec2<Coord>(location.x, y));
+            for (Coord x = 0; x < extent.x; ++x)
+            {
+                if (row[x] != NO_INDEX) return false;
+            }
+        }
+
+        return true;
     }
 
-    Container::Index Container::addTileAtNextFreeIndex(const Tile& tile)
+    bool Container::isWithinBounds(const Tile& tile, Vec2<Coord> size)
     {
-        if (m_free_tile_indices.empty())
+        const auto rotation = static_cast<int>(tile.getRotation());
+        if (rotation < static_cast<int>(Dir4::UP) || rotation > static_cast<int>(Dir4::LEFT)) return false;
+
+        // Extents are checked before rotation, and bounds are calculated in 64 bits so that no value read from a file can overflow
+        const auto tile_size = tile.getSize();
+        if (tile_size.x <= 0 || tile_size.y <= 0) return false;
+
+        const auto location = tile.getLocation();
+        const auto footprint = tile.getFootprint();
+        return (location.x >= 0 && location.y >= 0 &&
+            int64_t(location.x) + int64_t(footprint.x) <= int64_t(size.x) && int64_t(location.y) + int64_t(footprint.y) <= int64_t(size.y));
+    }
+
+    TileHandle Container::insertTile(const Tile& tile)
+    {
+        uint32_t slot;
+        if (m_free_slots.empty())
         {
-            auto ix = m_tiles.size();
-            m_tiles.push_back(tile);
-            return ix;
+            slot = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back({ NO_INDEX, 0U });
         }
         else
         {
-            auto ix = m_free_tile_indices.back();
-            m_free_tile_indices.pop_back();
-            m_tiles[ix] = tile;
-            return ix;
+            slot = m_free_slots.back();
+            m_free_slots.pop_back();
         }
+
+        const auto ix = m_tiles.size();
+        m_tiles.push_back(tile);
+        m_tile_slots.push_back(slot);
+        m_slots[slot].tile_index = ix;
+
+        markTileDirty(ix);
+        setFootprint(tile, ix);
+
+        return TileHandle(slot, m_slots[slot].generation);
     }
 
-    void Container::moveTileIndexToFreeList(Index index)
+    void Container::eraseTile(Index tile_index)
     {
-		m_free_tile_indices.push_back(index);
+        setFootprint(m_tiles[tile_index], NO_INDEX);
+
+        // Invalidate all outstanding handles to this tile and release its slot for reuse
+        auto& slot = m_slots[m_tile_slots[tile_index]];
+        slot.tile_index = NO_INDEX;
+        ++slot.generation;
+        m_free_slots.push_back(m_tile_slots[tile_index]);
+
+        // Swap the final tile into the vacated position so that live tiles remain contiguous.  The moved
+        // tile's footprint and slot are updated to refer to its new position
+        const auto last = m_tiles.size() - 1U;
+        if (tile_index != last)
+        {
+            m_tiles[tile_index] = m_tiles[last];
+            m_tile_slots[tile_index] = m_tile_slots[last];
+            m_slots[m_tile_slots[tile_index]].tile_index = tile_index;
+
+            markTileDirty(tile_index);
+            setFootprint(m_tiles[tile_index], tile_index);
+        }
+
+        m_tiles.pop_back();
+        m_tile_slots.pop_back();
+    }
+
+    void Container::setCell(Index cell_index, Index tile_index)
+    {
+        m_grid.set(cell_index, tile_index);
+        markCellDirty(cell_index);
+    }
+
+    void Container::setFootprint(const Tile& tile, Index tile_index)
+    {
+        const auto location = tile.getLocation();
+        const auto extent = tile.getFootprint();
+
+        for (Coord y = location.y; y < location.y + extent.y; ++y)
+        {
+            const auto row = m_grid.getIndexUnchecked(Vec2<Coord>(location.x, y));
+            for (Coord x = 0; x < extent.x; ++x)
+            {
+                setCell(row + Index(x), tile_index);
+            }
+        }
+    }
+
+    void Container::markAllDirty()
+    {
+        m_dirty_tile_chunks.assign((m_tiles.size() + TILE_CHUNK_SIZE - 1U) / TILE_CHUNK_SIZE, 1U);
+        m_dirty_cell_chunks.assign((m_grid.getCount() + CELL_CHUNK_SIZE - 1U) / CELL_CHUNK_SIZE, 1U);
+
+        ++m_version;
+        m_tile_chunk_versions.assign(m_dirty_tile_chunks.size(), m_version);
+        m_cell_chunk_versions.assign(m_dirty_cell_chunks.size(), m_version);
+    }
+
+    void Container::resetDeltaTracking()
+    {
+        markAllDirty();
+        m_delta_sequence = 0U;
+    }
+
+    void Container::rebuildHandles()
+    {
+        // Advance the generation of every existing slot so that no previously-issued handle can alias a tile
+        for (auto& slot : m_slots)
+        {
+            slot.tile_index = NO_INDEX;
+            ++slot.generation;
+        }
+
+        if (m_slots.size() < m_tiles.size()) m_slots.resize(m_tiles.size(), { NO_INDEX, 0U });
+
+        m_tile_slots.resize(m_tiles.size());
+        for (Index i = 0; i < m_tiles.size(); ++i)
+        {
+            m_slots[i].tile_index = i;
+            m_tile_slots[i] = static_cast<uint32_t>(i);
+        }
+
+        m_free_slots.clear();
+        for (Index i = m_slots.size(); i > m_tiles.size(); --i)
+        {
+            m_free_slots.push_back(static_cast<uint32_t>(i - 1U));
+        }
     }
 
 
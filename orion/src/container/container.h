@@ -8,43 +8,134 @@
 #include "../grid/grid.h"
 #include "../grid/quadtree.h"
 #include "../tile/tile.h"
+#include "tile_handle.h"
 
 namespace Orion
 {
 	class Container
 	{
+		friend class ContainerSerialiser;
+		friend class ContainerDelta;
+
 	public:
 		typedef size_t Index;
 		typedef int Coord;
 		typedef Grid<Index, Coord> TileGrid;
 		static const Index NO_INDEX = std::numeric_limits<Index>::max();
 
+		// Granularity of change tracking for delta snapshots
+		static const Index TILE_CHUNK_SIZE = 1024U;
+		static const Index CELL_CHUNK_SIZE = 4096U;
+
 		Container(Vec2<Coord> size);
 
 		inline Vec2<Coord> getSize() const { return m_size; }
 
-		const Tile::Collection& getTiles() const { return m_tiles; }
+		// Live tiles are held contiguously with no gaps; tile positions within this collection are not stable
+		// across removals, so persistent references should be held as a TileHandle
+		inline const Tile::Collection& getTiles() const { return m_tiles; }
+		inline Index getTileCount() const { return m_tiles.size(); }
+
+		// Index of the tile in getTiles() covering each cell, or NO_INDEX
+		inline const TileGrid& getGrid() const { return m_grid; }
+
+		// Every cell covered by a tile footprint resolves to the owning tile
 		const Tile * getTileAt(Vec2<Coord> location) const;
 		const Tile & getTileAtUnchecked(Vec2<Coord> location) const;
-		bool addTile(const Tile& tile);
-		void addTileUnchecked(const Tile& tile);
+		TileHandle getHandleAt(Vec2<Coord> location) const;
+
+		// Returns null if the handle does not refer to a live tile
+		const Tile * getTile(TileHandle handle) const;
+		inline bool isValid(TileHandle handle) const;
+
+		// Placement fails, returning a null handle, if any part of the footprint lies outside the container or
+		// overlaps an existing tile
+		TileHandle addTile(const Tile& tile);
+		TileHandle addTileUnchecked(const Tile& tile);
+
+		// Removes the tile covering this location, clearing its entire footprint
 		bool removeTileAt(Vec2<Coord> location);
 		void removeTileAtUnchecked(Vec2<Coord> location);
+		bool removeTile(TileHandle handle);
+
+		// Tests whether the given area lies within the container and is not covered by any tile.  O(area)
+		bool isAreaFree(Vec2<Coord> location, Vec2<Coord> extent) const;
+		inline bool canPlace(const Tile& tile) const { return isAreaFree(tile.getLocation(), tile.getFootprint()); }
+
+		// Tests whether a tile has a valid orientation and size, and a footprint lying entirely within a container of
+		// the given size.  Tiles read from untrusted data must pass this test before they are stored in a container
+		static bool isWithinBounds(const Tile& tile, Vec2<Coord> size);
+
+		// Flags all state as changed, so that the next delta snapshot will contain the complete container
+		void markAllDirty();
+
+		// As markAllDirty(), and restarts delta sequence numbering, so that the next delta snapshot is the base of a new delta stream
+		void resetDeltaTracking();
+
+		// Handles are runtime references and are not persisted.  Following a bulk rebuild of tile data (e.g. on
+		// load or delta replay) all existing handles are invalidated and each tile is assigned a new handle
+		void rebuildHandles();
 
 	private:
 
-		Index addTileAtNextFreeIndex(const Tile & tile);
-		void moveTileIndexToFreeList(Index index);
+		// Slot table entry mapping a handle to the current position of its tile in the dense tile collection
+		struct Slot
+		{
+			Index			tile_index;
+			uint32_t		generation;
+		};
+
+		TileHandle insertTile(const Tile& tile);
+		void eraseTile(Index tile_index);
+
+		void setCell(Index cell_index, Index tile_index);
+		void setFootprint(const Tile& tile, Index tile_index);
+		inline void markTileDirty(Index tile_index);
+		inline void markCellDirty(Index cell_index);
 
 	private:
 
 		Vec2<Coord>				m_size;
 		Index					m_count;
 
-		TileGrid				m_grid;
-		Tile::Collection		m_tiles;
-		std::vector<Index>		m_free_tile_indices;
+		TileGrid				m_grid;					// Index of the tile in m_tiles covering each cell
+		Tile::Collection		m_tiles;				// Dense collection of all live tiles
+		std::vector<uint32_t>	m_tile_slots;			// Slot owning each entry of m_tiles
+		std::vector<Slot>		m_slots;
+		std::vector<uint32_t>	m_free_slots;
+
+		std::vector<uint8_t>	m_dirty_tile_chunks;		// Chunks of m_tiles modified since the last delta snapshot
+		std::vector<uint8_t>	m_dirty_cell_chunks;		// Chunks of m_grid modified since the last delta snapshot
+		uint64_t				m_delta_sequence;
+
+		// Modification count of the container, and the count at which each chunk was last modified.  Allows any
+		// number of observers to identify the chunks changed since they last synchronised
+		uint64_t				m_version;
+		std::vector<uint64_t>	m_tile_chunk_versions;
+		std::vector<uint64_t>	m_cell_chunk_versions;
 
 	};
 
+	inline bool Container::isValid(TileHandle handle) const
+	{
+		return handle.slot < m_slots.size() && m_slots[handle.slot].generation == handle.generation && m_slots[handle.slot].tile_index != NO_INDEX;
+	}
+
+	inline void Container::markTileDirty(Index tile_index)
+	{
+		const auto chunk = tile_index / TILE_CHUNK_SIZE;
+		if (chunk >= m_dirty_tile_chunks.size()) m_dirty_tile_chunks.resize(chunk + 1U, 0U);
+		if (chunk >= m_tile_chunk_versions.size()) m_tile_chunk_versions.resize(chunk + 1U, 0U);
+
+		m_dirty_tile_chunks[chunk] = 1U;
+		m_tile_chunk_versions[chunk] = ++m_version;
+	}
+
+	inline void Container::markCellDirty(Index cell_index)
+	{
+		const auto chunk = cell_index / CELL_CHUNK_SIZE;
+		m_dirty_cell_chunks[chunk] = 1U;
+		m_cell_chunk_versions[chunk] = ++m_version;
+	}
+
 }
@@ -0,0 +1,250 @@
+#include <cstring>
+#include <algorithm>
+#include "../util/log.h"
+
+#include "container_delta.h"
+
+namespace Orion
+{
+	namespace
+	{
+		// Indices are always stored as 64-bit values, independent of the platform index width
+		inline uint64_t encodeIndex(Container::Index index)
+		{
+			return (index == Container::NO_INDEX ? ~0ULL : static_cast<uint64_t>(index));
+		}
+
+		inline Container::Index decodeIndex(uint64_t value)
+		{
+			return (value == ~0ULL ? Container::NO_INDEX : static_cast<Container::Index>(value));
+		}
+
+		template <typename T>
+		inline void writeValue(std::ostream& out, const T& value)
+		{
+			out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		void writeIndices(std::ostream& out, const std::vector<Container::Index>& indices)
+		{
+			for (const auto index : indices) writeValue(out, encodeIndex(index));
+		}
+
+		template <typename T>
+		inline bool readValue(const uint8_t*& data, const uint8_t* end, T& outValue)
+		{
+			if (static_cast<size_t>(end - data) < sizeof(T)) return false;
+
+			memcpy(&outValue, data, sizeof(T));
+			data += sizeof(T);
+			return true;
+		}
+
+		bool readIndices(const uint8_t*& data, const uint8_t* end, size_t count, std::vector<Container::Index>& outIndices)
+		{
+			if (static_cast<size_t>(end - data) / sizeof(uint64_t) < count) return false;
+
+			outIndices.resize(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				uint64_t value;
+				memcpy(&value, data, sizeof(uint64_t));
+				data += sizeof(uint64_t);
+				outIndices[i] = decodeIndex(value);
+			}
+
+			return true;
+		}
+	}
+
+	ContainerDelta::ContainerDelta()
+		:
+		m_sequence(0U),
+		m_size(0, 0),
+		m_tile_count(0U)
+	{
+	}
+
+	ContainerDelta ContainerDelta::capture(Container& container)
+	{
+		ContainerDelta delta;
+		delta.m_sequence = container.m_delta_sequence;
+		delta.m_size = container.m_size;
+		delta.m_tile_count = container.m_tiles.size();
+
+		const auto tile_count = container.m_tiles.size();
+		for (size_t chunk = 0; chunk < container.m_dirty_tile_chunks.size(); ++chunk)
+		{
+			if (container.m_dirty_tile_chunks[chunk] == 0U) continue;
+
+			const size_t start = chunk * Container::TILE_CHUNK_SIZE;
+			if (start >= tile_count) continue;
+
+			const size_t end = std::min<size_t>(start + Container::TILE_CHUNK_SIZE, tile_count);
+			delta.m_tile_chunks.push_back({ static_cast<uint32_t>(chunk), Tile::Collection(container.m_tiles.begin() + start, container.m_tiles.begin() + end) });
+		}
+
+		const auto* cells = container.m_grid.data();
+		const auto cell_count = container.m_grid.getCount();
+		for (size_t chunk = 0; chunk < container.m_dirty_cell_chunks.size(); ++chunk)
+		{
+			if (container.m_dirty_cell_chunks[chunk] == 0U) continue;
+
+			const size_t start = chunk * Container::CELL_CHUNK_SIZE;
+			const size_t end = std::min<size_t>(start + Container::CELL_CHUNK_SIZE, cell_count);
+			delta.m_cell_chunks.push_back({ static_cast<uint32_t>(chunk), std::vector<Container::Index>(cells + start, cells + end) });
+		}
+
+		// Reset change tracking; subsequent modifications will be reported in the next delta
+		std::fill(container.m_dirty_tile_chunks.begin(), container.m_dirty_tile_chunks.end(), uint8_t(0U));
+		std::fill(container.m_dirty_cell_chunks.begin(), container.m_dirty_cell_chunks.end(), uint8_t(0U));
+
+		// Empty deltas are never written, so only deltas carrying a change consume a sequence number.  This keeps
+		// the recorded sequence contiguous for replay
+		if (!delta.isEmpty()) ++container.m_delta_sequence;
+
+		return delta;
+	}
+
+	ResultCode ContainerDelta::apply(Container& container) const
+	{
+		if (!(container.getSize() == m_size))
+		{
+			RETURN_LOG_ERROR("Cannot apply container delta " << m_sequence << "; size " << m_size << " does not match container " << container.getSize(), ResultCodes::ContainerDeltaMismatch);
+		}
+
+		container.m_tiles.resize(static_cast<size_t>(m_tile_count), Tile(0, Dir4::UP, { 0, 0 }));
+		for (const auto& chunk : m_tile_chunks)
+		{
+			const size_t start = size_t(chunk.chunk) * Container::TILE_CHUNK_SIZE;
+			if (start + chunk.tiles.size() > container.m_tiles.size())
+			{
+				RETURN_LOG_ERROR("Invalid tile chunk " << chunk.chunk << " in container delta " << m_sequence, ResultCodes::ContainerDeltaMismatch);
+			}
+
+			std::copy(chunk.tiles.begin(), chunk.tiles.end(), container.m_tiles.begin() + start);
+			container.markTileDirty(start);
+		}
+
+		auto* cells = container.m_grid.data();
+		for (const auto& chunk : m_cell_chunks)
+		{
+			const size_t start = size_t(chunk.chunk) * Container::CELL_CHUNK_SIZE;
+			if (start + chunk.cells.size() > container.m_grid.getCount())
+			{
+				RETURN_LOG_ERROR("Invalid cell chunk " << chunk.chunk << " in container delta " << m_sequence, ResultCodes::ContainerDeltaMismatch);
+			}
+
+			std::copy(chunk.cells.begin(), chunk.cells.end(), cells + start);
+			container.markCellDirty(start);
+		}
+
+		container.m_delta_sequence = m_sequence + 1U;
+		return ResultCodes::Success;
+	}
+
+	void ContainerDelta::serialise(std::ostream& out) const
+	{
+		RecordHeader header;
+		memset(&header, 0, sizeof(RecordHeader));
+
+		header.magic = MAGIC;
+		header.version = CURRENT_VERSION;
+		header.sequence = m_sequence;
+		header.size_x = static_cast<int32_t>(m_size.x);
+		header.size_y = static_cast<int32_t>(m_size.y);
+		header.tile_chunk_count = static_cast<uint32_t>(m_tile_chunks.size());
+		header.cell_chunk_count = static_cast<uint32_t>(m_cell_chunks.size());
+		header.tile_count = m_tile_count;
+
+		writeValue(out, header);
+
+		for (const auto& chunk : m_tile_chunks)
+		{
+			writeValue(out, chunk.chunk);
+			writeValue(out, static_cast<uint32_t>(chunk.tiles.size()));
+			out.write(reinterpret_cast<const char*>(chunk.tiles.data()), static_cast<std::streamsize>(chunk.tiles.size() * sizeof(Tile)));
+		}
+
+		for (const auto& chunk : m_cell_chunks)
+		{
+			writeValue(out, chunk.chunk);
+			writeValue(out, static_cast<uint32_t>(chunk.cells.size()));
+			writeIndices(out, chunk.cells);
+		}
+	}
+
+	ResultCode ContainerDelta::deserialise(const uint8_t*& data, const uint8_t* end, ContainerDelta& outDelta)
+	{
+		RecordHeader header;
+		if (!readValue(data, end, header)) return ResultCodes::ContainerFileTruncated;
+
+		if (header.magic != MAGIC)
+			RETURN_LOG_ERROR("Invalid container delta record; bad magic number", ResultCodes::InvalidContainerFileFormat);
+		if (header.version != CURRENT_VERSION)
+			RETURN_LOG_ERROR("Unsupported container delta version " << header.version, ResultCodes::UnsupportedContainerFileVersion);
+
+		// Counts are validated against the container dimensions before any allocation.  Values which could never have
+		// been written are corrupt, while records which are valid but end early have only been truncated
+		if (header.size_x <= 0 || header.size_y <= 0)
+			RETURN_LOG_ERROR("Corrupt container delta record " << header.sequence << "; invalid size", ResultCodes::ContainerFileCorrupt);
+
+		// Tiles never overlap and cover at least one cell each, so can never outnumber the cells
+		const uint64_t cell_count = uint64_t(header.size_x) * uint64_t(header.size_y);
+		if (header.tile_count > cell_count)
+			RETURN_LOG_ERROR("Corrupt container delta record " << header.sequence << "; invalid tile count", ResultCodes::ContainerFileCorrupt);
+
+		const uint64_t max_tile_chunks = (header.tile_count + Container::TILE_CHUNK_SIZE - 1U) / Container::TILE_CHUNK_SIZE;
+		const uint64_t max_cell_chunks = (cell_count + Container::CELL_CHUNK_SIZE - 1U) / Container::CELL_CHUNK_SIZE;
+		if (header.tile_chunk_count > max_tile_chunks || header.cell_chunk_count > max_cell_chunks)
+			RETURN_LOG_ERROR("Corrupt container delta record " << header.sequence << "; invalid chunk count", ResultCodes::ContainerFileCorrupt);
+
+		// Every chunk holds at least its index and element count
+		const size_t min_chunk_size = sizeof(uint32_t) * 2U;
+		if (static_cast<size_t>(end - data) / min_chunk_size < uint64_t(header.tile_chunk_count) + uint64_t(header.cell_chunk_count))
+			return ResultCodes::ContainerFileTruncated;
+
+		ContainerDelta delta;
+		delta.m_sequence = header.sequence;
+		delta.m_size = Vec2<Container::Coord>(header.size_x, header.size_y);
+		delta.m_tile_count = header.tile_count;
+
+		delta.m_tile_chunks.resize(header.tile_chunk_count);
+		for (auto& chunk : delta.m_tile_chunks)
+		{
+			uint32_t count;
+			if (!readValue(data, end, chunk.chunk) || !readValue(data, end, count)) return ResultCodes::ContainerFileTruncated;
+
+			if (chunk.chunk >= max_tile_chunks || count > Container::TILE_CHUNK_SIZE)
+				RETURN_LOG_ERROR("Corrupt container delta record " << header.sequence << "; invalid tile chunk " << chunk.chunk, ResultCodes::ContainerFileCorrupt);
+
+			if (static_cast<size_t>(end - data) / sizeof(Tile) < count) return ResultCodes::ContainerFileTruncated;
+
+			// Records are not aligned within the stream, so tile data is copied rather than referenced in place
+			chunk.tiles.resize(count, Tile(0, Dir4::UP, { 0, 0 }));
+			memcpy(chunk.tiles.data(), data, count * sizeof(Tile));
+			data += count * sizeof(Tile);
+
+			for (const auto& tile : chunk.tiles)
+			{
+				if (!Container::isWithinBounds(tile, delta.m_size))
+					RETURN_LOG_ERROR("Corrupt container delta record " << header.sequence << "; tile in chunk " << chunk.chunk << " has an invalid orientation, size or location", ResultCodes::ContainerFileCorrupt);
+			}
+		}
+
+		delta.m_cell_chunks.resize(header.cell_chunk_count);
+		for (auto& chunk : delta.m_cell_chunks)
+		{
+			uint32_t count;
+			if (!readValue(data, end, chunk.chunk) || !readValue(data, end, count)) return ResultCodes::ContainerFileTruncated;
+
+			if (chunk.chunk >= max_cell_chunks || count > Container::CELL_CHUNK_SIZE)
+				RETURN_LOG_ERROR("Corrupt container delta record " << header.sequence << "; invalid cell chunk " << chunk.chunk, ResultCodes::ContainerFileCorrupt);
+
+			if (!readIndices(data, end, count, chunk.cells)) return ResultCodes::ContainerFileTruncated;
+		}
+
+		outDelta = std::move(delta);
+		return ResultCodes::Success;
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <ostream>
+#include "../util/result_code.h"
+#include "container.h"
+
+namespace Orion
+{
+	// Set of container chunks which changed between two snapshots.  Capturing a delta copies only the chunks
+	// modified since the previous capture, so the cost is proportional to the amount of change rather than the
+	// container size.  Applying each delta in sequence to an empty container reproduces the captured state exactly
+	class ContainerDelta
+	{
+	public:
+
+		static const uint32_t MAGIC = 0x4443524FU;		// "ORCD"
+		static const uint32_t CURRENT_VERSION = 3U;
+
+		struct TileChunk
+		{
+			uint32_t			chunk;
+			Tile::Collection	tiles;
+		};
+
+		struct CellChunk
+		{
+			uint32_t						chunk;
+			std::vector<Container::Index>	cells;
+		};
+
+		ContainerDelta();
+
+		// Captures all changes since the previous capture and resets change tracking in the container.  The delta
+		// is assigned the next sequence number of the container, which is consumed only if the delta is not empty
+		static ContainerDelta capture(Container& container);
+
+		inline uint64_t getSequence() const { return m_sequence; }
+		inline Vec2<Container::Coord> getSize() const { return m_size; }
+		inline size_t getChangedChunkCount() const { return m_tile_chunks.size() + m_cell_chunks.size(); }
+		// Any addition or removal of a tile modifies at least one grid cell, so a delta with no changed chunks carries no change
+		inline bool isEmpty() const { return m_tile_chunks.empty() && m_cell_chunks.empty(); }
+
+		// Tile handles are not updated when applying a delta; the container's handles should be rebuilt once all
+		// deltas have been applied
+		ResultCode apply(Container& container) const;
+
+		void serialise(std::ostream& out) const;
+		// Returns ContainerFileTruncated if the data ends partway through a record, and ContainerFileCorrupt if the
+		// record contains values which could not have been written
+		static ResultCode deserialise(const uint8_t*& data, const uint8_t* end, ContainerDelta& outDelta);
+
+	private:
+
+		// Fixed-size record header preceding each serialised delta
+		struct RecordHeader
+		{
+			uint32_t	magic;
+			uint32_t	version;
+			uint64_t	sequence;
+			int32_t		size_x;
+			int32_t		size_y;
+			uint32_t	tile_chunk_count;
+			uint32_t	cell_chunk_count;
+			uint64_t	tile_count;			// Number of live tiles after this delta
+		};
+
+	private:
+
+		uint64_t						m_sequence;
+		Vec2<Container::Coord>			m_size;
+		uint64_t						m_tile_count;
+
+		std::vector<TileChunk>			m_tile_chunks;
+		std::vector<CellChunk>			m_cell_chunks;
+	};
+}
@@ -0,0 +1,153 @@
+#include "../util/log.h"
+#include "../util/mapped_file.h"
+#include "../util/thread_pool.h"
+
+#include "container_delta_stream.h"
+
+namespace Orion
+{
+	ContainerDeltaStream::ContainerDeltaStream()
+		:
+		m_in_flight(0U),
+		m_write_failed(false)
+	{
+	}
+
+	ContainerDeltaStream::~ContainerDeltaStream()
+	{
+		close();
+	}
+
+	ResultCode ContainerDeltaStream::open(const std::string& path, Container& container)
+	{
+		close();
+
+		m_out.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!m_out.is_open())
+		{
+			RETURN_LOG_ERROR("Failed to open container delta stream \"" << path << "\"", ResultCodes::FailedToOpenFile);
+		}
+
+		m_path = path;
+		m_write_failed = false;
+		container.resetDeltaTracking();
+
+		return ResultCodes::Success;
+	}
+
+	void ContainerDeltaStream::close()
+	{
+		if (!m_out.is_open()) return;
+
+		flush();
+		m_out.close();
+	}
+
+	ResultCode ContainerDeltaStream::record(Container& container, ThreadPool& pool)
+	{
+		if (!m_out.is_open())
+		{
+			RETURN_LOG_ERROR("Cannot record container delta; stream is not open", ResultCodes::FailedToWriteFile);
+		}
+
+		auto delta = ContainerDelta::capture(container);
+		if (delta.isEmpty()) return ResultCodes::Success;
+
+		{
+			std::lock_guard<std::mutex> lock(m_pending_mutex);
+			if (m_write_failed)
+			{
+				RETURN_LOG_ERROR("Cannot record container delta; previous write to \"" << m_path << "\" failed", ResultCodes::FailedToWriteFile);
+			}
+
+			m_pending.push_back(std::move(delta));
+			++m_in_flight;
+		}
+
+		pool.enqueue([this]() { writePending(); });
+		return ResultCodes::Success;
+	}
+
+	void ContainerDeltaStream::writePending()
+	{
+		// The write lock is taken before popping, so deltas always reach the file in the order they were captured
+		std::lock_guard<std::mutex> write_lock(m_write_mutex);
+
+		while (true)
+		{
+			ContainerDelta delta;
+			{
+				std::lock_guard<std::mutex> lock(m_pending_mutex);
+				if (m_pending.empty()) return;
+
+				delta = std::move(m_pending.front());
+				m_pending.pop_front();
+			}
+
+			delta.serialise(m_out);
+			m_out.flush();
+
+			{
+				std::lock_guard<std::mutex> lock(m_pending_mutex);
+				if (m_out.fail()) m_write_failed = true;
+
+				--m_in_flight;
+			}
+			m_written.notify_all();
+		}
+	}
+
+	void ContainerDeltaStream::flush()
+	{
+		std::unique_lock<std::mutex> lock(m_pending_mutex);
+		m_written.wait(lock, [this]() { return m_in_flight == 0U; });
+	}
+
+	ResultCode ContainerDeltaStream::replay(const std::string& path, std::unique_ptr<Container>& outContainer, uint64_t last_sequence)
+	{
+		MappedFile file;
+		RETURN_ON_ERROR(file.open(path));
+
+		const uint8_t* data = file.data();
+		const uint8_t* end = data + file.size();
+
+		std::unique_ptr<Container> container;
+		uint64_t expected_sequence = 0U;
+
+		while (data < end)
+		{
+			ContainerDelta delta;
+			const auto result = ContainerDelta::deserialise(data, end, delta);
+			if (result == ResultCodes::ContainerFileTruncated)
+			{
+				// A partially-written trailing record is expected if the process ended mid-write; replay everything before it
+				LOG_WARN("Container delta stream \"" << path << "\" ends with an incomplete record; replaying " << expected_sequence << " deltas");
+				break;
+			}
+			RETURN_ON_ERROR(result);
+
+			if (delta.getSequence() > last_sequence) break;
+			if (delta.getSequence() != expected_sequence)
+			{
+				RETURN_LOG_ERROR("Container delta stream \"" << path << "\" is out of sequence (expected " << expected_sequence << ", found " << delta.getSequence() << ")", ResultCodes::ContainerDeltaMismatch);
+			}
+
+			if (!container) container = std::make_unique<Container>(delta.getSize());
+			RETURN_ON_ERROR(delta.apply(*container));
+
+			++expected_sequence;
+		}
+
+		if (!container)
+		{
+			RETURN_LOG_ERROR("Container delta stream \"" << path << "\" contains no deltas", ResultCodes::InvalidContainerFileFormat);
+		}
+
+		container->rebuildHandles();
+
+		LOG_INFO("Replayed " << expected_sequence << " container deltas from \"" << path << "\"");
+
+		outContainer = std::move(container);
+		return ResultCodes::Success;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include "../util/result_code.h"
+#include "container_delta.h"
+
+namespace Orion
+{
+	class ThreadPool;
+
+	// Append-only stream of container deltas, used for incremental autosave and replay.  Deltas are captured
+	// on the calling thread, which copies only the changed chunks, and are serialised to disk in capture order
+	// on a worker thread so that the simulation is never blocked on file I/O
+	class ContainerDeltaStream
+	{
+	public:
+
+		ContainerDeltaStream();
+		~ContainerDeltaStream();
+
+		ContainerDeltaStream(const ContainerDeltaStream&) = delete;
+		ContainerDeltaStream& operator=(const ContainerDeltaStream&) = delete;
+
+		// Opens a new stream, replacing any existing file.  The container is marked fully dirty and its delta
+		// sequence restarted, so that the first recorded delta is a complete base snapshot with sequence zero
+		ResultCode open(const std::string& path, Container& container);
+		void close();
+
+		inline bool isOpen() const { return m_out.is_open(); }
+
+		// Captures changes since the last record and queues them for background serialisation.  No data is
+		// written if the container has not changed
+		ResultCode record(Container& container, ThreadPool& pool);
+
+		// Blocks until all queued deltas have been written
+		void flush();
+
+		// Reconstructs a container by applying each delta in the stream in order, up to and including the given sequence number
+		static ResultCode replay(const std::string& path, std::unique_ptr<Container>& outContainer, uint64_t last_sequence = ~0ULL);
+
+	private:
+
+		void writePending();
+
+	private:
+
+		std::string						m_path;
+		std::ofstream					m_out;
+		std::mutex						m_write_mutex;			// Held for the duration of each write, to preserve delta ordering
+
+		std::deque<ContainerDelta>		m_pending;
+		std::mutex						m_pending_mutex;
+		std::condition_variable			m_written;
+		size_t							m_in_flight;
+		bool							m_write_failed;
+	};
+}
@@ -0,0 +1,395 @@
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#endif
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include "../util/log.h"
+#include "../util/mapped_file.h"
+#include "../util/thread_pool.h"
+
+#include "container_serialiser.h"
+
+namespace Orion
+{
+	static_assert(std::is_trivially_copyable<Tile>::value, "Tiles must be trivially copyable for direct serialisation");
+	static_assert(std::is_trivially_copyable<ContainerSerialiser::Header>::value, "Header must be trivially copyable");
+	static_assert(alignof(Tile) <= ContainerSerialiser::SECTION_ALIGNMENT && alignof(uint64_t) <= ContainerSerialiser::SECTION_ALIGNMENT, "Sections must be aligned for their records");
+
+	namespace
+	{
+		// Writes zero bytes until the stream is positioned at the given offset
+		void padTo(std::ofstream& out, uint64_t& position, uint64_t offset)
+		{
+			static const char zeroes[ContainerSerialiser::SECTION_ALIGNMENT] = { 0 };
+			out.write(zeroes, static_cast<std::streamsize>(offset - position));
+			position = offset;
+		}
+
+		void writeRaw(std::ofstream& out, uint64_t& position, const void* data, size_t bytes)
+		{
+			out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+			position += bytes;
+		}
+
+		// Copies an index array from file data, widening or narrowing if the file was written with a different index size
+		void readIndices(const uint8_t* src, uint32_t src_width, Container::Index* dst, size_t count)
+		{
+			if (src_width == sizeof(Container::Index))
+			{
+				memcpy(dst, src, count * sizeof(Container::Index));
+			}
+			else if (src_width == sizeof(uint64_t))
+			{
+				const auto* in = reinterpret_cast<const uint64_t*>(src);
+				for (size_t i = 0; i < count; ++i)
+				{
+					dst[i] = (in[i] == std::numeric_limits<uint64_t>::max() ? Container::NO_INDEX : static_cast<Container::Index>(in[i]));
+				}
+			}
+			else
+			{
+				const auto* in = reinterpret_cast<const uint32_t*>(src);
+				for (size_t i = 0; i < count; ++i)
+				{
+					dst[i] = (in[i] == std::numeric_limits<uint32_t>::max() ? Container::NO_INDEX : static_cast<Container::Index>(in[i]));
+				}
+			}
+		}
+
+		// Tests whether count records of the given width, starting at offset, end at or before the limit
+		inline bool sectionFits(uint64_t offset, uint64_t count, uint64_t width, uint64_t limit)
+		{
+			return offset <= limit && count <= (limit - offset) / width;
+		}
+
+		// Copies each chunk of the source which has been modified since it was last copied to the mirror
+		template <typename T>
+		void copyModifiedChunks(std::vector<T>& mirror, std::vector<uint64_t>& copied, const T* source, size_t count, size_t chunk_size,
+			const std::vector<uint64_t>& versions, bool full, T fill)
+		{
+			static const uint64_t NOT_COPIED = std::numeric_limits<uint64_t>::max();
+
+			mirror.resize(count, fill);
+			copied.resize((count + chunk_size - 1U) / chunk_size, NOT_COPIED);
+
+			for (size_t chunk = 0U; chunk < copied.size(); ++chunk)
+			{
+				const uint64_t version = (chunk < versions.size() ? versions[chunk] : NOT_COPIED);
+				if (!full && version != NOT_COPIED && copied[chunk] == version) continue;
+
+				const size_t start = chunk * chunk_size;
+				const size_t end = std::min(start + chunk_size, count);
+				std::copy(source + start, source + end, mirror.begin() + start);
+				copied[chunk] = version;
+			}
+		}
+	}
+
+	ContainerSerialiser::Snapshot::Snapshot()
+		:
+		m_source(nullptr),
+		m_size(0, 0),
+		m_version(0U),
+		m_writing(false)
+	{
+	}
+
+	ContainerSerialiser::Snapshot::~Snapshot()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_write_complete.wait(lock, [this]() { return !m_writing; });
+	}
+
+	ContainerSerialiser::StateView ContainerSerialiser::view(const Container& container)
+	{
+		StateView state;
+		state.size = container.m_size;
+		state.tiles = container.m_tiles.data();
+		state.tile_count = container.m_tiles.size();
+		state.cells = container.m_grid.data();
+		state.cell_count = container.m_grid.getCount();
+
+		return state;
+	}
+
+	ResultCode ContainerSerialiser::save(const Container& container, const std::string& path)
+	{
+		return write(view(container), path);
+	}
+
+	ContainerSerialiser::StateView ContainerSerialiser::view(const Snapshot& snapshot)
+	{
+		StateView state;
+		state.size = snapshot.m_size;
+		state.tiles = snapshot.m_tiles.data();
+		state.tile_count = snapshot.m_tiles.size();
+		state.cells = snapshot.m_cells.data();
+		state.cell_count = snapshot.m_cells.size();
+
+		return state;
+	}
+
+	void ContainerSerialiser::updateSnapshot(Snapshot& snapshot, const Container& container)
+	{
+		if (snapshot.m_source == &container && snapshot.m_version == container.m_version) return;
+
+		const bool full = (snapshot.m_source != &container || !(snapshot.m_size == container.m_size));
+		snapshot.m_source = &container;
+		snapshot.m_size = container.m_size;
+		snapshot.m_version = container.m_version;
+
+		copyModifiedChunks(snapshot.m_tiles, snapshot.m_tile_versions, container.m_tiles.data(), container.m_tiles.size(),
+			Container::TILE_CHUNK_SIZE, container.m_tile_chunk_versions, full, Tile(0, Dir4::UP, { 0, 0 }));
+
+		copyModifiedChunks(snapshot.m_cells, snapshot.m_cell_versions, container.m_grid.data(), container.m_grid.getCount(),
+			Container::CELL_CHUNK_SIZE, container.m_cell_chunk_versions, full, Container::NO_INDEX);
+	}
+
+	std::future<ResultCode> ContainerSerialiser::saveAsync(const Container& container, const std::string& path, ThreadPool& pool, Snapshot& snapshot)
+	{
+		// The snapshot is detached from the container, which can continue to be modified while the write is in progress
+		{
+			std::unique_lock<std::mutex> lock(snapshot.m_mutex);
+			snapshot.m_write_complete.wait(lock, [&snapshot]() { return !snapshot.m_writing; });
+
+			updateSnapshot(snapshot, container);
+			snapshot.m_writing = true;
+		}
+
+		auto promise = std::make_shared<std::promise<ResultCode>>();
+		auto result = promise->get_future();
+
+		pool.enqueue([&snapshot, promise, path]()
+		{
+			const ResultCode written = write(view(snapshot), path);
+			{
+				std::lock_guard<std::mutex> lock(snapshot.m_mutex);
+				snapshot.m_writing = false;
+			}
+			snapshot.m_write_complete.notify_all();
+
+			promise->set_value(written);
+		});
+
+		return result;
+	}
+
+	std::vector<Tile::DefId> ContainerSerialiser::buildDefinitionTable(const StateView& state)
+	{
+		std::vector<Tile::DefId> definitions;
+		for (size_t i = 0; i < state.tile_count; ++i)
+		{
+			definitions.push_back(state.tiles[i].getDefinition());
+		}
+
+		std::sort(definitions.begin(), definitions.end());
+		definitions.erase(std::unique(definitions.begin(), definitions.end()), definitions.end());
+
+		return definitions;
+	}
+
+	ContainerSerialiser::Header ContainerSerialiser::buildHeader(const StateView& state, const std::vector<Tile::DefId>& definitions)
+	{
+		Header header;
+		memset(&header, 0, sizeof(Header));
+
+		header.magic = MAGIC;
+		header.version = CURRENT_VERSION;
+		header.size_x = static_cast<int32_t>(state.size.x);
+		header.size_y = static_cast<int32_t>(state.size.y);
+		header.index_width = static_cast<uint32_t>(sizeof(Container::Index));
+		header.tile_width = static_cast<uint32_t>(sizeof(Tile));
+		header.tile_chunk_size = TILE_CHUNK_SIZE;
+		header.definition_count = static_cast<uint32_t>(definitions.size());
+		header.tile_count = state.tile_count;
+		header.cell_count = state.cell_count;
+
+		header.definition_offset = align(sizeof(Header));
+		header.tile_offset = align(header.definition_offset + (definitions.size() * sizeof(Tile::DefId)));
+		header.grid_offset = align(header.tile_offset + (state.tile_count * sizeof(Tile)));
+		header.file_size = header.grid_offset + (state.cell_count * sizeof(Container::Index));
+
+		return header;
+	}
+
+	ResultCode ContainerSerialiser::write(const StateView& state, const std::string& path)
+	{
+		// Write to a temporary file and then replace the target, so that a failed save never corrupts an existing file
+		const std::string temp_path = path + ".tmp";
+		std::ofstream out(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+		{
+			RETURN_LOG_ERROR("Failed to open \"" << temp_path << "\" for container save", ResultCodes::FailedToOpenFile);
+		}
+
+		const auto definitions = buildDefinitionTable(state);
+		const auto header = buildHeader(state, definitions);
+		uint64_t position = 0U;
+
+		writeRaw(out, position, &header, sizeof(Header));
+
+		padTo(out, position, header.definition_offset);
+		writeRaw(out, position, definitions.data(), definitions.size() * sizeof(Tile::DefId));
+
+		// Tiles are streamed in chunks to bound the size of each individual write
+		padTo(out, position, header.tile_offset);
+		for (size_t chunk = 0; chunk < state.tile_count; chunk += TILE_CHUNK_SIZE)
+		{
+			const size_t count = std::min<size_t>(TILE_CHUNK_SIZE, state.tile_count - chunk);
+			writeRaw(out, position, state.tiles + chunk, count * sizeof(Tile));
+		}
+
+		padTo(out, position, header.grid_offset);
+		writeRaw(out, position, state.cells, state.cell_count * sizeof(Container::Index));
+
+		out.close();
+		if (out.fail() || position != header.file_size)
+		{
+			std::remove(temp_path.c_str());
+			RETURN_LOG_ERROR("Failed to write container data to \"" << temp_path << "\"", ResultCodes::FailedToWriteFile);
+		}
+
+		RETURN_ON_ERROR(replaceFile(temp_path, path));
+
+		LOG_INFO("Saved container " << state.size << " with " << state.tile_count << " tiles to \"" << path << "\" (" << header.file_size << " bytes)");
+		return ResultCodes::Success;
+	}
+
+	// Replaces the target with the source file in a single operation, so that the target always holds either its
+	// previous or its new contents
+	ResultCode ContainerSerialiser::replaceFile(const std::string& source, const std::string& target)
+	{
+#		ifdef _WIN32
+		const bool replaced = (MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#		else
+		const bool replaced = (std::rename(source.c_str(), target.c_str()) == 0);
+#		endif
+
+		if (!replaced)
+		{
+			std::remove(source.c_str());
+			RETURN_LOG_ERROR("Failed to replace container file \"" << target << "\"", ResultCodes::FailedToWriteFile);
+		}
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode ContainerSerialiser::validateHeader(const Header& header, size_t mapped_size)
+	{
+		if (header.magic != MAGIC)
+			RETURN_LOG_ERROR("Invalid container file; bad magic number", ResultCodes::InvalidContainerFileFormat);
+		if (header.version != CURRENT_VERSION)
+			RETURN_LOG_ERROR("Unsupported container file version " << header.version, ResultCodes::UnsupportedContainerFileVersion);
+		if (header.tile_width != sizeof(Tile) || (header.index_width != sizeof(uint32_t) && header.index_width != sizeof(uint64_t)))
+			RETURN_LOG_ERROR("Invalid container file; unsupported record widths", ResultCodes::InvalidContainerFileFormat);
+		if (header.size_x <= 0 || header.size_y <= 0 || header.cell_count != uint64_t(header.size_x) * uint64_t(header.size_y))
+			RETURN_LOG_ERROR("Invalid container file; inconsistent dimensions", ResultCodes::InvalidContainerFileFormat);
+		if (header.file_size > mapped_size)
+			RETURN_LOG_ERROR("Container file is truncated (" << mapped_size << " of " << header.file_size << " bytes)", ResultCodes::ContainerFileTruncated);
+
+		// Tiles never overlap and cover at least one cell each, so can never outnumber the cells
+		if (header.tile_count > header.cell_count || header.definition_count > header.tile_count)
+			RETURN_LOG_ERROR("Invalid container file; inconsistent record counts", ResultCodes::InvalidContainerFileFormat);
+
+		// Every section must be aligned, follow the previous section, and lie entirely within the file.  Sizes are
+		// compared against the space remaining so that no calculation can overflow
+		const bool sections_valid =
+			(header.definition_offset % SECTION_ALIGNMENT) == 0U && (header.tile_offset % SECTION_ALIGNMENT) == 0U && (header.grid_offset % SECTION_ALIGNMENT) == 0U &&
+			header.definition_offset >= sizeof(Header) &&
+			sectionFits(header.definition_offset, header.definition_count, sizeof(Tile::DefId), header.tile_offset) &&
+			sectionFits(header.tile_offset, header.tile_count, header.tile_width, header.grid_offset) &&
+			sectionFits(header.grid_offset, header.cell_count, header.index_width, header.file_size);
+
+		if (!sections_valid)
+			RETURN_LOG_ERROR("Invalid container file; inconsistent section layout", ResultCodes::InvalidContainerFileFormat);
+
+		return ResultCodes::Success;
+	}
+
+	// Verifies that the grid only refers to stored tiles, that tiles only refer to stored definitions, and that each
+	// tile lies within the container with every cell of its footprint referring back to it.  Footprints of valid tiles
+	// never overlap, so the footprint checks visit each cell at most once before any overlap is rejected
+	ResultCode ContainerSerialiser::validateContent(const Container& container, const std::vector<Tile::DefId>& definitions)
+	{
+		if (!std::is_sorted(definitions.begin(), definitions.end()) || std::adjacent_find(definitions.begin(), definitions.end()) != definitions.end())
+			RETURN_LOG_ERROR("Invalid container file; definition table is not ordered", ResultCodes::InvalidContainerFileFormat);
+
+		for (const auto& tile : container.m_tiles)
+		{
+			if (!std::binary_search(definitions.begin(), definitions.end(), tile.getDefinition()))
+				RETURN_LOG_ERROR("Invalid container file; tile definition " << tile.getDefinition() << " is not in the definition table", ResultCodes::InvalidContainerFileFormat);
+		}
+
+		const auto tile_count = container.m_tiles.size();
+		const auto* cells = container.m_grid.data();
+		const auto cell_count = container.m_grid.getCount();
+		for (size_t i = 0U; i < cell_count; ++i)
+		{
+			if (cells[i] != Container::NO_INDEX && cells[i] >= tile_count)
+				RETURN_LOG_ERROR("Invalid container file; cell " << i << " refers to tile " << cells[i] << " of " << tile_count, ResultCodes::InvalidContainerFileFormat);
+		}
+
+		for (size_t i = 0U; i < tile_count; ++i)
+		{
+			const auto& tile = container.m_tiles[i];
+			if (!Container::isWithinBounds(tile, container.m_size))
+				RETURN_LOG_ERROR("Invalid container file; tile " << i << " has an invalid orientation, size or location", ResultCodes::InvalidContainerFileFormat);
+
+			const auto location = tile.getLocation();
+			const auto footprint = tile.getFootprint();
+			for (Container::Coord y = location.y; y < location.y + footprint.y; ++y)
+			{
+				const auto* row = cells + container.m_grid.getIndexUnchecked(Vec2<Container::Coord>(location.x, y));
+				for (Container::Coord x = 0; x < footprint.x; ++x)
+				{
+					if (row[x] != i)
+						RETURN_LOG_ERROR("Invalid container file; footprint of tile " << i << " is not covered by that tile", ResultCodes::InvalidContainerFileFormat);
+				}
+			}
+		}
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode ContainerSerialiser::load(const std::string& path, std::unique_ptr<Container>& outContainer, std::vector<Tile::DefId>* outDefinitions)
+	{
+		MappedFile file;
+		RETURN_ON_ERROR(file.open(path));
+
+		if (file.size() < sizeof(Header))
+			RETURN_LOG_ERROR("Container file \"" << path << "\" is truncated", ResultCodes::ContainerFileTruncated);
+
+		Header header;
+		memcpy(&header, file.data(), sizeof(Header));
+		RETURN_ON_ERROR(validateHeader(header, file.size()));
+
+		const uint8_t* base = file.data();
+		auto container = std::make_unique<Container>(Vec2<Container::Coord>(header.size_x, header.size_y));
+
+		const auto* definition_data = reinterpret_cast<const Tile::DefId*>(base + header.definition_offset);
+		std::vector<Tile::DefId> definitions(definition_data, definition_data + header.definition_count);
+
+		// Sections are aligned within the mapping, so tile records can be bulk-copied directly from the mapped view
+		const auto* tiles = reinterpret_cast<const Tile*>(base + header.tile_offset);
+		container->m_tiles.assign(tiles, tiles + static_cast<size_t>(header.tile_count));
+
+		readIndices(base + header.grid_offset, header.index_width, container->m_grid.data(), static_cast<size_t>(header.cell_count));
+		RETURN_ON_ERROR(validateContent(*container, definitions));
+
+		container->rebuildHandles();
+		container->markAllDirty();
+
+		LOG_INFO("Loaded container " << container->getSize() << " with " << header.tile_count << " tiles from \"" << path << "\"");
+
+		outContainer = std::move(container);
+		if (outDefinitions) *outDefinitions = std::move(definitions);
+
+		return ResultCodes::Success;
+	}
+}
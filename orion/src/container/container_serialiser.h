@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include "../util/result_code.h"
+#include "container.h"
+
+namespace Orion
+{
+	class ThreadPool;
+
+	// Versioned binary persistence for containers.  Each section of the file is a raw little-endian array in the
+	// same layout as its in-memory counterpart, so loading is a validated bulk copy from a memory-mapped file
+	// with no per-tile parsing.  File layout:
+	//
+	//   Header | Definition table (DefId[]) | Tile chunks (Tile[]) | Grid index (Index[])
+	//
+	// Tiles are written in chunks of TILE_CHUNK_SIZE, which is the unit of streaming on save.  All sections
+	// begin on a SECTION_ALIGNMENT boundary.  Tile handles are not persisted and are reassigned on load
+	class ContainerSerialiser
+	{
+	public:
+
+		static const uint32_t MAGIC = 0x4E43524FU;		// "ORCN"
+		static const uint32_t CURRENT_VERSION = 3U;
+		static const uint32_t TILE_CHUNK_SIZE = 16384U;
+		static const uint64_t SECTION_ALIGNMENT = 16U;
+
+		struct Header
+		{
+			uint32_t	magic;
+			uint32_t	version;
+			int32_t		size_x;
+			int32_t		size_y;
+
+			uint32_t	index_width;			// Size in bytes of each index in the grid section
+			uint32_t	tile_width;				// Size in bytes of each tile record
+			uint32_t	tile_chunk_size;		// Number of tiles in each chunk of the tile section
+			uint32_t	definition_count;
+
+			uint64_t	tile_count;
+			uint64_t	cell_count;
+
+			uint64_t	definition_offset;
+			uint64_t	tile_offset;
+			uint64_t	grid_offset;
+			uint64_t	file_size;
+		};
+
+		// Copy of container state retained between background saves.  Each save copies only the chunks modified since
+		// the previous save through the same snapshot, so the cost to the calling thread is proportional to the changes
+		// made rather than to the size of the container.  The first save through a snapshot copies the full state
+		class Snapshot
+		{
+		public:
+
+			Snapshot();
+			~Snapshot();			// Waits for any save in progress
+
+			Snapshot(const Snapshot&) = delete;
+			Snapshot& operator=(const Snapshot&) = delete;
+
+		private:
+
+			friend class ContainerSerialiser;
+
+			const Container *				m_source;				// Container last copied; any other is copied in full
+			Vec2<Container::Coord>			m_size;
+			Tile::Collection				m_tiles;
+			std::vector<Container::Index>	m_cells;
+			uint64_t						m_version;				// Container modification count when last updated
+			std::vector<uint64_t>			m_tile_versions;		// Container version of each tile chunk when last copied
+			std::vector<uint64_t>			m_cell_versions;
+
+			std::mutex						m_mutex;
+			std::condition_variable			m_write_complete;
+			bool							m_writing;
+		};
+
+		static ResultCode save(const Container& container, const std::string& path);
+
+		// The table of tile definitions referenced by the container is optionally returned, e.g. for validation against
+		// the definitions currently loaded
+		static ResultCode load(const std::string& path, std::unique_ptr<Container>& outContainer, std::vector<Tile::DefId>* outDefinitions = nullptr);
+
+		// Updates the snapshot from the container on the calling thread and streams it to disk on the given thread pool.
+		// If a previous save through the same snapshot is still in progress, the calling thread waits for it
+		static std::future<ResultCode> saveAsync(const Container& container, const std::string& path, ThreadPool& pool, Snapshot& snapshot);
+
+	private:
+
+		// Read-only view of the container state being written; may refer to the live container or a detached copy
+		struct StateView
+		{
+			Vec2<Container::Coord>		size;
+			const Tile*					tiles;
+			size_t						tile_count;
+			const Container::Index*		cells;
+			size_t						cell_count;
+		};
+
+		static StateView view(const Container& container);
+		static StateView view(const Snapshot& snapshot);
+		static void updateSnapshot(Snapshot& snapshot, const Container& container);
+		static ResultCode write(const StateView& state, const std::string& path);
+		static ResultCode replaceFile(const std::string& source, const std::string& target);
+
+		static Header buildHeader(const StateView& state, const std::vector<Tile::DefId>& definitions);
+		static std::vector<Tile::DefId> buildDefinitionTable(const StateView& state);
+		static ResultCode validateHeader(const Header& header, size_t mapped_size);
+		static ResultCode validateContent(const Container& container, const std::vector<Tile::DefId>& definitions);
+
+		static inline uint64_t align(uint64_t offset) { return (offset + SECTION_ALIGNMENT - 1U) & ~(SECTION_ALIGNMENT - 1U); }
+	};
+}
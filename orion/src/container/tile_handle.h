@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace Orion
+{
+	// Stable reference to a tile within a container.  Tiles may move within the container's dense tile storage,
+	// but a handle continues to resolve to the same tile until it is removed.  Handles to removed tiles are
+	// detected via the generation count and will resolve to nothing, even if their slot has since been reused
+	struct TileHandle
+	{
+		static const uint32_t NO_SLOT = 0xFFFFFFFFU;
+
+		uint32_t	slot;
+		uint32_t	generation;
+
+		inline TileHandle() : slot(NO_SLOT), generation(0U) { }
+		inline TileHandle(uint32_t _slot, uint32_t _generation) : slot(_slot), generation(_generation) { }
+
+		inline bool isNull() const { return slot == NO_SLOT; }
+		inline explicit operator bool() const { return !isNull(); }
+
+		inline bool operator==(const TileHandle& other) const { return slot == other.slot && generation == other.generation; }
+		inline bool operator!=(const TileHandle& other) const { return !(*this == other); }
+	};
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace Orion
+{
+	// Actions which input may be bound to.  Actions are held between their press and release, except for those bound
+	// to the mouse wheel, which are pressed and released together
+	enum class InputAction : uint8_t
+	{
+		Quit = 0,
+		MoveUp,
+		MoveDown,
+		MoveLeft,
+		MoveRight,
+		MoveFast,
+		ZoomIn,
+		ZoomOut,
+		ToggleDebugDraw,
+
+		Count
+	};
+}
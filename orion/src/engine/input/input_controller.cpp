@@ -1,6 +1,181 @@
+#include <algorithm>
+#include "entry/entry_p.h"
+#include "../../util/log.h"
+
 #include "input_controller.h"
 
 namespace Orion
 {
+	InputController::InputController()
+		:
+		m_bindings(),
+		m_active(),
+		m_modifiers(0U),
+		m_wheel(0),
+		m_queue(),
+		m_stats({ 0U, 0U, 0U })
+	{
+	}
+
+	ResultCode InputController::initialise()
+	{
+		LOG_INFO("Initialising input controller");
+
+		entry::setEventObserver(&InputController::observeEvent, this);
+
+		return ResultCodes::Success;
+	}
+
+	void InputController::bind(const ActionBinding& binding)
+	{
+		m_bindings.push_back(binding);
+		m_active.push_back(false);
+	}
+
+	void InputController::clearBindings()
+	{
+		m_bindings.clear();
+		m_active.clear();
+	}
+
+	void InputController::observeEvent(const entry::Event& event, void* controller)
+	{
+		static_cast<InputController*>(controller)->processEvent(event);
+	}
+
+	void InputController::processEvent(const entry::Event& event)
+	{
+		// Entry events carry no time of their own, so are stamped as they are taken from the entry queue
+		const Clock::time_point now = Clock::now();
+
+		switch (event.m_type)
+		{
+		case entry::Event::Key:
+		{
+			const auto& key = static_cast<const entry::KeyEvent&>(event);
+			updateModifiers(key.m_modifiers, now);
+
+			for (size_t i = 0U; i < m_bindings.size(); ++i)
+			{
+				const ActionBinding& binding = m_bindings[i];
+				if (binding.source != ActionBinding::Source::Key || binding.code != int32_t(key.m_key)) continue;
+
+				// Release does not depend on modifiers, so that an action always ends with its key
+				setBindingActive(i, key.m_down && (key.m_modifiers & binding.modifiers) == binding.modifiers, now);
+			}
+			break;
+		}
+
+		case entry::Event::Mouse:
+		{
+			const auto& mouse = static_cast<const entry::MouseEvent&>(event);
+			for (size_t i = 0U; i < m_bindings.size() && !mouse.m_move; ++i)
+			{
+				const ActionBinding& binding = m_bindings[i];
+				if (binding.source != ActionBinding::Source::MouseButton || binding.code != int32_t(mouse.m_button)) continue;
+
+				setBindingActive(i, mouse.m_down && (m_modifiers & binding.modifiers) == binding.modifiers, now);
+			}
+
+			// The wheel position is absolute; each step of movement is a separate press of any bound action
+			const int32_t wheel_delta = mouse.m_mz - m_wheel;
+			m_wheel = mouse.m_mz;
+			if (wheel_delta == 0) break;
+
+			const int32_t direction = (wheel_delta > 0 ? +1 : -1);
+			for (const ActionBinding& binding : m_bindings)
+			{
+				if (binding.source != ActionBinding::Source::MouseWheel || binding.code != direction) continue;
+				if ((m_modifiers & binding.modifiers) != binding.modifiers) continue;
+
+				for (int32_t step = 0; step != wheel_delta; step += direction)
+				{
+					queueAction(binding.action, true, now);
+					queueAction(binding.action, false, now);
+				}
+			}
+			break;
+		}
+
+		default:
+			break;
+		}
+
+		++m_stats.events;
+	}
+
+	void InputController::updateModifiers(uint8_t modifiers, Clock::time_point timestamp)
+	{
+		if (modifiers == m_modifiers) return;
+		m_modifiers = modifiers;
+
+		for (size_t i = 0U; i < m_bindings.size(); ++i)
+		{
+			const ActionBinding& binding = m_bindings[i];
+			if (binding.source != ActionBinding::Source::Modifier) continue;
+
+			setBindingActive(i, (modifiers & uint8_t(binding.code)) != 0U, timestamp);
+		}
+	}
+
+	// Repeated presses from a held key, and releases of bindings which never activated, are ignored
+	void InputController::setBindingActive(size_t binding, bool active, Clock::time_point timestamp)
+	{
+		if (m_active[binding] == active) return;
+
+		m_active[binding] = active;
+		queueAction(m_bindings[binding].action, active, timestamp);
+	}
+
+	void InputController::queueAction(InputAction action, bool pressed, Clock::time_point timestamp)
+	{
+		if (m_queue.push({ action, pressed, timestamp }))
+		{
+			++m_stats.actions;
+		}
+		else
+		{
+			++m_stats.dropped;
+		}
+	}
+
+	void InputController::sample(ActionState& state, Clock::time_point until)
+	{
+		state.m_presses.fill(0U);
+		state.m_releases.fill(0U);
+		state.m_events = 0U;
+		state.m_latency_ms = 0.0;
+
+		const Clock::time_point now = Clock::now();
+		for (const ActionEvent* event = m_queue.front(); event && event->timestamp <= until; event = m_queue.front())
+		{
+			const size_t index = ActionState::index(event->action);
+			state.m_held[index] = event->pressed;
+			++(event->pressed ? state.m_presses[index] : state.m_releases[index]);
+
+			state.m_latency_ms = std::max(state.m_latency_ms, std::chrono::duration<double, std::milli>(now - event->timestamp).count());
+			++state.m_events;
+
+			m_queue.pop();
+		}
+	}
+
+	void InputController::shutdown()
+	{
+		LOG_INFO("Shutting down input controller");
+
+		entry::setEventObserver(nullptr, nullptr);
+		clearBindings();
+	}
+
 
+	InputController::ActionState::ActionState()
+		:
+		m_held(),
+		m_presses(),
+		m_releases(),
+		m_events(0U),
+		m_latency_ms(0.0)
+	{
+	}
 }
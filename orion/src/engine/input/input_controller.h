@@ -1,9 +1,127 @@
 #pragma once
 
+#include <stdint.h>
+#include <array>
+#include <vector>
+#include <chrono>
+#include "entry/entry.h"
+#include "../../util/result_code.h"
+#include "../../util/spsc_queue.h"
+#include "input_action.h"
+
 namespace Orion
 {
+	// Maps entry events to actions as they are processed, and queues each action event with the time at which it
+	// arrived.  Events are mapped on the thread processing entry events and consumed on any one other thread (or the
+	// same thread), which samples the queue into its own action state at whatever rate it runs
 	class InputController
 	{
+	public:
+
+		typedef std::chrono::steady_clock Clock;
+
+		static const size_t QUEUE_CAPACITY = 1024U;
+		static const size_t ACTION_COUNT = static_cast<size_t>(InputAction::Count);
+
+		struct ActionBinding
+		{
+			enum class Source : uint8_t
+			{
+				Key,				// code is an entry::Key::Enum
+				MouseButton,		// code is an entry::MouseButton::Enum
+				MouseWheel,			// code is +1 for wheel up, or -1 for wheel down
+				Modifier			// code is an entry::Modifier mask, any of which will activate the action
+			};
+
+			Source			source;
+			int32_t			code;
+			uint8_t			modifiers;			// Modifiers required for the action to activate, if any
+			InputAction		action;
+		};
+
+		struct ActionEvent
+		{
+			InputAction			action;
+			bool				pressed;			// False on release
+			Clock::time_point	timestamp;
+		};
+
+		// State of all actions as seen by one consumer
+		class ActionState
+		{
+		public:
+
+			ActionState();
+
+			inline bool isHeld(InputAction action) const { return m_held[index(action)]; }
+
+			// Presses and releases consumed in the last sample
+			inline uint32_t getPressCount(InputAction action) const { return m_presses[index(action)]; }
+			inline bool wasPressed(InputAction action) const { return m_presses[index(action)] != 0U; }
+			inline bool wasReleased(InputAction action) const { return m_releases[index(action)] != 0U; }
+
+			inline size_t getEventCount() const { return m_events; }
+
+			// Greatest delay between the arrival of an event and its consumption, in the last sample
+			inline double getLatencyMs() const { return m_latency_ms; }
+
+		private:
+
+			friend class InputController;
+
+			static inline size_t index(InputAction action) { return static_cast<size_t>(action); }
+
+		private:
+
+			std::array<bool, ACTION_COUNT>			m_held;
+			std::array<uint32_t, ACTION_COUNT>		m_presses;
+			std::array<uint32_t, ACTION_COUNT>		m_releases;
+			size_t									m_events;
+			double									m_latency_ms;
+		};
+
+		struct Stats
+		{
+			size_t		events;					// Entry events observed
+			size_t		actions;				// Action events queued
+			size_t		dropped;				// Action events lost to a full queue
+		};
+
+		InputController();
+
+		// Begins observing entry events; bindings may then only be changed from the thread processing events
+		ResultCode initialise();
+
+		void bind(const ActionBinding& binding);
+		void clearBindings();
+
+		// Consumes all action events which arrived up to the given time, leaving later events queued for the next
+		// sample.  Must only be called from a single consuming thread
+		void sample(ActionState& state, Clock::time_point until = Clock::now());
+
+		// Owned by the thread processing events
+		inline Stats getStats() const { return m_stats; }
+
+		void shutdown();
+
+	private:
+
+		static void observeEvent(const entry::Event& event, void* controller);
+		void processEvent(const entry::Event& event);
+
+		void updateModifiers(uint8_t modifiers, Clock::time_point timestamp);
+		void setBindingActive(size_t binding, bool active, Clock::time_point timestamp);
+		void queueAction(InputAction action, bool pressed, Clock::time_point timestamp);
+
+	private:
+
+		std::vector<ActionBinding>							m_bindings;
+		std::vector<bool>									m_active;			// Indexed by binding
+		uint8_t												m_modifiers;
+		int32_t												m_wheel;
+
+		SpscQueue<ActionEvent, QUEUE_CAPACITY>				m_queue;
 
+		Stats												m_stats;
 	};
 }
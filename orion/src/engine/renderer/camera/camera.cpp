@@ -16,6 +16,8 @@ namespace Orion
 		m_topdown_pos({ 0.0f, 0.0f }),
 		m_topdown_height(200.0f)
 	{
+		bx::mtxIdentity(m_view);
+		bx::mtxIdentity(m_proj);
 	}
 
 	ResultCode Camera::initialise()
@@ -27,16 +29,22 @@ namespace Orion
 
 	ResultCode Camera::beginFrame(const RendererInputState& state)
 	{
-        float view[16], proj[16];
-
-        // Set view and projection matrices, and default viewport, for the primary view
-        calculateCameraTransforms(view, proj, state);
-		bgfx::setViewTransform(0, view, proj);
-		bgfx::setViewRect(0, 0, 0, uint16_t(state.width), uint16_t(state.height));
+        // View and projection matrices are applied to the views of any passes rendering from the camera
+        calculateCameraTransforms(m_view, m_proj, state);
 
 		return ResultCodes::Success;
 	}
 
+	void Camera::applyViewTransform(bgfx::ViewId view) const
+	{
+		bgfx::setViewTransform(view, m_view, m_proj);
+	}
+
+	void Camera::getViewProjection(float* outViewProj) const
+	{
+		bx::mtxMul(outViewProj, m_view, m_proj);
+	}
+
 	ResultCode Camera::executeFrame(const RendererInputState& state)
 	{
 		(void)state;
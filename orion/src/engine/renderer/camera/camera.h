@@ -3,6 +3,7 @@
 #include "../../../util/result_code.h"
 #include "../../../math/vec2.h"
 #include "camera_mode.h"
+#include "bgfx_utils.h"
 struct RendererInputState;
 
 namespace Orion
@@ -38,6 +39,10 @@ namespace Orion
 		void setTopDownCameraHeight(float height);
 		void adjustTopDownCameraHeight(float delta);
 
+		// Applies the transforms calculated for the current frame to a view
+		void applyViewTransform(bgfx::ViewId view) const;
+		void getViewProjection(float* outViewProj) const;
+
 		void shutdown();
 
 	private:
@@ -55,5 +60,8 @@ namespace Orion
 
 		Vec2<float> m_topdown_pos;
 		float m_topdown_height;
+
+		float m_view[16];
+		float m_proj[16];
 	};
 }
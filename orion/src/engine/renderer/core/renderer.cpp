@@ -7,12 +7,21 @@ namespace Orion
 {
 	Renderer::Renderer()
 		:
+		m_workers(),
+		m_file_watcher(),
 		m_shaders(),
 		m_geometry(),
 		m_textures(),
+		m_lighting(),
+		m_particles(),
+		m_text(),
+		m_debug_draw(),
 		m_gui(),
 		m_camera(),
 		m_queues(),
+		m_graph(),
+		m_world_view(0U),
+		m_graph_generation(0U),
 		m_renderStats()
 	{	
 	}
@@ -41,40 +50,69 @@ namespace Orion
 		// Set debug levels
 		bgfx::setDebug(debug);
 
-		// Set view 0 clear state.
-		bgfx::setViewClear(0
-			, BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH
-			, 0x303030ff
-			, 1.0f
-			, 0
-		);
-
 		// Initialise renderer components
+		RETURN_ON_ERROR(initialiseWorkerPool());
+		RETURN_ON_ERROR(initialiseFileWatcher());
 		RETURN_ON_ERROR(initialiseShaderManager());
 		RETURN_ON_ERROR(initialiseGeometryManger());
 		RETURN_ON_ERROR(initialiseTextureManager());
+		RETURN_ON_ERROR(initialiseLightingManager());
+		RETURN_ON_ERROR(initialiseParticleManager());
+		RETURN_ON_ERROR(initialiseTextManager());
+		RETURN_ON_ERROR(initialiseDebugDrawManager());
 		RETURN_ON_ERROR(initialiseGuiManger());
 		RETURN_ON_ERROR(initialiseCamera());
 		RETURN_ON_ERROR(initialiseRenderQueues());
 		RETURN_ON_ERROR(initialiseRenderStats());
+		RETURN_ON_ERROR(initialiseRenderGraph(width, height));
 
 		return ResultCodes::Success;
 	}
 
 
+	ResultCode Renderer::initialiseWorkerPool()
+	{
+		return m_workers.initialise();
+	}
+
+	ResultCode Renderer::initialiseFileWatcher()
+	{
+		return m_file_watcher.initialise();
+	}
+
 	ResultCode Renderer::initialiseShaderManager()
 	{
-		return m_shaders.initialise();
+		return m_shaders.initialise(m_workers, m_file_watcher);
 	}
 
 	ResultCode Renderer::initialiseGeometryManger()
 	{
-		return m_geometry.initialise();
+		return m_geometry.initialise(m_workers);
 	}
 
 	ResultCode Renderer::initialiseTextureManager()
 	{
-		return m_textures.initialise();
+		return m_textures.initialise(m_workers, m_file_watcher);
+	}
+
+	ResultCode Renderer::initialiseLightingManager()
+	{
+		return m_lighting.initialise(m_shaders);
+	}
+
+	ResultCode Renderer::initialiseParticleManager()
+	{
+		return m_particles.initialise(m_workers, m_shaders, m_geometry);
+	}
+
+	ResultCode Renderer::initialiseTextManager()
+	{
+		return m_text.initialise(m_workers, m_shaders);
+	}
+
+	ResultCode Renderer::initialiseDebugDrawManager()
+	{
+		return m_debug_draw.initialise(m_workers);
 	}
 
 	ResultCode Renderer::initialiseGuiManger()
@@ -97,6 +135,40 @@ namespace Orion
         return m_renderStats.initialise();
     }
 
+	ResultCode Renderer::initialiseRenderGraph(uint32_t width, uint32_t height)
+	{
+		RETURN_ON_ERROR(m_graph.initialise(width, height));
+
+		// World geometry is rendered from the camera, then debug overlays, screen text and the GUI are drawn over it
+		m_graph.addPass("world", [this](bgfx::ViewId view, const RendererInputState& state) { return renderWorld(view, state); })
+			.writes(RenderGraph::BACKBUFFER)
+			.clears(BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0x303030ff, 1.0f);
+
+		m_graph.addPass("debug", [this](bgfx::ViewId view, const RendererInputState&) { return renderDebugDraw(view); })
+			.writes(RenderGraph::BACKBUFFER);
+
+		m_graph.addPass("text", [this](bgfx::ViewId view, const RendererInputState& state) { m_text.renderScreenText(view, state); return ResultCodes::Success; })
+			.writes(RenderGraph::BACKBUFFER);
+
+		// GUI draw lists are submitted by the GUI manager at the end of the frame, to the view assigned to this pass
+		m_graph.addPass("gui", [](bgfx::ViewId, const RendererInputState&) { return ResultCodes::Success; })
+			.writes(RenderGraph::BACKBUFFER);
+
+		// Compiled immediately so that views are assigned for any immediate submissions before the first frame
+		RETURN_ON_ERROR(m_graph.compile());
+		updateViewIds();
+
+		return ResultCodes::Success;
+	}
+
+	// View IDs are resolved by pass name only when the graph has been recompiled, rather than on every frame
+	void Renderer::updateViewIds()
+	{
+		m_world_view = m_graph.getViewId("world");
+		m_gui.setViewId(m_graph.getViewId("gui"));
+		m_graph_generation = m_graph.getGeneration();
+	}
+
 	ResultCode Renderer::frame(const RendererInputState& state)
 	{
 		// Pre-frame initialisation for all renderer components
@@ -116,16 +188,27 @@ namespace Orion
 	 
 	ResultCode Renderer::beginFrame(const RendererInputState& state)
 	{
+		// Resource changes are dispatched before components begin the frame, so that reloads can be swapped in
+		m_file_watcher.poll();
+
+		// Jobs requiring the main thread, such as resource creation, are run before any component uses their results
+		m_workers.runMainThreadTasks();
+
+		// Views are reassigned if the graph has changed or the backbuffer has been resized
+		RETURN_ON_ERROR(m_graph.beginFrame(state));
+		if (m_graph.getGeneration() != m_graph_generation) updateViewIds();
+
 		RETURN_ON_ERROR(m_shaders.beginFrame(state));
 		RETURN_ON_ERROR(m_geometry.beginFrame(state));
 		RETURN_ON_ERROR(m_textures.beginFrame(state));
+		RETURN_ON_ERROR(m_lighting.beginFrame(state));
+		RETURN_ON_ERROR(m_particles.beginFrame(state));
+		RETURN_ON_ERROR(m_text.beginFrame(state));
+		RETURN_ON_ERROR(m_debug_draw.beginFrame(state));
 		RETURN_ON_ERROR(m_gui.beginFrame(state));
 		RETURN_ON_ERROR(m_camera.beginFrame(state));
 		RETURN_ON_ERROR(m_renderStats.beginFrame(state));
 
-		// Ensures at least one draw call is submitted and backbuffer is therefore cleared between frames
-		bgfx::touch(0);
-
 		return ResultCodes::Success;
 	}
 
@@ -134,6 +217,10 @@ namespace Orion
 		RETURN_ON_ERROR(m_shaders.executeFrame(state));
 		RETURN_ON_ERROR(m_geometry.executeFrame(state));
 		RETURN_ON_ERROR(m_textures.executeFrame(state));
+		RETURN_ON_ERROR(m_lighting.executeFrame(state));
+		RETURN_ON_ERROR(m_particles.executeFrame(state));
+		RETURN_ON_ERROR(m_text.executeFrame(state));
+		RETURN_ON_ERROR(m_debug_draw.executeFrame(state));
 		RETURN_ON_ERROR(m_gui.executeFrame(state));
 		RETURN_ON_ERROR(m_camera.executeFrame(state));
 		RETURN_ON_ERROR(m_renderStats.executeFrame(state));
@@ -152,6 +239,10 @@ namespace Orion
 		RETURN_ON_ERROR(m_shaders.endFrame(state));
 		RETURN_ON_ERROR(m_geometry.endFrame(state));
 		RETURN_ON_ERROR(m_textures.endFrame(state));
+		RETURN_ON_ERROR(m_lighting.endFrame(state));
+		RETURN_ON_ERROR(m_particles.endFrame(state));
+		RETURN_ON_ERROR(m_text.endFrame(state));
+		RETURN_ON_ERROR(m_debug_draw.endFrame(state));
 		RETURN_ON_ERROR(m_gui.endFrame(state));
 		RETURN_ON_ERROR(m_camera.endFrame(state));
 		RETURN_ON_ERROR(m_renderStats.endFrame(state));
@@ -161,8 +252,8 @@ namespace Orion
 
 	ResultCode Renderer::render(const RendererInputState& state)
 	{
-        // Process all renderer queues and submit geometry
-        RETURN_ON_ERROR(processRenderQueues(state));
+        // Execute each pass of the render graph; render queues are processed by the world pass
+        RETURN_ON_ERROR(m_graph.execute(state));
 
         // Reset and clean up render queues
         RETURN_ON_ERROR(resetRenderQueues());
@@ -170,41 +261,128 @@ namespace Orion
         return ResultCodes::Success;
 	}
 
-	ResultCode Renderer::processRenderQueues(const RendererInputState& state)
+	ResultCode Renderer::renderWorld(bgfx::ViewId view, const RendererInputState& state)
 	{
+		m_camera.applyViewTransform(view);
+
+		// Light lists are built for the current view before any lit geometry is submitted
+		RETURN_ON_ERROR(m_lighting.cullLights(m_camera, calculatePixelsPerUnit(state), state));
+
+		// Particle instances are written for the current view, so that blended particles can be sorted against it
+		m_particles.submit(m_queues.particles(), m_camera);
+
+		RETURN_ON_ERROR(processRenderQueues(view, state));
+
+		// Labels are blended over all world geometry
+		m_text.renderLabels(view);
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode Renderer::renderDebugDraw(bgfx::ViewId view)
+	{
+		if (!m_debug_draw.isEnabled()) return ResultCodes::Success;
+
+		m_camera.applyViewTransform(view);
+		m_debug_draw.render(view);
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode Renderer::processRenderQueues(bgfx::ViewId view, const RendererInputState& state)
+	{
+        // Mesh LODs are selected per slot from the projected size of each mesh at the current camera height
+        const float pixels_per_unit = calculatePixelsPerUnit(state);
+
         // Process each render queue
-        RETURN_ON_ERROR(processRenderQueue(m_queues.primary(), state));
+        RETURN_ON_ERROR(processRenderQueue(m_queues.primary(), view, pixels_per_unit));
+        RETURN_ON_ERROR(processRenderQueue(m_queues.atlas(), view, pixels_per_unit));
+        RETURN_ON_ERROR(processRenderQueue(m_queues.particles(), view, pixels_per_unit));
 
         return ResultCodes::Success;
 	}
 
+	float Renderer::calculatePixelsPerUnit(const RendererInputState& state) const
+	{
+		// Geometry lies on the ground plane below the top-down camera, so all instances are at the camera height
+		const float view_height = 2.0f * m_camera.getTopDownCameraHeight() * std::tan(bx::toRad(m_camera.getFov()) * 0.5f);
+		return (view_height > 0.0f ? float(state.height) / view_height : 0.0f);
+	}
+
 	ResultCode Renderer::resetRenderQueues()
 	{
 		// Proces each render queue
         RETURN_ON_ERROR(resetRenderQueue(m_queues.primary()));
+        RETURN_ON_ERROR(resetRenderQueue(m_queues.atlas()));
+        RETURN_ON_ERROR(resetRenderQueue(m_queues.particles()));
 
         return ResultCodes::Success;
 	}
 
-	void Renderer::submitWithRenderConfig(const RenderConfig& config)
+	void Renderer::submitWithRenderConfig(bgfx::ViewId view, const RenderConfig& config, const BasicMesh& mesh)
 	{
-		bgfx::setVertexBuffer(0, config.get_vertex_buffer());
-		bgfx::setIndexBuffer(config.get_index_buffer());
+		// Meshes are ranges within shared buffers; indices are relative to the base vertex
+		bgfx::setVertexBuffer(0, mesh.vertex_buffer, mesh.base_vertex, mesh.vertex_count);
+		bgfx::setIndexBuffer(mesh.index_buffer, mesh.first_index, mesh.index_count);
 		bgfx::setState(config.get_state());
 
 		const auto textures = config.get_textures().data();
 		for (uint8_t i = 0, texture_count = config.get_textures().get_texture_count(); i < texture_count; ++i)
 		{
-			bgfx::setTexture(0, textures[i].uniform, textures[i].texture);
+			bgfx::setTexture(i, textures[i].uniform, textures[i].texture);
 		}
 
-		bgfx::submit(0, config.get_shader());
+		if (config.get_uniforms() == RenderConfig::Uniforms::Lighting) m_lighting.applyUniforms();
+
+		bgfx::submit(view, config.get_shader());
 	}
 
     void Renderer::renderDebugInfo()
     {
         bgfx::dbgTextPrintf(0, 0, 0x0f, "FPS: %.1f", m_renderStats.getFps());
 		bgfx::dbgTextPrintf(0, 1, 0x0f, "Pos: %s @ %.1f", m_camera.getTopDownCameraPos().str().c_str(), m_camera.getTopDownCameraHeight());
+
+		const auto textures = m_textures.getLoadStats();
+		bgfx::dbgTextPrintf(0, 2, 0x0f, "Textures: %zu/%zu loaded (%zu decoding, %zu awaiting upload, %zu failed), latency %.1fms mean / %.1fms max",
+			textures.uploaded, textures.requested, textures.decoding, textures.awaiting_upload, textures.failed, textures.mean_latency_ms, textures.max_latency_ms);
+		bgfx::dbgTextPrintf(0, 3, 0x0f, "Streaming: %zu textures, %.1f/%.1f MB resident, %zu loads in progress",
+			textures.streamed_textures, double(textures.streamed_resident_bytes) / (1024.0 * 1024.0), double(m_textures.getStreamingBudget()) / (1024.0 * 1024.0), textures.streaming_loads);
+
+		const auto geometry = m_geometry.getBufferStats();
+		bgfx::dbgTextPrintf(0, 4, 0x0f, "Geometry: %zu vertices in %zu vertex pages, %zu indices in %zu index pages",
+			geometry.vertices, geometry.vertex_pages, geometry.indices, geometry.index_pages);
+
+		const auto graph = m_graph.getStats();
+		bgfx::dbgTextPrintf(0, 5, 0x0f, "Render graph: %zu/%zu passes, %zu targets in %zu textures",
+			graph.live_passes, graph.declared_passes, graph.live_targets, graph.physical_targets);
+
+		const auto lighting = m_lighting.getStats();
+		bgfx::dbgTextPrintf(0, 6, 0x0f, "Lighting: %zu/%zu lights visible, max %zu per tile, %zu dropped",
+			lighting.visible_lights, lighting.lights, lighting.max_tile_lights, lighting.dropped);
+
+		const auto particles = m_particles.getStats();
+		bgfx::dbgTextPrintf(0, 7, 0x0f, "Particles: %zu in %zu emitters, %zu sorted, %zu dropped",
+			particles.particles, particles.emitters, particles.sorted, particles.dropped);
+
+		const auto text = m_text.getStats();
+		bgfx::dbgTextPrintf(0, 8, 0x0f, "Text: %zu labels, %zu glyphs in %zu pages, %zu laid out, %zu pages updated",
+			text.labels, text.glyphs, text.pages, text.layouts, text.updated_pages);
+
+		const auto gui = m_gui.getStats();
+		bgfx::dbgTextPrintf(0, 9, 0x0f, "GUI: %zu draw lists, %zu reused, %zu uploaded (%.1f KB)",
+			gui.draw_lists, gui.reused, gui.uploaded, double(gui.uploaded_bytes) / 1024.0);
+
+		if (m_debug_draw.isEnabled())
+		{
+			const auto debug_draw = m_debug_draw.getStats();
+			const auto& trees = debug_draw.quadtrees;
+			bgfx::dbgTextPrintf(0, 10, 0x0f, "Debug draw: %zu line and %zu triangle vertices in %zu draws",
+				debug_draw.line_vertices, debug_draw.triangle_vertices, debug_draw.draws);
+			bgfx::dbgTextPrintf(0, 11, 0x0f, "Quadtrees: %zu nodes, %zu leaves (%zu empty, %zu full), depth %zu, %.1f items/leaf, %zu queries visiting %zu nodes, %.1f%% hit rate",
+				trees.nodes, trees.leaves, trees.empty_leaves, trees.full_leaves, trees.max_depth,
+				(trees.leaves != 0U ? double(trees.items) / double(trees.leaves) : 0.0), trees.queries, trees.nodes_visited,
+				(trees.items_tested != 0U ? 100.0 * double(trees.items_found) / double(trees.items_tested) : 0.0));
+		}
     }
 
 	void Renderer::shutdown()
@@ -214,10 +392,17 @@ namespace Orion
 		shutdownShaderManager();
 		shutdownGeometryManger();
 		shutdownTextureManager();
+		shutdownLightingManager();
+		shutdownParticleManager();
+		shutdownTextManager();
+		shutdownDebugDrawManager();
 		shutdownGuiManger();
 		shutdownCamera();
 		shutdownRenderQueues();
         shutdownRenderStats();
+		shutdownRenderGraph();
+		shutdownFileWatcher();
+		shutdownWorkerPool();
 
 		LOG_INFO("Shutting down core render libraries");
 		bgfx::shutdown();
@@ -225,7 +410,8 @@ namespace Orion
 
 	void Renderer::submitImmediate(const RenderConfig& config)
 	{
-		submitWithRenderConfig(config);
+		// Immediate submissions are rendered by the world pass
+		submitWithRenderConfig(m_world_view, config, config.get_mesh());
 	}
 
 	void Renderer::submitImmediate(const RenderConfig& config, float transform[16])
@@ -235,6 +421,16 @@ namespace Orion
 	}
 
 
+	void Renderer::shutdownWorkerPool()
+	{
+		m_workers.shutdown();
+	}
+
+	void Renderer::shutdownFileWatcher()
+	{
+		m_file_watcher.shutdown();
+	}
+
     void Renderer::shutdownShaderManager()
 	{
 		m_shaders.shutdown();
@@ -250,6 +446,26 @@ namespace Orion
 		m_textures.shutdown();
 	}
 
+	void Renderer::shutdownLightingManager()
+	{
+		m_lighting.shutdown();
+	}
+
+	void Renderer::shutdownParticleManager()
+	{
+		m_particles.shutdown();
+	}
+
+	void Renderer::shutdownTextManager()
+	{
+		m_text.shutdown();
+	}
+
+	void Renderer::shutdownDebugDrawManager()
+	{
+		m_debug_draw.shutdown();
+	}
+
 	void Renderer::shutdownGuiManger()
 	{
 		m_gui.shutdown();
@@ -269,4 +485,9 @@ namespace Orion
     {
         m_renderStats.shutdown();
     }
+
+	void Renderer::shutdownRenderGraph()
+	{
+		m_graph.shutdown();
+	}
 }
@@ -2,6 +2,8 @@
 
 #include <stdint.h>
 #include <array>
+#include <cmath>
+#include <algorithm>
 #include "../../../util/result_code.h"
 #include "../../../math/vec2.h"
 #include "../shader/shader_manager.h"
@@ -9,9 +11,16 @@
 #include "../queue/render_queues.h"
 #include "../queue/render_queue.h"
 #include "../texture/texture_manager.h"
+#include "../lighting/lighting_manager.h"
+#include "../particles/particle_manager.h"
+#include "../text/text_manager.h"
 #include "../gui/gui_manager.h"
 #include "../camera/camera.h"
+#include "../graph/render_graph.h"
 #include "../debug/render_stats.h"
+#include "../debug/debug_draw_manager.h"
+#include "../../../util/thread_pool.h"
+#include "../../../util/file_watcher.h"
 struct RendererInputState;
 struct Args;
 
@@ -30,14 +39,26 @@ namespace Orion
 		inline ShaderManager& getShaderManager() { return m_shaders; }
 		inline GeometryManager& getGeometryManager() { return m_geometry; }
 		inline TextureManager& getTextureManager() { return m_textures; }
+		inline LightingManager& getLightingManager() { return m_lighting; }
+		inline ParticleManager& getParticleManager() { return m_particles; }
+		inline TextManager& getTextManager() { return m_text; }
+		inline DebugDrawManager& getDebugDrawManager() { return m_debug_draw; }
 		inline GuiManager& getGuiManager() { return m_gui; }
 		inline Camera& getCamera() { return m_camera; }
+		inline RenderGraph& getRenderGraph() { return m_graph; }
+		inline ThreadPool& getWorkerPool() { return m_workers; }
+		inline FileWatcher& getFileWatcher() { return m_file_watcher; }
 		
 		const inline ShaderManager& getShaderManager() const { return m_shaders; }
 		const inline GeometryManager& getGeometryManager() const { return m_geometry; }
 		const inline TextureManager& getTextureManager() const { return m_textures; }
+		const inline LightingManager& getLightingManager() const { return m_lighting; }
+		const inline ParticleManager& getParticleManager() const { return m_particles; }
+		const inline TextManager& getTextManager() const { return m_text; }
+		const inline DebugDrawManager& getDebugDrawManager() const { return m_debug_draw; }
 		const inline GuiManager& getGuiManager() const { return m_gui; }
 		const inline Camera& getCamera() const { return m_camera; }
+		const inline RenderGraph& getRenderGraph() const { return m_graph; }
 
 		inline RenderQueues& queue() { return m_queues; }
 		const inline RenderQueues& queue() const { return m_queues; }
@@ -53,13 +74,20 @@ namespace Orion
 
 	private:
 
+		ResultCode initialiseWorkerPool();
+		ResultCode initialiseFileWatcher();
 		ResultCode initialiseShaderManager();
 		ResultCode initialiseGeometryManger();
 		ResultCode initialiseTextureManager();
+		ResultCode initialiseLightingManager();
+		ResultCode initialiseParticleManager();
+		ResultCode initialiseTextManager();
+		ResultCode initialiseDebugDrawManager();
 		ResultCode initialiseGuiManger();
 		ResultCode initialiseCamera();
 		ResultCode initialiseRenderQueues();
 		ResultCode initialiseRenderStats();
+		ResultCode initialiseRenderGraph(uint32_t width, uint32_t height);
 
 		ResultCode beginFrame(const RendererInputState& state);
 		ResultCode executeFrame(const RendererInputState& state);
@@ -67,10 +95,17 @@ namespace Orion
 
 		ResultCode render(const RendererInputState& state);
 
-		ResultCode processRenderQueues(const RendererInputState& state);
+		void updateViewIds();
+
+		ResultCode renderWorld(bgfx::ViewId view, const RendererInputState& state);
+		ResultCode renderDebugDraw(bgfx::ViewId view);
+		ResultCode processRenderQueues(bgfx::ViewId view, const RendererInputState& state);
+		template <typename T>
+		ResultCode processRenderQueue(const RenderQueue<T>& queue, bgfx::ViewId view, float pixels_per_unit);
 		template <typename T>
-		ResultCode processRenderQueue(const RenderQueue<T>& queue, const RendererInputState& state);
-		void submitWithRenderConfig(const RenderConfig& config);
+		static float calculateMaxInstanceScale(const std::vector<T>& instances);
+		float calculatePixelsPerUnit(const RendererInputState& state) const;
+		void submitWithRenderConfig(bgfx::ViewId view, const RenderConfig& config, const BasicMesh& mesh);
 
 		ResultCode resetRenderQueues();
 		template <typename T>
@@ -78,31 +113,46 @@ namespace Orion
 
 		void renderDebugInfo();
 
+		void shutdownWorkerPool();
+		void shutdownFileWatcher();
 		void shutdownShaderManager();
 		void shutdownGeometryManger();
 		void shutdownTextureManager();
+		void shutdownLightingManager();
+		void shutdownParticleManager();
+		void shutdownTextManager();
+		void shutdownDebugDrawManager();
 		void shutdownGuiManger();
 		void shutdownCamera();
 		void shutdownRenderQueues();
 		void shutdownRenderStats();
+		void shutdownRenderGraph();
 
 
 	private:
+		ThreadPool m_workers;			// Shared by renderer components for background resource work
+		FileWatcher m_file_watcher;		// Detects modified resources for hot reload; polled at the start of each frame
 		ShaderManager m_shaders;
 		GeometryManager m_geometry;
 		TextureManager m_textures;
+		LightingManager m_lighting;
+		ParticleManager m_particles;
+		TextManager m_text;
+		DebugDrawManager m_debug_draw;
 		GuiManager m_gui;
 		Camera m_camera;
 		RenderQueues m_queues;
+		RenderGraph m_graph;			// Assigns the bgfx view, framebuffer and clear state of each render pass
+		bgfx::ViewId m_world_view;
+		uint32_t m_graph_generation;	// Generation of the render graph when view IDs were last resolved
 
 		RenderStats m_renderStats;
 
 
 	};
 	template<typename T>
-	inline ResultCode Renderer::processRenderQueue(const RenderQueue<T>& queue, const RendererInputState& state)
+	inline ResultCode Renderer::processRenderQueue(const RenderQueue<T>& queue, bgfx::ViewId view, float pixels_per_unit)
 	{
-		(void)state;	// Current unused
 		bgfx::InstanceDataBuffer instanceBuffer;
 
 		for (const RenderSlot<T>& slot : queue.getSlots())
@@ -125,13 +175,49 @@ namespace Orion
 			bx::mtxIdentity(id);
 			bgfx::setTransform(id);*/
 
+			// Select a mesh LOD for the slot, based on the instance with the largest projected size
+			const auto& config = slot.getConfig();
+			const auto& mesh = (m_geometry.hasLods(config.get_mesh())
+				? m_geometry.selectLod(config.get_mesh(), pixels_per_unit, calculateMaxInstanceScale(instances))
+				: config.get_mesh());
+
 			// Submit draw call
-			submitWithRenderConfig(slot.getConfig());
+			submitWithRenderConfig(view, config, mesh);
 		}
 
 		return ResultCodes::Success;
 	}
 
+	// Instance transforms are row-major with the basis vectors in the first three rows
+	template<typename T>
+	inline float Renderer::calculateMaxInstanceScale(const std::vector<T>& instances)
+	{
+		float max_scale_sq = 0.0f;
+		for (const T& instance : instances)
+		{
+			const float* m = instance.transform;
+			max_scale_sq = std::max({ max_scale_sq,
+				m[0] * m[0] + m[1] * m[1] + m[2] * m[2],
+				m[4] * m[4] + m[5] * m[5] + m[6] * m[6],
+				m[8] * m[8] + m[9] * m[9] + m[10] * m[10] });
+		}
+
+		return std::sqrt(max_scale_sq);
+	}
+
+	// Particle instances hold a radius rather than a transform
+	template<>
+	inline float Renderer::calculateMaxInstanceScale(const std::vector<ParticleInstanceData>& instances)
+	{
+		float max_radius = 0.0f;
+		for (const ParticleInstanceData& instance : instances)
+		{
+			max_radius = std::max(max_radius, instance.position_size[3]);
+		}
+
+		return max_radius;
+	}
+
 	template<typename T>
 	inline ResultCode Renderer::resetRenderQueue(RenderQueue<T>& queue)
 	{
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace Orion
+{
+	// Dense integer identifier for a renderer resource.  Resource names are resolved to an ID once, after which
+	// the resource is found by direct array index.  IDs are typed by resource kind so that an ID for one kind of
+	// resource cannot be used to look up another
+	template <typename Tag>
+	struct ResourceId
+	{
+		typedef uint16_t Index;
+		static const Index NONE = 0xFFFFU;
+
+		Index index;
+
+		constexpr ResourceId() : index(NONE) { }
+		constexpr explicit ResourceId(Index _index) : index(_index) { }
+
+		constexpr inline bool isNull() const { return index == NONE; }
+		constexpr inline explicit operator bool() const { return !isNull(); }
+
+		constexpr inline bool operator==(const ResourceId& other) const { return index == other.index; }
+		constexpr inline bool operator!=(const ResourceId& other) const { return index != other.index; }
+	};
+
+	typedef ResourceId<struct ProgramResourceTag>	ProgramId;
+	typedef ResourceId<struct UniformResourceTag>	UniformId;
+	typedef ResourceId<struct TextureResourceTag>	TextureId;
+	typedef ResourceId<struct MeshResourceTag>		MeshId;
+	typedef ResourceId<struct LightResourceTag>		LightId;
+	typedef ResourceId<struct EmitterResourceTag>	ParticleEmitterId;
+	typedef ResourceId<struct FontResourceTag>		FontId;
+	typedef ResourceId<struct LabelResourceTag>		TextLabelId;
+	typedef ResourceId<struct ScreenTextResourceTag>	ScreenTextId;
+
+
+	// Interned names for one kind of resource.  IDs are assigned densely in order of registration, so may be
+	// used directly to index per-resource tables held alongside
+	template <typename TId>
+	class ResourceNameTable
+	{
+	public:
+
+		// Returns a null ID if the name is already registered, or the table is full
+		TId add(const std::string& name);
+
+		TId find(const std::string& name) const;
+
+		inline const std::string& getName(TId id) const { return m_names[id.index]; }
+		inline size_t size() const { return m_names.size(); }
+
+		void clear();
+
+	private:
+
+		std::unordered_map<std::string, typename TId::Index>	m_ids;
+		std::vector<std::string>								m_names;
+	};
+
+
+	template <typename TId>
+	inline TId ResourceNameTable<TId>::add(const std::string& name)
+	{
+		if (m_names.size() >= TId::NONE || m_ids.find(name) != m_ids.end()) return TId();
+
+		const auto index = static_cast<typename TId::Index>(m_names.size());
+		m_ids[name] = index;
+		m_names.push_back(name);
+
+		return TId(index);
+	}
+
+	template <typename TId>
+	inline TId ResourceNameTable<TId>::find(const std::string& name) const
+	{
+		const auto it = m_ids.find(name);
+		return (it != m_ids.end() ? TId(it->second) : TId());
+	}
+
+	template <typename TId>
+	inline void ResourceNameTable<TId>::clear()
+	{
+		m_ids.clear();
+		m_names.clear();
+	}
+}
@@ -0,0 +1,316 @@
+#include "../../../util/log.h"
+#include "../core/renderer_input_state.h"
+
+#include "debug_draw_manager.h"
+
+namespace Orion
+{
+	// Paths and bounds are built together, in blocks of this many segments or boxes per worker task
+	static const size_t PRIMITIVE_TASK_SIZE = 1024U;
+
+	DebugDrawManager::DebugDrawManager()
+		:
+		m_workers(nullptr),
+		m_enabled(false),
+		m_jobs(),
+		m_path_points(),
+		m_paths(),
+		m_bounds(),
+		m_quadtree_stats(),
+		m_tasks(),
+		m_task_geometry(),
+		m_batches(),
+		m_batch_count(0U),
+		m_stats({ 0U, 0U, 0U, { 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U } })
+	{
+	}
+
+	ResultCode DebugDrawManager::initialise(ThreadPool& workers)
+	{
+		LOG_INFO("Initialising debug draw manager");
+
+		m_workers = &workers;
+		ddInit();
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode DebugDrawManager::beginFrame(const RendererInputState& state)
+	{
+		(void)state;
+		return ResultCodes::Success;
+	}
+
+	ResultCode DebugDrawManager::executeFrame(const RendererInputState& state)
+	{
+		(void)state;
+
+		m_batch_count = 0U;
+		if (m_enabled) buildGeometry();
+
+		// Requests only apply to the frame in which they are made
+		m_jobs.clear();
+		m_path_points.clear();
+		m_paths.clear();
+		m_bounds.clear();
+		m_quadtree_stats.clear();
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode DebugDrawManager::endFrame(const RendererInputState& state)
+	{
+		(void)state;
+		return ResultCodes::Success;
+	}
+
+	void DebugDrawManager::addPath(const std::vector<Vec2<float>>& points, uint32_t colour)
+	{
+		if (!m_enabled || points.size() < 2U) return;
+
+		m_paths.push_back({ m_path_points.size(), points.size(), colour });
+		m_path_points.insert(m_path_points.end(), points.cbegin(), points.cend());
+	}
+
+	void DebugDrawManager::addBounds(Vec2<float> min_bounds, Vec2<float> max_bounds, uint32_t colour)
+	{
+		if (!m_enabled) return;
+
+		m_bounds.push_back({ min_bounds, max_bounds, colour });
+	}
+
+	void DebugDrawManager::addJob(size_t tasks, BuildTask&& build)
+	{
+		if (tasks == 0U) return;
+
+		m_jobs.push_back({ tasks, std::move(build) });
+	}
+
+	void DebugDrawManager::buildGeometry()
+	{
+		// Paths are split into blocks of segments, which may span more than one path
+		size_t segments = 0U;
+		for (const Path& path : m_paths) segments += (path.count - 1U);
+
+		addJob((segments + PRIMITIVE_TASK_SIZE - 1U) / PRIMITIVE_TASK_SIZE, [this](size_t task, Geometry& out)
+		{
+			size_t skip = task * PRIMITIVE_TASK_SIZE, remaining = PRIMITIVE_TASK_SIZE;
+			for (const Path& path : m_paths)
+			{
+				const size_t path_segments = path.count - 1U;
+				if (skip >= path_segments)
+				{
+					skip -= path_segments;
+					continue;
+				}
+
+				const size_t end = std::min(path_segments, skip + remaining);
+				for (size_t i = skip; i < end; ++i)
+				{
+					out.line(m_path_points[path.first + i], m_path_points[path.first + i + 1U], path.colour);
+				}
+
+				remaining -= (end - skip);
+				skip = 0U;
+				if (remaining == 0U) break;
+			}
+		});
+
+		const size_t bounds_count = m_bounds.size();
+		addJob((bounds_count + PRIMITIVE_TASK_SIZE - 1U) / PRIMITIVE_TASK_SIZE, [this, bounds_count](size_t task, Geometry& out)
+		{
+			const size_t end = std::min(bounds_count, (task + 1U) * PRIMITIVE_TASK_SIZE);
+			for (size_t i = task * PRIMITIVE_TASK_SIZE; i < end; ++i)
+			{
+				out.outline(m_bounds[i].min_bounds, m_bounds[i].max_bounds, m_bounds[i].colour);
+			}
+		});
+
+		// Every task of every job writes to its own geometry, so no synchronisation is required during the build
+		m_tasks.clear();
+		for (size_t job = 0U; job < m_jobs.size(); ++job)
+		{
+			for (size_t task = 0U; task < m_jobs[job].tasks; ++task) m_tasks.push_back({ job, task });
+		}
+
+		if (m_task_geometry.size() < m_tasks.size()) m_task_geometry.resize(m_tasks.size());
+		m_workers->parallelFor(m_tasks.size(), [this](size_t i)
+		{
+			Geometry& geometry = m_task_geometry[i];
+			geometry.clear();
+
+			m_jobs[m_tasks[i].first].build(m_tasks[i].second, geometry);
+		});
+
+		for (size_t i = 0U; i < m_tasks.size(); ++i) mergeGeometry(m_task_geometry[i]);
+
+		m_stats.line_vertices = 0U;
+		m_stats.triangle_vertices = 0U;
+		m_stats.draws = 0U;
+		for (size_t i = 0U; i < m_batch_count; ++i)
+		{
+			const Batch& batch = m_batches[i];
+			m_stats.line_vertices += batch.lines.size();
+			m_stats.triangle_vertices += batch.triangles.size();
+			m_stats.draws += (batch.lines.size() + MAX_BATCH_VERTICES - 1U) / MAX_BATCH_VERTICES;
+			m_stats.draws += (batch.triangles.size() + MAX_BATCH_VERTICES - 1U) / MAX_BATCH_VERTICES;
+		}
+
+		m_stats.quadtrees = { 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U };
+		for (const QuadtreeStats& tree : m_quadtree_stats)
+		{
+			auto& total = m_stats.quadtrees;
+			total.nodes += tree.nodes;
+			total.leaves += tree.leaves;
+			total.empty_leaves += tree.empty_leaves;
+			total.full_leaves += tree.full_leaves;
+			total.max_depth = std::max(total.max_depth, tree.max_depth);
+			total.items += tree.items;
+			total.queries += tree.queries;
+			total.nodes_visited += tree.nodes_visited;
+			total.items_tested += tree.items_tested;
+			total.items_found += tree.items_found;
+		}
+	}
+
+	// Geometry of the same colour from all tasks is combined, so that each colour is drawn with as few calls as possible
+	void DebugDrawManager::mergeGeometry(const Geometry& geometry)
+	{
+		for (const Batch& source : geometry.getBatches())
+		{
+			if (source.lines.empty() && source.triangles.empty()) continue;
+
+			size_t index = 0U;
+			while (index < m_batch_count && m_batches[index].colour != source.colour) ++index;
+
+			if (index == m_batch_count)
+			{
+				if (m_batch_count == m_batches.size()) m_batches.emplace_back();
+
+				Batch& batch = m_batches[m_batch_count++];
+				batch.colour = source.colour;
+				batch.lines.clear();
+				batch.triangles.clear();
+			}
+
+			Batch& target = m_batches[index];
+			target.lines.insert(target.lines.end(), source.lines.cbegin(), source.lines.cend());
+			target.triangles.insert(target.triangles.end(), source.triangles.cbegin(), source.triangles.cend());
+		}
+	}
+
+	void DebugDrawManager::render(bgfx::ViewId view)
+	{
+		if (!m_enabled || m_batch_count == 0U) return;
+
+		DebugDrawEncoder encoder;
+		encoder.begin(view);
+
+		// Overlays are tested against world geometry but never occlude one another
+		encoder.setState(true, false, true);
+
+		for (size_t i = 0U; i < m_batch_count; ++i)
+		{
+			const Batch& batch = m_batches[i];
+			encoder.setColor(batch.colour);
+
+			for (size_t offset = 0U; offset < batch.lines.size(); offset += MAX_BATCH_VERTICES)
+			{
+				const auto count = static_cast<uint32_t>(std::min<size_t>(MAX_BATCH_VERTICES, batch.lines.size() - offset));
+				encoder.drawLineList(count, batch.lines.data() + offset);
+			}
+
+			for (size_t offset = 0U; offset < batch.triangles.size(); offset += MAX_BATCH_VERTICES)
+			{
+				const auto count = static_cast<uint32_t>(std::min<size_t>(MAX_BATCH_VERTICES, batch.triangles.size() - offset));
+				encoder.drawTriList(count, batch.triangles.data() + offset);
+			}
+		}
+
+		encoder.end();
+	}
+
+	// Occupancy is quantised to a few steps from green (empty) to red (full), so that leaves share batches
+	uint32_t DebugDrawManager::occupancyColour(size_t items, size_t capacity)
+	{
+		static const uint32_t STEPS[5] = { 0xff00ff00U, 0xff00ff80U, 0xff00ffffU, 0xff0080ffU, 0xff0000ffU };
+		if (items == 0U) return 0xff606060U;
+
+		const size_t step = std::min<size_t>(4U, (items * 4U) / std::max<size_t>(capacity, 1U));
+		return STEPS[step];
+	}
+
+	void DebugDrawManager::shutdown()
+	{
+		LOG_INFO("Shutting down debug draw manager");
+
+		m_jobs.clear();
+		m_task_geometry.clear();
+		m_batches.clear();
+		m_batch_count = 0U;
+
+		ddShutdown();
+	}
+
+
+	void DebugDrawManager::Geometry::line(Vec2<float> from, Vec2<float> to, uint32_t colour)
+	{
+		auto& lines = batch(colour).lines;
+		lines.push_back({ from.x, from.y, OVERLAY_DEPTH });
+		lines.push_back({ to.x, to.y, OVERLAY_DEPTH });
+	}
+
+	void DebugDrawManager::Geometry::outline(Vec2<float> min_bounds, Vec2<float> max_bounds, uint32_t colour)
+	{
+		const DdVertex corners[4] = {
+			{ min_bounds.x, min_bounds.y, OVERLAY_DEPTH }, { max_bounds.x, min_bounds.y, OVERLAY_DEPTH },
+			{ max_bounds.x, max_bounds.y, OVERLAY_DEPTH }, { min_bounds.x, max_bounds.y, OVERLAY_DEPTH }
+		};
+
+		auto& lines = batch(colour).lines;
+		for (size_t i = 0U; i < 4U; ++i)
+		{
+			lines.push_back(corners[i]);
+			lines.push_back(corners[(i + 1U) & 3U]);
+		}
+	}
+
+	// The encoder always culls back faces, so fills are emitted with both windings to be visible from either side
+	void DebugDrawManager::Geometry::fill(Vec2<float> min_bounds, Vec2<float> max_bounds, uint32_t colour)
+	{
+		const DdVertex a = { min_bounds.x, min_bounds.y, OVERLAY_DEPTH }, b = { max_bounds.x, min_bounds.y, OVERLAY_DEPTH };
+		const DdVertex c = { max_bounds.x, max_bounds.y, OVERLAY_DEPTH }, d = { min_bounds.x, max_bounds.y, OVERLAY_DEPTH };
+		const DdVertex vertices[12] = { a, b, c, a, c, d, a, c, b, a, d, c };
+
+		auto& triangles = batch(colour).triangles;
+		triangles.insert(triangles.end(), std::begin(vertices), std::end(vertices));
+	}
+
+	void DebugDrawManager::Geometry::clear()
+	{
+		for (size_t i = 0U; i < m_count; ++i)
+		{
+			m_batches[i].lines.clear();
+			m_batches[i].triangles.clear();
+		}
+
+		m_count = 0U;
+	}
+
+	DebugDrawManager::Batch& DebugDrawManager::Geometry::batch(uint32_t colour)
+	{
+		// Consecutive primitives usually share a colour, so the most recent batch is checked first
+		if (m_count != 0U && m_batches[m_count - 1U].colour == colour) return m_batches[m_count - 1U];
+
+		for (size_t i = 0U; i < m_count; ++i)
+		{
+			if (m_batches[i].colour == colour) return m_batches[i];
+		}
+
+		if (m_count == m_batches.size()) m_batches.emplace_back();
+
+		Batch& batch = m_batches[m_count++];
+		batch.colour = colour;
+		return batch;
+	}
+}
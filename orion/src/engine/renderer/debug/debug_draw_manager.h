@@ -0,0 +1,241 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include "bgfx/bgfx.h"
+#include "debugdraw/debugdraw.h"
+#include "../../../util/result_code.h"
+#include "../../../util/thread_pool.h"
+#include "../../../math/vec2.h"
+#include "../../../grid/grid.h"
+#include "../../../grid/quadtree.h"
+struct RendererInputState;
+
+namespace Orion
+{
+	// Debug visualisation of spatial data over the world, drawn through the vendored debug draw encoder.  Primitives
+	// are requested each frame; their geometry is built on the worker pool and merged into one line list and one
+	// triangle list per colour, which are submitted through transient buffers.  While disabled, requests return
+	// immediately and nothing is built or drawn.  Structures passed by reference must remain valid and unmodified
+	// until the renderer has executed the frame
+	class DebugDrawManager
+	{
+	public:
+
+		// Vertices per draw, as a multiple of both line and triangle vertex counts
+		static const uint32_t MAX_BATCH_VERTICES = 65520U;
+
+		// Cells per worker task when building grid overlays
+		static const size_t GRID_TASK_CELLS = 4096U;
+
+		// Overlays are drawn in the ground plane, above all tile geometry
+		static constexpr float OVERLAY_DEPTH = 0.0f;
+
+		// Structure of all quadtrees drawn in the last frame, and the queries made against them
+		struct QuadtreeStats
+		{
+			size_t		nodes;
+			size_t		leaves;
+			size_t		empty_leaves;
+			size_t		full_leaves;			// Leaves at or beyond the item limit for subdivision
+			size_t		max_depth;
+			size_t		items;
+			size_t		queries;
+			size_t		nodes_visited;
+			size_t		items_tested;
+			size_t		items_found;
+		};
+
+		struct Stats
+		{
+			size_t			line_vertices;
+			size_t			triangle_vertices;
+			size_t			draws;
+			QuadtreeStats	quadtrees;
+		};
+
+		DebugDrawManager();
+
+		ResultCode initialise(ThreadPool& workers);
+
+		ResultCode beginFrame(const RendererInputState& state);
+		ResultCode executeFrame(const RendererInputState& state);
+		ResultCode endFrame(const RendererInputState& state);
+
+		inline void setEnabled(bool enabled) { m_enabled = enabled; }
+		inline bool isEnabled() const { return m_enabled; }
+
+		// Fills each cell of the grid with colour(value), in ABGR, or skips the cell if the colour is zero.  Cell (0,0)
+		// has its minimum corner at the origin
+		template <typename T, typename TCoord, typename TColourFn>
+		void addGrid(const Grid<T, TCoord>& grid, Vec2<float> origin, float cell_size, TColourFn colour);
+
+		// Outlines each leaf of the tree, coloured by its occupancy.  Query statistics, if provided, are included in
+		// the reported stats
+		template <typename T, typename TCoord>
+		void addQuadtree(const Quadtree<T, TCoord>& tree, const typename Quadtree<T, TCoord>::QueryStats * query_stats = nullptr);
+
+		void addPath(const std::vector<Vec2<float>>& points, uint32_t colour);
+		void addBounds(Vec2<float> min_bounds, Vec2<float> max_bounds, uint32_t colour);
+
+		// Submits all geometry built for this frame to a view using its current view transform
+		void render(bgfx::ViewId view);
+
+		inline Stats getStats() const { return m_stats; }
+
+		void shutdown();
+
+	private:
+
+		struct Batch
+		{
+			uint32_t				colour;
+			std::vector<DdVertex>	lines;
+			std::vector<DdVertex>	triangles;
+		};
+
+		// Geometry output of a single build task
+		class Geometry
+		{
+		public:
+
+			Geometry() : m_batches(), m_count(0U) { }
+
+			void line(Vec2<float> from, Vec2<float> to, uint32_t colour);
+			void outline(Vec2<float> min_bounds, Vec2<float> max_bounds, uint32_t colour);
+			void fill(Vec2<float> min_bounds, Vec2<float> max_bounds, uint32_t colour);
+
+			void clear();
+			inline const std::vector<Batch>& getBatches() const { return m_batches; }
+
+		private:
+
+			Batch& batch(uint32_t colour);
+
+		private:
+
+			std::vector<Batch>		m_batches;
+			size_t					m_count;			// Live batches; cleared batches are retained to avoid reallocation
+		};
+
+		typedef std::function<void(size_t, Geometry&)> BuildTask;
+
+		struct Job
+		{
+			size_t			tasks;
+			BuildTask		build;
+		};
+
+		struct Path
+		{
+			size_t			first;
+			size_t			count;
+			uint32_t		colour;
+		};
+
+		struct Bounds
+		{
+			Vec2<float>		min_bounds;
+			Vec2<float>		max_bounds;
+			uint32_t		colour;
+		};
+
+		void addJob(size_t tasks, BuildTask&& build);
+		void buildGeometry();
+		void mergeGeometry(const Geometry& geometry);
+
+		static uint32_t occupancyColour(size_t items, size_t capacity);
+
+	private:
+
+		ThreadPool *						m_workers;
+		bool								m_enabled;
+
+		// Requests for the current frame
+		std::vector<Job>					m_jobs;
+		std::vector<Vec2<float>>			m_path_points;
+		std::vector<Path>					m_paths;
+		std::vector<Bounds>					m_bounds;
+		std::vector<QuadtreeStats>			m_quadtree_stats;		// One per requested quadtree, written by its build task
+
+		// Built geometry, retained to avoid reallocation
+		std::vector<std::pair<size_t, size_t>>	m_tasks;			// Job and task index
+		std::vector<Geometry>				m_task_geometry;
+		std::vector<Batch>					m_batches;
+		size_t								m_batch_count;
+
+		Stats								m_stats;
+	};
+
+
+	template <typename T, typename TCoord, typename TColourFn>
+	void DebugDrawManager::addGrid(const Grid<T, TCoord>& grid, Vec2<float> origin, float cell_size, TColourFn colour)
+	{
+		if (!m_enabled) return;
+
+		// Grids are split into blocks of whole rows
+		const size_t width = static_cast<size_t>(grid.getSize().x);
+		const size_t height = static_cast<size_t>(grid.getSize().y);
+		const size_t rows_per_task = std::max<size_t>(1U, GRID_TASK_CELLS / width);
+		const Grid<T, TCoord>* source = &grid;
+
+		addJob((height + rows_per_task - 1U) / rows_per_task, [source, origin, cell_size, colour, width, height, rows_per_task](size_t task, Geometry& out)
+		{
+			const size_t end_row = std::min(height, (task + 1U) * rows_per_task);
+			for (size_t y = task * rows_per_task; y < end_row; ++y)
+			{
+				const T* row = source->data() + (y * width);
+				for (size_t x = 0U; x < width; ++x)
+				{
+					const uint32_t cell_colour = colour(row[x]);
+					if (cell_colour == 0U) continue;
+
+					const Vec2<float> cell_min(origin.x + (float(x) * cell_size), origin.y + (float(y) * cell_size));
+					out.fill(cell_min, cell_min + Vec2<float>(cell_size, cell_size), cell_colour);
+				}
+			}
+		});
+	}
+
+	template <typename T, typename TCoord>
+	void DebugDrawManager::addQuadtree(const Quadtree<T, TCoord>& tree, const typename Quadtree<T, TCoord>::QueryStats * query_stats)
+	{
+		if (!m_enabled) return;
+
+		const size_t slot = m_quadtree_stats.size();
+		m_quadtree_stats.push_back({ 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U });
+		if (query_stats)
+		{
+			auto& stats = m_quadtree_stats.back();
+			stats.queries = query_stats->queries;
+			stats.nodes_visited = query_stats->nodes_visited;
+			stats.items_tested = query_stats->items_tested;
+			stats.items_found = query_stats->items_found;
+		}
+
+		const Quadtree<T, TCoord>* source = &tree;
+		addJob(1U, [this, source, slot](size_t, Geometry& out)
+		{
+			QuadtreeStats& stats = m_quadtree_stats[slot];
+			source->forEachNode([&stats, &out](const typename Quadtree<T, TCoord>::Node& node, size_t depth)
+			{
+				++stats.nodes;
+				stats.max_depth = std::max(stats.max_depth, depth);
+				if (!node.isLeaf()) return;
+
+				const size_t items = node.getItems().size();
+				const size_t capacity = Quadtree<T, TCoord>::MAX_NODE_ITEMS;
+				++stats.leaves;
+				stats.items += items;
+				if (items == 0U) ++stats.empty_leaves;
+				if (items >= capacity) ++stats.full_leaves;
+
+				const auto min_bounds = node.getMinBounds(), max_bounds = node.getMaxBounds();
+				out.outline(Vec2<float>(float(min_bounds.x), float(min_bounds.y)), Vec2<float>(float(max_bounds.x), float(max_bounds.y)),
+					occupancyColour(items, capacity));
+			});
+		});
+	}
+}
@@ -2,28 +2,10 @@
 
 namespace Orion
 {
-	BasicMesh::BasicMesh()
-		:
-		BasicMesh(BGFX_INVALID_HANDLE, BGFX_INVALID_HANDLE)
-	{
-	}
-
-	BasicMesh::BasicMesh(bgfx::VertexBufferHandle vb, bgfx::IndexBufferHandle ib)
-		:
-		vertex_buffer(vb),
-		index_buffer(ib)
-	{
-	}
-
-	bool BasicMesh::isValid()
+	bool BasicMesh::isValid() const
 	{
 		return bgfx::isValid(vertex_buffer)
-			&& bgfx::isValid(index_buffer);
-	}
-
-	void BasicMesh::destroy()
-	{
-		bgfx::destroy(vertex_buffer);
-		bgfx::destroy(index_buffer);
+			&& bgfx::isValid(index_buffer)
+			&& index_count != 0U;
 	}
 }
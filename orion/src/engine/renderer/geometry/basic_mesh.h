@@ -4,20 +4,44 @@
 
 namespace Orion
 {
+	// Range of a shared vertex and index buffer holding a single mesh.  Indices are relative to the base vertex, and
+	// buffers are owned by the GeometryManager
 	struct BasicMesh
 	{
 	public:
 
-		bgfx::VertexBufferHandle	vertex_buffer;
-		bgfx::IndexBufferHandle		index_buffer;
+		bgfx::DynamicVertexBufferHandle		vertex_buffer;
+		bgfx::DynamicIndexBufferHandle		index_buffer;
+		uint32_t							base_vertex;
+		uint32_t							vertex_count;
+		uint32_t							first_index;
+		uint32_t							index_count;
 
 	public:
 
-		BasicMesh();
-		BasicMesh(bgfx::VertexBufferHandle vb, bgfx::IndexBufferHandle ib);
+		constexpr BasicMesh();
+		constexpr BasicMesh(bgfx::DynamicVertexBufferHandle vb, uint32_t base_vertex, uint32_t vertex_count,
+							bgfx::DynamicIndexBufferHandle ib, uint32_t first_index, uint32_t index_count);
 
-		bool isValid();
-		void destroy();
+		bool isValid() const;
 
 	};
+
+	constexpr BasicMesh::BasicMesh()
+		:
+		BasicMesh(BGFX_INVALID_HANDLE, 0U, 0U, BGFX_INVALID_HANDLE, 0U, 0U)
+	{
+	}
+
+	constexpr BasicMesh::BasicMesh(bgfx::DynamicVertexBufferHandle vb, uint32_t base_vertex, uint32_t vertex_count,
+								   bgfx::DynamicIndexBufferHandle ib, uint32_t first_index, uint32_t index_count)
+		:
+		vertex_buffer(vb),
+		index_buffer(ib),
+		base_vertex(base_vertex),
+		vertex_count(vertex_count),
+		first_index(first_index),
+		index_count(index_count)
+	{
+	}
 }
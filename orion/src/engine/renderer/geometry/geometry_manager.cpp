@@ -1,7 +1,10 @@
 #include <algorithm>
+#include <cmath>
 #include "vertex_definitions.h"
 #include "vertex_definition_loader.h"
+#include "mesh_loader.h"
 #include "../../../util/log.h"
+#include "../../../util/thread_pool.h"
 #include "../core/renderer_input_state.h"
 
 #include "geometry_manager.h"
@@ -54,14 +57,22 @@ namespace Orion
 {
 	GeometryManager::GeometryManager()
 		:
-		m_meshes()
+		m_workers(nullptr),
+		m_meshes(),
+		m_lods(),
+		m_mesh_names(),
+		m_lod_meshes(),
+		m_vertex_pages(),
+		m_index_pages()
 	{
 	}
 
-	ResultCode GeometryManager::initialise()
+	ResultCode GeometryManager::initialise(ThreadPool& workers)
 	{
 		LOG_INFO("Initialise geometry manager");
 
+		m_workers = &workers;
+
 		RETURN_ON_ERROR(initialiseVertexDefinitions());
 		RETURN_ON_ERROR(initialiseGeometryData());
 
@@ -83,6 +94,21 @@ namespace Orion
 
 		RETURN_ON_ERROR(loadInternalMeshes());
 
+		// Temporary: meshes will be loaded from configuration in future.  Compiled meshes are produced by
+		// scripts/build-meshes.sh and are not committed, so any which have not been built are skipped
+		std::vector<std::tuple<std::string, std::string>> temporaryResources;
+		for (const auto& resource : std::vector<std::tuple<std::string, std::string>> { { "crate", "meshes/crate.bin" } })
+		{
+			if (MeshLoader::exists(std::get<1>(resource))) temporaryResources.push_back(resource);
+			else LOG_INFO("Skipping mesh \"" << std::get<0>(resource) << "\"; \"" << std::get<1>(resource) << "\" has not been built");
+		}
+
+		const auto result = loadMeshResources(temporaryResources);
+		if (!ResultCodes::isSuccess(result))
+		{
+			LOG_WARN("At least one failure while loading mesh resources (" << result << ")");
+		}
+
 		return ResultCodes::Success;
 	}
 
@@ -114,43 +140,239 @@ namespace Orion
 
 		LOG_INFO("Loading mesh data for \"" << name << "\"");
 
-		bgfx::VertexBufferHandle vb;
-		bgfx::IndexBufferHandle ib;
+		const bgfx::VertexLayout * layout;
+		const bgfx::Memory * vertices;
+		const bgfx::Memory * indices;
 
 		if (name == "cube")
 		{
-			vb = bgfx::createVertexBuffer(bgfx::makeRef(s_cubeVertices, sizeof(s_cubeVertices)), VertexDefinitions::PosColorVertex::ms_layout);
-			ib = bgfx::createIndexBuffer(bgfx::makeRef(s_cubeTriList, sizeof(s_cubeTriList)));
+			layout = &VertexDefinitions::PosColorVertex::ms_layout;
+			vertices = bgfx::makeRef(s_cubeVertices, sizeof(s_cubeVertices));
+			indices = bgfx::makeRef(s_cubeTriList, sizeof(s_cubeTriList));
 		}
 		else if (name == "quad")
 		{
-			vb = bgfx::createVertexBuffer(bgfx::makeRef(s_quadVertices, sizeof(s_quadVertices)), VertexDefinitions::PosTexVertex::ms_layout);
-			ib = bgfx::createIndexBuffer(bgfx::makeRef(s_quadTriList, sizeof(s_quadTriList)));
+			layout = &VertexDefinitions::PosTexVertex::ms_layout;
+			vertices = bgfx::makeRef(s_quadVertices, sizeof(s_quadVertices));
+			indices = bgfx::makeRef(s_quadTriList, sizeof(s_quadTriList));
 		}
 		else
 		{
 			return ResultCodes::CannotLoadMeshWithInvalidName;
 		}
 
-		return storeMesh(name, BasicMesh(vb, ib));
+		BasicMesh mesh;
+		mesh.vertex_count = vertices->size / layout->getStride();
+		mesh.index_count = indices->size / sizeof(uint16_t);
+
+		if (allocateVertices(*layout, mesh.vertex_count, mesh.vertex_buffer, mesh.base_vertex) &&
+			allocateIndices(mesh.index_count, false, mesh.index_buffer, mesh.first_index))
+		{
+			bgfx::update(mesh.vertex_buffer, mesh.base_vertex, vertices);
+			bgfx::update(mesh.index_buffer, mesh.first_index, indices);
+		}
+
+		return storeMesh(name, std::move(mesh));
 	}
 
-	ResultCode GeometryManager::storeMesh(const std::string& name, BasicMesh&& mesh)
+	ResultCode GeometryManager::loadMeshResources(const std::vector<std::tuple<std::string, std::string>>& resources)
+	{
+		// Files are read and decoded on worker threads.  Buffer creation is deferred to the calling thread so that
+		// meshes are stored in a deterministic order
+		std::vector<MeshData> meshes(resources.size());
+		std::vector<ResultCode> results(resources.size(), ResultCodes::Success);
+
+		m_workers->parallelFor(resources.size(), [&](size_t index) {
+			results[index] = MeshLoader::load(std::get<1>(resources[index]), meshes[index]);
+		});
+
+		ResultCode aggregate = ResultCodes::Success;
+		for (size_t i = 0; i < resources.size(); ++i)
+		{
+			const auto& name = std::get<0>(resources[i]);
+			if (name.empty())
+			{
+				aggregate = ResultCodes::aggregate(aggregate, ResultCodes::CannotLoadMeshWithInvalidEmptyName);
+				continue;
+			}
+
+			if (ResultCodes::isError(results[i]))
+			{
+				LOG_ERROR("Failed to load mesh \"" << name << "\" from \"" << std::get<1>(resources[i]) << "\" (" << results[i] << ")");
+				aggregate = ResultCodes::aggregate(aggregate, results[i]);
+				continue;
+			}
+
+			LOG_INFO("Loaded mesh \"" << name << "\" (" << meshes[i].vertex_count << " vertices, " << meshes[i].indices.size() / 3U << " triangles, " << meshes[i].lods.size() << " LODs)");
+			auto mesh = createMesh(meshes[i]);
+			auto lods = createLodChain(meshes[i], mesh);
+			aggregate = ResultCodes::aggregate(aggregate, storeMesh(name, std::move(mesh), std::move(lods)));
+		}
+
+		return aggregate;
+	}
+
+	BasicMesh GeometryManager::createMesh(const MeshData& data)
+	{
+		BasicMesh mesh;
+		mesh.vertex_count = data.vertex_count;
+		if (!allocateVertices(data.layout, data.vertex_count, mesh.vertex_buffer, mesh.base_vertex)) return BasicMesh();
+
+		bgfx::update(mesh.vertex_buffer, mesh.base_vertex, bgfx::copy(data.vertices.data(), static_cast<uint32_t>(data.vertices.size())));
+		allocateIndexRange(data.indices, mesh);
+
+		return mesh;
+	}
+
+	GeometryManager::MeshLodChain GeometryManager::createLodChain(const MeshData& data, const BasicMesh& mesh)
+	{
+		// Each level is an index range over the vertices of the full-detail mesh
+		MeshLodChain chain;
+		for (const auto& lod : data.lods)
+		{
+			BasicMesh level(mesh.vertex_buffer, mesh.base_vertex, mesh.vertex_count, BGFX_INVALID_HANDLE, 0U, 0U);
+			if (mesh.isValid()) allocateIndexRange(lod, level);
+
+			chain.levels.push_back(level);
+		}
+
+		const float dx = data.bounds.max.x - data.bounds.min.x;
+		const float dy = data.bounds.max.y - data.bounds.min.y;
+		const float dz = data.bounds.max.z - data.bounds.min.z;
+		chain.radius = 0.5f * std::sqrt(dx * dx + dy * dy + dz * dz);
+
+		return chain;
+	}
+
+	bool GeometryManager::allocateIndexRange(const std::vector<uint32_t>& indices, BasicMesh& mesh)
+	{
+		// Indices are relative to the base vertex of the mesh, so 16-bit indices can be used for any mesh with fewer
+		// than 64k vertices, regardless of its position in the shared vertex buffer
+		const bool index32 = (mesh.vertex_count > 0xFFFFU);
+		const auto count = static_cast<uint32_t>(indices.size());
+		if (!allocateIndices(count, index32, mesh.index_buffer, mesh.first_index)) return false;
+
+		mesh.index_count = count;
+		if (index32)
+		{
+			bgfx::update(mesh.index_buffer, mesh.first_index, bgfx::copy(indices.data(), count * sizeof(uint32_t)));
+		}
+		else
+		{
+			const auto memory = bgfx::alloc(count * sizeof(uint16_t));
+			std::transform(indices.cbegin(), indices.cend(), reinterpret_cast<uint16_t*>(memory->data), [](uint32_t index) { return static_cast<uint16_t>(index); });
+			bgfx::update(mesh.index_buffer, mesh.first_index, memory);
+		}
+
+		return true;
+	}
+
+	bool GeometryManager::allocateVertices(const bgfx::VertexLayout& layout, uint32_t count, bgfx::DynamicVertexBufferHandle& outBuffer, uint32_t& outFirst)
+	{
+		if (count == 0U) return false;
+
+		auto page = std::find_if(m_vertex_pages.begin(), m_vertex_pages.end(), [&layout, count](const VertexPage& page) {
+			return page.layout_hash == layout.m_hash && page.capacity - page.used >= count;
+		});
+
+		if (page == m_vertex_pages.end())
+		{
+			const auto capacity = std::max(count, VERTEX_PAGE_CAPACITY);
+			const auto buffer = bgfx::createDynamicVertexBuffer(capacity, layout);
+			if (!bgfx::isValid(buffer))
+			{
+				LOG_ERROR("Failed to create vertex buffer page with capacity " << capacity);
+				return false;
+			}
+
+			LOG_INFO("Created vertex buffer page " << m_vertex_pages.size() << " with capacity " << capacity << " (stride " << layout.getStride() << ")");
+			page = m_vertex_pages.insert(m_vertex_pages.end(), { layout.m_hash, buffer, capacity, 0U });
+		}
+
+		outBuffer = page->buffer;
+		outFirst = page->used;
+		page->used += count;
+		return true;
+	}
+
+	bool GeometryManager::allocateIndices(uint32_t count, bool index32, bgfx::DynamicIndexBufferHandle& outBuffer, uint32_t& outFirst)
+	{
+		if (count == 0U) return false;
+
+		auto page = std::find_if(m_index_pages.begin(), m_index_pages.end(), [index32, count](const IndexPage& page) {
+			return page.index32 == index32 && page.capacity - page.used >= count;
+		});
+
+		if (page == m_index_pages.end())
+		{
+			const auto capacity = std::max(count, INDEX_PAGE_CAPACITY);
+			const auto buffer = bgfx::createDynamicIndexBuffer(capacity, (index32 ? BGFX_BUFFER_INDEX32 : BGFX_BUFFER_NONE));
+			if (!bgfx::isValid(buffer))
+			{
+				LOG_ERROR("Failed to create index buffer page with capacity " << capacity);
+				return false;
+			}
+
+			LOG_INFO("Created " << (index32 ? 32 : 16) << "-bit index buffer page " << m_index_pages.size() << " with capacity " << capacity);
+			page = m_index_pages.insert(m_index_pages.end(), { index32, buffer, capacity, 0U });
+		}
+
+		outBuffer = page->buffer;
+		outFirst = page->used;
+		page->used += count;
+		return true;
+	}
+
+	ResultCode GeometryManager::storeMesh(const std::string& name, BasicMesh&& mesh, MeshLodChain&& lods)
     {
         if (!mesh.isValid())
         {
             RETURN_LOG_ERROR("Failed to create valid mesh data for \"" << name << "\"", ResultCodes::FailedToCreateMesh);
         }
     
-		if (m_meshes.find(name) != m_meshes.end())
+		if (std::any_of(lods.levels.cbegin(), lods.levels.cend(), [](const BasicMesh& level) { return !level.isValid(); }))
+		{
+			RETURN_LOG_ERROR("Failed to create valid LOD data for \"" << name << "\"", ResultCodes::FailedToCreateMesh);
+		}
+
+		const auto id = m_mesh_names.add(name);
+		if (!id)
 		{
 			RETURN_LOG_ERROR("Cannot store mesh data; mesh already exists with name \"" << name << "\"", ResultCodes::CannotStoreDuplicateMesh);
 		}
 
-		m_meshes[name] = mesh;
+		if (!lods.levels.empty())
+		{
+			m_lod_meshes[getLodKey(mesh)] = id;
+		}
+
+		m_meshes.push_back(mesh);
+		m_lods.push_back(std::move(lods));
 		return ResultCodes::Success;
 	}
 
+	const BasicMesh& GeometryManager::selectLod(const BasicMesh& mesh, float pixels_per_unit, float mesh_scale) const
+	{
+		const auto entry = m_lod_meshes.find(getLodKey(mesh));
+		if (entry == m_lod_meshes.end()) return mesh;
+
+		const auto& chain = m_lods[entry->second.index];
+		const float projected_size = 2.0f * chain.radius * mesh_scale * pixels_per_unit;
+		if (projected_size >= FULL_DETAIL_PROJECTED_SIZE) return mesh;
+
+		const auto level = 1U + static_cast<size_t>(std::log2(FULL_DETAIL_PROJECTED_SIZE / std::max(projected_size, 1.0f)));
+		return chain.levels[std::min(level, chain.levels.size()) - 1U];
+	}
+
+	GeometryManager::BufferStats GeometryManager::getBufferStats() const
+	{
+		BufferStats stats = { m_vertex_pages.size(), m_index_pages.size(), 0U, 0U };
+		for (const auto& page : m_vertex_pages) stats.vertices += page.used;
+		for (const auto& page : m_index_pages) stats.indices += page.used;
+
+		return stats;
+	}
+
 
 	ResultCode GeometryManager::beginFrame(const RendererInputState& state)
 	{
@@ -170,11 +392,6 @@ namespace Orion
 		return ResultCodes::Success;
 	}
 
-	const BasicMesh GeometryManager::getMesh(const std::string& name) const
-	{
-        return m_meshes.at(name);
-	}
-
 	void GeometryManager::shutdown()
 	{
 		LOG_INFO("Shutting down geometry manager");
@@ -186,7 +403,15 @@ namespace Orion
 	{
 		LOG_INFO("Releasing all geometry data");
 
-		std::for_each(m_meshes.begin(), m_meshes.end(), [](auto& mesh) { mesh.second.destroy(); });
+		// Meshes are ranges within the shared pages, so only the pages themselves are released
+		std::for_each(m_vertex_pages.begin(), m_vertex_pages.end(), [](auto& page) { bgfx::destroy(page.buffer); });
+		std::for_each(m_index_pages.begin(), m_index_pages.end(), [](auto& page) { bgfx::destroy(page.buffer); });
+		m_vertex_pages.clear();
+		m_index_pages.clear();
+
         m_meshes.clear();
+        m_lods.clear();
+        m_mesh_names.clear();
+        m_lod_meshes.clear();
 	}
 }
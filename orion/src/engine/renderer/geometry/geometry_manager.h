@@ -1,44 +1,124 @@
 #pragma once
 
+#include <vector>
+#include <tuple>
+#include <string>
 #include <unordered_map>
 #include "../../../util/result_code.h"
+#include "../core/resource_id.h"
 #include "basic_mesh.h"
 struct RendererInputState;
 
 namespace Orion
 {
+	class ThreadPool;
+	struct MeshData;
+
 	class GeometryManager
 	{
 	public:
 
+		// Projected diameter, in pixels, below which a mesh is rendered from its first simplified level.  Each
+		// further halving of the projected size selects the next level
+		static constexpr float FULL_DETAIL_PROJECTED_SIZE = 256.0f;
+
+		// Capacity of each shared buffer page.  Meshes larger than a page are allocated a dedicated page
+		static const uint32_t VERTEX_PAGE_CAPACITY = 128U * 1024U;
+		static const uint32_t INDEX_PAGE_CAPACITY = 512U * 1024U;
+
+		struct BufferStats
+		{
+			size_t		vertex_pages;
+			size_t		index_pages;
+			size_t		vertices;
+			size_t		indices;
+		};
+
 		GeometryManager();
 
-		ResultCode initialise();
+		ResultCode initialise(ThreadPool& workers);
 
 		ResultCode beginFrame(const RendererInputState& state);
 		ResultCode executeFrame(const RendererInputState& state);
 		ResultCode endFrame(const RendererInputState& state);
 
-		const BasicMesh getMesh(const std::string& name) const;
+		// Meshes should be resolved to an ID once and the ID retained, rather than looking up by name each frame
+		inline MeshId getMeshId(const std::string& name) const { return m_mesh_names.find(name); }
+		inline const BasicMesh& getMesh(MeshId id) const { return m_meshes[id.index]; }
+		inline size_t getLodCount(MeshId id) const { return m_lods[id.index].levels.size(); }
+
+		// Returns true if the given full-detail mesh has simplified levels
+		inline bool hasLods(const BasicMesh& mesh) const { return !m_lod_meshes.empty() && m_lod_meshes.find(getLodKey(mesh)) != m_lod_meshes.end(); }
+
+		// Selects the mesh range to render, given the full-detail mesh, the screen-space scale of the view and the
+		// largest scale applied to the mesh.  Each level has half the triangles of the last and is selected at half
+		// the projected size, so that on-screen triangle density remains constant
+		const BasicMesh& selectLod(const BasicMesh& mesh, float pixels_per_unit, float mesh_scale) const;
+
+		BufferStats getBufferStats() const;
+
+		// Loads a set of geometryc mesh files as (name, path) pairs.  Files are read and decoded in parallel on worker
+		// threads, and buffers are created once all decoding is complete.  Failed meshes are logged and omitted
+		ResultCode loadMeshResources(const std::vector<std::tuple<std::string, std::string>>& resources);
 
 		void shutdown();
 
 	private:
 
+		// Simplified levels of a mesh, sharing the vertex buffer of the full-detail mesh.  Empty for meshes without LODs
+		struct MeshLodChain
+		{
+			std::vector<BasicMesh>					levels;				// In decreasing detail
+			float									radius;				// Bounding radius in model space
+		};
+
+		// Shared buffers from which meshes are suballocated.  Vertex pages hold a single vertex layout, and index pages
+		// a single index width.  Allocations are never released, since all geometry is static
+		struct VertexPage
+		{
+			uint32_t							layout_hash;
+			bgfx::DynamicVertexBufferHandle		buffer;
+			uint32_t							capacity;
+			uint32_t							used;
+		};
+
+		struct IndexPage
+		{
+			bool								index32;
+			bgfx::DynamicIndexBufferHandle		buffer;
+			uint32_t							capacity;
+			uint32_t							used;
+		};
+
 		ResultCode initialiseVertexDefinitions();
 		ResultCode initialiseGeometryData();
 
 		ResultCode loadInternalMeshes();
 		ResultCode loadInternalMesh(const std::string& name);
 
-		ResultCode storeMesh(const std::string& name, BasicMesh&& mesh);
+		BasicMesh createMesh(const MeshData& data);
+		MeshLodChain createLodChain(const MeshData& data, const BasicMesh& mesh);
+		bool allocateVertices(const bgfx::VertexLayout& layout, uint32_t count, bgfx::DynamicVertexBufferHandle& outBuffer, uint32_t& outFirst);
+		bool allocateIndices(uint32_t count, bool index32, bgfx::DynamicIndexBufferHandle& outBuffer, uint32_t& outFirst);
+		bool allocateIndexRange(const std::vector<uint32_t>& indices, BasicMesh& mesh);
+		ResultCode storeMesh(const std::string& name, BasicMesh&& mesh, MeshLodChain&& lods = MeshLodChain());
+
+		static inline uint64_t getLodKey(const BasicMesh& mesh) { return (uint64_t(mesh.index_buffer.idx) << 32) | mesh.first_index; }
 
 		void shutdownGeometryData();
 
 	private:
 
-		std::unordered_map<std::string, BasicMesh> m_meshes;
+		ThreadPool * m_workers;
+
+		std::vector<BasicMesh> m_meshes;			// Indexed by MeshId
+		std::vector<MeshLodChain> m_lods;			// Indexed by MeshId
+		ResourceNameTable<MeshId> m_mesh_names;
+
+		std::unordered_map<uint64_t, MeshId> m_lod_meshes;		// Meshes with LODs, keyed by full-detail index range
 
+		std::vector<VertexPage> m_vertex_pages;
+		std::vector<IndexPage> m_index_pages;
 
 	};
 }
@@ -0,0 +1,276 @@
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <bx/readerwriter.h>
+#include <meshoptimizer/src/meshoptimizer.h>
+#include "../../../util/log.h"
+
+#include "mesh_loader.h"
+
+namespace bgfx
+{
+	int32_t read(bx::ReaderI* _reader, bgfx::VertexLayout& _layout, bx::Error* _err = NULL);
+}
+
+namespace Orion
+{
+	namespace
+	{
+		// Chunk identifiers written by geometryc
+		const uint32_t CHUNK_VERTEX_BUFFER				= BX_MAKEFOURCC('V', 'B', ' ', 0x1);
+		const uint32_t CHUNK_VERTEX_BUFFER_COMPRESSED	= BX_MAKEFOURCC('V', 'B', 'C', 0x0);
+		const uint32_t CHUNK_INDEX_BUFFER				= BX_MAKEFOURCC('I', 'B', ' ', 0x0);
+		const uint32_t CHUNK_INDEX_BUFFER_COMPRESSED	= BX_MAKEFOURCC('I', 'B', 'C', 0x1);
+		const uint32_t CHUNK_PRIMITIVE					= BX_MAKEFOURCC('P', 'R', 'I', 0x0);
+		const uint32_t CHUNK_LOD						= BX_MAKEFOURCC('L', 'O', 'D', 0x0);
+		const uint32_t CHUNK_LOD_COMPRESSED				= BX_MAKEFOURCC('L', 'O', 'C', 0x0);
+
+		template <typename T>
+		inline bool readValue(const uint8_t*& data, const uint8_t* end, T& outValue)
+		{
+			if (static_cast<size_t>(end - data) < sizeof(T)) return false;
+
+			memcpy(&outValue, data, sizeof(T));
+			data += sizeof(T);
+			return true;
+		}
+
+		inline bool skip(const uint8_t*& data, const uint8_t* end, size_t bytes)
+		{
+			if (static_cast<size_t>(end - data) < bytes) return false;
+
+			data += bytes;
+			return true;
+		}
+
+		// Reads a raw or meshopt-encoded list of 16-bit group indices, and appends them to the merged index set
+		bool readIndices(const uint8_t*& data, const uint8_t* end, bool compressed, uint32_t group_base_vertex, uint32_t group_vertex_count, std::vector<uint32_t>& outIndices)
+		{
+			uint32_t index_count;
+			if (!readValue(data, end, index_count)) return false;
+
+			std::vector<uint16_t> indices(index_count);
+			if (compressed)
+			{
+				uint32_t compressed_size;
+				if (!readValue(data, end, compressed_size) || static_cast<size_t>(end - data) < compressed_size ||
+					meshopt_decodeIndexBuffer(indices.data(), index_count, sizeof(uint16_t), data, compressed_size) != 0)
+				{
+					return false;
+				}
+
+				data += compressed_size;
+			}
+			else
+			{
+				const auto bytes = size_t(index_count) * sizeof(uint16_t);
+				if (static_cast<size_t>(end - data) < bytes) return false;
+
+				memcpy(indices.data(), data, bytes);
+				data += bytes;
+			}
+
+			if (std::any_of(indices.cbegin(), indices.cend(), [group_vertex_count](uint16_t index) { return index >= group_vertex_count; }))
+			{
+				return false;
+			}
+
+			outIndices.reserve(outIndices.size() + index_count);
+			for (const auto index : indices) outIndices.push_back(group_base_vertex + index);
+
+			return true;
+		}
+
+		inline bool isSameLayout(const bgfx::VertexLayout& first, const bgfx::VertexLayout& second)
+		{
+			return first.m_hash == second.m_hash && first.m_stride == second.m_stride;
+		}
+
+		void mergeBounds(Aabb& bounds, const Aabb& group)
+		{
+			bounds.min = bx::Vec3(std::min(bounds.min.x, group.min.x), std::min(bounds.min.y, group.min.y), std::min(bounds.min.z, group.min.z));
+			bounds.max = bx::Vec3(std::max(bounds.max.x, group.max.x), std::max(bounds.max.y, group.max.y), std::max(bounds.max.z, group.max.z));
+		}
+	}
+
+	ResultCode MeshLoader::load(const std::string& path, MeshData& outMesh)
+	{
+		// The shared file reader is not thread-safe, so the file is read independently
+		std::ifstream in(path, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!in.is_open())
+		{
+			RETURN_LOG_ERROR("Failed to open mesh file \"" << path << "\"", ResultCodes::FailedToLoadMeshResource);
+		}
+
+		const auto size = static_cast<size_t>(in.tellg());
+		std::vector<uint8_t> data(size);
+		in.seekg(0, std::ios::beg);
+		if (!in.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size)))
+		{
+			RETURN_LOG_ERROR("Failed to read mesh file \"" << path << "\"", ResultCodes::FailedToLoadMeshResource);
+		}
+
+		return parse(path, data.data(), data.data() + data.size(), outMesh);
+	}
+
+	bool MeshLoader::exists(const std::string& path)
+	{
+		return std::ifstream(path, std::ios::in | std::ios::binary).is_open();
+	}
+
+	ResultCode MeshLoader::parse(const std::string& path, const uint8_t* data, const uint8_t* end, MeshData& outMesh)
+	{
+		MeshData mesh;
+		mesh.vertex_count = 0U;
+
+		// Each group is a vertex chunk, an index chunk and a primitive chunk.  Group indices are relative to the
+		// group vertices, so are rebased onto the merged vertex set
+		uint32_t group_base_vertex = 0U;
+		uint32_t group_vertex_count = 0U;
+		uint32_t group_count = 0U;
+		bool group_has_lods = false;
+		bool has_layout = false;
+
+		while (data != end)
+		{
+			uint32_t chunk;
+			if (!readValue(data, end, chunk)) break;
+
+			if (chunk == CHUNK_VERTEX_BUFFER || chunk == CHUNK_VERTEX_BUFFER_COMPRESSED)
+			{
+				Sphere sphere; Aabb aabb; Obb obb;
+				if (!readValue(data, end, sphere) || !readValue(data, end, aabb) || !readValue(data, end, obb))
+				{
+					RETURN_LOG_ERROR("Truncated vertex data in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+				}
+
+				// The layout must be read in full and valid before it can be compared with that of earlier groups
+				bx::MemoryReader reader(data, static_cast<uint32_t>(end - data));
+				bx::Error error;
+				bgfx::VertexLayout layout;
+				bgfx::read(&reader, layout, &error);
+				data += reader.seek(0, bx::Whence::Current);
+
+				uint16_t vertex_count;
+				if (!error.isOk() || layout.getStride() == 0U || !readValue(data, end, vertex_count))
+				{
+					RETURN_LOG_ERROR("Invalid vertex layout in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+				}
+
+				if (has_layout && !isSameLayout(layout, mesh.layout))
+				{
+					RETURN_LOG_ERROR("Mesh file \"" << path << "\" contains groups with differing vertex layouts", ResultCodes::InvalidMeshFile);
+				}
+
+				const size_t stride = layout.getStride();
+				const size_t offset = mesh.vertices.size();
+				mesh.vertices.resize(offset + size_t(vertex_count) * stride);
+
+				if (chunk == CHUNK_VERTEX_BUFFER_COMPRESSED)
+				{
+					uint32_t compressed_size;
+					if (!readValue(data, end, compressed_size) || static_cast<size_t>(end - data) < compressed_size ||
+						meshopt_decodeVertexBuffer(mesh.vertices.data() + offset, vertex_count, stride, data, compressed_size) != 0)
+					{
+						RETURN_LOG_ERROR("Failed to decode compressed vertex data in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+					}
+
+					data += compressed_size;
+				}
+				else
+				{
+					const auto bytes = size_t(vertex_count) * stride;
+					if (static_cast<size_t>(end - data) < bytes)
+					{
+						RETURN_LOG_ERROR("Truncated vertex data in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+					}
+
+					memcpy(mesh.vertices.data() + offset, data, bytes);
+					data += bytes;
+				}
+
+				if (has_layout) mergeBounds(mesh.bounds, aabb);
+				else mesh.bounds = aabb;
+
+				mesh.layout = layout;
+				has_layout = true;
+
+				group_base_vertex = mesh.vertex_count;
+				group_vertex_count = vertex_count;
+				mesh.vertex_count += vertex_count;
+			}
+			else if (chunk == CHUNK_INDEX_BUFFER || chunk == CHUNK_INDEX_BUFFER_COMPRESSED)
+			{
+				if (!readIndices(data, end, chunk == CHUNK_INDEX_BUFFER_COMPRESSED, group_base_vertex, group_vertex_count, mesh.indices))
+				{
+					RETURN_LOG_ERROR("Invalid index data in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+				}
+			}
+			else if (chunk == CHUNK_LOD || chunk == CHUNK_LOD_COMPRESSED)
+			{
+				// geometryc writes the same number of levels for every group, so that each level of the merged mesh
+				// is the union of the same level in each group
+				uint8_t lod_count;
+				if (!readValue(data, end, lod_count) || (group_count != 0U && lod_count != mesh.lods.size()))
+				{
+					RETURN_LOG_ERROR("Inconsistent LOD data in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+				}
+
+				mesh.lods.resize(lod_count);
+				for (auto& lod : mesh.lods)
+				{
+					if (!readIndices(data, end, chunk == CHUNK_LOD_COMPRESSED, group_base_vertex, group_vertex_count, lod))
+					{
+						RETURN_LOG_ERROR("Invalid LOD index data in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+					}
+				}
+
+				group_has_lods = true;
+			}
+			else if (chunk == CHUNK_PRIMITIVE)
+			{
+				// The primitive chunk completes each group
+				if (!group_has_lods && !mesh.lods.empty())
+				{
+					RETURN_LOG_ERROR("Inconsistent LOD data in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+				}
+
+				++group_count;
+				group_has_lods = false;
+
+				// Primitive ranges are not required, since each mesh is drawn in full
+				uint16_t length;
+				if (!readValue(data, end, length) || !skip(data, end, length))
+				{
+					RETURN_LOG_ERROR("Truncated primitive data in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+				}
+
+				uint16_t primitive_count;
+				if (!readValue(data, end, primitive_count))
+				{
+					RETURN_LOG_ERROR("Truncated primitive data in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+				}
+
+				for (uint16_t i = 0; i < primitive_count; ++i)
+				{
+					if (!readValue(data, end, length) || !skip(data, end, length + sizeof(uint32_t) * 4U + sizeof(Sphere) + sizeof(Aabb) + sizeof(Obb)))
+					{
+						RETURN_LOG_ERROR("Truncated primitive data in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+					}
+				}
+			}
+			else
+			{
+				RETURN_LOG_ERROR("Unknown chunk " << chunk << " in mesh file \"" << path << "\"", ResultCodes::InvalidMeshFile);
+			}
+		}
+
+		if (mesh.vertex_count == 0U || mesh.indices.empty())
+		{
+			RETURN_LOG_ERROR("Mesh file \"" << path << "\" contains no geometry", ResultCodes::InvalidMeshFile);
+		}
+
+		outMesh = std::move(mesh);
+		return ResultCodes::Success;
+	}
+}
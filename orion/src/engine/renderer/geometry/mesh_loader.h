@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "bgfx_utils.h"
+#include "bounds.h"
+#include "../../../util/result_code.h"
+
+namespace Orion
+{
+	// Mesh data decoded from a geometryc mesh file.  All groups within the file are merged into a single vertex and
+	// index set, so that each mesh can be rendered with a single draw
+	struct MeshData
+	{
+		bgfx::VertexLayout			layout;
+		std::vector<uint8_t>		vertices;
+		std::vector<uint32_t>		indices;
+		std::vector<std::vector<uint32_t>>	lods;		// Simplified index sets over the same vertices, in decreasing detail
+		uint32_t					vertex_count;
+		Aabb						bounds;
+	};
+
+	// Loads meshes compiled by geometryc, including meshes encoded with the meshoptimizer vertex and index codecs
+	// (geometryc --compress).  glTF and OBJ sources are converted offline by scripts/build-meshes.sh
+	class MeshLoader
+	{
+	public:
+
+		// Reads and decodes a mesh file.  Safe to call concurrently from worker threads
+		static ResultCode load(const std::string& path, MeshData& outMesh);
+
+		static bool exists(const std::string& path);
+
+	private:
+
+		static ResultCode parse(const std::string& path, const uint8_t* data, const uint8_t* end, MeshData& outMesh);
+
+	};
+}
@@ -0,0 +1,378 @@
+#include <set>
+#include <algorithm>
+#include "../../../util/log.h"
+#include "../core/renderer_input_state.h"
+
+#include "render_graph.h"
+
+namespace Orion
+{
+	const std::string RenderGraph::BACKBUFFER = "backbuffer";
+
+	RenderGraph::RenderGraph()
+		:
+		m_passes(),
+		m_targets(),
+		m_schedule(),
+		m_compiled(),
+		m_textures(),
+		m_views_in_use(0U),
+		m_width(0U),
+		m_height(0U),
+		m_dirty(true),
+		m_generation(0U),
+		m_stats({ 0U, 0U, 0U, 0U })
+	{
+	}
+
+	ResultCode RenderGraph::initialise(uint32_t width, uint32_t height)
+	{
+		LOG_INFO("Initialising render graph");
+
+		m_width = width;
+		m_height = height;
+		m_dirty = true;
+
+		return ResultCodes::Success;
+	}
+
+	void RenderGraph::declareTarget(const std::string& name, const TargetDesc& desc)
+	{
+		m_targets[name] = desc;
+		m_dirty = true;
+	}
+
+	RenderPass& RenderGraph::addPass(const std::string& name, RenderPass::ExecuteFn execute)
+	{
+		m_passes.emplace_back(name, execute);
+		m_dirty = true;
+
+		return m_passes.back();
+	}
+
+	ResultCode RenderGraph::beginFrame(const RendererInputState& state)
+	{
+		// Transient targets are sized relative to the backbuffer, so are reallocated on resize
+		if (state.width != m_width || state.height != m_height)
+		{
+			m_width = state.width;
+			m_height = state.height;
+			m_dirty = true;
+		}
+
+		if (m_dirty) RETURN_ON_ERROR(compile());
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode RenderGraph::execute(const RendererInputState& state)
+	{
+		for (const auto& compiled : m_compiled)
+		{
+			// Views are touched so that clears are applied even if the pass submits no draws
+			bgfx::touch(compiled.view);
+			RETURN_ON_ERROR(m_passes[compiled.pass].execute(compiled.view, state));
+		}
+
+		return ResultCodes::Success;
+	}
+
+	bgfx::ViewId RenderGraph::getViewId(const std::string& pass) const
+	{
+		for (const auto& compiled : m_compiled)
+		{
+			if (m_passes[compiled.pass].getName() == pass) return compiled.view;
+		}
+
+		return INVALID_VIEW;
+	}
+
+	bgfx::TextureHandle RenderGraph::getTexture(const std::string& target) const
+	{
+		const auto entry = m_schedule.targets.find(target);
+		return (entry != m_schedule.targets.end() ? m_textures[entry->second] : bgfx::TextureHandle(BGFX_INVALID_HANDLE));
+	}
+
+	ResultCode RenderGraph::compile()
+	{
+		LOG_INFO("Compiling render graph (" << m_passes.size() << " passes, " << m_targets.size() << " targets) at " << m_width << "x" << m_height);
+
+		Schedule schedule;
+		RETURN_ON_ERROR(buildSchedule(m_passes, m_targets, schedule));
+
+		releaseResources();
+		m_schedule = std::move(schedule);
+
+		for (const auto& desc : m_schedule.physical)
+		{
+			const auto texture = bgfx::createTexture2D(getTargetSize(m_width, desc.scale), getTargetSize(m_height, desc.scale), false, 1U, desc.format,
+				BGFX_TEXTURE_RT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP);
+			if (!bgfx::isValid(texture))
+			{
+				releaseResources();
+				RETURN_LOG_ERROR("Failed to create render graph target texture", ResultCodes::FailedToCreateRenderTarget);
+			}
+
+			m_textures.push_back(texture);
+		}
+
+		// Views are assigned in execution order, since bgfx processes views in ID order
+		for (size_t i = 0; i < m_schedule.order.size(); ++i)
+		{
+			const auto& pass = m_passes[m_schedule.order[i]];
+			CompiledPass compiled = { m_schedule.order[i], static_cast<bgfx::ViewId>(i), BGFX_INVALID_HANDLE };
+
+			uint16_t width, height;
+			const auto result = createFrameBuffer(pass, compiled, width, height);
+			if (ResultCodes::isError(result))
+			{
+				releaseResources();
+				return result;
+			}
+
+			bgfx::setViewName(compiled.view, pass.getName().c_str());
+			bgfx::setViewRect(compiled.view, 0, 0, width, height);
+			bgfx::setViewFrameBuffer(compiled.view, compiled.framebuffer);
+			bgfx::setViewClear(compiled.view, pass.getClearFlags(), pass.getClearColour(), pass.getClearDepth(), pass.getClearStencil());
+
+			m_compiled.push_back(compiled);
+		}
+
+		m_views_in_use = static_cast<bgfx::ViewId>(m_compiled.size());
+		m_stats = { m_passes.size(), m_compiled.size(), m_schedule.targets.size(), m_schedule.physical.size() };
+		++m_generation;
+		m_dirty = false;
+
+		LOG_INFO("Render graph compiled; " << m_stats.live_passes << " live passes, " << m_stats.live_targets << " targets in " << m_stats.physical_targets << " textures");
+		return ResultCodes::Success;
+	}
+
+	ResultCode RenderGraph::createFrameBuffer(const RenderPass& pass, CompiledPass& compiled, uint16_t& outWidth, uint16_t& outHeight) const
+	{
+		outWidth = static_cast<uint16_t>(m_width);
+		outHeight = static_cast<uint16_t>(m_height);
+
+		// Passes writing only the backbuffer, or writing nothing, render to the default framebuffer
+		std::vector<bgfx::TextureHandle> attachments;
+		for (const auto& resource : pass.getWrites())
+		{
+			if (resource == BACKBUFFER) continue;
+
+			const auto& desc = m_targets.at(resource);
+			if (!attachments.empty() && (getTargetSize(m_width, desc.scale) != outWidth || getTargetSize(m_height, desc.scale) != outHeight))
+			{
+				RETURN_LOG_ERROR("Render pass \"" << pass.getName() << "\" writes targets of differing sizes", ResultCodes::InvalidRenderGraph);
+			}
+
+			outWidth = getTargetSize(m_width, desc.scale);
+			outHeight = getTargetSize(m_height, desc.scale);
+			attachments.push_back(m_textures[m_schedule.targets.at(resource)]);
+		}
+
+		if (attachments.empty()) return ResultCodes::Success;
+
+		compiled.framebuffer = bgfx::createFrameBuffer(static_cast<uint8_t>(attachments.size()), attachments.data(), false);
+		if (!bgfx::isValid(compiled.framebuffer))
+		{
+			RETURN_LOG_ERROR("Failed to create framebuffer for render pass \"" << pass.getName() << "\"", ResultCodes::FailedToCreateRenderTarget);
+		}
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode RenderGraph::buildSchedule(const std::deque<RenderPass>& passes, const std::unordered_map<std::string, TargetDesc>& targets, Schedule& outSchedule)
+	{
+		Schedule schedule;
+		RETURN_ON_ERROR(orderPasses(passes, targets, schedule.order));
+		assignTargets(passes, targets, schedule);
+
+		outSchedule = std::move(schedule);
+		return ResultCodes::Success;
+	}
+
+	ResultCode RenderGraph::orderPasses(const std::deque<RenderPass>& passes, const std::unordered_map<std::string, TargetDesc>& targets, std::vector<size_t>& outOrder)
+	{
+		const size_t count = passes.size();
+
+		// Validate resources; the backbuffer cannot be sampled, and cannot share a framebuffer with transient targets
+		for (const auto& pass : passes)
+		{
+			for (const auto& resource : pass.getReads())
+			{
+				if (resource == BACKBUFFER) RETURN_LOG_ERROR("Render pass \"" << pass.getName() << "\" cannot read the backbuffer", ResultCodes::InvalidRenderGraph);
+				if (targets.find(resource) == targets.end()) RETURN_LOG_ERROR("Render pass \"" << pass.getName() << "\" reads undeclared target \"" << resource << "\"", ResultCodes::InvalidRenderGraph);
+				if (std::none_of(passes.cbegin(), passes.cend(), [&resource](const RenderPass& other) { return other.isWriting(resource); }))
+				{
+					RETURN_LOG_ERROR("Render pass \"" << pass.getName() << "\" reads target \"" << resource << "\" which is never written", ResultCodes::InvalidRenderGraph);
+				}
+			}
+
+			for (const auto& resource : pass.getWrites())
+			{
+				if (resource != BACKBUFFER && targets.find(resource) == targets.end()) RETURN_LOG_ERROR("Render pass \"" << pass.getName() << "\" writes undeclared target \"" << resource << "\"", ResultCodes::InvalidRenderGraph);
+			}
+
+			if (pass.isWriting(BACKBUFFER) && pass.getWrites().size() > 1U)
+			{
+				RETURN_LOG_ERROR("Render pass \"" << pass.getName() << "\" cannot write both the backbuffer and transient targets", ResultCodes::InvalidRenderGraph);
+			}
+		}
+
+		// A pass depends on every writer of the resources it reads, and on every earlier writer of the resources it
+		// writes.  Read-only passes therefore always see the final contents of a resource
+		std::vector<std::vector<size_t>> dependencies(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (size_t j = 0; j < count; ++j)
+			{
+				if (i == j) continue;
+
+				const bool depends = std::any_of(passes[j].getWrites().cbegin(), passes[j].getWrites().cend(), [&](const std::string& resource) {
+					return (passes[i].isReading(resource) && !passes[i].isWriting(resource)) || (passes[i].isWriting(resource) && j < i);
+				});
+
+				if (depends) dependencies[i].push_back(j);
+			}
+		}
+
+		// Passes contributing to the backbuffer, or with side effects, are retained along with all of their dependencies
+		std::vector<bool> live(count, false);
+		std::vector<size_t> pending;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (passes[i].getHasSideEffects() || passes[i].isWriting(BACKBUFFER)) pending.push_back(i);
+		}
+
+		while (!pending.empty())
+		{
+			const auto pass = pending.back();
+			pending.pop_back();
+			if (live[pass]) continue;
+
+			live[pass] = true;
+			pending.insert(pending.end(), dependencies[pass].cbegin(), dependencies[pass].cend());
+		}
+
+		// Topological sort of the live passes, preferring declaration order between independent passes
+		std::vector<size_t> remaining(count, 0U);
+		std::set<size_t> ready;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!live[i]) continue;
+
+			remaining[i] = dependencies[i].size();
+			if (remaining[i] == 0U) ready.insert(i);
+		}
+
+		std::vector<size_t> order;
+		while (!ready.empty())
+		{
+			const auto pass = *ready.begin();
+			ready.erase(ready.begin());
+			order.push_back(pass);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (live[i] && std::find(dependencies[i].cbegin(), dependencies[i].cend(), pass) != dependencies[i].cend())
+				{
+					if (--remaining[i] == 0U) ready.insert(i);
+				}
+			}
+		}
+
+		const auto live_count = static_cast<size_t>(std::count(live.cbegin(), live.cend(), true));
+		if (order.size() != live_count)
+		{
+			RETURN_LOG_ERROR("Render graph contains a dependency cycle", ResultCodes::InvalidRenderGraph);
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!live[i]) LOG_INFO("Culling render pass \"" << passes[i].getName() << "\"; output is never read");
+		}
+
+		outOrder = std::move(order);
+		return ResultCodes::Success;
+	}
+
+	void RenderGraph::assignTargets(const std::deque<RenderPass>& passes, const std::unordered_map<std::string, TargetDesc>& targets, Schedule& schedule)
+	{
+		// Lifetime of each live target, as the first and last positions in the execution order at which it is used
+		std::unordered_map<std::string, std::pair<size_t, size_t>> lifetimes;
+		for (size_t position = 0; position < schedule.order.size(); ++position)
+		{
+			const auto& pass = passes[schedule.order[position]];
+			for (const auto* resources : { &pass.getReads(), &pass.getWrites() })
+			{
+				for (const auto& resource : *resources)
+				{
+					if (resource == BACKBUFFER) continue;
+
+					auto entry = lifetimes.emplace(resource, std::make_pair(position, position));
+					entry.first->second.second = position;
+				}
+			}
+		}
+
+		std::vector<std::pair<std::string, std::pair<size_t, size_t>>> ordered(lifetimes.cbegin(), lifetimes.cend());
+		std::sort(ordered.begin(), ordered.end(), [](const auto& first, const auto& second) {
+			return first.second.first < second.second.first || (first.second.first == second.second.first && first.first < second.first);
+		});
+
+		// Targets are assigned to the first physical target with a matching description which is no longer in use
+		std::vector<size_t> physical_last_use;
+		for (const auto& target : ordered)
+		{
+			const auto& desc = targets.at(target.first);
+
+			size_t physical = 0U;
+			for (; physical < schedule.physical.size(); ++physical)
+			{
+				if (schedule.physical[physical].format == desc.format && schedule.physical[physical].scale == desc.scale &&
+					physical_last_use[physical] < target.second.first)
+				{
+					break;
+				}
+			}
+
+			if (physical == schedule.physical.size())
+			{
+				schedule.physical.push_back(desc);
+				physical_last_use.push_back(0U);
+			}
+
+			physical_last_use[physical] = target.second.second;
+			schedule.targets[target.first] = physical;
+		}
+	}
+
+	void RenderGraph::releaseResources()
+	{
+		for (const auto& compiled : m_compiled)
+		{
+			if (bgfx::isValid(compiled.framebuffer)) bgfx::destroy(compiled.framebuffer);
+		}
+
+		std::for_each(m_textures.begin(), m_textures.end(), [](auto texture) { bgfx::destroy(texture); });
+
+		// Views may be reassigned to different passes on recompilation, so all previous view state is cleared
+		for (bgfx::ViewId view = 0U; view < m_views_in_use; ++view)
+		{
+			bgfx::resetView(view);
+		}
+
+		m_compiled.clear();
+		m_textures.clear();
+		m_schedule = Schedule();
+		m_views_in_use = 0U;
+	}
+
+	void RenderGraph::shutdown()
+	{
+		LOG_INFO("Shutting down render graph");
+
+		releaseResources();
+		m_passes.clear();
+		m_targets.clear();
+	}
+}
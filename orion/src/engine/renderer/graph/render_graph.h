@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include "bgfx_utils.h"
+#include "../../../util/result_code.h"
+#include "render_pass.h"
+struct RendererInputState;
+
+namespace Orion
+{
+	// Schedules a set of render passes over bgfx views.  Passes declare the resources they read and write; the graph
+	// orders passes by their dependencies, culls passes whose output is never used, assigns a view, framebuffer and
+	// clear state to each remaining pass, and allocates transient render targets, sharing a single texture between
+	// targets whose lifetimes do not overlap
+	class RenderGraph
+	{
+	public:
+
+		// Resource name for the backbuffer.  Passes writing the backbuffer are the roots of the graph
+		static const std::string BACKBUFFER;
+		static const bgfx::ViewId INVALID_VIEW = UINT16_MAX;
+
+		// Description of a transient render target, sized relative to the backbuffer
+		struct TargetDesc
+		{
+			bgfx::TextureFormat::Enum		format;
+			float							scale;
+		};
+
+		struct Stats
+		{
+			size_t		declared_passes;
+			size_t		live_passes;				// Passes remaining after culling
+			size_t		live_targets;
+			size_t		physical_targets;			// Textures allocated for live targets after aliasing
+		};
+
+		// Execution order and target assignment calculated from the pass declarations
+		struct Schedule
+		{
+			std::vector<size_t>							order;			// Indices of live passes, in execution order
+			std::unordered_map<std::string, size_t>		targets;		// Physical target index for each live target
+			std::vector<TargetDesc>						physical;
+		};
+
+		RenderGraph();
+
+		ResultCode initialise(uint32_t width, uint32_t height);
+
+		// Targets and passes may be declared at any time; the graph is recompiled at the start of the next frame
+		void declareTarget(const std::string& name, const TargetDesc& desc);
+		RenderPass& addPass(const std::string& name, RenderPass::ExecuteFn execute);
+
+		// Compiles the graph immediately, rather than at the start of the next frame
+		ResultCode compile();
+
+		ResultCode beginFrame(const RendererInputState& state);
+		ResultCode execute(const RendererInputState& state);
+
+		// Returns INVALID_VIEW for passes which have been culled
+		bgfx::ViewId getViewId(const std::string& pass) const;
+		bgfx::TextureHandle getTexture(const std::string& target) const;
+
+		inline Stats getStats() const { return m_stats; }
+
+		// Incremented each time the graph is compiled, allowing consumers to detect when view assignments may have changed
+		inline uint32_t getGeneration() const { return m_generation; }
+
+		// Calculates the schedule for a set of passes without allocating any resources
+		static ResultCode buildSchedule(const std::deque<RenderPass>& passes, const std::unordered_map<std::string, TargetDesc>& targets, Schedule& outSchedule);
+
+		void shutdown();
+
+	private:
+
+		struct CompiledPass
+		{
+			size_t							pass;
+			bgfx::ViewId					view;
+			bgfx::FrameBufferHandle			framebuffer;		// Invalid for passes rendering to the backbuffer
+		};
+
+		ResultCode createFrameBuffer(const RenderPass& pass, CompiledPass& compiled, uint16_t& outWidth, uint16_t& outHeight) const;
+		void releaseResources();
+
+		static ResultCode orderPasses(const std::deque<RenderPass>& passes, const std::unordered_map<std::string, TargetDesc>& targets, std::vector<size_t>& outOrder);
+		static void assignTargets(const std::deque<RenderPass>& passes, const std::unordered_map<std::string, TargetDesc>& targets, Schedule& schedule);
+
+		inline uint16_t getTargetSize(uint32_t dimension, float scale) const { return static_cast<uint16_t>(std::max(1.0f, float(dimension) * scale)); }
+
+	private:
+
+		std::deque<RenderPass>								m_passes;			// Deque, so that references returned by addPass() remain valid
+		std::unordered_map<std::string, TargetDesc>			m_targets;
+
+		Schedule											m_schedule;
+		std::vector<CompiledPass>							m_compiled;
+		std::vector<bgfx::TextureHandle>					m_textures;			// Indexed by physical target
+		bgfx::ViewId										m_views_in_use;
+
+		uint32_t											m_width;
+		uint32_t											m_height;
+		bool												m_dirty;
+		uint32_t											m_generation;
+		Stats												m_stats;
+	};
+}
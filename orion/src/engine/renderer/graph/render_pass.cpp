@@ -0,0 +1,47 @@
+#include <algorithm>
+
+#include "render_pass.h"
+
+namespace Orion
+{
+	RenderPass::RenderPass(const std::string& name, ExecuteFn execute)
+		:
+		m_name(name),
+		m_execute(execute),
+		m_reads(),
+		m_writes(),
+		m_side_effects(false),
+		m_clear_flags(BGFX_CLEAR_NONE),
+		m_clear_rgba(0x000000ffU),
+		m_clear_depth(1.0f),
+		m_clear_stencil(0U)
+	{
+	}
+
+	RenderPass& RenderPass::reads(const std::string& resource)
+	{
+		if (!isReading(resource)) m_reads.push_back(resource);
+		return *this;
+	}
+
+	RenderPass& RenderPass::writes(const std::string& resource)
+	{
+		if (!isWriting(resource)) m_writes.push_back(resource);
+		return *this;
+	}
+
+	RenderPass& RenderPass::clears(uint16_t flags, uint32_t rgba, float depth, uint8_t stencil)
+	{
+		m_clear_flags = flags;
+		m_clear_rgba = rgba;
+		m_clear_depth = depth;
+		m_clear_stencil = stencil;
+		return *this;
+	}
+
+	RenderPass& RenderPass::hasSideEffects()
+	{
+		m_side_effects = true;
+		return *this;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include "bgfx_utils.h"
+#include "../../../util/result_code.h"
+struct RendererInputState;
+
+namespace Orion
+{
+	// Declaration of a single pass within the RenderGraph.  Passes declare the resources they read and write, and
+	// are assigned a bgfx view, framebuffer and clear state by the graph when it is compiled
+	class RenderPass
+	{
+	public:
+
+		typedef std::function<ResultCode(bgfx::ViewId view, const RendererInputState& state)> ExecuteFn;
+
+		RenderPass(const std::string& name, ExecuteFn execute);
+
+		// The pass depends on all passes writing a resource it reads
+		RenderPass& reads(const std::string& resource);
+
+		// Passes writing the same resource are executed in declaration order, so later passes draw over earlier ones
+		RenderPass& writes(const std::string& resource);
+
+		RenderPass& clears(uint16_t flags, uint32_t rgba = 0x000000ffU, float depth = 1.0f, uint8_t stencil = 0U);
+
+		// Passes with side effects are never culled, even if no other pass reads their output
+		RenderPass& hasSideEffects();
+
+		inline const std::string& getName() const { return m_name; }
+		inline const std::vector<std::string>& getReads() const { return m_reads; }
+		inline const std::vector<std::string>& getWrites() const { return m_writes; }
+		inline bool isReading(const std::string& resource) const { return std::find(m_reads.cbegin(), m_reads.cend(), resource) != m_reads.cend(); }
+		inline bool isWriting(const std::string& resource) const { return std::find(m_writes.cbegin(), m_writes.cend(), resource) != m_writes.cend(); }
+		inline bool getHasSideEffects() const { return m_side_effects; }
+
+		inline uint16_t getClearFlags() const { return m_clear_flags; }
+		inline uint32_t getClearColour() const { return m_clear_rgba; }
+		inline float getClearDepth() const { return m_clear_depth; }
+		inline uint8_t getClearStencil() const { return m_clear_stencil; }
+
+		inline ResultCode execute(bgfx::ViewId view, const RendererInputState& state) const { return m_execute(view, state); }
+
+	private:
+
+		std::string							m_name;
+		ExecuteFn							m_execute;
+
+		std::vector<std::string>			m_reads;
+		std::vector<std::string>			m_writes;
+		bool								m_side_effects;
+
+		uint16_t							m_clear_flags;
+		uint32_t							m_clear_rgba;
+		float								m_clear_depth;
+		uint8_t								m_clear_stencil;
+	};
+}
@@ -1,4 +1,11 @@
+#include <cstring>
+#include <algorithm>
+#include <bgfx/embedded_shader.h>
 #include "imgui/imgui.h"
+#include "imgui/vs_ocornut_imgui.bin.h"
+#include "imgui/fs_ocornut_imgui.bin.h"
+#include "imgui/vs_imgui_image.bin.h"
+#include "imgui/fs_imgui_image.bin.h"
 #include "../../../util/log.h"
 #include "../core/renderer_input_state.h"
 
@@ -6,7 +13,40 @@
 
 namespace Orion
 {
+	// Buffers are allocated with capacity for at least this many elements, and grown in powers of two
+	static const uint32_t MIN_BUFFER_CAPACITY = 1024U;
+
+	// Shaders of the vendored integration, built for every backend
+	static const bgfx::EmbeddedShader EMBEDDED_SHADERS[] =
+	{
+		BGFX_EMBEDDED_SHADER(vs_ocornut_imgui),
+		BGFX_EMBEDDED_SHADER(fs_ocornut_imgui),
+		BGFX_EMBEDDED_SHADER(vs_imgui_image),
+		BGFX_EMBEDDED_SHADER(fs_imgui_image),
+
+		BGFX_EMBEDDED_SHADER_END()
+	};
+
+	static uint32_t bufferCapacity(uint32_t count)
+	{
+		uint32_t capacity = MIN_BUFFER_CAPACITY;
+		while (capacity < count) capacity <<= 1;
+
+		return capacity;
+	}
+
 	GuiManager::GuiManager()
+		:
+		m_view(255U),
+		m_layout(),
+		m_font_texture(BGFX_INVALID_HANDLE),
+		m_program(BGFX_INVALID_HANDLE),
+		m_image_program(BGFX_INVALID_HANDLE),
+		m_sampler(BGFX_INVALID_HANDLE),
+		m_image_lod(BGFX_INVALID_HANDLE),
+		m_lists(),
+		m_frame(0U),
+		m_stats({ 0U, 0U, 0U, 0U })
 	{
 	}
 
@@ -14,7 +54,58 @@ namespace Orion
 	{
 		LOG_INFO("Initialising GUI manager");
 
-		imguiCreate();
+		// Context, style and fonts are created by the vendored integration; rendering is performed here
+		imguiCreateContext();
+
+		m_layout
+			.begin()
+			.add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
+			.end();
+
+		RETURN_ON_ERROR(createPrograms());
+		return createFontTexture();
+	}
+
+	ResultCode GuiManager::createPrograms()
+	{
+		const auto type = bgfx::getRendererType();
+		m_program = bgfx::createProgram(
+			bgfx::createEmbeddedShader(EMBEDDED_SHADERS, type, "vs_ocornut_imgui"),
+			bgfx::createEmbeddedShader(EMBEDDED_SHADERS, type, "fs_ocornut_imgui"), true);
+		m_image_program = bgfx::createProgram(
+			bgfx::createEmbeddedShader(EMBEDDED_SHADERS, type, "vs_imgui_image"),
+			bgfx::createEmbeddedShader(EMBEDDED_SHADERS, type, "fs_imgui_image"), true);
+
+		m_sampler = bgfx::createUniform("s_tex", bgfx::UniformType::Sampler);
+		m_image_lod = bgfx::createUniform("u_imageLodEnabled", bgfx::UniformType::Vec4);
+
+		if (!bgfx::isValid(m_program) || !bgfx::isValid(m_image_program) || !bgfx::isValid(m_sampler) || !bgfx::isValid(m_image_lod))
+		{
+			RETURN_LOG_ERROR("Failed to create GUI shader programs or uniforms", ResultCodes::FailedToInitialiseGui);
+		}
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode GuiManager::createFontTexture()
+	{
+		ImGuiIO& io = ImGui::GetIO();
+
+		uint8_t* data = nullptr;
+		int32_t width = 0, height = 0;
+		io.Fonts->GetTexDataAsRGBA32(&data, &width, &height);
+
+		m_font_texture = bgfx::createTexture2D(uint16_t(width), uint16_t(height), false, 1, bgfx::TextureFormat::BGRA8, 0,
+			bgfx::copy(data, uint32_t(width * height * 4)));
+		if (!bgfx::isValid(m_font_texture))
+		{
+			RETURN_LOG_ERROR("Failed to create GUI font texture", ResultCodes::FailedToInitialiseGui);
+		}
+
+		// Every draw command then refers to an explicit texture
+		io.Fonts->TexID = ImGui::toId(m_font_texture, IMGUI_FLAGS_ALPHA_BLEND, 0);
 
 		return ResultCodes::Success;
 	}
@@ -31,6 +122,8 @@ namespace Orion
 			,  mouse_state.m_mz
 			, uint16_t(state.width)
 			, uint16_t(state.height)
+			, -1
+			, m_view
 		);
 
 		bgfx::dbgTextClear();
@@ -51,15 +144,225 @@ namespace Orion
 	{
 		(void)state;
 
-		imguiEndFrame();
+		const ImDrawData* draw_data = ImGui::GetDrawData();
+		if (draw_data) render(*draw_data);
 
 		return ResultCodes::Success;
 	}
 
+	void GuiManager::render(const ImDrawData& draw_data)
+	{
+		++m_frame;
+		m_stats = { 0U, 0U, 0U, 0U };
+
+		const ImGuiIO& io = ImGui::GetIO();
+		const float width = io.DisplaySize.x;
+		const float height = io.DisplaySize.y;
+
+		float ortho[16];
+		bx::mtxOrtho(ortho, 0.0f, width, height, 0.0f, 0.0f, 1000.0f, 0.0f, bgfx::getCaps()->homogeneousDepth);
+
+		bgfx::setViewName(m_view, "GUI");
+		bgfx::setViewMode(m_view, bgfx::ViewMode::Sequential);
+		bgfx::setViewTransform(m_view, nullptr, ortho);
+		bgfx::setViewRect(m_view, 0, 0, uint16_t(width), uint16_t(height));
+
+		for (int32_t i = 0; i < draw_data.CmdListsCount; ++i)
+		{
+			const ImDrawList& list = *draw_data.CmdLists[i];
+			submitList(list, updateList(list), width, height);
+		}
+
+		m_stats.draw_lists = size_t(draw_data.CmdListsCount);
+		evictUnusedLists();
+	}
+
+	// Lists are compared by element counts before hashing, so a list which has changed size is never hashed twice
+	const GuiManager::CachedList& GuiManager::updateList(const ImDrawList& list)
+	{
+		auto it = m_lists.find(&list);
+		if (it == m_lists.end())
+		{
+			it = m_lists.emplace(&list, CachedList{ 0U, 0U, 0U, 0U, 0U, BGFX_INVALID_HANDLE, BGFX_INVALID_HANDLE, 0U }).first;
+		}
+
+		CachedList& cached = it->second;
+		cached.last_frame = m_frame;
+
+		const uint32_t vertex_count = uint32_t(list.VtxBuffer.Size);
+		const uint32_t index_count = uint32_t(list.IdxBuffer.Size);
+		if (vertex_count == 0U || index_count == 0U)
+		{
+			cached.vertex_count = cached.index_count = 0U;
+			return cached;
+		}
+
+		const bool same_size = (vertex_count == cached.vertex_count && index_count == cached.index_count);
+		const uint64_t hash = hashDrawList(list);
+		if (same_size && hash == cached.hash)
+		{
+			++m_stats.reused;
+			return cached;
+		}
+
+		if (vertex_count > cached.vertex_capacity)
+		{
+			if (bgfx::isValid(cached.vertices)) bgfx::destroy(cached.vertices);
+
+			cached.vertex_capacity = bufferCapacity(vertex_count);
+			cached.vertices = bgfx::createDynamicVertexBuffer(cached.vertex_capacity, m_layout);
+		}
+
+		if (index_count > cached.index_capacity)
+		{
+			if (bgfx::isValid(cached.indices)) bgfx::destroy(cached.indices);
+
+			cached.index_capacity = bufferCapacity(index_count);
+			cached.indices = bgfx::createDynamicIndexBuffer(cached.index_capacity);
+		}
+
+		const uint32_t vertex_bytes = vertex_count * uint32_t(sizeof(ImDrawVert));
+		const uint32_t index_bytes = index_count * uint32_t(sizeof(ImDrawIdx));
+		bgfx::update(cached.vertices, 0U, bgfx::copy(list.VtxBuffer.Data, vertex_bytes));
+		bgfx::update(cached.indices, 0U, bgfx::copy(list.IdxBuffer.Data, index_bytes));
+
+		cached.hash = hash;
+		cached.vertex_count = vertex_count;
+		cached.index_count = index_count;
+
+		++m_stats.uploaded;
+		m_stats.uploaded_bytes += (vertex_bytes + index_bytes);
+
+		return cached;
+	}
+
+	// Draw commands are submitted every frame, as they are cheap relative to uploading their geometry.  Commands
+	// whose clip rect is empty or lies entirely outside the display are skipped
+	void GuiManager::submitList(const ImDrawList& list, const CachedList& cached, float width, float height)
+	{
+		uint32_t offset = 0U;
+		for (const ImDrawCmd* cmd = list.CmdBuffer.begin(), *end = list.CmdBuffer.end(); cmd != end; ++cmd)
+		{
+			const ImVec4& clip = cmd->ClipRect;
+			const bool visible = (clip.x < width && clip.y < height && clip.z > std::max(clip.x, 0.0f) && clip.w > std::max(clip.y, 0.0f));
+
+			if (cmd->UserCallback)
+			{
+				cmd->UserCallback(&list, cmd);
+			}
+			else if (cmd->ElemCount != 0U && visible && offset + cmd->ElemCount <= cached.index_count)
+			{
+				uint64_t state = BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_MSAA;
+				bgfx::TextureHandle texture = m_font_texture;
+				bgfx::ProgramHandle program = m_program;
+
+				if (cmd->TextureId != nullptr)
+				{
+					union { ImTextureID ptr; struct { bgfx::TextureHandle handle; uint8_t flags; uint8_t mip; } s; } id = { cmd->TextureId };
+					if (id.s.flags & IMGUI_FLAGS_ALPHA_BLEND) state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+
+					texture = id.s.handle;
+					if (id.s.mip != 0U)
+					{
+						const float lod_enabled[4] = { float(id.s.mip), 1.0f, 0.0f, 0.0f };
+						bgfx::setUniform(m_image_lod, lod_enabled);
+						program = m_image_program;
+					}
+				}
+				else
+				{
+					state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+				}
+
+				const uint16_t x = uint16_t(std::max(clip.x, 0.0f));
+				const uint16_t y = uint16_t(std::max(clip.y, 0.0f));
+				bgfx::setScissor(x, y, uint16_t(std::min(clip.z, 65535.0f) - x), uint16_t(std::min(clip.w, 65535.0f) - y));
+
+				bgfx::setState(state);
+				bgfx::setTexture(0, m_sampler, texture);
+				bgfx::setVertexBuffer(0, cached.vertices, 0U, cached.vertex_count);
+				bgfx::setIndexBuffer(cached.indices, offset, cmd->ElemCount);
+				bgfx::submit(m_view, program);
+			}
+
+			offset += cmd->ElemCount;
+		}
+	}
+
+	// Draw lists of closed windows are released once they have been unused for some time, so that briefly hidden
+	// panels do not need to be re-uploaded
+	void GuiManager::evictUnusedLists()
+	{
+		for (auto it = m_lists.begin(); it != m_lists.end(); )
+		{
+			if ((m_frame - it->second.last_frame) > EVICTION_FRAMES)
+			{
+				destroyList(it->second);
+				it = m_lists.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	// FNV-1a over 64-bit words, with each word folded so that its high bits also reach the low bits of the hash
+	uint64_t GuiManager::hashDrawList(const ImDrawList& list)
+	{
+		const auto hashBytes = [](uint64_t hash, const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			const size_t words = size / sizeof(uint64_t);
+
+			for (size_t i = 0U; i < words; ++i)
+			{
+				uint64_t word;
+				std::memcpy(&word, bytes + (i * sizeof(uint64_t)), sizeof(uint64_t));
+				hash = (hash ^ word ^ (word >> 32)) * 0x100000001B3ULL;
+			}
+
+			for (size_t i = words * sizeof(uint64_t); i < size; ++i)
+			{
+				hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+			}
+
+			return hash;
+		};
+
+		uint64_t hash = 0xCBF29CE484222325ULL;
+		hash = hashBytes(hash, list.VtxBuffer.Data, size_t(list.VtxBuffer.Size) * sizeof(ImDrawVert));
+		hash = hashBytes(hash, list.IdxBuffer.Data, size_t(list.IdxBuffer.Size) * sizeof(ImDrawIdx));
+
+		return hash;
+	}
+
+	void GuiManager::destroyList(CachedList& cached)
+	{
+		if (bgfx::isValid(cached.vertices)) bgfx::destroy(cached.vertices);
+		if (bgfx::isValid(cached.indices)) bgfx::destroy(cached.indices);
+
+		cached.vertices = BGFX_INVALID_HANDLE;
+		cached.indices = BGFX_INVALID_HANDLE;
+	}
+
 	void GuiManager::shutdown()
 	{
 		LOG_INFO("Shutting down GUI manager");
 
+		for (auto& entry : m_lists) destroyList(entry.second);
+		m_lists.clear();
+
+		if (bgfx::isValid(m_font_texture)) bgfx::destroy(m_font_texture);
+		if (bgfx::isValid(m_program)) bgfx::destroy(m_program);
+		if (bgfx::isValid(m_image_program)) bgfx::destroy(m_image_program);
+		if (bgfx::isValid(m_sampler)) bgfx::destroy(m_sampler);
+		if (bgfx::isValid(m_image_lod)) bgfx::destroy(m_image_lod);
+
+		m_font_texture = BGFX_INVALID_HANDLE;
+		m_program = m_image_program = BGFX_INVALID_HANDLE;
+		m_sampler = m_image_lod = BGFX_INVALID_HANDLE;
+
 		imguiDestroy();
 	}
 }
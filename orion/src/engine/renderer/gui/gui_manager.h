@@ -1,14 +1,34 @@
 #pragma once
 
+#include <stdint.h>
+#include <unordered_map>
+#include "bgfx_utils.h"
 #include "../../../util/result_code.h"
 struct RendererInputState;
+struct ImDrawData;
+struct ImDrawList;
 
 namespace Orion
 {
+	// ImGui integration.  Draw lists are rendered from persistent buffers, one pair per window, which are only
+	// re-uploaded when the geometry of the window changes; an unchanged panel costs one hash of its vertex and
+	// index data and its draw submissions.  The vendored integration provides the context, fonts and embedded
+	// shaders, while all GPU resources are created here
 	class GuiManager
 	{
 	public:
 
+		// Buffers of draw lists which have not been rendered for this many frames are released
+		static const uint32_t EVICTION_FRAMES = 120U;
+
+		struct Stats
+		{
+			size_t		draw_lists;
+			size_t		reused;					// Draw lists rendered from their existing buffers in the last frame
+			size_t		uploaded;
+			size_t		uploaded_bytes;
+		};
+
 		GuiManager();
 
 		ResultCode initialise();
@@ -17,8 +37,53 @@ namespace Orion
 		ResultCode executeFrame(const RendererInputState& state);
 		ResultCode endFrame(const RendererInputState& state);
 
+		// View to which the GUI is submitted; must be set before the frame begins
+		inline void setViewId(bgfx::ViewId view) { m_view = view; }
+
+		inline Stats getStats() const { return m_stats; }
+
 		void shutdown();
 
 	private:
+
+		struct CachedList
+		{
+			uint64_t							hash;
+			uint32_t							vertex_count;
+			uint32_t							index_count;
+			uint32_t							vertex_capacity;
+			uint32_t							index_capacity;
+			bgfx::DynamicVertexBufferHandle		vertices;
+			bgfx::DynamicIndexBufferHandle		indices;
+			uint32_t							last_frame;			// Frame in which the list was last rendered
+		};
+
+		ResultCode createPrograms();
+		ResultCode createFontTexture();
+
+		void render(const ImDrawData& draw_data);
+		const CachedList& updateList(const ImDrawList& list);
+		void submitList(const ImDrawList& list, const CachedList& cached, float width, float height);
+		void evictUnusedLists();
+
+		static uint64_t hashDrawList(const ImDrawList& list);
+		static void destroyList(CachedList& cached);
+
+	private:
+
+		bgfx::ViewId											m_view;
+
+		bgfx::VertexLayout										m_layout;
+		bgfx::TextureHandle										m_font_texture;
+		bgfx::ProgramHandle										m_program;
+		bgfx::ProgramHandle										m_image_program;		// Images drawn at an explicit mip level
+		bgfx::UniformHandle										m_sampler;
+		bgfx::UniformHandle										m_image_lod;
+
+		// Keyed by the draw list of each window, which persists for the lifetime of the window
+		std::unordered_map<const ImDrawList*, CachedList>		m_lists;
+		uint32_t												m_frame;
+
+		Stats													m_stats;
 	};
 }
@@ -0,0 +1,347 @@
+#include <cmath>
+#include <algorithm>
+#include "../../../util/log.h"
+#include "../core/renderer_input_state.h"
+#include "../camera/camera.h"
+#include "../shader/shader_manager.h"
+
+#include "lighting_manager.h"
+
+namespace Orion
+{
+	// Default region covered by the light quadtree, until bounds are set for the active container
+	static const Vec2<float> DEFAULT_MIN_BOUNDS(-16384.0f, -16384.0f);
+	static const Vec2<float> DEFAULT_MAX_BOUNDS(+16384.0f, +16384.0f);
+
+	LightingManager::LightingManager()
+		:
+		m_lights(),
+		m_active(),
+		m_free_ids(),
+		m_tree(DEFAULT_MIN_BOUNDS, DEFAULT_MAX_BOUNDS),
+		m_query_stats({ 0U, 0U, 0U, 0U }),
+		m_min_bounds(DEFAULT_MIN_BOUNDS),
+		m_max_bounds(DEFAULT_MAX_BOUNDS),
+		m_max_radius(0.0f),
+		m_tree_dirty(false),
+		m_tile_size(TILE_SIZE),
+		m_grid_width(0U),
+		m_grid_height(0U),
+		m_ambient{ 0.1f, 0.1f, 0.1f, 0.0f },
+		m_light_texture(BGFX_INVALID_HANDLE),
+		m_grid_texture(BGFX_INVALID_HANDLE),
+		m_index_texture(BGFX_INVALID_HANDLE),
+		m_light_sampler(BGFX_INVALID_HANDLE),
+		m_grid_sampler(BGFX_INVALID_HANDLE),
+		m_index_sampler(BGFX_INVALID_HANDLE),
+		m_grid_uniform(BGFX_INVALID_HANDLE),
+		m_ambient_uniform(BGFX_INVALID_HANDLE),
+		m_stats({ 0U, 0U, 0U, 0U })
+	{
+	}
+
+	ResultCode LightingManager::initialise(const ShaderManager& shaders)
+	{
+		LOG_INFO("Initialising lighting manager");
+
+		const UniformId uniforms[] = {
+			shaders.getUniformId("s_lightData"), shaders.getUniformId("s_lightGrid"), shaders.getUniformId("s_lightIndices"),
+			shaders.getUniformId("u_lightGrid"), shaders.getUniformId("u_ambient")
+		};
+
+		if (std::any_of(std::begin(uniforms), std::end(uniforms), [](UniformId id) { return id.isNull(); }))
+		{
+			RETURN_LOG_ERROR("Lighting uniforms have not been defined", ResultCodes::FailedToInitialiseLighting);
+		}
+
+		m_light_sampler = shaders.getUniform(uniforms[0]);
+		m_grid_sampler = shaders.getUniform(uniforms[1]);
+		m_index_sampler = shaders.getUniform(uniforms[2]);
+		m_grid_uniform = shaders.getUniform(uniforms[3]);
+		m_ambient_uniform = shaders.getUniform(uniforms[4]);
+
+		// Lighting data is read by index, so must not be filtered
+		const uint64_t flags = BGFX_SAMPLER_POINT | BGFX_SAMPLER_UVW_CLAMP;
+		m_light_texture = bgfx::createTexture2D(TEXTURE_WIDTH, LIGHT_DATA_HEIGHT, false, 1U, bgfx::TextureFormat::RGBA32F, flags);
+		m_grid_texture = bgfx::createTexture2D(TEXTURE_WIDTH, GRID_HEIGHT, false, 1U, bgfx::TextureFormat::RG32F, flags);
+		m_index_texture = bgfx::createTexture2D(TEXTURE_WIDTH, INDEX_HEIGHT, false, 1U, bgfx::TextureFormat::R32F, flags);
+
+		if (!bgfx::isValid(m_light_texture) || !bgfx::isValid(m_grid_texture) || !bgfx::isValid(m_index_texture))
+		{
+			RETURN_LOG_ERROR("Failed to create lighting textures", ResultCodes::FailedToInitialiseLighting);
+		}
+
+		m_light_data.assign(size_t(TEXTURE_WIDTH) * LIGHT_DATA_HEIGHT * 4U, 0.0f);
+		m_grid_data.assign(size_t(TEXTURE_WIDTH) * GRID_HEIGHT * 2U, 0.0f);
+		m_index_data.assign(size_t(TEXTURE_WIDTH) * INDEX_HEIGHT, 0.0f);
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode LightingManager::beginFrame(const RendererInputState& state)
+	{
+		(void)state;
+		return ResultCodes::Success;
+	}
+
+	ResultCode LightingManager::executeFrame(const RendererInputState& state)
+	{
+		(void)state;
+		return ResultCodes::Success;
+	}
+
+	ResultCode LightingManager::endFrame(const RendererInputState& state)
+	{
+		(void)state;
+		return ResultCodes::Success;
+	}
+
+	void LightingManager::setBounds(Vec2<float> min_bounds, Vec2<float> max_bounds)
+	{
+		ASS(min_bounds < max_bounds, "Invalid lighting bounds; min=" << min_bounds << ", max=" << max_bounds);
+
+		m_min_bounds = min_bounds;
+		m_max_bounds = max_bounds;
+		m_tree_dirty = true;
+	}
+
+	LightId LightingManager::addLight(const PointLight& light)
+	{
+		LightId id;
+		if (!m_free_ids.empty())
+		{
+			id = m_free_ids.back();
+			m_free_ids.pop_back();
+			m_lights[id.index] = light;
+			m_active[id.index] = 1U;
+		}
+		else
+		{
+			if (m_lights.size() >= LightId::NONE)
+			{
+				LOG_WARN("Cannot add light; light limit reached");
+				return LightId();
+			}
+
+			id = LightId(static_cast<LightId::Index>(m_lights.size()));
+			m_lights.push_back(light);
+			m_active.push_back(1U);
+		}
+
+		m_tree_dirty = true;
+		return id;
+	}
+
+	void LightingManager::updateLight(LightId id, const PointLight& light)
+	{
+		ASS(id.index < m_lights.size() && m_active[id.index], "Invalid light ID: " << id.index);
+
+		m_lights[id.index] = light;
+		m_tree_dirty = true;
+	}
+
+	void LightingManager::removeLight(LightId id)
+	{
+		if (id.index >= m_lights.size() || !m_active[id.index]) return;
+
+		m_active[id.index] = 0U;
+		m_free_ids.push_back(id);
+		m_tree_dirty = true;
+	}
+
+	void LightingManager::clearLights()
+	{
+		m_lights.clear();
+		m_active.clear();
+		m_free_ids.clear();
+		m_tree_dirty = true;
+	}
+
+	void LightingManager::setAmbient(float r, float g, float b)
+	{
+		m_ambient[0] = r;
+		m_ambient[1] = g;
+		m_ambient[2] = b;
+	}
+
+	void LightingManager::rebuildTree()
+	{
+		// Lights change far less often than they are culled, so the tree is rebuilt in full on any change
+		m_tree = LightTree(m_min_bounds, m_max_bounds);
+		m_max_radius = 0.0f;
+		m_stats.lights = 0U;
+
+		for (LightId::Index i = 0U; i < m_lights.size(); ++i)
+		{
+			if (!m_active[i]) continue;
+
+			const auto& light = m_lights[i];
+			if (m_tree.addItem(LightNode{ LightId(i), light.position }) == LightTree::NO_NODE) continue;
+
+			m_max_radius = std::max(m_max_radius, light.radius);
+			++m_stats.lights;
+		}
+
+		m_tree_dirty = false;
+	}
+
+	ResultCode LightingManager::cullLights(const Camera& camera, float pixels_per_unit, const RendererInputState& state)
+	{
+		if (m_tree_dirty) rebuildTree();
+
+		// Tile size is increased for very large backbuffers so that the grid always covers the full view
+		m_tile_size = TILE_SIZE;
+		while (((state.width + m_tile_size - 1U) / m_tile_size) * ((state.height + m_tile_size - 1U) / m_tile_size) > uint32_t(TEXTURE_WIDTH) * GRID_HEIGHT)
+		{
+			m_tile_size *= 2U;
+		}
+
+		m_grid_width = static_cast<uint16_t>(std::max(1U, (state.width + m_tile_size - 1U) / m_tile_size));
+		m_grid_height = static_cast<uint16_t>(std::max(1U, (state.height + m_tile_size - 1U) / m_tile_size));
+		const size_t tile_count = size_t(m_grid_width) * m_grid_height;
+
+		m_visible.clear();
+		m_entries.clear();
+		m_stats.dropped = 0U;
+		m_query_stats = { 0U, 0U, 0U, 0U };
+
+		if (pixels_per_unit > 0.0f)
+		{
+			// Lights are held in the tree by position only, so the search region is extended by the largest radius
+			const auto centre = camera.getTopDownCameraPos();
+			const Vec2<float> extent(float(state.width) * 0.5f / pixels_per_unit + m_max_radius, float(state.height) * 0.5f / pixels_per_unit + m_max_radius);
+
+			m_candidates.clear();
+			m_tree.findItems(centre - extent, centre + extent, m_candidates, &m_query_stats);
+
+			float view_proj[16];
+			camera.getViewProjection(view_proj);
+
+			for (const auto& candidate : m_candidates)
+			{
+				if (m_visible.size() >= MAX_VISIBLE_LIGHTS)
+				{
+					++m_stats.dropped;
+					continue;
+				}
+
+				// Lights are only retained if they overlap at least one tile
+				const auto entries = m_entries.size();
+				binLight(static_cast<uint16_t>(m_visible.size()), m_lights[candidate.id.index], view_proj, pixels_per_unit, state);
+				if (m_entries.size() != entries) m_visible.push_back(candidate.id);
+			}
+		}
+
+		// Entries are sorted into contiguous per-tile ranges of the index list
+		m_tile_counts.assign(tile_count, 0U);
+		for (const auto& entry : m_entries) ++m_tile_counts[entry.tile];
+
+		const uint32_t capacity = uint32_t(TEXTURE_WIDTH) * INDEX_HEIGHT;
+		uint32_t offset = 0U;
+		m_tile_cursors.resize(tile_count);
+		m_stats.max_tile_lights = 0U;
+
+		for (size_t tile = 0U; tile < tile_count; ++tile)
+		{
+			const auto count = std::min({ m_tile_counts[tile], uint32_t(MAX_LIGHTS_PER_TILE), capacity - offset });
+			m_stats.dropped += (m_tile_counts[tile] - count);
+			m_stats.max_tile_lights = std::max(m_stats.max_tile_lights, size_t(count));
+
+			m_grid_data[tile * 2U + 0U] = float(offset);
+			m_grid_data[tile * 2U + 1U] = float(count);
+			m_tile_cursors[tile] = offset;
+			offset += count;
+			m_tile_counts[tile] = offset;		// End of the tile range, beyond which entries are discarded
+		}
+
+		for (const auto& entry : m_entries)
+		{
+			auto& cursor = m_tile_cursors[entry.tile];
+			if (cursor < m_tile_counts[entry.tile]) m_index_data[cursor++] = float(entry.light);
+		}
+
+		for (size_t i = 0U; i < m_visible.size(); ++i)
+		{
+			const auto& light = m_lights[m_visible[i].index];
+			float* data = &m_light_data[i * 8U];
+
+			data[0] = light.position.x;		data[1] = light.position.y;		data[2] = light.radius;			data[3] = light.intensity;
+			data[4] = light.colour[0];		data[5] = light.colour[1];		data[6] = light.colour[2];		data[7] = 0.0f;
+		}
+
+		uploadTexture(m_light_texture, m_light_data, 4U, m_visible.size() * 2U);
+		uploadTexture(m_grid_texture, m_grid_data, 2U, tile_count);
+		uploadTexture(m_index_texture, m_index_data, 1U, offset);
+
+		m_stats.visible_lights = m_visible.size();
+		return ResultCodes::Success;
+	}
+
+	void LightingManager::binLight(uint16_t visible_index, const PointLight& light, const float* view_proj, float pixels_per_unit, const RendererInputState& state)
+	{
+		// Pixel coordinates are measured from the bottom-left of the view, matching the lit atlas shader
+		const auto ndc = bx::mulH(bx::Vec3(light.position.x, light.position.y, 0.0f), view_proj);
+		const float x = (ndc.x * 0.5f + 0.5f) * float(state.width);
+		const float y = (ndc.y * 0.5f + 0.5f) * float(state.height);
+		const float radius = light.radius * pixels_per_unit;
+		const float tile_size = float(m_tile_size);
+
+		const int min_x = std::max(0, int(std::floor((x - radius) / tile_size)));
+		const int max_x = std::min(int(m_grid_width) - 1, int(std::floor((x + radius) / tile_size)));
+		const int min_y = std::max(0, int(std::floor((y - radius) / tile_size)));
+		const int max_y = std::min(int(m_grid_height) - 1, int(std::floor((y + radius) / tile_size)));
+
+		for (int ty = min_y; ty <= max_y; ++ty)
+		{
+			for (int tx = min_x; tx <= max_x; ++tx)
+			{
+				// Tiles within the light's bounding square are only included if the light reaches the nearest point of the tile
+				const float dx = std::clamp(x, float(tx) * tile_size, float(tx + 1) * tile_size) - x;
+				const float dy = std::clamp(y, float(ty) * tile_size, float(ty + 1) * tile_size) - y;
+				if ((dx * dx + dy * dy) > (radius * radius)) continue;
+
+				m_entries.push_back({ uint32_t(ty) * m_grid_width + uint32_t(tx), visible_index });
+			}
+		}
+	}
+
+	void LightingManager::uploadTexture(bgfx::TextureHandle texture, const std::vector<float>& data, uint16_t components, size_t count)
+	{
+		// Only the rows holding data for this frame are uploaded
+		const auto rows = static_cast<uint16_t>((count + TEXTURE_WIDTH - 1U) / TEXTURE_WIDTH);
+		if (rows == 0U) return;
+
+		const auto size = static_cast<uint32_t>(size_t(rows) * TEXTURE_WIDTH * components * sizeof(float));
+		bgfx::updateTexture2D(texture, 0U, 0U, 0U, 0U, TEXTURE_WIDTH, rows, bgfx::copy(data.data(), size));
+	}
+
+	void LightingManager::applyUniforms() const
+	{
+		const float grid[4] = { float(m_tile_size), float(m_grid_width), float(m_grid_height), 0.0f };
+		bgfx::setUniform(m_grid_uniform, grid);
+		bgfx::setUniform(m_ambient_uniform, m_ambient);
+	}
+
+	RenderConfig::Textures LightingManager::getTextures(const TextureUniformBinding& albedo) const
+	{
+		return RenderConfig::Textures(std::array<TextureUniformBinding, RenderConfig::Textures::MAX_TEXTURES>({
+			albedo,
+			TextureUniformBinding(m_light_texture, m_light_sampler),
+			TextureUniformBinding(m_grid_texture, m_grid_sampler),
+			TextureUniformBinding(m_index_texture, m_index_sampler)
+		}));
+	}
+
+	void LightingManager::shutdown()
+	{
+		LOG_INFO("Shutting down lighting manager");
+
+		for (auto texture : { m_light_texture, m_grid_texture, m_index_texture })
+		{
+			if (bgfx::isValid(texture)) bgfx::destroy(texture);
+		}
+
+		m_light_texture = m_grid_texture = m_index_texture = BGFX_INVALID_HANDLE;
+		clearLights();
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+#include "bgfx_utils.h"
+#include "../../../util/result_code.h"
+#include "../../../grid/quadtree.h"
+#include "../core/resource_id.h"
+#include "../queue/render_config.h"
+#include "point_light.h"
+struct RendererInputState;
+
+namespace Orion
+{
+	class Camera;
+	class ShaderManager;
+
+	// Tiled lighting for the tile layer.  Lights are registered in a quadtree and, each frame, those visible are
+	// binned into fixed-size screen tiles.  The per-tile light lists are uploaded as textures and read by the lit
+	// atlas shader, so that each pixel only evaluates the lights overlapping its tile
+	class LightingManager
+	{
+	public:
+
+		// Must match the constants in fs_instanced_atlas_lit
+		static const uint16_t TEXTURE_WIDTH = 128U;
+		static const uint16_t MAX_VISIBLE_LIGHTS = 1024U;
+		static const uint16_t MAX_LIGHTS_PER_TILE = 32U;
+		static const uint16_t LIGHT_DATA_HEIGHT = (MAX_VISIBLE_LIGHTS * 2U) / TEXTURE_WIDTH;		// Two texels per light
+		static const uint16_t GRID_HEIGHT = 128U;
+		static const uint16_t INDEX_HEIGHT = 128U;
+
+		// Tiles are enlarged beyond this size if the backbuffer would otherwise need more tiles than the grid holds
+		static const uint16_t TILE_SIZE = 32U;
+
+		struct Stats
+		{
+			size_t		lights;
+			size_t		visible_lights;
+			size_t		max_tile_lights;
+			size_t		dropped;				// Lights and tile entries discarded due to capacity limits
+		};
+
+		LightingManager();
+
+		ResultCode initialise(const ShaderManager& shaders);
+
+		ResultCode beginFrame(const RendererInputState& state);
+		ResultCode executeFrame(const RendererInputState& state);
+		ResultCode endFrame(const RendererInputState& state);
+
+		// Lights outside the bounds are retained but never rendered.  Changing the bounds rebuilds the quadtree
+		void setBounds(Vec2<float> min_bounds, Vec2<float> max_bounds);
+
+		// IDs of removed lights are reused by subsequent additions
+		LightId addLight(const PointLight& light);
+		void updateLight(LightId id, const PointLight& light);
+		void removeLight(LightId id);
+		void clearLights();
+
+		inline const PointLight& getLight(LightId id) const { return m_lights[id.index]; }
+
+		void setAmbient(float r, float g, float b);
+
+		// Culls lights against the screen tiles of the current view and uploads the per-tile light lists
+		ResultCode cullLights(const Camera& camera, float pixels_per_unit, const RendererInputState& state);
+
+		// Binds the lighting uniforms for the next draw submitted.  Called by the renderer for each draw of a config
+		// using RenderConfig::Uniforms::Lighting, following cullLights() in the frame
+		void applyUniforms() const;
+
+		// Albedo texture followed by the lighting textures, in the stages expected by the lit atlas shader
+		RenderConfig::Textures getTextures(const TextureUniformBinding& albedo) const;
+
+		inline Stats getStats() const { return m_stats; }
+
+		// Light position wrapper held by the quadtree
+		struct LightNode
+		{
+			LightId			id;
+			Vec2<float>		position;
+
+			inline Vec2<float> getPosition() const { return position; }
+			inline bool operator==(const LightNode& other) const { return id == other.id; }
+		};
+
+		typedef Quadtree<LightNode, float> LightTree;
+
+		// Spatial index of all lights, and the work performed querying it in the last call to cullLights
+		inline const LightTree& getTree() const { return m_tree; }
+		inline LightTree::QueryStats getQueryStats() const { return m_query_stats; }
+
+		void shutdown();
+
+	private:
+
+		struct TileEntry
+		{
+			uint32_t		tile;
+			uint16_t		light;			// Index into the visible light list
+		};
+
+		void rebuildTree();
+		void binLight(uint16_t visible_index, const PointLight& light, const float* view_proj, float pixels_per_unit, const RendererInputState& state);
+		void uploadTexture(bgfx::TextureHandle texture, const std::vector<float>& data, uint16_t components, size_t count);
+
+	private:
+
+		std::vector<PointLight>							m_lights;			// Indexed by LightId
+		std::vector<uint8_t>							m_active;			// Indexed by LightId
+		std::vector<LightId>							m_free_ids;
+
+		LightTree										m_tree;
+		LightTree::QueryStats							m_query_stats;
+		Vec2<float>										m_min_bounds;
+		Vec2<float>										m_max_bounds;
+		float											m_max_radius;		// Largest radius of any light in the tree
+		bool											m_tree_dirty;
+
+		// Per-frame culling state, retained to avoid reallocation
+		std::vector<LightNode>							m_candidates;
+		std::vector<LightId>							m_visible;
+		std::vector<TileEntry>							m_entries;
+		std::vector<uint32_t>							m_tile_counts;
+		std::vector<uint32_t>							m_tile_cursors;
+		std::vector<float>								m_light_data;
+		std::vector<float>								m_grid_data;
+		std::vector<float>								m_index_data;
+
+		uint16_t										m_tile_size;
+		uint16_t										m_grid_width;
+		uint16_t										m_grid_height;
+		float											m_ambient[4];
+
+		bgfx::TextureHandle								m_light_texture;	// RGBA32F; position, radius and intensity, then colour
+		bgfx::TextureHandle								m_grid_texture;		// RG32F; offset and count in the index list for each tile
+		bgfx::TextureHandle								m_index_texture;	// R32F; visible light index for each tile entry
+
+		bgfx::UniformHandle								m_light_sampler;
+		bgfx::UniformHandle								m_grid_sampler;
+		bgfx::UniformHandle								m_index_sampler;
+		bgfx::UniformHandle								m_grid_uniform;
+		bgfx::UniformHandle								m_ambient_uniform;
+
+		Stats											m_stats;
+	};
+}
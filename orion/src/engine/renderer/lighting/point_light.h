@@ -0,0 +1,15 @@
+#pragma once
+
+#include "../../../math/vec2.h"
+
+namespace Orion
+{
+	// Point light on the tile plane.  Contribution falls off quadratically to zero at the light radius
+	struct PointLight
+	{
+		Vec2<float>		position;
+		float			radius;
+		float			intensity;
+		float			colour[3];		// Linear RGB
+	};
+}
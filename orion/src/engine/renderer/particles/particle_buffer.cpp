@@ -0,0 +1,203 @@
+#include <algorithm>
+#include "../../../util/simd.h"
+#include "../../../util/debug.h"
+
+#include "particle_buffer.h"
+
+namespace Orion
+{
+	ParticleBuffer::ParticleBuffer()
+		:
+		m_count(0U),
+		m_capacity(0U)
+	{
+	}
+
+	void ParticleBuffer::allocate(size_t capacity)
+	{
+		m_count = 0U;
+		m_capacity = capacity;
+
+		for (auto* stream : { &m_position_x, &m_position_y, &m_position_z, &m_velocity_x, &m_velocity_y, &m_velocity_z, &m_age, &m_age_rate })
+		{
+			stream->assign(capacity, 0.0f);
+		}
+	}
+
+	void ParticleBuffer::add(const float(&position)[3], const float(&velocity)[3], float lifetime)
+	{
+		ASS(m_count < m_capacity, "Particle buffer is full (" << m_capacity << " particles)");
+
+		const size_t i = m_count++;
+		m_position_x[i] = position[0];
+		m_position_y[i] = position[1];
+		m_position_z[i] = position[2];
+		m_velocity_x[i] = velocity[0];
+		m_velocity_y[i] = velocity[1];
+		m_velocity_z[i] = velocity[2];
+		m_age[i] = 0.0f;
+		m_age_rate[i] = 1.0f / std::max(lifetime, 0.001f);
+	}
+
+	void ParticleBuffer::clear()
+	{
+		m_count = 0U;
+	}
+
+	void ParticleBuffer::integrate(size_t begin, size_t end, float dt, const float(&acceleration)[3], float damping)
+	{
+		size_t i = begin;
+
+#		if ORION_SIMD_SSE
+		const __m128 v_dt = _mm_set1_ps(dt);
+		const __m128 v_damping = _mm_set1_ps(damping);
+		const __m128 v_accel_x = _mm_set1_ps(acceleration[0] * dt);
+		const __m128 v_accel_y = _mm_set1_ps(acceleration[1] * dt);
+		const __m128 v_accel_z = _mm_set1_ps(acceleration[2] * dt);
+
+		for (; i + size_t(Simd::WIDTH) <= end; i += size_t(Simd::WIDTH))
+		{
+			const __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocity_x[i]), v_accel_x), v_damping);
+			const __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocity_y[i]), v_accel_y), v_damping);
+			const __m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocity_z[i]), v_accel_z), v_damping);
+
+			_mm_storeu_ps(&m_velocity_x[i], vx);
+			_mm_storeu_ps(&m_velocity_y[i], vy);
+			_mm_storeu_ps(&m_velocity_z[i], vz);
+
+			_mm_storeu_ps(&m_position_x[i], _mm_add_ps(_mm_loadu_ps(&m_position_x[i]), _mm_mul_ps(vx, v_dt)));
+			_mm_storeu_ps(&m_position_y[i], _mm_add_ps(_mm_loadu_ps(&m_position_y[i]), _mm_mul_ps(vy, v_dt)));
+			_mm_storeu_ps(&m_position_z[i], _mm_add_ps(_mm_loadu_ps(&m_position_z[i]), _mm_mul_ps(vz, v_dt)));
+
+			_mm_storeu_ps(&m_age[i], _mm_add_ps(_mm_loadu_ps(&m_age[i]), _mm_mul_ps(_mm_loadu_ps(&m_age_rate[i]), v_dt)));
+		}
+#		endif
+
+		for (; i < end; ++i)
+		{
+			m_velocity_x[i] = (m_velocity_x[i] + acceleration[0] * dt) * damping;
+			m_velocity_y[i] = (m_velocity_y[i] + acceleration[1] * dt) * damping;
+			m_velocity_z[i] = (m_velocity_z[i] + acceleration[2] * dt) * damping;
+
+			m_position_x[i] += m_velocity_x[i] * dt;
+			m_position_y[i] += m_velocity_y[i] * dt;
+			m_position_z[i] += m_velocity_z[i] * dt;
+
+			m_age[i] += m_age_rate[i] * dt;
+		}
+	}
+
+	size_t ParticleBuffer::removeExpired()
+	{
+		const size_t initial_count = m_count;
+
+		size_t i = 0U;
+		while (i < m_count)
+		{
+			if (m_age[i] >= 1.0f)	remove(i);
+			else					++i;
+		}
+
+		return initial_count - m_count;
+	}
+
+	void ParticleBuffer::remove(size_t index)
+	{
+		const size_t last = --m_count;
+		if (index == last) return;
+
+		m_position_x[index] = m_position_x[last];
+		m_position_y[index] = m_position_y[last];
+		m_position_z[index] = m_position_z[last];
+		m_velocity_x[index] = m_velocity_x[last];
+		m_velocity_y[index] = m_velocity_y[last];
+		m_velocity_z[index] = m_velocity_z[last];
+		m_age[index] = m_age[last];
+		m_age_rate[index] = m_age_rate[last];
+	}
+
+	void ParticleBuffer::writeInstances(size_t begin, size_t end, const ParticleEmitterDesc& desc, ParticleInstanceData* outInstances,
+		const float* view_proj, float* outDepth) const
+	{
+		const float size_delta = desc.size[1] - desc.size[0];
+		const float colour_delta[4] = {
+			desc.colour_end[0] - desc.colour_start[0], desc.colour_end[1] - desc.colour_start[1],
+			desc.colour_end[2] - desc.colour_start[2], desc.colour_end[3] - desc.colour_start[3]
+		};
+
+		// Depth is the clip-space w of each particle, which increases with distance from the camera
+		const bool write_depth = (view_proj != nullptr && outDepth != nullptr);
+		size_t i = begin;
+
+#		if ORION_SIMD_SSE
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 size_start = _mm_set1_ps(desc.size[0]);
+		const __m128 size_scale = _mm_set1_ps(size_delta);
+
+		__m128 colour_start[4], colour_scale[4];
+		for (int c = 0; c < 4; ++c)
+		{
+			colour_start[c] = _mm_set1_ps(desc.colour_start[c]);
+			colour_scale[c] = _mm_set1_ps(colour_delta[c]);
+		}
+
+		// Particles are processed in groups of four, then transposed from streams into per-instance vectors
+		for (; i + size_t(Simd::WIDTH) <= end; i += size_t(Simd::WIDTH))
+		{
+			const __m128 age = _mm_min_ps(_mm_loadu_ps(&m_age[i]), one);
+
+			__m128 x = _mm_loadu_ps(&m_position_x[i]);
+			__m128 y = _mm_loadu_ps(&m_position_y[i]);
+			__m128 z = _mm_loadu_ps(&m_position_z[i]);
+			__m128 size = _mm_add_ps(size_start, _mm_mul_ps(size_scale, age));
+
+			if (write_depth)
+			{
+				const __m128 w = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(view_proj[3])), _mm_mul_ps(y, _mm_set1_ps(view_proj[7]))),
+					_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(view_proj[11])), _mm_set1_ps(view_proj[15])));
+				_mm_storeu_ps(outDepth + (i - begin), w);
+			}
+
+			__m128 r = _mm_add_ps(colour_start[0], _mm_mul_ps(colour_scale[0], age));
+			__m128 g = _mm_add_ps(colour_start[1], _mm_mul_ps(colour_scale[1], age));
+			__m128 b = _mm_add_ps(colour_start[2], _mm_mul_ps(colour_scale[2], age));
+			__m128 a = _mm_add_ps(colour_start[3], _mm_mul_ps(colour_scale[3], age));
+
+			_MM_TRANSPOSE4_PS(x, y, z, size);
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+
+			ParticleInstanceData* out = outInstances + (i - begin);
+			_mm_storeu_ps(out[0].position_size, x);
+			_mm_storeu_ps(out[1].position_size, y);
+			_mm_storeu_ps(out[2].position_size, z);
+			_mm_storeu_ps(out[3].position_size, size);
+			_mm_storeu_ps(out[0].colour, r);
+			_mm_storeu_ps(out[1].colour, g);
+			_mm_storeu_ps(out[2].colour, b);
+			_mm_storeu_ps(out[3].colour, a);
+		}
+#		endif
+
+		for (; i < end; ++i)
+		{
+			const float age = std::min(m_age[i], 1.0f);
+			ParticleInstanceData& out = outInstances[i - begin];
+
+			out.position_size[0] = m_position_x[i];
+			out.position_size[1] = m_position_y[i];
+			out.position_size[2] = m_position_z[i];
+			out.position_size[3] = desc.size[0] + size_delta * age;
+
+			for (int c = 0; c < 4; ++c)
+			{
+				out.colour[c] = desc.colour_start[c] + colour_delta[c] * age;
+			}
+
+			if (write_depth)
+			{
+				outDepth[i - begin] = (m_position_x[i] * view_proj[3]) + (m_position_y[i] * view_proj[7]) + (m_position_z[i] * view_proj[11]) + view_proj[15];
+			}
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include "../queue/render_instance.h"
+#include "particle_emitter.h"
+
+namespace Orion
+{
+	// Structure-of-arrays particle storage for a single emitter.  Each attribute is held in its own stream so that
+	// simulation can process Simd::WIDTH particles per operation.  Particles are unordered; removal moves the last
+	// particle into the vacated slot.  Age is normalised to [0, 1) over the lifetime of each particle
+	class ParticleBuffer
+	{
+	public:
+
+		ParticleBuffer();
+
+		// Capacity is fixed once allocated, so that simulation never reallocates the streams
+		void allocate(size_t capacity);
+
+		inline size_t size() const { return m_count; }
+		inline size_t capacity() const { return m_capacity; }
+		inline bool isFull() const { return m_count == m_capacity; }
+
+		void add(const float(&position)[3], const float(&velocity)[3], float lifetime);
+		void clear();
+
+		// Advances all particles in [begin, end) by dt seconds.  Velocity is scaled by damping after acceleration is applied
+		void integrate(size_t begin, size_t end, float dt, const float(&acceleration)[3], float damping);
+
+		// Removes all particles which have reached the end of their lifetime, returning the number removed
+		size_t removeExpired();
+
+		// Writes render instances for particles in [begin, end), interpolating size and colour by age.  If outDepth is
+		// provided, it receives the view depth of each particle under the given view-projection transform
+		void writeInstances(size_t begin, size_t end, const ParticleEmitterDesc& desc, ParticleInstanceData* outInstances,
+			const float* view_proj = nullptr, float* outDepth = nullptr) const;
+
+	private:
+
+		void remove(size_t index);
+
+	private:
+
+		size_t					m_count;
+		size_t					m_capacity;
+
+		std::vector<float>		m_position_x;
+		std::vector<float>		m_position_y;
+		std::vector<float>		m_position_z;
+		std::vector<float>		m_velocity_x;
+		std::vector<float>		m_velocity_y;
+		std::vector<float>		m_velocity_z;
+		std::vector<float>		m_age;
+		std::vector<float>		m_age_rate;			// Reciprocal of lifetime
+	};
+}
@@ -0,0 +1,65 @@
+#include <cmath>
+#include <iterator>
+#include <algorithm>
+
+#include "particle_effects.h"
+
+namespace Orion
+{
+	ParticleEmitterDesc ParticleEffects::explosion(const float(&position)[3], uint32_t particle_count)
+	{
+		ParticleEmitterDesc desc = { };
+		std::copy(std::begin(position), std::end(position), desc.position);
+		desc.spawn_radius = 2.0f;
+
+		desc.direction[0] = 1.0f;
+		desc.spread = 3.14159265f;
+		desc.speed[0] = 20.0f;				desc.speed[1] = 120.0f;
+		desc.vertical_speed[0] = 0.0f;		desc.vertical_speed[1] = 30.0f;
+
+		desc.lifetime[0] = 0.4f;			desc.lifetime[1] = 1.2f;
+		desc.size[0] = 3.0f;				desc.size[1] = 0.5f;
+		const float colour_start[4] = { 1.0f, 0.8f, 0.3f, 1.0f };
+		const float colour_end[4] = { 0.8f, 0.1f, 0.0f, 0.0f };
+		std::copy(std::begin(colour_start), std::end(colour_start), desc.colour_start);
+		std::copy(std::begin(colour_end), std::end(colour_end), desc.colour_end);
+
+		desc.drag = 0.9f;
+
+		// All particles are spawned by the burst, after which the emitter stops on its first update
+		desc.burst = particle_count;
+		desc.duration = 0.001f;
+		desc.max_particles = particle_count;
+
+		desc.blend = ParticleBlend::Additive;
+		return desc;
+	}
+
+	ParticleEmitterDesc ParticleEffects::venting(const float(&position)[3], const float(&direction)[2], float particles_per_second)
+	{
+		ParticleEmitterDesc desc = { };
+		std::copy(std::begin(position), std::end(position), desc.position);
+		desc.spawn_radius = 1.0f;
+
+		std::copy(std::begin(direction), std::end(direction), desc.direction);
+		desc.spread = 0.3f;
+		desc.speed[0] = 40.0f;				desc.speed[1] = 80.0f;
+		desc.vertical_speed[0] = 5.0f;		desc.vertical_speed[1] = 20.0f;
+
+		desc.lifetime[0] = 1.0f;			desc.lifetime[1] = 2.5f;
+		desc.size[0] = 1.0f;				desc.size[1] = 6.0f;
+		const float colour_start[4] = { 0.85f, 0.9f, 1.0f, 0.5f };
+		const float colour_end[4] = { 0.85f, 0.9f, 1.0f, 0.0f };
+		std::copy(std::begin(colour_start), std::end(colour_start), desc.colour_start);
+		std::copy(std::begin(colour_end), std::end(colour_end), desc.colour_end);
+
+		desc.drag = 0.6f;
+
+		// Sufficient capacity for a full lifetime of particles at the given rate
+		desc.rate = particles_per_second;
+		desc.max_particles = static_cast<uint32_t>(std::ceil(particles_per_second * desc.lifetime[1]));
+
+		desc.blend = ParticleBlend::Alpha;
+		return desc;
+	}
+}
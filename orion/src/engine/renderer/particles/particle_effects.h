@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include "particle_emitter.h"
+
+namespace Orion
+{
+	// Emitter descriptions for common effects, which may be adjusted before the emitter is added
+	class ParticleEffects
+	{
+	public:
+
+		// Single additive burst in all directions; the emitter is removed once its particles have expired
+		static ParticleEmitterDesc explosion(const float(&position)[3], uint32_t particle_count);
+
+		// Continuous alpha-blended stream of gas escaping in the given direction, e.g. from a hull breach
+		static ParticleEmitterDesc venting(const float(&position)[3], const float(&direction)[2], float particles_per_second);
+	};
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace Orion
+{
+	// Additive particles may be drawn in any order.  Alpha-blended particles are sorted back-to-front before rendering
+	enum class ParticleBlend
+	{
+		Additive = 0,
+		Alpha
+	};
+
+	// Describes the particles spawned by an emitter.  Each (min, max) range is sampled uniformly per particle.  Particles
+	// are emitted in the ground plane within the spread half-angle (in radians) around the emitter direction, with an
+	// optional vertical speed towards the top-down camera, and are interpolated from their start to end size and colour
+	// over their lifetime
+	struct ParticleEmitterDesc
+	{
+		float			position[3];
+		float			spawn_radius;			// Particles are spawned at a random point within this distance of the emitter
+
+		float			direction[2];
+		float			spread;
+		float			speed[2];
+		float			vertical_speed[2];
+
+		float			lifetime[2];			// Seconds
+		float			size[2];				// Radius at the start and end of each particle's life
+		float			colour_start[4];
+		float			colour_end[4];
+
+		float			acceleration[3];
+		float			drag;					// Proportion of velocity lost per second
+
+		float			rate;					// Particles spawned per second while the emitter is active
+		uint32_t		burst;					// Particles spawned immediately when the emitter is added
+		float			duration;				// Seconds for which the emitter spawns particles, or zero for no limit
+		uint32_t		max_particles;
+
+		ParticleBlend	blend;
+	};
+}
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include "../../../util/log.h"
+#include "../core/renderer_input_state.h"
+#include "../camera/camera.h"
+#include "../shader/shader_manager.h"
+#include "../geometry/geometry_manager.h"
+
+#include "particle_manager.h"
+
+namespace Orion
+{
+	// Particles are composited over the scene without writing depth; colour is premultiplied by alpha in the shader
+	static const uint64_t PARTICLE_STATE_BASE = BGFX_STATE_WRITE_RGB | BGFX_STATE_DEPTH_TEST_LESS | BGFX_STATE_CULL_CW | BGFX_STATE_MSAA;
+	static const uint64_t PARTICLE_STATE_ADDITIVE = PARTICLE_STATE_BASE | BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_ONE);
+	static const uint64_t PARTICLE_STATE_ALPHA = PARTICLE_STATE_BASE | BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+
+	ParticleManager::ParticleManager()
+		:
+		m_workers(nullptr),
+		m_shaders(nullptr),
+		m_geometry(nullptr),
+		m_program(),
+		m_mesh(),
+		m_system()
+	{
+	}
+
+	ResultCode ParticleManager::initialise(ThreadPool& workers, const ShaderManager& shaders, const GeometryManager& geometry)
+	{
+		LOG_INFO("Initialising particle manager");
+
+		m_workers = &workers;
+		m_shaders = &shaders;
+		m_geometry = &geometry;
+
+		// Resources are held by ID so that hot-reloaded shaders are picked up on the next submission
+		m_program = shaders.getProgramId("inst_particle");
+		m_mesh = geometry.getMeshId("quad");
+
+		if (m_program.isNull() || m_mesh.isNull())
+		{
+			RETURN_LOG_ERROR("Particle shader or mesh has not been loaded", ResultCodes::FailedToInitialiseParticles);
+		}
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode ParticleManager::beginFrame(const RendererInputState& state)
+	{
+		(void)state;
+		return ResultCodes::Success;
+	}
+
+	ResultCode ParticleManager::executeFrame(const RendererInputState& state)
+	{
+		const float dt = std::min(state.frame_ms * 0.001f, MAX_TIME_STEP);
+		if (dt > 0.0f) m_system.update(dt, *m_workers);
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode ParticleManager::endFrame(const RendererInputState& state)
+	{
+		(void)state;
+		return ResultCodes::Success;
+	}
+
+	void ParticleManager::submit(RenderQueue<ParticleInstanceData>& queue, const Camera& camera)
+	{
+		const size_t additive_count = m_system.getParticleCount(ParticleBlend::Additive);
+		const size_t alpha_count = m_system.getParticleCount(ParticleBlend::Alpha);
+		if (additive_count == 0U && alpha_count == 0U) return;
+
+		const auto shader = m_shaders->getProgram(m_program);
+		const auto& mesh = m_geometry->getMesh(m_mesh);
+
+		// Instances are written directly into the queue, one slot per blend mode
+		ParticleInstanceData* additive = (additive_count != 0U ? queue.allocate(RenderConfig(shader, mesh, PARTICLE_STATE_ADDITIVE), additive_count) : nullptr);
+		ParticleInstanceData* alpha = (alpha_count != 0U ? queue.allocate(RenderConfig(shader, mesh, PARTICLE_STATE_ALPHA), alpha_count) : nullptr);
+
+		float view_proj[16];
+		camera.getViewProjection(view_proj);
+
+		m_system.writeInstances(view_proj, additive, alpha, *m_workers);
+	}
+
+	void ParticleManager::shutdown()
+	{
+		LOG_INFO("Shutting down particle manager");
+
+		m_system.clear();
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "bgfx_utils.h"
+#include "../../../util/result_code.h"
+#include "../core/resource_id.h"
+#include "../queue/render_queue.h"
+#include "../queue/render_instance.h"
+#include "particle_system.h"
+struct RendererInputState;
+
+namespace Orion
+{
+	class Camera;
+	class ShaderManager;
+	class GeometryManager;
+
+	// Renderer integration for the particle system.  Particles are simulated on the worker pool each frame, and
+	// submitted through the particle render queue as one instanced draw per blend mode
+	class ParticleManager
+	{
+	public:
+
+		// Simulation steps are clamped to this length, so that a long frame cannot eject particles far beyond their emitters
+		static constexpr float MAX_TIME_STEP = 0.1f;
+
+		ParticleManager();
+
+		ResultCode initialise(ThreadPool& workers, const ShaderManager& shaders, const GeometryManager& geometry);
+
+		ResultCode beginFrame(const RendererInputState& state);
+		ResultCode executeFrame(const RendererInputState& state);
+		ResultCode endFrame(const RendererInputState& state);
+
+		inline ParticleEmitterId addEmitter(const ParticleEmitterDesc& desc) { return m_system.addEmitter(desc); }
+		inline void setEmitterPosition(ParticleEmitterId id, const float(&position)[3]) { m_system.setEmitterPosition(id, position); }
+		inline void stopEmitter(ParticleEmitterId id) { m_system.stopEmitter(id); }
+		inline void removeEmitter(ParticleEmitterId id) { m_system.removeEmitter(id); }
+
+		// Writes instances for all live particles into the render queue, sorted as required for the current view
+		void submit(RenderQueue<ParticleInstanceData>& queue, const Camera& camera);
+
+		inline ParticleSystem::Stats getStats() const { return m_system.getStats(); }
+
+		void shutdown();
+
+	private:
+
+		ThreadPool *				m_workers;
+		const ShaderManager *		m_shaders;
+		const GeometryManager *		m_geometry;
+
+		ProgramId					m_program;
+		MeshId						m_mesh;
+
+		ParticleSystem				m_system;
+	};
+}
@@ -0,0 +1,300 @@
+#include <cmath>
+#include <algorithm>
+#include "../../../util/debug.h"
+#include "../../../util/log.h"
+
+#include "particle_system.h"
+
+namespace Orion
+{
+	ParticleSystem::ParticleSystem()
+		:
+		m_emitters(),
+		m_active(),
+		m_free_ids(),
+		m_next_seed(0x9E3779B9U),
+		m_stats({ 0U, 0U, 0U, 0U })
+	{
+	}
+
+	ParticleEmitterId ParticleSystem::addEmitter(const ParticleEmitterDesc& desc)
+	{
+		ParticleEmitterId id;
+		if (!m_free_ids.empty())
+		{
+			id = m_free_ids.back();
+			m_free_ids.pop_back();
+		}
+		else
+		{
+			if (m_emitters.size() >= ParticleEmitterId::NONE)
+			{
+				LOG_WARN("Cannot add particle emitter; emitter limit reached");
+				return ParticleEmitterId();
+			}
+
+			id = ParticleEmitterId(static_cast<ParticleEmitterId::Index>(m_emitters.size()));
+			m_emitters.emplace_back();
+			m_active.push_back(0U);
+		}
+
+		// Each emitter has its own random sequence, so that spawning is deterministic regardless of update order
+		m_next_seed = (m_next_seed * 1664525U) + 1013904223U;
+
+		Emitter& emitter = m_emitters[id.index];
+		emitter.desc = desc;
+		emitter.particles.allocate(desc.max_particles);
+		emitter.elapsed = 0.0f;
+		emitter.pending_spawns = float(desc.burst);
+		emitter.spawning = true;
+		emitter.random = (m_next_seed != 0U ? m_next_seed : 1U);
+
+		m_active[id.index] = 1U;
+		++m_stats.emitters;
+
+		return id;
+	}
+
+	void ParticleSystem::setEmitterPosition(ParticleEmitterId id, const float(&position)[3])
+	{
+		ASS(isActive(id), "Invalid particle emitter ID: " << id.index);
+		std::copy(std::begin(position), std::end(position), m_emitters[id.index].desc.position);
+	}
+
+	void ParticleSystem::stopEmitter(ParticleEmitterId id)
+	{
+		if (!isActive(id)) return;
+
+		m_emitters[id.index].spawning = false;
+		m_emitters[id.index].pending_spawns = 0.0f;
+	}
+
+	void ParticleSystem::removeEmitter(ParticleEmitterId id)
+	{
+		if (!isActive(id)) return;
+
+		m_stats.particles -= m_emitters[id.index].particles.size();
+		m_emitters[id.index].particles.clear();
+		m_active[id.index] = 0U;
+		m_free_ids.push_back(id);
+
+		--m_stats.emitters;
+	}
+
+	void ParticleSystem::clear()
+	{
+		m_emitters.clear();
+		m_active.clear();
+		m_free_ids.clear();
+
+		m_stats = { 0U, 0U, 0U, 0U };
+	}
+
+	void ParticleSystem::update(float dt, ThreadPool& pool)
+	{
+		// Existing particles are simulated in parallel, before any are removed or spawned
+		buildChunks();
+		pool.parallelFor(m_chunks.size(), [this, dt](size_t i)
+		{
+			const Chunk& chunk = m_chunks[i];
+			Emitter& emitter = m_emitters[chunk.emitter];
+
+			const float damping = std::pow(std::max(1.0f - emitter.desc.drag, 0.0f), dt);
+			emitter.particles.integrate(chunk.begin, chunk.end, dt, emitter.desc.acceleration, damping);
+		});
+
+		m_stats.particles = 0U;
+		m_stats.dropped = 0U;
+
+		for (size_t i = 0U; i < m_emitters.size(); ++i)
+		{
+			if (!m_active[i]) continue;
+
+			Emitter& emitter = m_emitters[i];
+			emitter.particles.removeExpired();
+			spawnParticles(emitter, dt);
+
+			emitter.elapsed += dt;
+			if (emitter.spawning && emitter.desc.duration > 0.0f && emitter.elapsed >= emitter.desc.duration)
+			{
+				emitter.spawning = false;
+				emitter.pending_spawns = 0.0f;
+			}
+
+			if (!emitter.spawning && emitter.particles.size() == 0U)
+			{
+				removeEmitter(ParticleEmitterId(static_cast<ParticleEmitterId::Index>(i)));
+				continue;
+			}
+
+			m_stats.particles += emitter.particles.size();
+		}
+	}
+
+	void ParticleSystem::spawnParticles(Emitter& emitter, float dt)
+	{
+		const ParticleEmitterDesc& desc = emitter.desc;
+		if (emitter.spawning) emitter.pending_spawns += desc.rate * dt;
+
+		const size_t requested = size_t(emitter.pending_spawns);
+		const size_t count = std::min(requested, emitter.particles.capacity() - emitter.particles.size());
+		emitter.pending_spawns -= float(requested);
+		m_stats.dropped += (requested - count);
+
+		const float base_angle = std::atan2(desc.direction[1], desc.direction[0]);
+		const float unit_range[2] = { 0.0f, 1.0f };
+		const float angle_range[2] = { base_angle - desc.spread, base_angle + desc.spread };
+
+		for (size_t i = 0U; i < count; ++i)
+		{
+			// Spawn points are distributed uniformly over the area of the spawn radius
+			const float offset_distance = desc.spawn_radius * std::sqrt(random(emitter.random, unit_range));
+			const float offset_angle = random(emitter.random, unit_range) * 6.2831853f;
+
+			const float angle = random(emitter.random, angle_range);
+			const float speed = random(emitter.random, desc.speed);
+
+			// The top-down camera looks along +z, so particles rising towards it have negative z velocity
+			const float position[3] = {
+				desc.position[0] + (std::cos(offset_angle) * offset_distance),
+				desc.position[1] + (std::sin(offset_angle) * offset_distance),
+				desc.position[2]
+			};
+			const float velocity[3] = { std::cos(angle) * speed, std::sin(angle) * speed, -random(emitter.random, desc.vertical_speed) };
+
+			emitter.particles.add(position, velocity, random(emitter.random, desc.lifetime));
+		}
+	}
+
+	size_t ParticleSystem::getParticleCount(ParticleBlend blend) const
+	{
+		size_t count = 0U;
+		for (size_t i = 0U; i < m_emitters.size(); ++i)
+		{
+			if (m_active[i] && m_emitters[i].desc.blend == blend) count += m_emitters[i].particles.size();
+		}
+
+		return count;
+	}
+
+	void ParticleSystem::buildChunks()
+	{
+		m_chunks.clear();
+
+		size_t output[2] = { 0U, 0U };		// Indexed by ParticleBlend
+		for (size_t i = 0U; i < m_emitters.size(); ++i)
+		{
+			if (!m_active[i]) continue;
+
+			const size_t count = m_emitters[i].particles.size();
+			size_t& offset = output[static_cast<size_t>(m_emitters[i].desc.blend)];
+
+			for (size_t begin = 0U; begin < count; begin += CHUNK_SIZE)
+			{
+				const size_t end = (count - begin > CHUNK_SIZE ? begin + CHUNK_SIZE : count);
+				m_chunks.push_back({ i, begin, end, offset });
+				offset += (end - begin);
+			}
+		}
+	}
+
+	void ParticleSystem::writeInstances(const float* view_proj, ParticleInstanceData* outAdditive, ParticleInstanceData* outAlpha, ThreadPool& pool)
+	{
+		buildChunks();
+
+		// Alpha-blended instances are written to an intermediate buffer, along with their depth, if they need sorting
+		const size_t alpha_count = getParticleCount(ParticleBlend::Alpha);
+		const bool sort = (alpha_count > 1U);
+		if (sort)
+		{
+			m_unsorted.resize(alpha_count);
+			m_depths.resize(alpha_count);
+		}
+
+		ParticleInstanceData* alpha_target = (sort ? m_unsorted.data() : outAlpha);
+		pool.parallelFor(m_chunks.size(), [this, view_proj, outAdditive, alpha_target, sort](size_t i)
+		{
+			const Chunk& chunk = m_chunks[i];
+			const Emitter& emitter = m_emitters[chunk.emitter];
+
+			if (emitter.desc.blend == ParticleBlend::Additive)
+			{
+				emitter.particles.writeInstances(chunk.begin, chunk.end, emitter.desc, outAdditive + chunk.output);
+			}
+			else
+			{
+				emitter.particles.writeInstances(chunk.begin, chunk.end, emitter.desc, alpha_target + chunk.output,
+					view_proj, (sort ? m_depths.data() + chunk.output : nullptr));
+			}
+		});
+
+		m_stats.sorted = 0U;
+		if (sort) sortBackToFront(outAlpha, pool);
+	}
+
+	// Depths are quantised into a fixed number of buckets and ordered with a single counting sort pass, since the
+	// full precision of a comparison sort is not needed to composite overlapping particles.  Particles within the
+	// same bucket retain their relative order.  If all particles lie at the same depth, no sort is required
+	void ParticleSystem::sortBackToFront(ParticleInstanceData* outAlpha, ThreadPool& pool)
+	{
+		const size_t count = m_unsorted.size();
+		const auto range = std::minmax_element(m_depths.cbegin(), m_depths.cend());
+		const float min_depth = *range.first;
+		const float max_depth = *range.second;
+
+		if ((max_depth - min_depth) <= (1e-5f * std::max(std::abs(max_depth), 1.0f)))
+		{
+			std::copy(m_unsorted.cbegin(), m_unsorted.cend(), outAlpha);
+			return;
+		}
+
+		// The most distant particles receive the lowest keys, so are drawn first
+		const float scale = float(SORT_BUCKETS - 1U) / (max_depth - min_depth);
+		m_keys.resize(count);
+		m_bucket_offsets.assign(SORT_BUCKETS, 0U);
+
+		for (size_t i = 0U; i < count; ++i)
+		{
+			const uint16_t key = static_cast<uint16_t>((max_depth - m_depths[i]) * scale);
+			m_keys[i] = key;
+			++m_bucket_offsets[key];
+		}
+
+		uint32_t offset = 0U;
+		for (auto& bucket : m_bucket_offsets)
+		{
+			const uint32_t bucket_count = bucket;
+			bucket = offset;
+			offset += bucket_count;
+		}
+
+		m_order.resize(count);
+		for (size_t i = 0U; i < count; ++i)
+		{
+			m_order[m_bucket_offsets[m_keys[i]]++] = static_cast<uint32_t>(i);
+		}
+
+		// Instances are gathered into the output in order, which parallelises and avoids scattered writes to the queue
+		pool.parallelFor((count + CHUNK_SIZE - 1U) / CHUNK_SIZE, [this, count, outAlpha](size_t chunk)
+		{
+			const size_t end = std::min<size_t>(count, (chunk + 1U) * CHUNK_SIZE);
+			for (size_t i = chunk * CHUNK_SIZE; i < end; ++i)
+			{
+				outAlpha[i] = m_unsorted[m_order[i]];
+			}
+		});
+
+		m_stats.sorted = count;
+	}
+
+	// Xorshift sequence per emitter, sampled uniformly within the range
+	float ParticleSystem::random(uint32_t& state, const float(&range)[2])
+	{
+		state ^= (state << 13);
+		state ^= (state >> 17);
+		state ^= (state << 5);
+
+		const float unit = float(state >> 8) * (1.0f / 16777216.0f);
+		return range[0] + ((range[1] - range[0]) * unit);
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "../../../util/thread_pool.h"
+#include "../core/resource_id.h"
+#include "../queue/render_instance.h"
+#include "particle_emitter.h"
+#include "particle_buffer.h"
+
+namespace Orion
+{
+	// CPU simulation of all particle emitters.  Particles are held per emitter in structure-of-arrays buffers, and both
+	// simulation and instance generation are split into fixed-size chunks which are processed across a thread pool.
+	// Alpha-blended particles from all emitters are sorted back-to-front together; additive particles are never sorted
+	class ParticleSystem
+	{
+	public:
+
+		// Particles per parallel task; a multiple of the SIMD width so that only the final chunk of each emitter has a remainder
+		static const size_t CHUNK_SIZE = 4096U;
+
+		// Resolution to which the depth range of alpha-blended particles is quantised for sorting
+		static const uint32_t SORT_BUCKETS = 4096U;
+
+		struct Stats
+		{
+			size_t		emitters;
+			size_t		particles;
+			size_t		sorted;					// Alpha-blended particles sorted in the last call to writeInstances
+			size_t		dropped;				// Particles not spawned in the last update due to emitter capacity
+		};
+
+		ParticleSystem();
+
+		// Emitters are removed automatically once their duration has elapsed and all of their particles have expired.
+		// IDs of removed emitters are reused by subsequent additions
+		ParticleEmitterId addEmitter(const ParticleEmitterDesc& desc);
+		void setEmitterPosition(ParticleEmitterId id, const float(&position)[3]);
+
+		// Stops an emitter spawning new particles; it is removed once its existing particles expire
+		void stopEmitter(ParticleEmitterId id);
+
+		// Removes an emitter and all of its particles immediately
+		void removeEmitter(ParticleEmitterId id);
+		void clear();
+
+		inline bool isActive(ParticleEmitterId id) const { return id.index < m_active.size() && m_active[id.index]; }
+
+		// Advances all particles by dt seconds, then spawns new particles from each active emitter
+		void update(float dt, ThreadPool& pool);
+
+		size_t getParticleCount(ParticleBlend blend) const;
+
+		// Writes render instances for all particles, split by blend mode.  Each output must have space for the number of
+		// particles returned by getParticleCount for its blend mode.  Alpha-blended instances are written back-to-front
+		// with respect to the given view-projection transform
+		void writeInstances(const float* view_proj, ParticleInstanceData* outAdditive, ParticleInstanceData* outAlpha, ThreadPool& pool);
+
+		inline Stats getStats() const { return m_stats; }
+
+	private:
+
+		struct Emitter
+		{
+			ParticleEmitterDesc		desc;
+			ParticleBuffer			particles;
+			float					elapsed;
+			float					pending_spawns;		// Fractional particles carried between updates
+			bool					spawning;
+			uint32_t				random;
+		};
+
+		// A contiguous range of particles from one emitter, and the offset of its output within the instances for its blend mode
+		struct Chunk
+		{
+			size_t					emitter;
+			size_t					begin;
+			size_t					end;
+			size_t					output;
+		};
+
+		void buildChunks();
+		void spawnParticles(Emitter& emitter, float dt);
+		void sortBackToFront(ParticleInstanceData* outAlpha, ThreadPool& pool);
+
+		static float random(uint32_t& state, const float(&range)[2]);
+
+	private:
+
+		std::vector<Emitter>					m_emitters;			// Indexed by ParticleEmitterId
+		std::vector<uint8_t>					m_active;			// Indexed by ParticleEmitterId
+		std::vector<ParticleEmitterId>			m_free_ids;
+		uint32_t								m_next_seed;
+
+		// Per-frame working state, retained to avoid reallocation
+		std::vector<Chunk>						m_chunks;
+		std::vector<ParticleInstanceData>		m_unsorted;
+		std::vector<float>						m_depths;
+		std::vector<uint16_t>					m_keys;
+		std::vector<uint32_t>					m_bucket_offsets;
+		std::vector<uint32_t>					m_order;
+
+		Stats									m_stats;
+	};
+}
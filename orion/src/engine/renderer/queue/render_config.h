@@ -4,6 +4,7 @@
 #include <functional>
 #include "bgfx_utils.h"
 #include "../shader/uniform_binding.h"
+#include "../geometry/basic_mesh.h"
 
 #define RENDER_CONFIG_FAST_HASH
 
@@ -44,20 +45,23 @@ namespace Orion
 			const uint8_t m_texture_count;	// Calculated field; number of texture slots being used
 		};
 
-		constexpr RenderConfig(bgfx::ProgramHandle shader, bgfx::VertexBufferHandle vertex_buffer, bgfx::IndexBufferHandle index_buffer,
-							   uint64_t state, const Textures & textures);
-
-		constexpr RenderConfig(bgfx::ProgramHandle shader, bgfx::VertexBufferHandle vertex_buffer, bgfx::IndexBufferHandle index_buffer,
-							   uint64_t state, Textures && textures);
+		// Sets of per-frame uniforms which are bound by the renderer alongside each draw of a config.  Uniform values
+		// do not persist between bgfx submissions, so cannot be set once for all draws in a frame
+		enum class Uniforms : uint8_t
+		{
+			None = 0,
+			Lighting
+		};
 
-		constexpr RenderConfig(bgfx::ProgramHandle shader, bgfx::VertexBufferHandle vertex_buffer, bgfx::IndexBufferHandle index_buffer,
-							   uint64_t state);
+		constexpr RenderConfig(bgfx::ProgramHandle shader, const BasicMesh & mesh, uint64_t state, const Textures & textures, Uniforms uniforms = Uniforms::None);
+		constexpr RenderConfig(bgfx::ProgramHandle shader, const BasicMesh & mesh, uint64_t state, Textures && textures, Uniforms uniforms = Uniforms::None);
+		constexpr RenderConfig(bgfx::ProgramHandle shader, const BasicMesh & mesh, uint64_t state);
 
 		constexpr inline const bgfx::ProgramHandle get_shader() const { return m_shader; }
-		constexpr inline const bgfx::VertexBufferHandle get_vertex_buffer() const { return m_vb; }
-		constexpr inline const bgfx::IndexBufferHandle get_index_buffer() const { return m_ib; }
+		constexpr inline const BasicMesh & get_mesh() const { return m_mesh; }
 		constexpr inline const uint64_t get_state() const { return m_state; }
 		constexpr inline const Textures & get_textures() const { return m_textures; }
+		constexpr inline const Uniforms get_uniforms() const { return m_uniforms; }
 		
 		constexpr inline const size_t hash() const { return m_hash; }
 
@@ -70,10 +74,10 @@ namespace Orion
 
 	private:
 		const bgfx::ProgramHandle m_shader;
-		const bgfx::VertexBufferHandle m_vb;
-		const bgfx::IndexBufferHandle m_ib;
+		const BasicMesh m_mesh;				// Range within the shared geometry buffers
 		const uint64_t m_state;
 		const Textures m_textures;
+		const Uniforms m_uniforms;
 
 		// Calculated fields
 		const size_t m_hash;			// Calculated on construction, objects are immutable
@@ -83,34 +87,33 @@ namespace Orion
 // Definitions
 namespace Orion
 {
-	constexpr RenderConfig::RenderConfig(bgfx::ProgramHandle shader, bgfx::VertexBufferHandle vertex_buffer, bgfx::IndexBufferHandle index_buffer,
-		uint64_t state, const Textures& textures)
+	constexpr RenderConfig::RenderConfig(bgfx::ProgramHandle shader, const BasicMesh& mesh, uint64_t state, const Textures& textures, Uniforms uniforms)
 		:
 		m_shader(shader),
-		m_vb(vertex_buffer),
-		m_ib(index_buffer),
+		m_mesh(mesh),
 		m_state(state),
 		m_textures(textures),
+		m_uniforms(uniforms),
 
 		m_hash(calculate_hash())
 	{
 	}
 
-	constexpr RenderConfig::RenderConfig(bgfx::ProgramHandle shader, bgfx::VertexBufferHandle vertex_buffer, bgfx::IndexBufferHandle index_buffer, uint64_t state, Textures&& textures)
+	constexpr RenderConfig::RenderConfig(bgfx::ProgramHandle shader, const BasicMesh& mesh, uint64_t state, Textures&& textures, Uniforms uniforms)
 		:
 		m_shader(shader),
-		m_vb(vertex_buffer),
-		m_ib(index_buffer),
+		m_mesh(mesh),
 		m_state(state),
 		m_textures(textures),
+		m_uniforms(uniforms),
 
 		m_hash(calculate_hash())
 	{
 	}
 
-	constexpr RenderConfig::RenderConfig(bgfx::ProgramHandle shader, bgfx::VertexBufferHandle vertex_buffer, bgfx::IndexBufferHandle index_buffer, uint64_t state)
+	constexpr RenderConfig::RenderConfig(bgfx::ProgramHandle shader, const BasicMesh& mesh, uint64_t state)
 		:
-		RenderConfig(shader, vertex_buffer, index_buffer, state, Textures::NO_TEXTURES)
+		RenderConfig(shader, mesh, state, Textures::NO_TEXTURES)
 	{
 	}
 
@@ -118,10 +121,13 @@ namespace Orion
 	{
 		size_t res = 17;
 		res = res * 31 + HASH_COMP(uint16_t, m_shader.idx);
-		res = res * 31 + HASH_COMP(uint16_t, m_vb.idx);
-		res = res * 31 + HASH_COMP(uint16_t, m_ib.idx);
+		res = res * 31 + HASH_COMP(uint16_t, m_mesh.vertex_buffer.idx);
+		res = res * 31 + HASH_COMP(uint32_t, m_mesh.base_vertex);
+		res = res * 31 + HASH_COMP(uint16_t, m_mesh.index_buffer.idx);
+		res = res * 31 + HASH_COMP(uint32_t, m_mesh.first_index);
 		res = res * 31 + HASH_COMP(uint64_t, m_state);
 		res = res * 31 + m_textures.calculate_hash_component();
+		res = res * 31 + HASH_COMP(uint8_t, static_cast<uint8_t>(m_uniforms));
 
 		return res;
 	}
@@ -131,10 +137,14 @@ namespace Orion
 		// TODO: Can delegate this to the hash function, assuming all idx combinations are unique?
 		return
 			m_shader.idx == other.m_shader.idx &&
-			m_vb.idx == other.m_vb.idx &&
-			m_ib.idx == other.m_ib.idx &&
+			m_mesh.vertex_buffer.idx == other.m_mesh.vertex_buffer.idx &&
+			m_mesh.base_vertex == other.m_mesh.base_vertex &&
+			m_mesh.index_buffer.idx == other.m_mesh.index_buffer.idx &&
+			m_mesh.first_index == other.m_mesh.first_index &&
+			m_mesh.index_count == other.m_mesh.index_count &&
 			m_state == other.m_state &&
-			m_textures == other.m_textures;
+			m_textures == other.m_textures &&
+			m_uniforms == other.m_uniforms;
 	}
 
 	constexpr RenderConfig::Textures::Textures(const std::array<TextureUniformBinding, MAX_TEXTURES>& textures)
@@ -6,4 +6,18 @@ namespace Orion
 	{
 		float transform[16];
 	};
+
+	// Instance data for geometry textured from a TextureAtlas; uv_rect holds the (u, v, width, height) of the atlas region
+	struct AtlasInstanceData
+	{
+		float transform[16];
+		float uv_rect[4];
+	};
+
+	// Instance data for camera-facing particle quads; position_size holds the world position and radius of the particle
+	struct ParticleInstanceData
+	{
+		float position_size[4];
+		float colour[4];
+	};
 }
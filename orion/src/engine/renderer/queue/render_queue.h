@@ -22,6 +22,10 @@ namespace Orion
 		void add_instance(size_t slot_index, T&& instance);
 		void add_instance(size_t slot_index, const T & instance);
 
+		// Reserves space for a block of instances in the slot for this config, to be written directly by the caller.
+		// The returned pointer is invalidated by any further submission to the same slot
+		T* allocate(const RenderConfig& config, size_t count);
+
 		inline const std::vector<RenderSlot<T>>& getSlots() const { return m_slots; }
 
 		ResultCode reset();
@@ -97,6 +101,22 @@ namespace Orion
 		m_slots[slot_index].add_instance(instance);
 	}
 
+	template<typename T>
+	inline T* RenderQueue<T>::allocate(const RenderConfig& config, size_t count)
+	{
+		const auto ix = m_slot_map.find(config);
+		if (ix != m_slot_map.end())
+		{
+			return m_slots[ix->second].allocate_instances(count);
+		}
+
+		const auto index = m_slots.size();
+		m_slots.push_back(RenderSlot<T>(config));
+		m_slot_map[config] = index;
+
+		return m_slots[index].allocate_instances(count);
+	}
+
 	template<typename T>
 	inline ResultCode RenderQueue<T>::reset()
 	{
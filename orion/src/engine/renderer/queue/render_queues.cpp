@@ -4,7 +4,9 @@ namespace Orion
 {
 	RenderQueues::RenderQueues()
 		:
-		m_primary("Primary")
+		m_primary("Primary"),
+		m_atlas("Atlas"),
+		m_particles("Particles")
 	{
 	}
 
@@ -16,6 +18,8 @@ namespace Orion
 		ResultCode result = ResultCodes::Success;
 
 		result = ResultCodes::aggregate(result, m_primary.initialise());
+		result = ResultCodes::aggregate(result, m_atlas.initialise());
+		result = ResultCodes::aggregate(result, m_particles.initialise());
 
 		return result;
 	}
@@ -26,5 +30,7 @@ namespace Orion
 
 		// Shutdown each render queue in turn
 		m_primary.shutdown();
+		m_atlas.shutdown();
+		m_particles.shutdown();
 	}
 }
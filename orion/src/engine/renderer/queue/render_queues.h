@@ -13,12 +13,18 @@ namespace Orion
 		ResultCode initialise();
 
 		const inline RenderQueue<InstanceData>& primary() const { return m_primary; }
+		const inline RenderQueue<AtlasInstanceData>& atlas() const { return m_atlas; }
+		const inline RenderQueue<ParticleInstanceData>& particles() const { return m_particles; }
 
 		inline RenderQueue<InstanceData>& primary() { return m_primary; }
+		inline RenderQueue<AtlasInstanceData>& atlas() { return m_atlas; }
+		inline RenderQueue<ParticleInstanceData>& particles() { return m_particles; }
 
 		void shutdown();
 
 	private:
 		RenderQueue<InstanceData> m_primary;
+		RenderQueue<AtlasInstanceData> m_atlas;
+		RenderQueue<ParticleInstanceData> m_particles;
 	};
 }
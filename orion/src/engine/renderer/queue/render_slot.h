@@ -19,6 +19,9 @@ namespace Orion
 		void add_instance(T&& instance);
 		void add_instance(const T& instance);
 
+		// Appends count uninitialised instances to the slot, returning a pointer to the first for the caller to populate
+		T* allocate_instances(size_t count);
+
 		inline const RenderConfig& getConfig() const { return m_config; }
 		inline const std::vector<T>& getInstances() const { return m_instances; }
 
@@ -67,4 +70,13 @@ namespace Orion
 	{
         m_instances.push_back(instance);
 	}
+
+	template<typename T>
+	inline T* RenderSlot<T>::allocate_instances(size_t count)
+	{
+		const size_t first = m_instances.size();
+		m_instances.resize(first + count);
+
+		return m_instances.data() + first;
+	}
 }
@@ -0,0 +1,71 @@
+#include <cstring>
+#include "../../../util/log.h"
+
+#include "shader_archive.h"
+
+namespace Orion
+{
+	ShaderArchive::ShaderArchive()
+	{
+	}
+
+	ResultCode ShaderArchive::open(const std::string& path)
+	{
+		close();
+		RETURN_ON_ERROR(m_file.open(path));
+
+		const auto* data = m_file.data();
+		const auto size = m_file.size();
+
+		Header header;
+		if (size < sizeof(Header))
+		{
+			close();
+			RETURN_LOG_ERROR("Invalid shader archive \"" << path << "\"; file is truncated", ResultCodes::InvalidShaderArchive);
+		}
+
+		memcpy(&header, data, sizeof(Header));
+		if (header.magic != MAGIC || header.version != CURRENT_VERSION)
+		{
+			close();
+			RETURN_LOG_ERROR("Invalid shader archive \"" << path << "\"; unsupported format or version " << header.version, ResultCodes::InvalidShaderArchive);
+		}
+
+		if ((size - sizeof(Header)) / sizeof(Entry) < header.entry_count)
+		{
+			close();
+			RETURN_LOG_ERROR("Invalid shader archive \"" << path << "\"; index is truncated", ResultCodes::InvalidShaderArchive);
+		}
+
+		m_index.reserve(header.entry_count);
+		for (uint32_t i = 0; i < header.entry_count; ++i)
+		{
+			Entry entry;
+			memcpy(&entry, data + sizeof(Header) + (i * sizeof(Entry)), sizeof(Entry));
+
+			if (entry.offset > size || entry.size > size - entry.offset)
+			{
+				close();
+				RETURN_LOG_ERROR("Invalid shader archive \"" << path << "\"; entry " << i << " lies outside the archive", ResultCodes::InvalidShaderArchive);
+			}
+
+			const std::string name(entry.name, strnlen(entry.name, MAX_NAME_LENGTH));
+			m_index[name] = { data + entry.offset, entry.size };
+		}
+
+		LOG_INFO("Opened shader archive \"" << path << "\" containing " << m_index.size() << " shaders");
+		return ResultCodes::Success;
+	}
+
+	ShaderArchive::Shader ShaderArchive::find(const std::string& name) const
+	{
+		const auto it = m_index.find(name);
+		return (it != m_index.end() ? it->second : Shader { nullptr, 0U });
+	}
+
+	void ShaderArchive::close()
+	{
+		m_index.clear();
+		m_file.close();
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include "../../../util/result_code.h"
+#include "../../../util/mapped_file.h"
+
+namespace Orion
+{
+	// Packed archive of compiled shader binaries for a single renderer backend, as produced by build-shaders.sh.
+	// The archive is memory-mapped and shader data is referenced in place, so it must remain open until all
+	// shaders created from it have been consumed by the renderer
+	class ShaderArchive
+	{
+	public:
+
+		static const uint32_t MAGIC = 0x4153524FU;		// "ORSA"
+		static const uint32_t CURRENT_VERSION = 1U;
+		static const size_t MAX_NAME_LENGTH = 56U;
+
+		struct Shader
+		{
+			const uint8_t *		data;
+			uint32_t			size;
+		};
+
+		ShaderArchive();
+
+		ResultCode open(const std::string& path);
+		void close();
+
+		inline bool isOpen() const { return m_file.isOpen(); }
+		inline size_t getShaderCount() const { return m_index.size(); }
+
+		// Returns the shader with the given name (excluding the .bin extension), or a null shader if not present
+		Shader find(const std::string& name) const;
+
+	private:
+
+		// File layout: header, followed by entry_count fixed-size index entries, followed by shader data.
+		// All values are little-endian and offsets are relative to the start of the file
+		struct Header
+		{
+			uint32_t	magic;
+			uint32_t	version;
+			uint32_t	entry_count;
+			uint32_t	reserved;
+		};
+
+		struct Entry
+		{
+			char		name[MAX_NAME_LENGTH];		// Null-padded
+			uint32_t	offset;
+			uint32_t	size;
+		};
+
+	private:
+
+		MappedFile									m_file;
+		std::unordered_map<std::string, Shader>		m_index;
+	};
+}
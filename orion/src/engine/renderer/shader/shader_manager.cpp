@@ -1,23 +1,35 @@
 #include <algorithm>
+#include <fstream>
 #include "bgfx_utils.h"
 #include "../../../util/log.h"
+#include "../../../util/thread_pool.h"
+#include "../../../util/file_watcher.h"
 #include "../core/renderer_input_state.h"
 
 #include "shader_manager.h"
 
 namespace Orion
 {
+	const char * const ShaderManager::ARCHIVE_NAME = "shaders.pak";
+
 	ShaderManager::ShaderManager()
+		:
+		m_workers(nullptr),
+		m_reloads_in_flight(0U)
 	{
 	}
 
-	ResultCode ShaderManager::initialise()
+	ResultCode ShaderManager::initialise(ThreadPool& workers, FileWatcher& watcher)
 	{
 		LOG_INFO("Initialising shader manager");
 
+		m_workers = &workers;
+
 		RETURN_ON_ERROR(initialiseShaderPrograms());
 		RETURN_ON_ERROR(initialiseUniforms());
 
+		watchShaderFiles(watcher);
+
 		return ResultCodes::Success;
 	}
 
@@ -27,45 +39,266 @@ namespace Orion
 
 		RETURN_ON_ERROR(initialiseShaderProgram("colour", "vs_cubes", "fs_cubes"));
 		RETURN_ON_ERROR(initialiseShaderProgram("inst_textured", "vs_instanced_texture", "fs_instanced_texture"));
+		RETURN_ON_ERROR(initialiseShaderProgram("inst_atlas", "vs_instanced_atlas", "fs_instanced_atlas"));
+		RETURN_ON_ERROR(initialiseShaderProgram("inst_atlas_lit", "vs_instanced_atlas_lit", "fs_instanced_atlas_lit"));
+		RETURN_ON_ERROR(initialiseShaderProgram("inst_particle", "vs_instanced_particle", "fs_instanced_particle"));
+		RETURN_ON_ERROR(initialiseShaderProgram("text_sdf", "vs_text_sdf", "fs_text_sdf"));
 
-		return ResultCodes::Success;
+		// The packed archive is used where available.  Loose shader binaries remain supported as a fallback, e.g.
+		// for backends which have not been packed, or shaders which have been added since packing
+		const auto archive_path = getBackendShaderPath() + ARCHIVE_NAME;
+		if (std::ifstream(archive_path).good())
+		{
+			RETURN_ON_ERROR(m_archive.open(archive_path));
+		}
+		else
+		{
+			LOG_WARN("No shader archive found at \"" << archive_path << "\", loading individual shader binaries");
+		}
+
+		return loadPrograms();
 	}
 
 	ResultCode ShaderManager::initialiseShaderProgram(const std::string& name, const std::string& vs, std::optional<std::string> fs)
 	{
-		LOG_INFO("Initialising shader program \"" << name << "\"");
-
 		if (name.empty())
 			RETURN_LOG_ERROR("Invalid empty shader name", ResultCodes::InvalidEmptyShaderName);
-		if (m_shaders.find(name) != m_shaders.end())
+		if (!m_program_names.add(name))
 			RETURN_LOG_ERROR("Cannot load duplicate shader; program \"" << name << "\" already exists", ResultCodes::CannotLoadDuplicateShader);
 
-		auto fs_str = fs.has_value() ? fs.value().c_str() : NULL;
-		const auto program = loadProgram(vs.c_str(), fs_str);
+		// Programs are only registered here; all registered programs are loaded together once registration is complete
+		m_definitions.push_back({ name, vs, fs });
+		m_programs.push_back(BGFX_INVALID_HANDLE);
+		m_reload_state.push_back(ReloadState::Idle);
+
+		return ResultCodes::Success;
+	}
 
-		if (!bgfx::isValid(program))
+	ResultCode ShaderManager::loadPrograms()
+	{
+		// bgfx serialises resource creation internally, so programs are created on the calling thread.  Archived shader
+		// data is referenced in place within the mapped archive
+		for (size_t i = 0; i < m_definitions.size(); ++i)
 		{
-			RETURN_LOG_ERROR("Could not load shader program \"" << name << "\"; invalid shader", ResultCodes::CouldNotLoadShaderProgram);
-		}
+			const auto& definition = m_definitions[i];
+
+			const auto vsh = createShader(definition.vs);
+			const auto fsh = (definition.fs.has_value() ? createShader(definition.fs.value()) : bgfx::ShaderHandle(BGFX_INVALID_HANDLE));
+			if (!bgfx::isValid(vsh) || (definition.fs.has_value() && !bgfx::isValid(fsh)))
+			{
+				if (bgfx::isValid(vsh)) bgfx::destroy(vsh);
+				if (bgfx::isValid(fsh)) bgfx::destroy(fsh);
+				RETURN_LOG_ERROR("Could not load shader program \"" << definition.name << "\"; invalid shader", ResultCodes::CouldNotLoadShaderProgram);
+			}
 
-		m_shaders[name] = program;
+			m_programs[i] = bgfx::createProgram(vsh, fsh, true);
+			if (!bgfx::isValid(m_programs[i]))
+			{
+				RETURN_LOG_ERROR("Could not create shader program \"" << definition.name << "\"", ResultCodes::CouldNotLoadShaderProgram);
+			}
+		}
 
-		LOG_INFO("Successfully loaded shader program \"" << name << "\"");
+		LOG_INFO("Successfully loaded " << m_definitions.size() << " shader programs");
 		return ResultCodes::Success;
 	}
 
+	// Shaders are taken from the archive where present, and otherwise from their loose binary, so that a shader added
+	// since the archive was last packed can still be loaded
+	bgfx::ShaderHandle ShaderManager::createShader(const std::string& name) const
+	{
+		if (m_archive.isOpen())
+		{
+			const auto handle = createArchivedShader(name);
+			if (bgfx::isValid(handle)) return handle;
+
+			LOG_WARN("Shader \"" << name << "\" not found in archive [" << ResultCodes::ShaderNotFoundInArchive << "], loading individual shader binary");
+		}
+
+		return createShaderFromFile(name);
+	}
+
+	bgfx::ShaderHandle ShaderManager::createArchivedShader(const std::string& name) const
+	{
+		const auto shader = m_archive.find(name);
+		if (shader.data == nullptr) return BGFX_INVALID_HANDLE;
+
+		const auto handle = bgfx::createShader(bgfx::makeRef(shader.data, shader.size));
+		if (bgfx::isValid(handle)) bgfx::setName(handle, name.c_str());
+
+		return handle;
+	}
+
+	bgfx::ShaderHandle ShaderManager::createShaderFromFile(const std::string& name)
+	{
+		// The shared file reader is not thread-safe, so the file is read independently
+		const auto path = getBackendShaderPath() + name + ".bin";
+		std::ifstream in(path, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!in.is_open()) return BGFX_INVALID_HANDLE;
+
+		// Shader data is null-terminated, as for shaders loaded via loadShader()
+		const auto size = static_cast<size_t>(in.tellg());
+		std::vector<char> data(size + 1U, '\0');
+		in.seekg(0, std::ios::beg);
+		if (!in.read(data.data(), static_cast<std::streamsize>(size))) return BGFX_INVALID_HANDLE;
+
+		const auto handle = bgfx::createShader(bgfx::copy(data.data(), static_cast<uint32_t>(data.size())));
+		if (bgfx::isValid(handle)) bgfx::setName(handle, name.c_str());
+
+		return handle;
+	}
+
+	void ShaderManager::watchShaderFiles(FileWatcher& watcher)
+	{
+		// Compiled shaders are watched individually, whether or not they were initially loaded from the archive, so
+		// that a single shader can be recompiled and reloaded without rebuilding the archive
+		std::vector<std::string> shaders;
+		for (const auto& definition : m_definitions)
+		{
+			shaders.push_back(definition.vs);
+			if (definition.fs.has_value()) shaders.push_back(definition.fs.value());
+		}
+
+		std::sort(shaders.begin(), shaders.end());
+		shaders.erase(std::unique(shaders.begin(), shaders.end()), shaders.end());
+
+		for (const auto& shader : shaders)
+		{
+			watcher.watch(getBackendShaderPath() + shader + ".bin", [this, shader](const std::string&) { requestReload(shader); });
+		}
+	}
+
+	void ShaderManager::requestReload(const std::string& shader)
+	{
+		for (size_t i = 0; i < m_definitions.size(); ++i)
+		{
+			const auto& definition = m_definitions[i];
+			if (definition.vs != shader && definition.fs != shader) continue;
+
+			// A program modified again while reloading is reloaded once more when the in-flight reload completes
+			if (m_reload_state[i] != ReloadState::Idle)
+			{
+				m_reload_state[i] = ReloadState::ReloadingStale;
+				continue;
+			}
+
+			reloadProgram(ProgramId(static_cast<ProgramId::Index>(i)));
+		}
+	}
+
+	void ShaderManager::reloadProgram(ProgramId id)
+	{
+		LOG_INFO("Reloading shader program \"" << m_definitions[id.index].name << "\"");
+
+		m_reload_state[id.index] = ReloadState::Reloading;
+		{
+			std::lock_guard<std::mutex> lock(m_reload_mutex);
+			++m_reloads_in_flight;
+		}
+
+		m_workers->enqueue([this, id]()
+		{
+			// Shaders without a loose binary are taken from the archive, if one is loaded
+			const auto& definition = m_definitions[id.index];
+			const auto load = [this](const std::string& name) {
+				const auto handle = createShaderFromFile(name);
+				return (bgfx::isValid(handle) || !m_archive.isOpen() ? handle : createArchivedShader(name));
+			};
+
+			const auto vsh = load(definition.vs);
+			const auto fsh = (definition.fs.has_value() ? load(definition.fs.value()) : bgfx::ShaderHandle(BGFX_INVALID_HANDLE));
+
+			bgfx::ProgramHandle program = BGFX_INVALID_HANDLE;
+			if (bgfx::isValid(vsh) && (!definition.fs.has_value() || bgfx::isValid(fsh)))
+			{
+				program = bgfx::createProgram(vsh, fsh, true);
+			}
+			else
+			{
+				if (bgfx::isValid(vsh)) bgfx::destroy(vsh);
+				if (bgfx::isValid(fsh)) bgfx::destroy(fsh);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_reload_mutex);
+				m_reloaded.push_back({ id, program });
+				--m_reloads_in_flight;
+			}
+
+			m_reload_complete.notify_all();
+		});
+	}
+
+	void ShaderManager::processReloads()
+	{
+		std::deque<std::pair<ProgramId, bgfx::ProgramHandle>> reloaded;
+		{
+			std::lock_guard<std::mutex> lock(m_reload_mutex);
+			reloaded.swap(m_reloaded);
+		}
+
+		for (const auto& entry : reloaded)
+		{
+			const auto id = entry.first;
+			const auto program = entry.second;
+
+			if (bgfx::isValid(program))
+			{
+				// The previous program is released by bgfx once no longer referenced by an in-flight frame
+				if (bgfx::isValid(m_programs[id.index])) bgfx::destroy(m_programs[id.index]);
+				m_programs[id.index] = program;
+
+				LOG_INFO("Reloaded shader program \"" << m_definitions[id.index].name << "\"");
+			}
+			else
+			{
+				LOG_WARN("Failed to reload shader program \"" << m_definitions[id.index].name << "\", retaining existing program [" << ResultCodes::CouldNotLoadShaderProgram << "]");
+			}
+
+			const bool stale = (m_reload_state[id.index] == ReloadState::ReloadingStale);
+			m_reload_state[id.index] = ReloadState::Idle;
+			if (stale) reloadProgram(id);
+		}
+	}
+
+	std::string ShaderManager::getBackendShaderPath()
+	{
+		// Matches the per-backend directory layout used by loadShader() and build-shaders.sh
+		switch (bgfx::getRendererType())
+		{
+			case bgfx::RendererType::Noop:
+			case bgfx::RendererType::Direct3D9:		return "shaders/dx9/";
+			case bgfx::RendererType::Direct3D11:
+			case bgfx::RendererType::Direct3D12:	return "shaders/dx11/";
+			case bgfx::RendererType::Gnm:			return "shaders/pssl/";
+			case bgfx::RendererType::Metal:			return "shaders/metal/";
+			case bgfx::RendererType::Nvn:			return "shaders/nvn/";
+			case bgfx::RendererType::OpenGL:		return "shaders/glsl/";
+			case bgfx::RendererType::OpenGLES:		return "shaders/essl/";
+			case bgfx::RendererType::Vulkan:
+			case bgfx::RendererType::WebGPU:		return "shaders/spirv/";
+			default:								return "shaders/";
+		}
+	}
+
 	ResultCode ShaderManager::initialiseUniforms()
 	{
 		LOG_INFO("Initialising uniform definitions");
 
 		RETURN_ON_ERROR(createUniform("s_texColor", bgfx::UniformType::Enum::Sampler));
 
+		// Tiled lighting
+		RETURN_ON_ERROR(createUniform("s_lightData", bgfx::UniformType::Enum::Sampler));
+		RETURN_ON_ERROR(createUniform("s_lightGrid", bgfx::UniformType::Enum::Sampler));
+		RETURN_ON_ERROR(createUniform("s_lightIndices", bgfx::UniformType::Enum::Sampler));
+		RETURN_ON_ERROR(createUniform("u_lightGrid", bgfx::UniformType::Enum::Vec4));
+		RETURN_ON_ERROR(createUniform("u_ambient", bgfx::UniformType::Enum::Vec4));
+
 		return ResultCodes::Success;
 	}
 
     ResultCode ShaderManager::createUniform(const std::string& name, bgfx::UniformType::Enum type, uint16_t num)
     {
-		if (m_uniforms.find(name) != m_uniforms.end())
+		if (m_uniform_names.find(name))
 		{
 			RETURN_LOG_ERROR("Cannot create uniform definition; uniform already exists with name \"" << name << "\"", ResultCodes::CannotCreateDuplicateUniform);
 		}
@@ -76,13 +309,17 @@ namespace Orion
 			RETURN_LOG_ERROR("Failed to create uniform \"" << name << "\"", ResultCodes::FailedToCreateUniform);
 		}
 
-		m_uniforms[name] = uniform;
+		m_uniform_names.add(name);
+		m_uniforms.push_back(uniform);
 		return ResultCodes::Success;
     }
 
 	ResultCode ShaderManager::beginFrame(const RendererInputState& state)
 	{
 		(void)state;
+
+		processReloads();
+
 		return ResultCodes::Success;
 	}
 
@@ -110,15 +347,31 @@ namespace Orion
 	{
 		LOG_INFO("Releasing all shader programs");
 
-		std::for_each(m_shaders.begin(), m_shaders.end(), [](auto& shader) { bgfx::destroy(shader.second); });
-		m_shaders.clear();
+		// Outstanding reloads hold a reference to this manager, so must complete before programs are released
+		{
+			std::unique_lock<std::mutex> lock(m_reload_mutex);
+			m_reload_complete.wait(lock, [this]() { return m_reloads_in_flight == 0U; });
+
+			std::for_each(m_reloaded.begin(), m_reloaded.end(), [](auto& entry) { if (bgfx::isValid(entry.second)) bgfx::destroy(entry.second); });
+			m_reloaded.clear();
+		}
+
+		std::for_each(m_programs.begin(), m_programs.end(), [](auto& program) { if (bgfx::isValid(program)) bgfx::destroy(program); });
+		m_programs.clear();
+		m_program_names.clear();
+		m_definitions.clear();
+		m_reload_state.clear();
+
+		// Shader data may be referenced by the renderer until the programs created from it are released
+		m_archive.close();
 	}
 
 	void ShaderManager::shutdownUniforms()
 	{
         LOG_INFO("Releasing all uniform definitions");
 
-        std::for_each(m_uniforms.begin(), m_uniforms.end(), [](auto& uniform) { bgfx::destroy(uniform.second); });
+        std::for_each(m_uniforms.begin(), m_uniforms.end(), [](auto& uniform) { bgfx::destroy(uniform); });
         m_uniforms.clear();
+        m_uniform_names.clear();
 	}
 }
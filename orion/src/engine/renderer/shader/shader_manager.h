@@ -1,37 +1,73 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <optional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
 #include <unordered_map>
 #include "../../../util/result_code.h"
 #include "bgfx_utils.h"
+#include "shader_archive.h"
+#include "../core/resource_id.h"
 struct RendererInputState;
 
 namespace Orion
 {
+	class ThreadPool;
+	class FileWatcher;
+
 	class ShaderManager
 	{
 	public:
 
+		static const char * const ARCHIVE_NAME;
+
 		ShaderManager();
 
-		ResultCode initialise();
+		ResultCode initialise(ThreadPool& workers, FileWatcher& watcher);
 
 		ResultCode beginFrame(const RendererInputState& state);
 		ResultCode executeFrame(const RendererInputState& state);
 		ResultCode endFrame(const RendererInputState& state);
 
-		inline bgfx::ProgramHandle getProgram(const std::string& name) const { return m_shaders.at(name); }
-		inline bgfx::UniformHandle getUniform(const std::string& name) const { return m_uniforms.at(name); }
+		// Programs and uniforms should be resolved to an ID once and the ID retained, rather than looking up by
+		// name each frame.  The program behind an ID may be replaced by hot reload between frames, so raw program
+		// handles should not be retained across frames.  Name lookups return a null ID if no such resource exists
+		inline ProgramId getProgramId(const std::string& name) const { return m_program_names.find(name); }
+		inline bgfx::ProgramHandle getProgram(ProgramId id) const { return m_programs[id.index]; }
+		inline size_t getProgramCount() const { return m_programs.size(); }
+
+		inline UniformId getUniformId(const std::string& name) const { return m_uniform_names.find(name); }
+		inline bgfx::UniformHandle getUniform(UniformId id) const { return m_uniforms[id.index]; }
 
 		void shutdown();
 
 	private:
 
+		struct ProgramDefinition
+		{
+			std::string						name;
+			std::string						vs;
+			std::optional<std::string>		fs;
+		};
+
 		ResultCode initialiseShaderPrograms();
 		ResultCode initialiseShaderProgram(const std::string& name, const std::string& vs, std::optional<std::string> fs);
 		ResultCode initialiseUniforms();
 
+		ResultCode loadPrograms();
+		bgfx::ShaderHandle createShader(const std::string& name) const;
+		bgfx::ShaderHandle createArchivedShader(const std::string& name) const;
+		static bgfx::ShaderHandle createShaderFromFile(const std::string& name);
+		static std::string getBackendShaderPath();
+
+		void watchShaderFiles(FileWatcher& watcher);
+		void requestReload(const std::string& shader);
+		void reloadProgram(ProgramId id);
+		void processReloads();
+
 		ResultCode createUniform(const std::string& name, bgfx::UniformType::Enum type, uint16_t num = (uint16_t)1U);
 
 		void shutdownShaderPrograms();
@@ -39,8 +75,24 @@ namespace Orion
 
 	private:
 
-		std::unordered_map<std::string, bgfx::ProgramHandle> m_shaders;
-		std::unordered_map<std::string, bgfx::UniformHandle> m_uniforms;
+		std::vector<ProgramDefinition>						m_definitions;		// Indexed by ProgramId
+		std::vector<bgfx::ProgramHandle>					m_programs;			// Indexed by ProgramId
+		ResourceNameTable<ProgramId>						m_program_names;
+
+		std::vector<bgfx::UniformHandle>					m_uniforms;			// Indexed by UniformId
+		ResourceNameTable<UniformId>						m_uniform_names;
+
+		ShaderArchive										m_archive;
+
+		// Hot reload: programs are rebuilt on worker threads and swapped in at the start of a frame
+		enum ReloadState : uint8_t { Idle = 0U, Reloading, ReloadingStale };
+
+		ThreadPool *										m_workers;
+		std::vector<ReloadState>							m_reload_state;		// Indexed by ProgramId
+		std::deque<std::pair<ProgramId, bgfx::ProgramHandle>> m_reloaded;
+		size_t												m_reloads_in_flight;
+		std::mutex											m_reload_mutex;
+		std::condition_variable								m_reload_complete;
 
 	};
 }
@@ -0,0 +1,565 @@
+#include <cstddef>
+#include <algorithm>
+#include "font/utf8.h"
+#include "cube_atlas.h"
+#include "../../../util/log.h"
+#include "../../../util/debug.h"
+#include "../../../util/thread_pool.h"
+#include "../core/renderer_input_state.h"
+#include "../shader/shader_manager.h"
+
+#include "text_manager.h"
+
+namespace Orion
+{
+	// Labels are transformed into their pages in blocks of this many labels per worker task
+	static const size_t LABEL_CHUNK_SIZE = 256U;
+
+	static const uint64_t LABEL_STATE = BGFX_STATE_WRITE_RGB | BGFX_STATE_DEPTH_TEST_LESS | BGFX_STATE_MSAA
+		| BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+
+	TextManager::TextManager()
+		:
+		m_workers(nullptr),
+		m_shaders(nullptr),
+		m_font_manager(),
+		m_text_buffers(),
+		m_font_names(),
+		m_ttfs(),
+		m_fonts(),
+		m_labels(),
+		m_active(),
+		m_free_ids(),
+		m_moved(),
+		m_pages_dirty(false),
+		m_pages(),
+		m_page_labels(),
+		m_screen_text(),
+		m_free_screen_ids(),
+		m_layout(),
+		m_index_buffer(BGFX_INVALID_HANDLE),
+		m_program(),
+		m_sampler(),
+		m_stats({ 0U, 0U, 0U, 0U, 0U })
+	{
+	}
+
+	ResultCode TextManager::initialise(ThreadPool& workers, const ShaderManager& shaders)
+	{
+		LOG_INFO("Initialising text manager");
+
+		m_workers = &workers;
+		m_shaders = &shaders;
+
+		m_program = shaders.getProgramId("text_sdf");
+		m_sampler = shaders.getUniformId("s_texColor");
+		if (m_program.isNull() || m_sampler.isNull())
+		{
+			RETURN_LOG_ERROR("Text shader or uniforms have not been loaded", ResultCodes::FailedToInitialiseText);
+		}
+
+		m_font_manager = std::make_unique<FontManager>(512U);
+		m_text_buffers = std::make_unique<TextBufferManager>(m_font_manager.get());
+
+		m_layout
+			.begin()
+			.add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::TexCoord0, 4, bgfx::AttribType::Int16, true)
+			.add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
+			.end();
+
+		// Every page uses the same quad topology, so a single index buffer covers the largest page
+		std::vector<uint16_t> indices(PAGE_GLYPHS * 6U);
+		for (size_t glyph = 0U; glyph < PAGE_GLYPHS; ++glyph)
+		{
+			const uint16_t base = static_cast<uint16_t>(glyph * 4U);
+			const uint16_t quad[6] = { base, uint16_t(base + 1U), uint16_t(base + 2U), base, uint16_t(base + 2U), uint16_t(base + 3U) };
+			std::copy(std::begin(quad), std::end(quad), indices.begin() + (glyph * 6U));
+		}
+
+		m_index_buffer = bgfx::createIndexBuffer(bgfx::copy(indices.data(), static_cast<uint32_t>(indices.size() * sizeof(uint16_t))));
+		if (!bgfx::isValid(m_index_buffer))
+		{
+			RETURN_LOG_ERROR("Failed to create text index buffer", ResultCodes::FailedToInitialiseText);
+		}
+
+		return loadFont("default", "font/robotomono-regular.ttf");
+	}
+
+	ResultCode TextManager::beginFrame(const RendererInputState& state)
+	{
+		(void)state;
+		return ResultCodes::Success;
+	}
+
+	ResultCode TextManager::executeFrame(const RendererInputState& state)
+	{
+		(void)state;
+
+		// Label offsets are only reassigned if labels have been added or removed, or have changed length
+		if (m_pages_dirty)
+		{
+			rebuildPages();
+		}
+		else if (!m_moved.empty())
+		{
+			updateMovedLabels();
+		}
+
+		uploadPages();
+		return ResultCodes::Success;
+	}
+
+	ResultCode TextManager::endFrame(const RendererInputState& state)
+	{
+		(void)state;
+
+		m_stats.layouts = 0U;
+		return ResultCodes::Success;
+	}
+
+	ResultCode TextManager::loadFont(const std::string& name, const std::string& path, uint32_t pixel_size)
+	{
+		if (!m_font_names.find(name).isNull())
+		{
+			RETURN_LOG_ERROR("Cannot load font \"" << name << "\"; font is already loaded", ResultCodes::FailedToLoadFont);
+		}
+
+		uint32_t size = 0U;
+		void* data = ::load(path.c_str(), &size);
+		if (data == nullptr)
+		{
+			RETURN_LOG_ERROR("Failed to read font file \"" << path << "\"", ResultCodes::FailedToLoadFont);
+		}
+
+		// The font manager retains its own copy of the font data
+		const TrueTypeHandle ttf = m_font_manager->createTtf(static_cast<const uint8_t*>(data), size);
+		::unload(data);
+
+		if (!::isValid(ttf))
+		{
+			RETURN_LOG_ERROR("Failed to load font \"" << name << "\" from \"" << path << "\"", ResultCodes::FailedToLoadFont);
+		}
+
+		const FontHandle font = m_font_manager->createFontByPixelSize(ttf, 0U, pixel_size, FONT_TYPE_DISTANCE);
+		if (!::isValid(font))
+		{
+			m_font_manager->destroyTtf(ttf);
+			RETURN_LOG_ERROR("Failed to create font \"" << name << "\" at " << pixel_size << "px", ResultCodes::FailedToLoadFont);
+		}
+
+		// Names are only registered once the font exists, since font IDs index directly into the font collection
+		const FontId id = m_font_names.add(name);
+		if (id.isNull())
+		{
+			m_font_manager->destroyFont(font);
+			m_font_manager->destroyTtf(ttf);
+			RETURN_LOG_ERROR("Cannot register font \"" << name << "\"; font limit reached", ResultCodes::FailedToLoadFont);
+		}
+
+		m_ttfs.push_back(ttf);
+		m_fonts.push_back(font);
+
+		LOG_INFO("Loaded font \"" << name << "\" from \"" << path << "\" at " << pixel_size << "px");
+		return ResultCodes::Success;
+	}
+
+	TextLabelId TextManager::addLabel(FontId font, const std::string& text, Vec2<float> position, float height, uint32_t colour)
+	{
+		ASS(font.index < m_fonts.size(), "Invalid font ID: " << font.index);
+
+		TextLabelId id;
+		if (!m_free_ids.empty())
+		{
+			id = m_free_ids.back();
+			m_free_ids.pop_back();
+		}
+		else
+		{
+			if (m_labels.size() >= TextLabelId::NONE)
+			{
+				LOG_WARN("Cannot add text label; label limit reached");
+				return TextLabelId();
+			}
+
+			id = TextLabelId(static_cast<TextLabelId::Index>(m_labels.size()));
+			m_labels.emplace_back();
+			m_active.push_back(0U);
+		}
+
+		Label& label = m_labels[id.index];
+		label.font = font;
+		label.text = text;
+		label.position = position;
+		label.height = height;
+		label.colour = colour;
+		label.moved = false;
+		layoutLabel(label);
+
+		m_active[id.index] = 1U;
+		m_pages_dirty = true;
+
+		return id;
+	}
+
+	void TextManager::setLabelText(TextLabelId id, const std::string& text)
+	{
+		ASS(id.index < m_labels.size() && m_active[id.index], "Invalid text label ID: " << id.index);
+
+		Label& label = m_labels[id.index];
+		if (label.text == text) return;
+
+		// A label which keeps the same number of glyphs can be rewritten in place
+		const size_t previous_vertices = label.glyphs.size();
+		label.text = text;
+		layoutLabel(label);
+
+		if (label.glyphs.size() == previous_vertices)	markMoved(id);
+		else											m_pages_dirty = true;
+	}
+
+	void TextManager::setLabelPosition(TextLabelId id, Vec2<float> position)
+	{
+		ASS(id.index < m_labels.size() && m_active[id.index], "Invalid text label ID: " << id.index);
+
+		m_labels[id.index].position = position;
+		markMoved(id);
+	}
+
+	void TextManager::setLabelColour(TextLabelId id, uint32_t colour)
+	{
+		ASS(id.index < m_labels.size() && m_active[id.index], "Invalid text label ID: " << id.index);
+		if (m_labels[id.index].colour == colour) return;
+
+		m_labels[id.index].colour = colour;
+		markMoved(id);
+	}
+
+	void TextManager::removeLabel(TextLabelId id)
+	{
+		if (id.index >= m_labels.size() || !m_active[id.index]) return;
+
+		m_labels[id.index].glyphs.clear();
+		m_labels[id.index].text.clear();
+		m_active[id.index] = 0U;
+		m_free_ids.push_back(id);
+
+		m_pages_dirty = true;
+	}
+
+	void TextManager::markMoved(TextLabelId id)
+	{
+		Label& label = m_labels[id.index];
+		if (label.moved) return;
+
+		label.moved = true;
+		m_moved.push_back(id);
+	}
+
+	// Glyphs are laid out as by the vendored text buffers, in font pixels with y increasing down each line.  Each line
+	// is centred horizontally, and the block of lines vertically, about the label position.  Glyphs not yet in the
+	// atlas are rasterised here, so layout must remain on the render thread
+	void TextManager::layoutLabel(Label& label)
+	{
+		const FontHandle font = m_fonts[label.font.index];
+		const FontInfo& info = m_font_manager->getFontInfo(font);
+		const Atlas* atlas = m_font_manager->getAtlas();
+
+		const float line_height = info.ascender - info.descender + info.lineGap;
+		label.scale = (line_height > 0.0f ? label.height / line_height : 0.0f);
+		label.glyphs.clear();
+
+		float pen_x = 0.0f, pen_y = 0.0f;
+		size_t line_start = 0U;
+		const auto centreLine = [&label, &line_start, &pen_x]()
+		{
+			for (size_t i = line_start; i < label.glyphs.size(); ++i) label.glyphs[i].x -= (pen_x * 0.5f);
+		};
+
+		uint32_t utf8_state = UTF8_ACCEPT, codepoint = 0U;
+		for (const char c : label.text)
+		{
+			if (utf8_decode(&utf8_state, &codepoint, static_cast<uint8_t>(c)) != UTF8_ACCEPT) continue;
+
+			if (codepoint == '\n')
+			{
+				centreLine();
+				pen_x = 0.0f;
+				pen_y += line_height;
+				line_start = label.glyphs.size();
+				continue;
+			}
+
+			if (label.glyphs.size() >= (MAX_LABEL_GLYPHS * 4U)) break;
+
+			const GlyphInfo* glyph = m_font_manager->getGlyphInfo(font, static_cast<CodePoint>(codepoint));
+			if (glyph == nullptr) continue;
+
+			// Whitespace only advances the pen
+			if (glyph->width > 0.0f && glyph->height > 0.0f)
+			{
+				const float x0 = pen_x + glyph->offset_x;
+				const float y0 = pen_y + info.ascender + glyph->offset_y;
+				const float x1 = x0 + glyph->width;
+				const float y1 = y0 + glyph->height;
+
+				const size_t first = label.glyphs.size();
+				label.glyphs.resize(first + 4U);
+				atlas->packUV(glyph->regionIndex, reinterpret_cast<uint8_t*>(&label.glyphs[first]), offsetof(TextVertex, u), sizeof(TextVertex));
+
+				TextVertex* quad = &label.glyphs[first];
+				quad[0].x = x0;		quad[0].y = y0;
+				quad[1].x = x0;		quad[1].y = y1;
+				quad[2].x = x1;		quad[2].y = y1;
+				quad[3].x = x1;		quad[3].y = y0;
+			}
+
+			pen_x += glyph->advance_x;
+		}
+
+		centreLine();
+
+		const float block_height = pen_y + line_height;
+		for (auto& vertex : label.glyphs) vertex.y -= (block_height * 0.5f);
+
+		++m_stats.layouts;
+	}
+
+	// World y increases up the screen, so glyph rows are flipped as they are placed
+	void TextManager::writeLabelVertices(const Label& label)
+	{
+		TextVertex* out = &m_pages[label.page].vertices[label.first_vertex];
+		for (const TextVertex& glyph : label.glyphs)
+		{
+			*out = glyph;
+			out->x = label.position.x + (glyph.x * label.scale);
+			out->y = label.position.y - (glyph.y * label.scale);
+			out->z = 0.0f;
+			out->colour = label.colour;
+			++out;
+		}
+	}
+
+	void TextManager::rebuildPages()
+	{
+		// Labels are packed into pages in ID order, without splitting any label across pages
+		m_page_labels.clear();
+		std::vector<size_t> page_glyphs;
+		size_t glyphs = 0U;
+
+		for (size_t i = 0U; i < m_labels.size(); ++i)
+		{
+			if (!m_active[i]) continue;
+
+			Label& label = m_labels[i];
+			const size_t count = label.glyphs.size() / 4U;
+			if (page_glyphs.empty() || page_glyphs.back() + count > PAGE_GLYPHS) page_glyphs.push_back(0U);
+
+			label.page = page_glyphs.size() - 1U;
+			label.first_vertex = page_glyphs.back() * 4U;
+			label.moved = false;
+			page_glyphs.back() += count;
+			glyphs += count;
+
+			m_page_labels.push_back(TextLabelId(static_cast<TextLabelId::Index>(i)));
+		}
+
+		// Pages are retained once created, and left empty if no longer required
+		while (m_pages.size() < page_glyphs.size())
+		{
+			const auto buffer = bgfx::createDynamicVertexBuffer(static_cast<uint32_t>(PAGE_GLYPHS * 4U), m_layout);
+			m_pages.push_back({ buffer, {}, false });
+		}
+
+		for (size_t page = 0U; page < m_pages.size(); ++page)
+		{
+			m_pages[page].vertices.resize(page < page_glyphs.size() ? page_glyphs[page] * 4U : 0U);
+			m_pages[page].dirty = true;
+		}
+
+		const size_t label_count = m_page_labels.size();
+		m_workers->parallelFor((label_count + LABEL_CHUNK_SIZE - 1U) / LABEL_CHUNK_SIZE, [this, label_count](size_t chunk)
+		{
+			const size_t end = std::min(label_count, (chunk + 1U) * LABEL_CHUNK_SIZE);
+			for (size_t i = chunk * LABEL_CHUNK_SIZE; i < end; ++i)
+			{
+				writeLabelVertices(m_labels[m_page_labels[i].index]);
+			}
+		});
+
+		m_moved.clear();
+		m_pages_dirty = false;
+
+		m_stats.labels = label_count;
+		m_stats.glyphs = glyphs;
+		m_stats.pages = page_glyphs.size();
+	}
+
+	void TextManager::updateMovedLabels()
+	{
+		const size_t moved_count = m_moved.size();
+		m_workers->parallelFor((moved_count + LABEL_CHUNK_SIZE - 1U) / LABEL_CHUNK_SIZE, [this, moved_count](size_t chunk)
+		{
+			const size_t end = std::min(moved_count, (chunk + 1U) * LABEL_CHUNK_SIZE);
+			for (size_t i = chunk * LABEL_CHUNK_SIZE; i < end; ++i)
+			{
+				writeLabelVertices(m_labels[m_moved[i].index]);
+			}
+		});
+
+		for (const TextLabelId id : m_moved)
+		{
+			m_labels[id.index].moved = false;
+			m_pages[m_labels[id.index].page].dirty = true;
+		}
+
+		m_moved.clear();
+	}
+
+	void TextManager::uploadPages()
+	{
+		m_stats.updated_pages = 0U;
+		for (Page& page : m_pages)
+		{
+			if (!page.dirty) continue;
+
+			if (!page.vertices.empty())
+			{
+				bgfx::update(page.buffer, 0U, bgfx::copy(page.vertices.data(), static_cast<uint32_t>(page.vertices.size() * sizeof(TextVertex))));
+				++m_stats.updated_pages;
+			}
+
+			page.dirty = false;
+		}
+	}
+
+	void TextManager::renderLabels(bgfx::ViewId view)
+	{
+		const auto program = m_shaders->getProgram(m_program);
+		const auto sampler = m_shaders->getUniform(m_sampler);
+		const auto atlas = m_font_manager->getAtlas()->getTextureHandle();
+
+		for (const Page& page : m_pages)
+		{
+			if (page.vertices.empty()) continue;
+
+			const uint32_t vertex_count = static_cast<uint32_t>(page.vertices.size());
+			bgfx::setVertexBuffer(0, page.buffer, 0U, vertex_count);
+			bgfx::setIndexBuffer(m_index_buffer, 0U, (vertex_count / 4U) * 6U);
+			bgfx::setTexture(0, sampler, atlas);
+			bgfx::setState(LABEL_STATE);
+			bgfx::submit(view, program);
+		}
+	}
+
+	ScreenTextId TextManager::addScreenText(FontId font, const std::string& text, Vec2<float> position, uint32_t colour)
+	{
+		ASS(font.index < m_fonts.size(), "Invalid font ID: " << font.index);
+
+		ScreenTextId id;
+		if (!m_free_screen_ids.empty())
+		{
+			id = m_free_screen_ids.back();
+			m_free_screen_ids.pop_back();
+		}
+		else
+		{
+			id = ScreenTextId(static_cast<ScreenTextId::Index>(m_screen_text.size()));
+			m_screen_text.push_back({ font, "", position, colour, BGFX_INVALID_HANDLE, false });
+		}
+
+		m_screen_text[id.index] = { font, text, position, colour, BGFX_INVALID_HANDLE, true };
+		buildScreenText(m_screen_text[id.index]);
+
+		return id;
+	}
+
+	void TextManager::setScreenText(ScreenTextId id, const std::string& text)
+	{
+		ASS(id.index < m_screen_text.size() && m_screen_text[id.index].active, "Invalid screen text ID: " << id.index);
+
+		ScreenText& screen_text = m_screen_text[id.index];
+		if (screen_text.text == text) return;
+
+		screen_text.text = text;
+		buildScreenText(screen_text);
+	}
+
+	void TextManager::removeScreenText(ScreenTextId id)
+	{
+		if (id.index >= m_screen_text.size() || !m_screen_text[id.index].active) return;
+
+		ScreenText& screen_text = m_screen_text[id.index];
+		if (::isValid(screen_text.buffer)) m_text_buffers->destroyTextBuffer(screen_text.buffer);
+
+		screen_text.buffer = BGFX_INVALID_HANDLE;
+		screen_text.active = false;
+		m_free_screen_ids.push_back(id);
+	}
+
+	// Static text buffers upload their geometry once, so are recreated whenever their string changes
+	void TextManager::buildScreenText(ScreenText& text)
+	{
+		if (::isValid(text.buffer)) m_text_buffers->destroyTextBuffer(text.buffer);
+
+		text.buffer = m_text_buffers->createTextBuffer(FONT_TYPE_DISTANCE, BufferType::Static);
+		if (!::isValid(text.buffer))
+		{
+			LOG_WARN("Cannot create screen text buffer; text buffer limit reached");
+			return;
+		}
+
+		m_text_buffers->setTextColor(text.buffer, text.colour);
+		m_text_buffers->setPenPosition(text.buffer, text.position.x, text.position.y);
+		m_text_buffers->appendText(text.buffer, m_fonts[text.font.index], text.text.c_str());
+	}
+
+	void TextManager::renderScreenText(bgfx::ViewId view, const RendererInputState& state)
+	{
+		float ortho[16];
+		bx::mtxOrtho(ortho, 0.0f, float(state.width), float(state.height), 0.0f, 0.0f, 100.0f, 0.0f, bgfx::getCaps()->homogeneousDepth);
+		bgfx::setViewTransform(view, nullptr, ortho);
+
+		for (const ScreenText& text : m_screen_text)
+		{
+			if (text.active && ::isValid(text.buffer)) m_text_buffers->submitTextBuffer(text.buffer, view);
+		}
+	}
+
+	void TextManager::shutdown()
+	{
+		LOG_INFO("Shutting down text manager");
+
+		for (const ScreenText& text : m_screen_text)
+		{
+			if (text.active && ::isValid(text.buffer)) m_text_buffers->destroyTextBuffer(text.buffer);
+		}
+		m_screen_text.clear();
+		m_free_screen_ids.clear();
+		m_text_buffers.reset();
+
+		for (Page& page : m_pages)
+		{
+			if (bgfx::isValid(page.buffer)) bgfx::destroy(page.buffer);
+		}
+		m_pages.clear();
+
+		if (bgfx::isValid(m_index_buffer)) bgfx::destroy(m_index_buffer);
+		m_index_buffer = BGFX_INVALID_HANDLE;
+
+		if (m_font_manager)
+		{
+			for (const FontHandle font : m_fonts) m_font_manager->destroyFont(font);
+			for (const TrueTypeHandle ttf : m_ttfs) m_font_manager->destroyTtf(ttf);
+		}
+		m_fonts.clear();
+		m_ttfs.clear();
+		m_font_names.clear();
+		m_font_manager.reset();
+
+		m_labels.clear();
+		m_active.clear();
+		m_free_ids.clear();
+		m_moved.clear();
+	}
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include "bgfx_utils.h"
+#include "font/font_manager.h"
+#include "font/text_buffer_manager.h"
+#include "../../../util/result_code.h"
+#include "../../../math/vec2.h"
+#include "../core/resource_id.h"
+struct RendererInputState;
+
+namespace Orion
+{
+	class ShaderManager;
+	class ThreadPool;
+
+	// Text rendering with signed distance field fonts.  World-space labels are laid out once per change of string,
+	// and the glyph quads of all labels are batched into shared vertex pages over the font atlas, so that any number
+	// of labels is drawn in one call per page.  Moving or recolouring a label only rewrites its existing quads.
+	// Screen-space text is held in retained text buffers, which are rebuilt only when their string changes
+	class TextManager
+	{
+	public:
+
+		static const uint32_t DEFAULT_FONT_SIZE = 32U;		// Pixel size at which SDF glyphs are rasterised
+		static const size_t MAX_LABEL_GLYPHS = 256U;
+		static const size_t PAGE_GLYPHS = 16384U;			// Four vertices per glyph, within the range of 16-bit indices
+
+		struct Stats
+		{
+			size_t		labels;
+			size_t		glyphs;
+			size_t		pages;					// Equal to the number of draw calls for all labels
+			size_t		layouts;				// Labels laid out in the last frame
+			size_t		updated_pages;			// Vertex pages uploaded in the last frame
+		};
+
+		TextManager();
+
+		ResultCode initialise(ThreadPool& workers, const ShaderManager& shaders);
+
+		ResultCode beginFrame(const RendererInputState& state);
+		ResultCode executeFrame(const RendererInputState& state);
+		ResultCode endFrame(const RendererInputState& state);
+
+		// Fonts are rasterised as distance fields at the given pixel size, and may be drawn at any scale
+		ResultCode loadFont(const std::string& name, const std::string& path, uint32_t pixel_size = DEFAULT_FONT_SIZE);
+		inline FontId getFontId(const std::string& name) const { return m_font_names.find(name); }
+
+		// Labels are centred on their position in the ground plane, with line height given in world units.  Colour
+		// is packed as 0xAABBGGRR.  IDs of removed labels are reused by subsequent additions
+		TextLabelId addLabel(FontId font, const std::string& text, Vec2<float> position, float height, uint32_t colour = 0xFFFFFFFFU);
+		void setLabelText(TextLabelId id, const std::string& text);
+		void setLabelPosition(TextLabelId id, Vec2<float> position);
+		void setLabelColour(TextLabelId id, uint32_t colour);
+		void removeLabel(TextLabelId id);
+
+		// Screen-space text, positioned in pixels from the top-left of the backbuffer
+		ScreenTextId addScreenText(FontId font, const std::string& text, Vec2<float> position, uint32_t colour = 0xFFFFFFFFU);
+		void setScreenText(ScreenTextId id, const std::string& text);
+		void removeScreenText(ScreenTextId id);
+
+		// Submits all labels to a view using its current view transform
+		void renderLabels(bgfx::ViewId view);
+
+		// Applies an orthographic screen-space transform to the view and submits all screen text
+		void renderScreenText(bgfx::ViewId view, const RendererInputState& state);
+
+		inline Stats getStats() const { return m_stats; }
+
+		void shutdown();
+
+	private:
+
+		struct TextVertex
+		{
+			float		x, y, z;
+			int16_t		u, v, w, t;				// Cube atlas coordinates, and the atlas channel in t
+			uint32_t	colour;
+		};
+
+		struct Label
+		{
+			FontId					font;
+			std::string				text;
+			Vec2<float>				position;
+			float					height;
+			float					scale;				// World units per font pixel
+			uint32_t				colour;
+
+			std::vector<TextVertex>	glyphs;				// Laid out in font pixels relative to the label position
+			size_t					page;
+			size_t					first_vertex;		// Within the page, assigned when the pages are rebuilt
+			bool					moved;
+		};
+
+		struct Page
+		{
+			bgfx::DynamicVertexBufferHandle		buffer;
+			std::vector<TextVertex>				vertices;
+			bool								dirty;
+		};
+
+		struct ScreenText
+		{
+			FontId					font;
+			std::string				text;
+			Vec2<float>				position;
+			uint32_t				colour;
+			TextBufferHandle		buffer;
+			bool					active;
+		};
+
+		void layoutLabel(Label& label);
+		void writeLabelVertices(const Label& label);
+		void markMoved(TextLabelId id);
+
+		void rebuildPages();
+		void updateMovedLabels();
+		void uploadPages();
+
+		void buildScreenText(ScreenText& text);
+
+	private:
+
+		ThreadPool *							m_workers;
+		const ShaderManager *					m_shaders;
+
+		std::unique_ptr<FontManager>			m_font_manager;
+		std::unique_ptr<TextBufferManager>		m_text_buffers;
+
+		ResourceNameTable<FontId>				m_font_names;
+		std::vector<TrueTypeHandle>				m_ttfs;				// Indexed by FontId
+		std::vector<FontHandle>					m_fonts;			// Indexed by FontId
+
+		std::vector<Label>						m_labels;			// Indexed by TextLabelId
+		std::vector<uint8_t>					m_active;			// Indexed by TextLabelId
+		std::vector<TextLabelId>				m_free_ids;
+		std::vector<TextLabelId>				m_moved;
+		bool									m_pages_dirty;		// Labels have been added, removed or changed length
+
+		std::vector<Page>						m_pages;
+		std::vector<TextLabelId>				m_page_labels;		// Active labels in page order, retained to avoid reallocation
+
+		std::vector<ScreenText>					m_screen_text;		// Indexed by ScreenTextId
+		std::vector<ScreenTextId>				m_free_screen_ids;
+
+		bgfx::VertexLayout						m_layout;
+		bgfx::IndexBufferHandle					m_index_buffer;		// Shared by all pages; two triangles per glyph
+		ProgramId								m_program;
+		UniformId								m_sampler;
+
+		Stats									m_stats;
+	};
+}
@@ -0,0 +1,165 @@
+#include <cstring>
+#include <algorithm>
+#include "../../../util/log.h"
+#include "entry/entry.h"
+
+#include "texture_atlas.h"
+
+namespace Orion
+{
+	TextureAtlas::TextureAtlas(const std::string& name, uint16_t page_size)
+		:
+		m_name(name),
+		m_page_size(page_size)
+	{
+	}
+
+	ResultCode TextureAtlas::add(const std::string& name, const std::string& path, uint32_t width, uint32_t height)
+	{
+		if (!m_pages.empty() && m_pages.front().texture)
+		{
+			RETURN_LOG_ERROR("Cannot add \"" << name << "\" to texture atlas \"" << m_name << "\" after it has been built", ResultCodes::CannotModifyBuiltTextureAtlas);
+		}
+		if (m_region_lookup.find(name) != m_region_lookup.end())
+		{
+			RETURN_LOG_ERROR("Cannot add \"" << name << "\" to texture atlas \"" << m_name << "\"; region already exists", ResultCodes::CannotLoadDuplicateTexture);
+		}
+		if (width == 0U || height == 0U || width + 2U * GUTTER > m_page_size || height + 2U * GUTTER > m_page_size)
+		{
+			RETURN_LOG_ERROR("Cannot add \"" << name << "\" to texture atlas \"" << m_name << "\"; image does not fit within a page (" << width << "x" << height << ")", ResultCodes::TextureAtlasFull);
+		}
+
+		const auto cell_width = static_cast<uint16_t>(width + 2U * GUTTER);
+		const auto cell_height = static_cast<uint16_t>(height + 2U * GUTTER);
+
+		Pack2D pack;
+		auto page = std::find_if(m_pages.begin(), m_pages.end(), [&](Page& candidate) { return candidate.packer.find(cell_width, cell_height, pack); });
+		if (page == m_pages.end())
+		{
+			// An image which fits within a page always fits on an empty page
+			m_pages.push_back({ RectPack2DT<64>(m_page_size, m_page_size), {}, TextureId() });
+			page = m_pages.end() - 1;
+			page->packer.find(cell_width, cell_height, pack);
+		}
+
+		const uint32_t x = pack.m_x + GUTTER;
+		const uint32_t y = pack.m_y + GUTTER;
+
+		const float scale = 1.0f / float(m_page_size);
+		m_regions.push_back({ float(x) * scale, float(y) * scale, float(width) * scale, float(height) * scale, static_cast<uint16_t>(page - m_pages.begin()) });
+		m_sources.push_back({ path, x, y, width, height });
+		m_region_lookup[name] = m_regions.size() - 1U;
+		page->regions.push_back(m_regions.size() - 1U);
+
+		return ResultCodes::Success;
+	}
+
+	bimg::ImageContainer * TextureAtlas::composePage(uint16_t page, uint8_t skip, const DecodeFn& decode) const
+	{
+		skip = std::min<uint8_t>(skip, uint8_t(MAX_PAGE_SKIP));
+		const uint32_t size = uint32_t(m_page_size) >> skip;
+
+		bimg::ImageContainer* image = bimg::imageAlloc(entry::getAllocator(), bimg::TextureFormat::RGBA8, uint16_t(size), uint16_t(size), 1U, 1U, false, true);
+		if (image == nullptr) return nullptr;
+
+		// The top-level mip is at the start of the image data, followed by each coarser level in turn
+		uint8_t* data = static_cast<uint8_t*>(image->m_data);
+		memset(data, 0, size_t(size) * size_t(size) * 4U);
+
+		std::vector<uint8_t> rgba;
+		for (const auto region : m_pages[page].regions)
+		{
+			const auto& source = m_sources[region];
+			bimg::ImageContainer* decoded = decode(source.path, skip);
+			if (decoded == nullptr) continue;
+
+			// Only the first decoded mip is used, and is converted to RGBA8 for composition
+			const uint32_t width = decoded->m_width;
+			const uint32_t height = decoded->m_height;
+			rgba.resize(size_t(width) * size_t(height) * 4U);
+			bimg::imageDecodeToRgba8(entry::getAllocator(), rgba.data(), decoded->m_data, width, height, width * 4U, decoded->m_format);
+			bimg::imageFree(decoded);
+
+			copyWithGutter(rgba.data(), width, height, data, size, source.x >> skip, source.y >> skip,
+				std::max(source.width >> skip, 1U), std::max(source.height >> skip, 1U), uint32_t(GUTTER) >> skip);
+		}
+
+		// Coarser levels are filtered from the composed level
+		uint8_t* level = data;
+		uint32_t level_size = size;
+		for (uint8_t lod = 1U; lod < image->m_numMips; ++lod)
+		{
+			uint8_t* next = level + (size_t(level_size) * size_t(level_size) * 4U);
+			const uint32_t next_size = std::max(level_size / 2U, 1U);
+
+			downsample(level, level_size, next, next_size);
+			level = next;
+			level_size = next_size;
+		}
+
+		return image;
+	}
+
+	void TextureAtlas::copyWithGutter(const uint8_t* src, uint32_t src_width, uint32_t src_height, uint8_t* dst, uint32_t dst_size,
+		uint32_t dst_x, uint32_t dst_y, uint32_t width, uint32_t height, uint32_t gutter)
+	{
+		const size_t pitch = size_t(dst_size) * 4U;
+
+		// Rows and columns [-gutter, size + gutter) clamp to the nearest texel of the region.  Sources which have no mip
+		// at the level being composed are larger than their region, and are point-sampled to fit
+		for (int row = -int(gutter); row < int(height + gutter); ++row)
+		{
+			const uint32_t region_row = static_cast<uint32_t>(std::min<int>(std::max<int>(row, 0), int(height) - 1));
+			const uint8_t* in = src + (size_t(region_row * src_height / height) * size_t(src_width) * 4U);
+			uint8_t* out = dst + (size_t(int(dst_y) + row) * pitch) + (size_t(dst_x) * 4U);
+
+			if (src_width == width)
+			{
+				memcpy(out, in, size_t(width) * 4U);
+				for (uint32_t g = 1U; g <= gutter; ++g)
+				{
+					memcpy(out - (g * 4U), in, 4U);
+					memcpy(out + ((width + g - 1U) * 4U), in + ((width - 1U) * 4U), 4U);
+				}
+				continue;
+			}
+
+			for (int col = -int(gutter); col < int(width + gutter); ++col)
+			{
+				const uint32_t region_col = static_cast<uint32_t>(std::min<int>(std::max<int>(col, 0), int(width) - 1));
+				memcpy(out + (col * 4), in + (size_t(region_col * src_width / width) * 4U), 4U);
+			}
+		}
+	}
+
+	void TextureAtlas::downsample(const uint8_t* src, uint32_t src_size, uint8_t* dst, uint32_t dst_size)
+	{
+		// 2x2 box filter, clamped at the edge of the source
+		const size_t src_pitch = size_t(src_size) * 4U;
+		const uint32_t last = src_size - 1U;
+
+		for (uint32_t y = 0U; y < dst_size; ++y)
+		{
+			const uint8_t* row0 = src + (size_t(std::min(y * 2U, last)) * src_pitch);
+			const uint8_t* row1 = src + (size_t(std::min(y * 2U + 1U, last)) * src_pitch);
+			uint8_t* out = dst + (size_t(y) * size_t(dst_size) * 4U);
+
+			for (uint32_t x = 0U; x < dst_size; ++x)
+			{
+				const size_t x0 = size_t(std::min(x * 2U, last)) * 4U;
+				const size_t x1 = size_t(std::min(x * 2U + 1U, last)) * 4U;
+
+				for (size_t c = 0U; c < 4U; ++c)
+				{
+					out[(x * 4U) + c] = static_cast<uint8_t>((uint32_t(row0[x0 + c]) + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2U) / 4U);
+				}
+			}
+		}
+	}
+
+	size_t TextureAtlas::find(const std::string& name) const
+	{
+		const auto it = m_region_lookup.find(name);
+		return (it != m_region_lookup.end() ? it->second : NO_REGION);
+	}
+}
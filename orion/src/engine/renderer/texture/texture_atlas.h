@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include "bgfx_utils.h"
+#include "packrect.h"
+#include "../../../util/result_code.h"
+#include "../core/resource_id.h"
+
+namespace Orion
+{
+	// Packs a set of source images into square RGBA8 pages, so that geometry using any of the images on a page can be
+	// drawn with one texture binding.  The atlas holds only the layout; each page is a streamed texture, composed by
+	// the texture manager from the source images at the level of detail requested for it.  Each packed image is
+	// surrounded by a gutter of replicated edge texels to prevent bleeding between regions when filtered, wide enough
+	// to remain at least one texel at the coarsest level to which pages are streamed
+	class TextureAtlas
+	{
+	public:
+
+		// Page size must be a multiple of (64 << MAX_PAGE_SKIP), so that packed regions remain texel-aligned at every streamed level
+		static const uint16_t DEFAULT_PAGE_SIZE = 2048U;
+		static const uint8_t MAX_PAGE_SKIP = 4U;
+		static const uint16_t GUTTER = (1U << MAX_PAGE_SKIP);
+		static const size_t NO_REGION = static_cast<size_t>(-1);
+
+		// Normalised texture-space rectangle of one packed image, within its page
+		struct Region
+		{
+			float u;
+			float v;
+			float width;
+			float height;
+			uint16_t page;
+		};
+
+		// Source image of one region, and its position on the page in full-resolution texels
+		struct Source
+		{
+			std::string path;
+			uint32_t x;
+			uint32_t y;
+			uint32_t width;
+			uint32_t height;
+		};
+
+		// Reads an image from the given mip level, or the finest level available if it is not present
+		typedef std::function<bimg::ImageContainer*(const std::string& path, uint8_t skip)> DecodeFn;
+
+		TextureAtlas(const std::string& name, uint16_t page_size = DEFAULT_PAGE_SIZE);
+
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+		// Images are placed on the first page with space, and a new page is added if none has space
+		ResultCode add(const std::string& name, const std::string& path, uint32_t width, uint32_t height);
+
+		inline const std::string& getName() const { return m_name; }
+		inline uint16_t getPageSize() const { return m_page_size; }
+		inline uint16_t getPageCount() const { return static_cast<uint16_t>(m_pages.size()); }
+		inline const std::vector<size_t>& getPageRegions(uint16_t page) const { return m_pages[page].regions; }
+
+		// Streamed texture holding the page; resolved through the texture manager each frame
+		inline TextureId getPageTexture(uint16_t page) const { return m_pages[page].texture; }
+
+		// Size of a full-resolution page and its complete mip chain
+		inline size_t getPageBytes() const { return (size_t(m_page_size) * size_t(m_page_size) * 16U) / 3U; }
+
+		inline size_t getRegionCount() const { return m_regions.size(); }
+		inline const Region& getRegion(size_t index) const { return m_regions[index]; }
+		inline const Source& getSource(size_t index) const { return m_sources[index]; }
+
+		size_t find(const std::string& name) const;
+
+		// Composes a page with its top-level mip at the given level, and the complete mip chain below it.  Each source
+		// is decoded only from the level required, and any source which cannot be read is left blank.  The layout is
+		// not modified once built, so pages may be composed on worker threads
+		bimg::ImageContainer * composePage(uint16_t page, uint8_t skip, const DecodeFn& decode) const;
+
+	private:
+
+		friend class TextureManager;
+
+		struct Page
+		{
+			RectPack2DT<64>			packer;
+			std::vector<size_t>		regions;
+			TextureId				texture;
+		};
+
+		inline void setPageTexture(uint16_t page, TextureId id) { m_pages[page].texture = id; }
+
+		static void copyWithGutter(const uint8_t* src, uint32_t src_width, uint32_t src_height, uint8_t* dst, uint32_t dst_size,
+			uint32_t dst_x, uint32_t dst_y, uint32_t width, uint32_t height, uint32_t gutter);
+		static void downsample(const uint8_t* src, uint32_t src_size, uint8_t* dst, uint32_t dst_size);
+
+	private:
+
+		std::string								m_name;
+		uint16_t								m_page_size;
+
+		std::vector<Page>						m_pages;
+		std::vector<Region>						m_regions;
+		std::vector<Source>						m_sources;		// Indexed by region
+		std::unordered_map<std::string, size_t>	m_region_lookup;
+	};
+}
@@ -1,25 +1,68 @@
+#include <array>
 #include <algorithm>
+#include <cmath>
+#include <fstream>
 #include "../../../util/log.h"
+#include "../../../util/bgfx_support.h"
+#include "../../../util/thread_pool.h"
+#include "../../../util/file_watcher.h"
 #include "../core/renderer_input_state.h"
 #include "bgfx_utils.h"
+#include "entry/entry.h"
 
 #include "texture_manager.h"
 
 namespace Orion
 {
+	namespace
+	{
+		void releaseImageContainer(void* data, void* user_data)
+		{
+			(void)data;
+			bimg::imageFree(static_cast<bimg::ImageContainer*>(user_data));
+		}
+	}
+
 	TextureManager::TextureManager()
+		:
+		m_workers(nullptr),
+		m_watcher(nullptr),
+		m_placeholder({ BgfxSupport::INVALID_HANDLE }),
+		m_upload_budget(DEFAULT_UPLOAD_BUDGET_BYTES),
+		m_stats(),
+		m_total_latency_ms(0.0),
+		m_streaming_budget(DEFAULT_STREAMING_BUDGET_BYTES),
+		m_frame(0U)
 	{
 	}
 
-	ResultCode TextureManager::initialise()
+	ResultCode TextureManager::initialise(ThreadPool& workers, FileWatcher& watcher)
 	{
 		LOG_INFO("Initialising texture manager");
 
+		m_workers = &workers;
+		m_watcher = &watcher;
+
+		RETURN_ON_ERROR(initialisePlaceholderTexture());
 		RETURN_ON_ERROR(initialiseTextures());
 
 		return ResultCodes::Success;
 	}
 
+	ResultCode TextureManager::initialisePlaceholderTexture()
+	{
+		// 2x2 magenta/black checker, so that textures which are still loading (or failed to load) are clearly visible
+		static const uint32_t texels[4] = { 0xffff00ff, 0xff000000, 0xff000000, 0xffff00ff };
+
+		m_placeholder = bgfx::createTexture2D(2U, 2U, false, 1U, bgfx::TextureFormat::RGBA8, BGFX_SAMPLER_POINT, bgfx::copy(texels, sizeof(texels)));
+		if (!bgfx::isValid(m_placeholder))
+		{
+			RETURN_LOG_ERROR("Failed to create placeholder texture", ResultCodes::FailedToLoadTextureResource);
+		}
+
+		return ResultCodes::Success;
+	}
+
 	ResultCode TextureManager::initialiseTextures()
 	{
 		LOG_INFO("Initialising texture resources");
@@ -29,15 +72,8 @@ namespace Orion
 			{ "fieldstone", "textures/fieldstone-rgba.dds" }
 		};
 
-		ResultCode aggregate = ResultCodes::Success;
-		for (auto resource : temporaryResources)
-		{
-			auto result = loadTextureResource(std::get<0>(resource), std::get<1>(resource));
-			if (!ResultCodes::isSuccess(result) && ResultCodes::isSuccess(aggregate))
-			{
-				aggregate = result;
-			}
-		}
+		// Tile textures are packed into a shared atlas so that all tile types on a page can be rendered in a single draw
+		const auto aggregate = buildTextureAtlas("tiles", temporaryResources);
 
 		if (!ResultCodes::isSuccess(aggregate))
 		{
@@ -47,27 +83,516 @@ namespace Orion
 		return ResultCodes::Success;
 	}
 
-	ResultCode TextureManager::loadTextureResource(const std::string& name, const std::string& path)
+	ResultCode TextureManager::registerTexture(const std::string& name, const std::string& path, TextureId& outId)
 	{
-		if (m_textures.find(name) != m_textures.end())
+		outId = m_texture_names.add(name);
+		if (!outId)
 		{
 			RETURN_LOG_ERROR("Cannot load texture resource; texture \"" << name << "\" already exists", ResultCodes::CannotLoadDuplicateTexture);
 		}
 
-		auto handle = loadTexture(path.c_str());
-		if (!bgfx::isValid(handle))
+		m_textures.push_back({ BgfxSupport::INVALID_HANDLE });
+		m_texture_paths.push_back(path);
+		m_texture_versions.push_back(0U);
+
+		// Atlas pages have no single source file, and instead watch each of their sources
+		if (!path.empty())
 		{
-			RETURN_LOG_ERROR("Failed to load texture resource \"" << name << "\"", ResultCodes::FailedToLoadTextureResource);
+			const auto id = outId;
+			m_watcher->watch(path, [this, id](const std::string&) { onTextureFileChanged(id); });
 		}
 
-		m_textures[name] = handle;
 		return ResultCodes::Success;
 	}
 
+	ResultCode TextureManager::loadTextureResourceAsync(const std::string& name, const std::string& path)
+	{
+		TextureId id;
+		RETURN_ON_ERROR(registerTexture(name, path, id));
+
+		requestDecode(id, 0U, false);
+
+		return ResultCodes::Success;
+	}
+
+	ResultCode TextureManager::loadTextureResourceStreamed(const std::string& name, const std::string& path)
+	{
+		TextureId id;
+		RETURN_ON_ERROR(registerTexture(name, path, id));
+
+		// Only the coarse mips are loaded initially; the mip count and full size are unknown until this first load completes
+		m_streamed[id.index] = { NO_SKIP_REQUESTED, INITIAL_STREAMING_SKIP, NO_SKIP_REQUESTED, 0U, nullptr, 0U, true, false, 0U, 0U, m_frame };
+		requestDecode(id, INITIAL_STREAMING_SKIP, true);
+
+		return ResultCodes::Success;
+	}
+
+	void TextureManager::requestTextureDetail(TextureId id, float view_distance)
+	{
+		const auto it = m_streamed.find(id.index);
+		if (it == m_streamed.end()) return;
+
+		it->second.requested_skip = std::min(it->second.requested_skip, calculateSkip(view_distance));
+		it->second.last_requested_frame = m_frame;
+	}
+
+	void TextureManager::onTextureFileChanged(TextureId id)
+	{
+		LOG_INFO("Reloading texture \"" << m_texture_names.getName(id) << "\"");
+
+		// Streamed textures reload their current mip level once any in-flight load completes.  Other textures are
+		// reloaded immediately, and any earlier load still in progress is discarded on completion
+		const auto streamed = m_streamed.find(id.index);
+		if (streamed != m_streamed.end())
+		{
+			streamed->second.stale = true;
+			return;
+		}
+
+		requestDecode(id, 0U, false);
+	}
+
+	void TextureManager::requestDecode(TextureId id, uint8_t skip, bool streamed)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_decoded_mutex);
+			++m_stats.requested;
+			++m_stats.decoding;
+		}
+
+		const auto version = ++m_texture_versions[id.index];
+		const auto& name = m_texture_names.getName(id);
+		const auto& path = m_texture_paths[id.index];
+
+		const auto entry = m_streamed.find(id.index);
+		const TextureAtlas* atlas = (entry != m_streamed.end() ? entry->second.atlas : nullptr);
+		const uint16_t page = (atlas ? entry->second.page : 0U);
+
+		const auto requested = Clock::now();
+		m_workers->enqueue([this, id, version, name, path, atlas, page, requested, skip, streamed]()
+		{
+			DecodedTexture texture { id, version, name, path, nullptr, requested, { 0U, 0U, 0U }, streamed };
+
+			// Atlas pages are composed from the retained mips of each of their sources
+			if (atlas)
+			{
+				const uint8_t page_skip = std::min<uint8_t>(skip, uint8_t(TextureAtlas::MAX_PAGE_SKIP));
+				texture.image = atlas->composePage(page, page_skip, [](const std::string& source, uint8_t source_skip)
+				{
+					DecodedLevels levels;
+					return decodeTexture(source, source_skip, levels);
+				});
+				texture.levels = { page_skip, uint8_t(TextureAtlas::MAX_PAGE_SKIP + 1U), atlas->getPageBytes() };
+			}
+			else
+			{
+				texture.image = decodeTexture(path, skip, texture.levels);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_decoded_mutex);
+				--m_stats.decoding;
+				++m_stats.awaiting_upload;
+				m_stats.bytes_awaiting_upload += (texture.image ? texture.image->m_size : 0U);
+				m_decoded.push_back(std::move(texture));
+			}
+
+			m_decode_complete.notify_all();
+		});
+	}
+
+	bimg::ImageContainer * TextureManager::decodeTexture(const std::string& path, uint8_t skip, DecodedLevels& outLevels)
+	{
+		// The shared entry file reader is not thread-safe, so each worker reads the file independently
+		std::ifstream in(path, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!in.is_open()) return nullptr;
+
+		const auto size = static_cast<size_t>(in.tellg());
+		in.seekg(0, std::ios::beg);
+
+		// Container formats describe their mip chain in the header, so the data for skipped mips is never read.  Mips
+		// can only be skipped where the remaining chain is contiguous in the file
+		std::array<char, TEXTURE_HEADER_READ_BYTES> header;
+		const auto header_bytes = std::min(size, header.size());
+
+		bimg::ImageContainer info;
+		if (skip != 0U && in.read(header.data(), static_cast<std::streamsize>(header_bytes)) &&
+			bimg::imageParse(info, header.data(), static_cast<uint32_t>(header_bytes)) && isStreamable(info) && info.m_numMips > 1U)
+		{
+			skip = std::min<uint8_t>(skip, uint8_t(info.m_numMips - 1U));
+
+			// Only the header is held in memory; the offset of the first retained mip is calculated relative to it
+			bimg::ImageMip mip;
+			if (!bimg::imageGetRawData(info, 0U, skip, header.data(), static_cast<uint32_t>(size), mip)) return nullptr;
+
+			const auto offset = static_cast<size_t>(mip.m_data - reinterpret_cast<const uint8_t*>(header.data()));
+			if (offset >= size) return nullptr;
+
+			// The retained mips have the layout of an image whose top-level mip is the first retained level
+			const uint8_t mip_count = uint8_t(info.m_numMips - skip);
+			bimg::ImageContainer* image = bimg::imageAlloc(entry::getAllocator(), info.m_format, uint16_t(mip.m_width), uint16_t(mip.m_height), 1U, 1U, false, mip_count > 1U);
+			if (image == nullptr) return nullptr;
+
+			if (size - offset > image->m_size)
+			{
+				bimg::imageFree(image);
+				return nullptr;
+			}
+
+			image->m_size = static_cast<uint32_t>(size - offset);
+			image->m_numMips = mip_count;
+			image->m_hasAlpha = info.m_hasAlpha;
+
+			in.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+			if (!in.read(static_cast<char*>(image->m_data), static_cast<std::streamsize>(image->m_size)))
+			{
+				bimg::imageFree(image);
+				return nullptr;
+			}
+
+			outLevels = { skip, info.m_numMips, size - info.m_offset };
+			return image;
+		}
+
+		// All other images are read and decoded in full
+		std::vector<char> data(size);
+		in.clear();
+		in.seekg(0, std::ios::beg);
+		if (!in.read(data.data(), static_cast<std::streamsize>(size))) return nullptr;
+
+		bimg::ImageContainer* image = bimg::imageParse(entry::getAllocator(), data.data(), static_cast<uint32_t>(size));
+		if (image) outLevels = { 0U, (isStreamable(*image) ? image->m_numMips : uint8_t(1U)), image->m_size };
+
+		return image;
+	}
+
+	bool TextureManager::readTextureSize(const std::string& path, uint32_t& outWidth, uint32_t& outHeight)
+	{
+		std::ifstream in(path, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!in.is_open()) return false;
+
+		const auto size = static_cast<size_t>(in.tellg());
+		in.seekg(0, std::ios::beg);
+
+		// Container formats are sized from their header alone, and all other images are decoded in full
+		std::array<char, TEXTURE_HEADER_READ_BYTES> header;
+		const auto header_bytes = std::min(size, header.size());
+
+		bimg::ImageContainer info;
+		if (in.read(header.data(), static_cast<std::streamsize>(header_bytes)) && bimg::imageParse(info, header.data(), static_cast<uint32_t>(header_bytes)))
+		{
+			outWidth = info.m_width;
+			outHeight = info.m_height;
+			return true;
+		}
+
+		DecodedLevels levels;
+		bimg::ImageContainer* image = decodeTexture(path, 0U, levels);
+		if (image == nullptr) return false;
+
+		outWidth = image->m_width;
+		outHeight = image->m_height;
+		bimg::imageFree(image);
+
+		return true;
+	}
+
+	bool TextureManager::isStreamable(const bimg::ImageContainer& image)
+	{
+		return (!image.m_cubeMap && image.m_depth <= 1U && image.m_numLayers <= 1U && !image.m_ktx);
+	}
+
+	bgfx::TextureHandle TextureManager::uploadTexture(const DecodedTexture& texture, size_t& outBytes)
+	{
+		const auto* image = texture.image;
+		const auto format = bgfx::TextureFormat::Enum(image->m_format);
+		const bool has_mips = (image->m_numMips > 1U);
+
+		bgfx::TextureHandle handle = { BgfxSupport::INVALID_HANDLE };
+
+		// The image holds only the retained mips, so is uploaded in full.  Image data is released by bgfx once it has been consumed
+		const bgfx::Memory* mem = bgfx::makeRef(image->m_data, image->m_size, releaseImageContainer, texture.image);
+		outBytes = image->m_size;
+
+		if (image->m_cubeMap)
+		{
+			handle = bgfx::createTextureCube(uint16_t(image->m_width), has_mips, image->m_numLayers, format, BGFX_TEXTURE_NONE | BGFX_SAMPLER_NONE, mem);
+		}
+		else if (image->m_depth > 1U)
+		{
+			handle = bgfx::createTexture3D(uint16_t(image->m_width), uint16_t(image->m_height), uint16_t(image->m_depth), has_mips, format, BGFX_TEXTURE_NONE | BGFX_SAMPLER_NONE, mem);
+		}
+		else
+		{
+			handle = bgfx::createTexture2D(uint16_t(image->m_width), uint16_t(image->m_height), has_mips, image->m_numLayers, format, BGFX_TEXTURE_NONE | BGFX_SAMPLER_NONE, mem);
+		}
+
+		if (bgfx::isValid(handle)) bgfx::setName(handle, (texture.path.empty() ? texture.name : texture.path).c_str());
+		return handle;
+	}
+
+	void TextureManager::processUploads()
+	{
+		size_t uploaded = 0U;
+		size_t uploaded_bytes = 0U;
+
+		// Upload decoded textures until the frame budget is exhausted.  At least one texture is always uploaded
+		// per frame, so that a texture larger than the budget cannot stall the queue
+		while (true)
+		{
+			DecodedTexture texture;
+			{
+				std::lock_guard<std::mutex> lock(m_decoded_mutex);
+				if (m_decoded.empty()) break;
+
+				const size_t bytes = (m_decoded.front().image ? m_decoded.front().image->m_size : 0U);
+				if (uploaded != 0U && uploaded_bytes + bytes > m_upload_budget) break;
+
+				texture = std::move(m_decoded.front());
+				m_decoded.pop_front();
+
+				--m_stats.awaiting_upload;
+				m_stats.bytes_awaiting_upload -= bytes;
+				uploaded_bytes += bytes;
+			}
+
+			// Superseded by a later request for the same texture
+			if (texture.version != m_texture_versions[texture.id.index])
+			{
+				if (texture.image) bimg::imageFree(texture.image);
+				continue;
+			}
+
+			size_t texture_bytes = 0U;
+			const auto handle = (texture.image ? uploadTexture(texture, texture_bytes) : bgfx::TextureHandle { BgfxSupport::INVALID_HANDLE });
+
+			if (texture.streamed) completeStreamingLoad(texture, handle, texture_bytes);
+
+			if (!bgfx::isValid(handle))
+			{
+				LOG_ERROR("Failed to load texture resource \"" << texture.name << "\" from \"" << texture.path << "\" [" << ResultCodes::FailedToLoadTextureResource << "]");
+				++m_stats.failed;
+				continue;
+			}
+
+			if (!texture.streamed)
+			{
+				// A reloaded texture replaces the existing texture; bgfx defers destruction until it is no longer referenced
+				auto& resident = m_textures[texture.id.index];
+				if (bgfx::isValid(resident)) bgfx::destroy(resident);
+				resident = handle;
+			}
+
+			++uploaded;
+
+			const double latency_ms = std::chrono::duration<double, std::milli>(Clock::now() - texture.requested).count();
+			m_total_latency_ms += latency_ms;
+			++m_stats.uploaded;
+
+			m_stats.last_latency_ms = latency_ms;
+			m_stats.mean_latency_ms = m_total_latency_ms / double(m_stats.uploaded);
+			m_stats.max_latency_ms = std::max(m_stats.max_latency_ms, latency_ms);
+		}
+
+		m_stats.uploaded_last_frame = uploaded;
+		m_stats.bytes_uploaded_last_frame = uploaded_bytes;
+	}
+
+	void TextureManager::completeStreamingLoad(const DecodedTexture& texture, bgfx::TextureHandle handle, size_t bytes)
+	{
+		auto& streamed = m_streamed.at(texture.id.index);
+		streamed.loading = false;
+
+		if (!bgfx::isValid(handle))
+		{
+			// Failed loads are not retried until a different level of detail is required
+			streamed.resident_skip = streamed.target_skip;
+			return;
+		}
+
+		// The previous mip chain is replaced in full; bgfx defers destruction until it is no longer referenced by the frame
+		auto& resident = m_textures[texture.id.index];
+		if (bgfx::isValid(resident)) bgfx::destroy(resident);
+		resident = handle;
+
+		streamed.mip_count = texture.levels.mip_count;
+		streamed.full_bytes = texture.levels.full_bytes;
+		streamed.resident_skip = texture.levels.skip;
+		streamed.resident_bytes = bytes;
+	}
+
+	uint8_t TextureManager::calculateSkip(float view_distance)
+	{
+		// Each doubling of view distance beyond the full-detail distance halves the texel density required on screen
+		if (!(view_distance > FULL_DETAIL_VIEW_DISTANCE)) return 0U;
+
+		const float levels = std::floor(std::log2(view_distance / FULL_DETAIL_VIEW_DISTANCE));
+		return static_cast<uint8_t>(std::min(levels, 15.0f));
+	}
+
+	size_t TextureManager::estimateStreamedBytes(const StreamedTexture& texture, uint8_t skip)
+	{
+		// Each skipped mip removes roughly three quarters of the remaining chain
+		return (skip < (sizeof(size_t) * 4U) ? (texture.full_bytes >> (2U * skip)) : 0U);
+	}
+
+	void TextureManager::updateStreaming()
+	{
+		std::vector<std::pair<TextureId, StreamedTexture*>> textures;
+		textures.reserve(m_streamed.size());
+
+		// Determine the detail required by each texture.  Textures which have not been requested recently fall back
+		// to their coarsest level, and others retain their current level until a different detail is requested.
+		// Evicted textures remain so until they are next requested
+		size_t required_bytes = 0U;
+		for (auto& entry : m_streamed)
+		{
+			auto& texture = entry.second;
+			if (texture.mip_count == 0U) continue;		// Awaiting first load
+
+			const uint8_t coarsest = uint8_t(texture.mip_count - 1U);
+			uint8_t desired = (texture.resident_skip != NO_SKIP_REQUESTED ? texture.resident_skip : texture.target_skip);
+
+			if (texture.requested_skip != NO_SKIP_REQUESTED) desired = texture.requested_skip;
+			else if (m_frame - texture.last_requested_frame > STREAMING_EVICTION_DELAY_FRAMES && desired != NO_SKIP_REQUESTED) desired = coarsest;
+
+			texture.target_skip = (desired != NO_SKIP_REQUESTED ? std::min(desired, coarsest) : NO_SKIP_REQUESTED);
+			texture.requested_skip = NO_SKIP_REQUESTED;
+
+			required_bytes += estimateStreamedBytes(texture, texture.target_skip);
+			textures.push_back({ TextureId(entry.first), &texture });
+		}
+
+		// Textures are prioritised by recency of use, then by the detail required
+		std::sort(textures.begin(), textures.end(), [](const auto& a, const auto& b) {
+			if (a.second->last_requested_frame != b.second->last_requested_frame) return a.second->last_requested_frame > b.second->last_requested_frame;
+			return a.second->target_skip < b.second->target_skip;
+		});
+
+		// Reduce the detail of the lowest-priority textures until the required set fits within the budget
+		for (auto it = textures.rbegin(); it != textures.rend() && required_bytes > m_streaming_budget; ++it)
+		{
+			auto& texture = *(it->second);
+			while (required_bytes > m_streaming_budget && texture.target_skip < texture.mip_count - 1U)
+			{
+				required_bytes -= estimateStreamedBytes(texture, texture.target_skip) - estimateStreamedBytes(texture, uint8_t(texture.target_skip + 1U));
+				++texture.target_skip;
+			}
+		}
+
+		// If the budget still cannot be met, textures which have not been requested recently are evicted entirely.
+		// Textures are ordered by recency of use, so no texture beyond the first recently-used texture is idle
+		for (auto it = textures.rbegin(); it != textures.rend() && required_bytes > m_streaming_budget; ++it)
+		{
+			auto& texture = *(it->second);
+			if (m_frame - texture.last_requested_frame <= STREAMING_EVICTION_DELAY_FRAMES) break;
+
+			required_bytes -= estimateStreamedBytes(texture, texture.target_skip);
+			texture.target_skip = NO_SKIP_REQUESTED;
+		}
+
+		// Issue loads for textures whose resident level differs from their target, highest priority first
+		size_t loading = static_cast<size_t>(std::count_if(m_streamed.begin(), m_streamed.end(), [](const auto& entry) { return entry.second.loading; }));
+		for (auto& entry : textures)
+		{
+			auto& texture = *(entry.second);
+			if (texture.loading) continue;
+
+			if (texture.target_skip == NO_SKIP_REQUESTED)
+			{
+				if (texture.resident_skip != NO_SKIP_REQUESTED) releaseStreamedTexture(entry.first, texture);
+				continue;
+			}
+
+			if (loading >= MAX_STREAMING_LOADS_IN_FLIGHT || (texture.resident_skip == texture.target_skip && !texture.stale)) continue;
+
+			texture.loading = true;
+			texture.stale = false;
+			++loading;
+			requestDecode(entry.first, texture.target_skip, true);
+		}
+
+		size_t resident_bytes = 0U;
+		std::for_each(m_streamed.begin(), m_streamed.end(), [&resident_bytes](const auto& entry) { resident_bytes += entry.second.resident_bytes; });
+
+		std::lock_guard<std::mutex> lock(m_decoded_mutex);
+		m_stats.streamed_textures = m_streamed.size();
+		m_stats.streamed_resident_bytes = resident_bytes;
+		m_stats.streaming_loads = loading;
+	}
+
+	void TextureManager::releaseStreamedTexture(TextureId id, StreamedTexture& texture)
+	{
+		// The placeholder is returned until the texture is next loaded; bgfx defers destruction until it is no longer referenced by the frame
+		auto& resident = m_textures[id.index];
+		if (bgfx::isValid(resident)) bgfx::destroy(resident);
+		resident = { BgfxSupport::INVALID_HANDLE };
+
+		texture.resident_skip = NO_SKIP_REQUESTED;
+		texture.resident_bytes = 0U;
+	}
+
+	TextureManager::LoadStats TextureManager::getLoadStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_decoded_mutex);
+		return m_stats;
+	}
+
+	ResultCode TextureManager::buildTextureAtlas(const std::string& name, const std::vector<std::tuple<std::string, std::string>>& resources)
+	{
+		if (m_atlases.find(name) != m_atlases.end())
+		{
+			RETURN_LOG_ERROR("Cannot build texture atlas; atlas \"" << name << "\" already exists", ResultCodes::CannotLoadDuplicateTextureAtlas);
+		}
+
+		// Page loads reference the atlas, so it is owned by the manager before any are requested
+		auto& atlas = *(m_atlases[name] = std::make_unique<TextureAtlas>(name));
+
+		// Images are only measured to lay out the atlas; texel data is read as each page is streamed.  Individual
+		// failures are logged and skipped, and the atlas is still built from all remaining resources
+		ResultCode aggregate = ResultCodes::Success;
+		for (const auto& resource : resources)
+		{
+			uint32_t width = 0U, height = 0U;
+			if (!readTextureSize(std::get<1>(resource), width, height))
+			{
+				LOG_ERROR("Failed to load texture resource \"" << std::get<1>(resource) << "\" for atlas \"" << name << "\" [" << ResultCodes::FailedToLoadTextureResource << "]");
+				aggregate = ResultCodes::aggregate(aggregate, ResultCodes::FailedToLoadTextureResource);
+				continue;
+			}
+
+			aggregate = ResultCodes::aggregate(aggregate, atlas.add(std::get<0>(resource), std::get<1>(resource), width, height));
+		}
+
+		// Each page is a streamed texture, recomposed whenever any of its sources change
+		for (uint16_t page = 0U; page < atlas.getPageCount(); ++page)
+		{
+			TextureId id;
+			RETURN_ON_ERROR(registerTexture(name + "#" + std::to_string(page), "", id));
+			atlas.setPageTexture(page, id);
+
+			for (const auto region : atlas.getPageRegions(page))
+			{
+				m_watcher->watch(atlas.getSource(region).path, [this, id](const std::string&) { onTextureFileChanged(id); });
+			}
+
+			m_streamed[id.index] = { NO_SKIP_REQUESTED, INITIAL_STREAMING_SKIP, NO_SKIP_REQUESTED, 0U, &atlas, page, true, false, 0U, 0U, m_frame };
+			requestDecode(id, INITIAL_STREAMING_SKIP, true);
+		}
+
+		LOG_INFO("Built texture atlas \"" << name << "\" (" << atlas.getPageCount() << " pages of " << atlas.getPageSize() << "x" << atlas.getPageSize() << ") with " << atlas.getRegionCount() << " regions");
+		return aggregate;
+	}
+
 
 	ResultCode TextureManager::beginFrame(const RendererInputState& state)
 	{
 		(void)state;
+
+		processUploads();
+		updateStreaming();
+		++m_frame;
+
 		return ResultCodes::Success;
 	}
 
@@ -92,9 +617,29 @@ namespace Orion
 
 	void TextureManager::shutdownTextureResources()
 	{
+		// Outstanding decodes hold a reference to this manager, so must complete before resources are released
+		{
+			std::unique_lock<std::mutex> lock(m_decoded_mutex);
+			m_decode_complete.wait(lock, [this]() { return m_stats.decoding == 0U; });
+
+			std::for_each(m_decoded.begin(), m_decoded.end(), [](auto& texture) { if (texture.image) bimg::imageFree(texture.image); });
+			m_decoded.clear();
+		}
+
 		LOG_INFO("Releasing all texture resources");
 
-		std::for_each(m_textures.begin(), m_textures.end(), [](auto& texture) { bgfx::destroy(texture.second); });
+		std::for_each(m_textures.begin(), m_textures.end(), [](auto& texture) { if (bgfx::isValid(texture)) bgfx::destroy(texture); });
 		m_textures.clear();
+		m_texture_names.clear();
+		m_texture_paths.clear();
+		m_texture_versions.clear();
+		m_streamed.clear();
+		m_atlases.clear();
+
+		if (bgfx::isValid(m_placeholder))
+		{
+			bgfx::destroy(m_placeholder);
+			m_placeholder = { BgfxSupport::INVALID_HANDLE };
+		}
 	}
 }
@@ -1,38 +1,192 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+#include <deque>
+#include <tuple>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include <unordered_map>
 #include "../../../util/result_code.h"
+#include "texture_atlas.h"
+#include "../core/resource_id.h"
 struct RendererInputState;
 
 namespace Orion
 {
+	class ThreadPool;
+	class FileWatcher;
+
 	class TextureManager
 	{
 	public:
 
+		// Default limit on the volume of texture data submitted for upload in a single frame
+		static const size_t DEFAULT_UPLOAD_BUDGET_BYTES = 8U * 1024U * 1024U;
+
+		// Streamed textures: default bound on resident memory, the mip level loaded before any detail is requested,
+		// and the view distance at which the full-resolution mip is required
+		static const size_t DEFAULT_STREAMING_BUDGET_BYTES = 64U * 1024U * 1024U;
+		static const uint8_t INITIAL_STREAMING_SKIP = 4U;
+		static const uint8_t NO_SKIP_REQUESTED = 0xFFU;
+		static const size_t MAX_STREAMING_LOADS_IN_FLIGHT = 4U;
+		static const uint32_t STREAMING_EVICTION_DELAY_FRAMES = 120U;
+		static constexpr float FULL_DETAIL_VIEW_DISTANCE = 200.0f;
+
+		struct LoadStats
+		{
+			size_t		requested;				// Total number of asynchronous load requests
+			size_t		decoding;				// Requests still being read and decoded on worker threads
+			size_t		awaiting_upload;		// Decoded textures waiting for upload budget
+			size_t		bytes_awaiting_upload;
+			size_t		uploaded;
+			size_t		failed;
+
+			size_t		uploaded_last_frame;
+			size_t		bytes_uploaded_last_frame;
+
+			double		last_latency_ms;		// Time from request to upload of the most recent texture
+			double		mean_latency_ms;
+			double		max_latency_ms;
+
+			size_t		streamed_textures;
+			size_t		streamed_resident_bytes;
+			size_t		streaming_loads;		// Streaming residency changes currently in progress
+		};
+
 		TextureManager();
 
-		ResultCode initialise();
+		ResultCode initialise(ThreadPool& workers, FileWatcher& watcher);
 
 		ResultCode beginFrame(const RendererInputState& state);
 		ResultCode executeFrame(const RendererInputState& state);
 		ResultCode endFrame(const RendererInputState& state);
 
-		inline bgfx::TextureHandle getTexture(const std::string& name) const { return m_textures.at(name); }
+		// Texture IDs remain valid while the underlying texture is loaded, streamed or hot reloaded, so should be
+		// resolved once and retained.  Raw texture handles should be resolved each frame rather than retained
+		inline TextureId getTextureId(const std::string& name) const { return m_texture_names.find(name); }
+
+		// Returns a placeholder texture until the texture has been loaded
+		inline bgfx::TextureHandle getTexture(TextureId id) const { return (bgfx::isValid(m_textures[id.index]) ? m_textures[id.index] : m_placeholder); }
+		inline bool isResident(TextureId id) const { return bgfx::isValid(m_textures[id.index]); }
+
+		// Atlas pages are streamed textures, requested and resolved via the page texture IDs held by the atlas
+		inline const TextureAtlas& getAtlas(const std::string& name) const { return *m_atlases.at(name); }
+
+		// Requests a texture load on a worker thread.  The texture is available via getTexture() immediately, and
+		// will resolve to the placeholder texture until decoded and uploaded
+		ResultCode loadTextureResourceAsync(const std::string& name, const std::string& path);
+
+		// Registers a texture whose mip residency is managed within the streaming budget.  The coarse mips are
+		// loaded first, and finer mips are loaded as detail is requested
+		ResultCode loadTextureResourceStreamed(const std::string& name, const std::string& path);
+
+		// Reports that a streamed texture is in use at the given distance from the camera.  Requests are
+		// aggregated over each frame, and residency is adjusted at the start of the next
+		void requestTextureDetail(TextureId id, float view_distance);
+
+		inline void setUploadBudget(size_t bytes_per_frame) { m_upload_budget = bytes_per_frame; }
+		inline size_t getUploadBudget() const { return m_upload_budget; }
+
+		inline void setStreamingBudget(size_t bytes) { m_streaming_budget = bytes; }
+		inline size_t getStreamingBudget() const { return m_streaming_budget; }
+
+		LoadStats getLoadStats() const;
 
 		void shutdown();
 
 	private:
 
+		typedef std::chrono::steady_clock Clock;
+
+		// Maximum size of the header read to locate mips within a container file, before the mip data itself is read
+		static const size_t TEXTURE_HEADER_READ_BYTES = 256U;
+
+		// Mip chain of a decoded texture, relative to the complete chain held by its source
+		struct DecodedLevels
+		{
+			uint8_t						skip;				// Number of top-level mips omitted from the decoded image
+			uint8_t						mip_count;			// Levels in the complete chain which can be streamed
+			size_t						full_bytes;			// Size of the complete mip chain
+		};
+
+		// Texture decoded on a worker thread and waiting for upload on the render thread
+		struct DecodedTexture
+		{
+			TextureId					id;
+			uint32_t					version;			// Superseded by any later load request for the same texture
+			std::string					name;
+			std::string					path;
+			bimg::ImageContainer *		image;				// Holds only the retained mips
+			Clock::time_point			requested;
+			DecodedLevels				levels;
+			bool						streamed;
+		};
+
+		// Residency state of a streamed texture.  Mip levels are identified by the number of top-level mips skipped
+		struct StreamedTexture
+		{
+			uint8_t						resident_skip;		// NO_SKIP_REQUESTED until loaded, and once evicted
+			uint8_t						target_skip;		// NO_SKIP_REQUESTED once selected for eviction
+			uint8_t						requested_skip;		// Finest detail requested during the current frame
+			uint8_t						mip_count;			// Levels which can be streamed; zero until first loaded
+			const TextureAtlas *		atlas;				// Page of an atlas, composed from its sources, or null for a single file
+			uint16_t					page;
+			bool						loading;
+			bool						stale;				// Source file has changed since the resident mips were loaded
+			size_t						full_bytes;			// Size of the complete mip chain, once known
+			size_t						resident_bytes;
+			uint32_t					last_requested_frame;
+		};
+
 		ResultCode initialiseTextures();
+		ResultCode initialisePlaceholderTexture();
 
-		ResultCode loadTextureResource(const std::string& name, const std::string& path);
+		ResultCode registerTexture(const std::string& name, const std::string& path, TextureId& outId);
+		void requestDecode(TextureId id, uint8_t skip, bool streamed);
+		static bimg::ImageContainer * decodeTexture(const std::string& path, uint8_t skip, DecodedLevels& outLevels);
+		static bool readTextureSize(const std::string& path, uint32_t& outWidth, uint32_t& outHeight);
+		bgfx::TextureHandle uploadTexture(const DecodedTexture& texture, size_t& outBytes);
+		void processUploads();
+		void onTextureFileChanged(TextureId id);
+
+		void updateStreaming();
+		void releaseStreamedTexture(TextureId id, StreamedTexture& texture);
+		void completeStreamingLoad(const DecodedTexture& texture, bgfx::TextureHandle handle, size_t bytes);
+		static bool isStreamable(const bimg::ImageContainer& image);
+		static size_t estimateStreamedBytes(const StreamedTexture& texture, uint8_t skip);
+		static uint8_t calculateSkip(float view_distance);
+
+		ResultCode buildTextureAtlas(const std::string& name, const std::vector<std::tuple<std::string, std::string>>& resources);
 
 		void shutdownTextureResources();
 
 	private:
 
-		std::unordered_map<std::string, bgfx::TextureHandle> m_textures;
+		ThreadPool *														m_workers;
+		FileWatcher *														m_watcher;
+
+		// Indexed by TextureId
+		std::vector<bgfx::TextureHandle>									m_textures;		// Invalid handle until resident
+		std::vector<std::string>											m_texture_paths;
+		std::vector<uint32_t>												m_texture_versions;
+		ResourceNameTable<TextureId>										m_texture_names;
+
+		std::unordered_map<std::string, std::unique_ptr<TextureAtlas>>		m_atlases;
+		bgfx::TextureHandle													m_placeholder;
+
+		// Decoded textures are passed from workers to the render thread under m_decoded_mutex
+		std::deque<DecodedTexture>											m_decoded;
+		mutable std::mutex													m_decoded_mutex;
+		std::condition_variable												m_decode_complete;
+
+		size_t																m_upload_budget;
+		LoadStats															m_stats;
+		double																m_total_latency_ms;
 
+		std::unordered_map<TextureId::Index, StreamedTexture>				m_streamed;
+		size_t																m_streaming_budget;
+		uint32_t															m_frame;
 	};
 }
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include "../../util/result_code.h"
+#include "../../util/log.h"
+
+namespace Orion
+{
+	// Advances a simulation state in fixed timesteps on a dedicated thread, independent of the render rate.  The two
+	// most recent states are retained, so that the renderer can interpolate between them for any point in time.
+	// States are copied on each tick and each read, so should be small values
+	template <typename TState>
+	class SimulationLoop
+	{
+	public:
+
+		typedef std::chrono::steady_clock Clock;
+
+		// Advances the state by dt seconds to the given simulation time
+		typedef std::function<void(TState& state, float dt, Clock::time_point time)> TickFn;
+
+		// When the simulation falls further behind than this, the excess time is dropped rather than simulated
+		static const uint32_t MAX_CATCHUP_TICKS = 5U;
+
+		struct Frame
+		{
+			TState		previous;
+			TState		current;
+			float		alpha;					// Interpolation factor from previous to current, in [0, 1]
+		};
+
+		struct Stats
+		{
+			uint64_t	ticks;
+			uint64_t	dropped_ticks;
+			double		tick_ms;				// Execution time of the last tick
+			double		max_tick_ms;
+		};
+
+		SimulationLoop();
+		~SimulationLoop();
+
+		ResultCode start(float tick_rate, const TState& initial, TickFn&& tick);
+		void stop();
+
+		inline bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+		inline float getTimestep() const { return m_timestep; }
+
+		// Frame to be displayed at the given time.  Rendering lags the simulation by one tick, so that the frame is
+		// always interpolated between two completed states and never extrapolated
+		Frame getFrame(Clock::time_point time = Clock::now()) const;
+
+		Stats getStats() const;
+
+	private:
+
+		void run();
+
+	private:
+
+		float							m_timestep;
+		Clock::duration					m_step;
+		TickFn							m_tick;
+
+		std::thread						m_thread;
+		std::atomic<bool>				m_running;
+
+		// Guarded by m_mutex, which is only held to copy states in and out
+		mutable std::mutex				m_mutex;
+		TState							m_previous;
+		TState							m_current;
+		Clock::time_point				m_current_time;
+		Stats							m_stats;
+	};
+
+
+	template <typename TState>
+	SimulationLoop<TState>::SimulationLoop()
+		:
+		m_timestep(0.0f),
+		m_step(Clock::duration::zero()),
+		m_tick(),
+		m_thread(),
+		m_running(false),
+		m_mutex(),
+		m_previous(),
+		m_current(),
+		m_current_time(),
+		m_stats({ 0U, 0U, 0.0, 0.0 })
+	{
+	}
+
+	template <typename TState>
+	SimulationLoop<TState>::~SimulationLoop()
+	{
+		stop();
+	}
+
+	template <typename TState>
+	ResultCode SimulationLoop<TState>::start(float tick_rate, const TState& initial, TickFn&& tick)
+	{
+		if (isRunning()) stop();
+		if (tick_rate <= 0.0f)
+		{
+			RETURN_LOG_ERROR("Invalid simulation tick rate (" << tick_rate << ")", ResultCodes::FailedToStartSimulation);
+		}
+
+		LOG_INFO("Starting simulation at " << tick_rate << " ticks per second");
+
+		m_timestep = 1.0f / tick_rate;
+		m_step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / double(tick_rate)));
+		m_tick = std::move(tick);
+
+		m_previous = initial;
+		m_current = initial;
+		m_current_time = Clock::now();
+		m_stats = { 0U, 0U, 0.0, 0.0 };
+
+		m_running.store(true, std::memory_order_release);
+		m_thread = std::thread(&SimulationLoop<TState>::run, this);
+
+		return ResultCodes::Success;
+	}
+
+	template <typename TState>
+	void SimulationLoop<TState>::stop()
+	{
+		if (!m_thread.joinable()) return;
+
+		m_running.store(false, std::memory_order_release);
+		m_thread.join();
+
+		const Stats stats = getStats();
+		LOG_INFO("Stopped simulation after " << stats.ticks << " ticks (" << stats.dropped_ticks << " dropped, " << stats.max_tick_ms << "ms longest tick)");
+	}
+
+	template <typename TState>
+	void SimulationLoop<TState>::run()
+	{
+		Clock::time_point next;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			next = m_current_time + m_step;
+		}
+
+		// The state is advanced outside the lock on a working copy, which is then published as the current state
+		TState state = m_current;
+		while (m_running.load(std::memory_order_acquire))
+		{
+			const Clock::time_point now = Clock::now();
+			if (now < next)
+			{
+				std::this_thread::sleep_until(next);
+				continue;
+			}
+
+			uint64_t dropped = 0U;
+			if ((now - next) > (m_step * MAX_CATCHUP_TICKS))
+			{
+				dropped = uint64_t((now - next) / m_step);
+				next += (m_step * dropped);
+			}
+
+			m_tick(state, m_timestep, next);
+			const double tick_ms = std::chrono::duration<double, std::milli>(Clock::now() - now).count();
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_previous = m_current;
+				m_current = state;
+				m_current_time = next;
+
+				++m_stats.ticks;
+				m_stats.dropped_ticks += dropped;
+				m_stats.tick_ms = tick_ms;
+				m_stats.max_tick_ms = std::max(m_stats.max_tick_ms, tick_ms);
+			}
+
+			next += m_step;
+		}
+	}
+
+	template <typename TState>
+	typename SimulationLoop<TState>::Frame SimulationLoop<TState>::getFrame(Clock::time_point time) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		const double elapsed = std::chrono::duration<double>(time - m_current_time).count();
+		const float alpha = std::min(std::max(float(elapsed / double(m_timestep)), 0.0f), 1.0f);
+
+		return Frame{ m_previous, m_current, alpha };
+	}
+
+	template <typename TState>
+	typename SimulationLoop<TState>::Stats SimulationLoop<TState>::getStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_stats;
+	}
+}
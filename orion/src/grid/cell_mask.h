@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <bitset>
+#include <algorithm>
+#include "../util/debug.h"
+#include "../util/simd.h"
+#include "../math/vec2.h"
+
+namespace Orion
+{
+	// Bit-packed set of cells over a grid, one bit per cell.  Rows are padded to a whole number of words so that
+	// each row starts on a word boundary, and row-wise operations can be applied a word at a time
+	template <typename TCoord>
+	class CellMask
+	{
+	public:
+
+		typedef uint64_t Word;
+		static constexpr size_t BITS_PER_WORD = 64U;
+
+		CellMask();
+		CellMask(Vec2<TCoord> size);
+
+		// Resizing discards the current contents
+		void resize(Vec2<TCoord> size);
+
+		inline Vec2<TCoord> getSize() const { return m_size; }
+		inline size_t getRowWords() const { return m_row_words; }
+
+		inline bool test(TCoord x, TCoord y) const { return (m_words[wordIndex(x, y)] & bit(x)) != 0U; }
+		inline void set(TCoord x, TCoord y) { m_words[wordIndex(x, y)] |= bit(x); }
+		inline void reset(TCoord x, TCoord y) { m_words[wordIndex(x, y)] &= ~bit(x); }
+
+		inline const Word* row(TCoord y) const { return &m_words[size_t(y) * m_row_words]; }
+		inline Word* row(TCoord y) { return &m_words[size_t(y) * m_row_words]; }
+
+		void clear();
+
+		// Sets this mask to the union of itself and another mask of the same size
+		void merge(const CellMask& other);
+
+		size_t count() const;
+
+	private:
+
+		inline size_t wordIndex(TCoord x, TCoord y) const { return (size_t(y) * m_row_words) + (size_t(x) / BITS_PER_WORD); }
+		inline static Word bit(TCoord x) { return Word(1U) << (size_t(x) % BITS_PER_WORD); }
+
+	private:
+
+		Vec2<TCoord>		m_size;
+		size_t				m_row_words;
+		std::vector<Word>	m_words;
+	};
+
+
+	// ==================================================================================
+
+	template <typename TCoord>
+	CellMask<TCoord>::CellMask()
+		:
+		m_size(0, 0),
+		m_row_words(0U),
+		m_words()
+	{
+	}
+
+	template <typename TCoord>
+	CellMask<TCoord>::CellMask(Vec2<TCoord> size)
+		:
+		CellMask()
+	{
+		resize(size);
+	}
+
+	template <typename TCoord>
+	void CellMask<TCoord>::resize(Vec2<TCoord> size)
+	{
+		ASS(size.x >= 0 && size.y >= 0, "Invalid cell mask size " << size);
+
+		m_size = size;
+		m_row_words = (size_t(size.x) + BITS_PER_WORD - 1U) / BITS_PER_WORD;
+		m_words.assign(m_row_words * size_t(size.y), 0U);
+	}
+
+	template <typename TCoord>
+	void CellMask<TCoord>::clear()
+	{
+		std::fill(m_words.begin(), m_words.end(), Word(0U));
+	}
+
+	template <typename TCoord>
+	void CellMask<TCoord>::merge(const CellMask& other)
+	{
+		ASS(m_size == other.m_size, "Cannot merge cell masks of differing size; " << m_size << " and " << other.m_size);
+
+		const size_t count = m_words.size();
+		const Word* src = other.m_words.data();
+		Word* dst = m_words.data();
+		size_t i = 0U;
+
+#		if ORION_SIMD_SSE
+		for (; i + 2U <= count; i += 2U)
+		{
+			const __m128i merged = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), merged);
+		}
+#		endif
+
+		for (; i < count; ++i) dst[i] |= src[i];
+	}
+
+	template <typename TCoord>
+	size_t CellMask<TCoord>::count() const
+	{
+		size_t total = 0U;
+		for (const Word word : m_words) total += std::bitset<BITS_PER_WORD>(word).count();
+
+		return total;
+	}
+}
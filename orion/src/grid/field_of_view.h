@@ -0,0 +1,309 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include "../util/debug.h"
+#include "../util/thread_pool.h"
+#include "../math/vec2.h"
+#include "cell_mask.h"
+#include "grid.h"
+
+namespace Orion
+{
+	// Field of view over a grid by recursive shadowcasting.  Opacity is held as a bit-packed layer, and visibility
+	// is returned as a CellMask of the same size.  Viewers may be computed individually or in batches across a
+	// thread pool, or registered with the field of view so that update() only recomputes those viewers which have
+	// moved, or which can see a cell whose opacity has changed
+	template <typename TCoord>
+	class FieldOfView
+	{
+	public:
+
+		typedef CellMask<TCoord> Mask;
+		typedef size_t ViewerId;
+		static const ViewerId NO_VIEWER = std::numeric_limits<ViewerId>::max();
+
+		// Above this number of opacity changes in one update, all viewers are recomputed rather than tested individually
+		static const size_t MAX_TRACKED_CHANGES = 64U;
+
+		struct Viewer
+		{
+			Vec2<TCoord>	position;
+			TCoord			radius;
+		};
+
+		FieldOfView(Vec2<TCoord> size);
+
+		inline Vec2<TCoord> getSize() const { return m_opacity.getSize(); }
+
+		inline bool isOpaque(TCoord x, TCoord y) const { return m_opacity.test(x, y); }
+		void setOpaque(Vec2<TCoord> location, bool opaque);
+
+		// Rebuilds the opacity layer from any grid of the same size, where is_opaque(T) determines whether each
+		// cell blocks sight.  All registered viewers are recomputed on the next update
+		template <typename T, typename TPredicate>
+		void setOpacity(const Grid<T, TCoord>& grid, TPredicate is_opaque);
+
+		// Visibility of all cells within the radius of a single viewer.  Cells beyond the grid are treated as opaque
+		void compute(Vec2<TCoord> origin, TCoord radius, Mask& outVisible) const;
+		void computeBatch(const std::vector<Viewer>& viewers, std::vector<Mask>& outVisible, ThreadPool& pool) const;
+
+		// Registered viewers; visibility is available following the next update()
+		ViewerId addViewer(const Viewer& viewer);
+		void moveViewer(ViewerId id, Vec2<TCoord> position);
+		void removeViewer(ViewerId id);
+
+		// Recomputes all registered viewers invalidated since the last update, returning the number recomputed
+		size_t update(ThreadPool& pool);
+
+		inline const Mask& getVisibility(ViewerId id) const { return m_visibility[id]; }
+
+		// Union of the visibility of all registered viewers
+		void getCombinedVisibility(Mask& outVisible) const;
+
+	private:
+
+		void castLight(Vec2<TCoord> origin, TCoord radius, TCoord row, float start_slope, float end_slope, const int(&octant)[4], Mask& outVisible) const;
+
+		inline bool isWithinRadius(TCoord dx, TCoord dy, TCoord radius) const { return (dx * dx) + (dy * dy) <= (radius * (radius + 1)); }
+		bool isAffectedByChanges(const Viewer& viewer) const;
+
+	private:
+
+		Mask						m_opacity;
+
+		std::vector<Viewer>			m_viewers;
+		std::vector<Mask>			m_visibility;		// Indexed by ViewerId
+		std::vector<uint8_t>		m_active;			// Indexed by ViewerId
+		std::vector<uint8_t>		m_dirty;			// Indexed by ViewerId
+		std::vector<ViewerId>		m_free_viewers;
+
+		std::vector<Vec2<TCoord>>	m_changed_cells;	// Opacity changes since the last update
+		bool						m_all_dirty;
+
+		std::vector<ViewerId>		m_pending;
+	};
+
+
+	// ==================================================================================
+
+	// Transforms from octant-relative (dx, dy) to grid offsets, as (xx, xy, yx, yy)
+	static const int FOV_OCTANTS[8][4] = {
+		{ 1, 0, 0, 1 }, { 0, 1, 1, 0 }, { 0, -1, 1, 0 }, { -1, 0, 0, 1 },
+		{ -1, 0, 0, -1 }, { 0, -1, -1, 0 }, { 0, 1, -1, 0 }, { 1, 0, 0, -1 }
+	};
+
+	template <typename TCoord>
+	FieldOfView<TCoord>::FieldOfView(Vec2<TCoord> size)
+		:
+		m_opacity(size),
+		m_all_dirty(false)
+	{
+	}
+
+	template <typename TCoord>
+	void FieldOfView<TCoord>::setOpaque(Vec2<TCoord> location, bool opaque)
+	{
+		ASS(location.x >= 0 && location.y >= 0 && location.x < getSize().x && location.y < getSize().y, "Invalid field of view location " << location);
+		if (m_opacity.test(location.x, location.y) == opaque) return;
+
+		if (opaque)		m_opacity.set(location.x, location.y);
+		else			m_opacity.reset(location.x, location.y);
+
+		if (m_changed_cells.size() < MAX_TRACKED_CHANGES)	m_changed_cells.push_back(location);
+		else												m_all_dirty = true;
+	}
+
+	template <typename TCoord>
+	template <typename T, typename TPredicate>
+	void FieldOfView<TCoord>::setOpacity(const Grid<T, TCoord>& grid, TPredicate is_opaque)
+	{
+		ASS(grid.getSize() == getSize(), "Opacity grid size " << grid.getSize() << " does not match field of view size " << getSize());
+
+		m_opacity.clear();
+		const T* data = grid.data();
+		for (TCoord y = 0; y < getSize().y; ++y)
+		{
+			const size_t row = size_t(y) * size_t(getSize().x);
+			for (TCoord x = 0; x < getSize().x; ++x)
+			{
+				if (is_opaque(data[row + size_t(x)])) m_opacity.set(x, y);
+			}
+		}
+
+		m_all_dirty = true;
+	}
+
+	template <typename TCoord>
+	void FieldOfView<TCoord>::compute(Vec2<TCoord> origin, TCoord radius, Mask& outVisible) const
+	{
+		if (outVisible.getSize() != getSize())	outVisible.resize(getSize());
+		else									outVisible.clear();
+
+		if (origin.x < 0 || origin.y < 0 || origin.x >= getSize().x || origin.y >= getSize().y) return;
+
+		// The viewer's own cell is always visible, even if opaque
+		outVisible.set(origin.x, origin.y);
+		for (const auto& octant : FOV_OCTANTS)
+		{
+			castLight(origin, radius, 1, 1.0f, 0.0f, octant, outVisible);
+		}
+	}
+
+	// Scans one octant row by row, from the given row outwards, between the start and end slopes.  Each opaque run
+	// encountered narrows the visible arc; the portion of the arc beyond the run is continued recursively
+	template <typename TCoord>
+	void FieldOfView<TCoord>::castLight(Vec2<TCoord> origin, TCoord radius, TCoord row, float start_slope, float end_slope, const int(&octant)[4], Mask& outVisible) const
+	{
+		if (start_slope < end_slope) return;
+
+		const auto size = getSize();
+		float next_start = start_slope;
+
+		for (TCoord distance = row; distance <= radius; ++distance)
+		{
+			bool blocked = false;
+			const TCoord dy = -distance;
+
+			for (TCoord dx = -distance; dx <= 0; ++dx)
+			{
+				const float left_slope = (float(dx) - 0.5f) / (float(dy) + 0.5f);
+				const float right_slope = (float(dx) + 0.5f) / (float(dy) - 0.5f);
+
+				if (start_slope < right_slope) continue;
+				if (end_slope > left_slope) break;
+
+				const TCoord x = origin.x + (dx * TCoord(octant[0])) + (dy * TCoord(octant[1]));
+				const TCoord y = origin.y + (dx * TCoord(octant[2])) + (dy * TCoord(octant[3]));
+				const bool in_bounds = (x >= 0 && y >= 0 && x < size.x && y < size.y);
+
+				if (in_bounds && isWithinRadius(dx, dy, radius)) outVisible.set(x, y);
+
+				const bool opaque = (!in_bounds || m_opacity.test(x, y));
+				if (blocked)
+				{
+					if (opaque)
+					{
+						next_start = right_slope;
+						continue;
+					}
+
+					blocked = false;
+					start_slope = next_start;
+				}
+				else if (opaque && distance < radius)
+				{
+					blocked = true;
+					castLight(origin, radius, distance + 1, start_slope, left_slope, octant, outVisible);
+					next_start = right_slope;
+				}
+			}
+
+			if (blocked) break;
+		}
+	}
+
+	template <typename TCoord>
+	void FieldOfView<TCoord>::computeBatch(const std::vector<Viewer>& viewers, std::vector<Mask>& outVisible, ThreadPool& pool) const
+	{
+		outVisible.resize(viewers.size());
+		pool.parallelFor(viewers.size(), [this, &viewers, &outVisible](size_t i)
+		{
+			compute(viewers[i].position, viewers[i].radius, outVisible[i]);
+		});
+	}
+
+	template <typename TCoord>
+	typename FieldOfView<TCoord>::ViewerId FieldOfView<TCoord>::addViewer(const Viewer& viewer)
+	{
+		ViewerId id;
+		if (!m_free_viewers.empty())
+		{
+			id = m_free_viewers.back();
+			m_free_viewers.pop_back();
+			m_viewers[id] = viewer;
+		}
+		else
+		{
+			id = m_viewers.size();
+			m_viewers.push_back(viewer);
+			m_visibility.emplace_back(getSize());
+			m_active.push_back(0U);
+			m_dirty.push_back(0U);
+		}
+
+		m_active[id] = 1U;
+		m_dirty[id] = 1U;
+		return id;
+	}
+
+	template <typename TCoord>
+	void FieldOfView<TCoord>::moveViewer(ViewerId id, Vec2<TCoord> position)
+	{
+		ASS(id < m_viewers.size() && m_active[id], "Invalid viewer ID: " << id);
+		if (m_viewers[id].position == position) return;
+
+		m_viewers[id].position = position;
+		m_dirty[id] = 1U;
+	}
+
+	template <typename TCoord>
+	void FieldOfView<TCoord>::removeViewer(ViewerId id)
+	{
+		if (id >= m_viewers.size() || !m_active[id]) return;
+
+		m_active[id] = 0U;
+		m_dirty[id] = 0U;
+		m_visibility[id].clear();
+		m_free_viewers.push_back(id);
+	}
+
+	// Opacity changes can only affect a viewer if they lie within its radius
+	template <typename TCoord>
+	bool FieldOfView<TCoord>::isAffectedByChanges(const Viewer& viewer) const
+	{
+		return std::any_of(m_changed_cells.cbegin(), m_changed_cells.cend(), [&viewer](const Vec2<TCoord>& cell)
+		{
+			return std::abs(cell.x - viewer.position.x) <= viewer.radius && std::abs(cell.y - viewer.position.y) <= viewer.radius;
+		});
+	}
+
+	template <typename TCoord>
+	size_t FieldOfView<TCoord>::update(ThreadPool& pool)
+	{
+		m_pending.clear();
+		for (ViewerId id = 0U; id < m_viewers.size(); ++id)
+		{
+			if (!m_active[id]) continue;
+
+			if (m_dirty[id] || m_all_dirty || isAffectedByChanges(m_viewers[id])) m_pending.push_back(id);
+			m_dirty[id] = 0U;
+		}
+
+		m_changed_cells.clear();
+		m_all_dirty = false;
+
+		pool.parallelFor(m_pending.size(), [this](size_t i)
+		{
+			const auto id = m_pending[i];
+			compute(m_viewers[id].position, m_viewers[id].radius, m_visibility[id]);
+		});
+
+		return m_pending.size();
+	}
+
+	template <typename TCoord>
+	void FieldOfView<TCoord>::getCombinedVisibility(Mask& outVisible) const
+	{
+		if (outVisible.getSize() != getSize())	outVisible.resize(getSize());
+		else									outVisible.clear();
+
+		for (ViewerId id = 0U; id < m_viewers.size(); ++id)
+		{
+			if (m_active[id]) outVisible.merge(m_visibility[id]);
+		}
+	}
+}
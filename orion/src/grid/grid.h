@@ -28,6 +28,13 @@ namespace Orion
 		Vec2<TCoord> getLocationUnchecked(Index index) const;
 
 		inline Vec2<TCoord> getSize() const { return m_size; }
+		inline Index getCount() const { return m_count; }
+		inline T getDefault() const { return m_default; }
+
+		// Direct access to the underlying row-major cell data, with a row stride of getSize().x
+		inline const T* data() const { return m_data.data(); }
+		inline T* data() { return m_data.data(); }
+
 		bool isValidLocation(Vec2<TCoord> location) const;
 		bool isValidLocation(TCoord x, TCoord y) const;
 		bool isValidIndex(Index index) const;
@@ -154,15 +161,15 @@ namespace Orion
 	template <typename T, typename TCoord>
 	typename Grid<T, TCoord>::Index Grid<T, TCoord>::getIndexUnchecked(Vec2<TCoord> location) const
 	{
-		ASS(location.x > 0 && location.y > 0, "Invalid location " << location);
-		return Index(location.x) + (Index(location.y) * Index(m_size.y));
+		ASS(location.x >= 0 && location.y >= 0, "Invalid location " << location);
+		return Index(location.x) + (Index(location.y) * Index(m_size.x));
 	}
 	
 	template <typename T, typename TCoord>
 	typename Grid<T, TCoord>::Index Grid<T, TCoord>::getIndexUnchecked(TCoord x, TCoord y) const
 	{
-		ASS(x > 0 && y > 0, "Invalid location (" << x << "," << y << ")");
-		return Index(x) + (Index(y) * Index(m_size.y));
+		ASS(x >= 0 && y >= 0, "Invalid location (" << x << "," << y << ")");
+		return Index(x) + (Index(y) * Index(m_size.x));
 	}
 
 	template <typename T, typename TCoord>
@@ -377,14 +384,14 @@ namespace Orion
 	{
 		switch (direction)
 		{
-			case Dir8::UP:			return index + m_size.y;
-			case Dir8::UP_RIGHT:	return index + m_size.y + 1;
+			case Dir8::UP:			return index + m_size.x;
+			case Dir8::UP_RIGHT:	return index + m_size.x + 1;
 			case Dir8::RIGHT:		return index + 1;
-			case Dir8::DOWN_RIGHT:	return index - m_size.y + 1;
-			case Dir8::DOWN:		return index - m_size.y;
-			case Dir8::DOWN_LEFT:	return index - m_size.y - 1;
+			case Dir8::DOWN_RIGHT:	return index - m_size.x + 1;
+			case Dir8::DOWN:		return index - m_size.x;
+			case Dir8::DOWN_LEFT:	return index - m_size.x - 1;
 			case Dir8::LEFT:		return index - 1;
-			case Dir8::UP_LEFT:		return index + m_size.y - 1;
+			case Dir8::UP_LEFT:		return index + m_size.x - 1;
 		}
 
 		ASS(false, "Invalid direction provided: " << (int)direction);
@@ -3,6 +3,7 @@
 #include <array>
 #include <vector>
 #include <algorithm>
+#include <utility>
 #include "../util/debug.h"
 #include "../math/vec2.h"
 
@@ -68,7 +69,7 @@ namespace Orion
 
 			NodeIndex							m_id;
 			NodeIndex							m_parent;
-			std::array<typename NodeIndex, 4>	m_children;
+			std::array<NodeIndex, 4>	m_children;
 
 			Vec2<TCoord>							m_min_bounds;
 			Vec2<TCoord>							m_max_bounds;
@@ -76,6 +77,17 @@ namespace Orion
 		};
 
 
+		// Work performed by findItems, for measuring the efficiency of the tree.  The hit rate of a query is the
+		// proportion of the items tested within its leaf nodes which lay inside the query region
+		struct QueryStats
+		{
+			size_t		queries;
+			size_t		nodes_visited;
+			size_t		items_tested;
+			size_t		items_found;
+		};
+
+
 	public:
 
 		Quadtree(Vec2<TCoord> minBounds, Vec2<TCoord> maxBounds);
@@ -91,7 +103,8 @@ namespace Orion
 
 		void		clearItems();
 
-		void		findItems(Vec2<TCoord> minPos, Vec2<TCoord> maxPos, std::vector<T> & outItems) const;
+		// Query work is accumulated into stats, if provided
+		void		findItems(Vec2<TCoord> minPos, Vec2<TCoord> maxPos, std::vector<T> & outItems, QueryStats * stats = nullptr) const;
 
 		T			getItemAtExact(Vec2<TCoord> pos) const;
 
@@ -99,6 +112,12 @@ namespace Orion
 
 		void		itemMoved(T item, Vec2<TCoord> oldPosition);
 
+		// Visits every node reachable from the root, depth-first, as func(node, depth)
+		template <typename TFunc>
+		void		forEachNode(TFunc && func) const;
+
+		inline size_t getNodeCount() const { return m_nodes.size() - m_free_nodes.size(); }
+
 	private:
 
 		NodeIndex	newNode(NodeIndex parent, Vec2<TCoord> minBounds, Vec2<TCoord> maxBounds);
@@ -237,7 +256,7 @@ namespace Orion
 		{
 			const auto child = node->getChildContainingPoint(pos);
 			index = node->getChildren()[static_cast<int>(child)];
-			ASS(index != NO_NODE, "Missing child node: " << child);
+			ASS(index != NO_NODE, "Missing child node: " << static_cast<int>(child));
 
 			node = &(m_nodes[index]);
 		}
@@ -295,15 +314,18 @@ namespace Orion
 	}
 
 	template <typename T, typename TCoord>
-	void Quadtree<T, TCoord>::findItems(Vec2<TCoord> minPos, Vec2<TCoord> maxPos, std::vector<T>& outItems) const
+	void Quadtree<T, TCoord>::findItems(Vec2<TCoord> minPos, Vec2<TCoord> maxPos, std::vector<T>& outItems, QueryStats * stats) const
 	{
 		std::vector<NodeIndex> search({ getRoot() });
+		size_t nodes_visited = 0U, items_tested = 0U;
+		const size_t initial_items = outItems.size();
 
 		while (!search.empty())
 		{
 			auto index = search.back();
 			search.pop_back();
 			const auto & node = m_nodes[index];
+			++nodes_visited;
 
 			// Skip this node immediately if it contains no part of the target region
 			if (!node.containsRegion(minPos, maxPos)) continue;
@@ -317,6 +339,7 @@ namespace Orion
 			else
 			{
 				// Otherwise, if this is a leaf node, check all items for eligibility
+				items_tested += node.getItems().size();
 				for (const T& item : node.getItems())
 				{
 					// Add all items which are within the target region
@@ -329,6 +352,14 @@ namespace Orion
 				}
 			}
 		}
+
+		if (stats)
+		{
+			++stats->queries;
+			stats->nodes_visited += nodes_visited;
+			stats->items_tested += items_tested;
+			stats->items_found += (outItems.size() - initial_items);
+		}
 	}
 
 	template<typename T, typename TCoord>
@@ -342,8 +373,8 @@ namespace Orion
 			search.pop_back();
 			const auto& node = m_nodes[index];
 
-			// Skip this node immediately if it contains no part of the target region
-			if (!node.containsRegion(minPos, maxPos)) continue;
+			// Skip this node immediately if it does not contain the target position
+			if (!node.containsPoint(pos)) continue;
 
 			// Recurse into all children if this node has them (eligibility will be checked when they are pulled from the search stack)
 			if (node.hasChildren())
@@ -407,11 +438,12 @@ namespace Orion
 
 		// Create children
 		const auto pMin = m_nodes[index].getMinBounds(), pCtr = m_nodes[index].getCentrePoint(), pMax = m_nodes[index].getMaxBounds();
+		// Children are held in ChildNode order, so that they can be indexed by getChildContainingPoint()
 		std::array<NodeIndex, 4> newChildren {
-			newNode(index, pMin, pCtr),														// Bottom-left
-			newNode(index, Vec2<TCoord>(pMin.x, pCtr.y), Vec2<TCoord>(pCtr.x, pMax.y)),		// Top-left
 			newNode(index, pCtr, pMax),														// Top-right
-			newNode(index, Vec2<TCoord>(pCtr.x, pMin.y), Vec2<TCoord>(pMax.x, pCtr.y))		// Bottom-right
+			newNode(index, Vec2<TCoord>(pCtr.x, pMin.y), Vec2<TCoord>(pMax.x, pCtr.y)),		// Bottom-right
+			newNode(index, pMin, pCtr),														// Bottom-left
+			newNode(index, Vec2<TCoord>(pMin.x, pCtr.y), Vec2<TCoord>(pCtr.x, pMax.y))		// Top-left
 		};
 		m_nodes[index].setChildren(newChildren);
 
@@ -443,6 +475,27 @@ namespace Orion
 		addItem(item);
 	}
 
+
+	template <typename T, typename TCoord>
+	template <typename TFunc>
+	void Quadtree<T, TCoord>::forEachNode(TFunc && func) const
+	{
+		std::vector<std::pair<NodeIndex, size_t>> search({ { getRoot(), 0U } });
+
+		while (!search.empty())
+		{
+			const auto entry = search.back();
+			search.pop_back();
+
+			const auto& node = m_nodes[entry.first];
+			func(node, entry.second);
+
+			if (node.hasChildren())
+			{
+				for (const auto child : node.getChildren()) search.push_back({ child, entry.second + 1U });
+			}
+		}
+	}
 	
 
 	/* ********************************************************************* */
@@ -16,6 +16,11 @@ namespace Orion
 		return m_dir4_rotation[static_cast<int>(direction)][static_cast<int>(rotation)];
 	}
 
+	Vec2<int> Rotation::rotateExtent(Vec2<int> size, Dir4 direction)
+	{
+		return (direction == Dir4::RIGHT || direction == Dir4::LEFT ? Vec2<int>(size.y, size.x) : size);
+	}
+
 
 
 	static_assert(
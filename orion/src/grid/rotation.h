@@ -1,8 +1,9 @@
 #pragma once
 
 #include <array>
-class Dir4;
-class Rot90;
+#include "../math/vec2.h"
+#include "dir4.h"
+#include "rot90.h"
 
 namespace Orion
 {
@@ -12,6 +13,9 @@ namespace Orion
 
 		static Dir4 rotate(Dir4 direction, Rot90 rotation);
 
+		// Returns the extent of an area of the given (unrotated) size when facing in the specified direction
+		static Vec2<int> rotateExtent(Vec2<int> size, Dir4 direction);
+
 
 	private:
 		static const std::array<std::array<Dir4, 4>, 4> m_dir4_rotation;
@@ -0,0 +1,409 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include "../util/debug.h"
+#include "../util/simd.h"
+#include "../util/thread_pool.h"
+#include "../math/vec2.h"
+#include "dir4.h"
+#include "dir8.h"
+#include "direction.h"
+#include "grid.h"
+
+namespace Orion
+{
+	enum class StencilNeighbourhood
+	{
+		Four = 4,		// Neighbours in Dir4 order
+		Eight = 8		// Neighbours in Dir8 order
+	};
+
+	// Double-buffered stencil / cellular automaton engine over a grid.  Each step reads exclusively from the current
+	// state and writes to the next state, before the two are swapped.  Work is split into row stripes of chunks which
+	// are distributed across a thread pool.  Chunks are skipped entirely unless they, or one of their neighbours,
+	// changed during the previous step or were explicitly written since then
+	template <typename T, typename TCoord>
+	class Stencil
+	{
+	public:
+
+		typedef Grid<T, TCoord> TGrid;
+		typedef typename TGrid::Index Index;
+
+		static const TCoord CHUNK_SIZE = 32;
+
+		Stencil(Vec2<TCoord> size, T initial, T boundary);
+
+		inline const TGrid& getCurrent() const { return m_buffers[m_current]; }
+		inline Vec2<TCoord> getSize() const { return m_size; }
+
+		inline T get(Vec2<TCoord> location) const { return getCurrent().get(location); }
+		void set(Vec2<TCoord> location, T value);
+
+		// Tolerance used by diffuse() when determining whether a chunk has settled; exact comparison is used by step()
+		inline void setSettleThreshold(T threshold) { m_settle_threshold = threshold; }
+
+		void activate(Vec2<TCoord> location);
+		void activateAll();
+
+		inline size_t getChunkCount() const { return m_chunk_total; }
+		size_t getActiveChunkCount() const;
+		bool isChunkActive(Vec2<TCoord> chunk) const;
+
+		// Executes one step of a general kernel, T kernel(T centre, const std::array<T, N>& neighbours), over all
+		// active chunks.  Cells beyond the grid bounds take the boundary value
+		template <StencilNeighbourhood N, typename TKernel>
+		void step(TKernel kernel, ThreadPool& pool);
+
+		// Executes one step of linear diffusion, next = c + rate * (sum(neighbours) - N*c), using SIMD inner loops
+		// where available.  Only valid for floating-point cell data
+		template <StencilNeighbourhood N>
+		void diffuse(T rate, ThreadPool& pool);
+
+	private:
+
+		static constexpr size_t BITS_PER_WORD = 64U;
+
+		inline size_t chunkIndex(TCoord cx, TCoord cy) const { return size_t(cx) + (size_t(cy) * size_t(m_chunks.x)); }
+
+		inline bool testBit(const std::vector<uint64_t>& bits, size_t ix) const { return (bits[ix / BITS_PER_WORD] & (1ULL << (ix % BITS_PER_WORD))) != 0U; }
+		inline void setBit(std::vector<uint64_t>& bits, size_t ix) { bits[ix / BITS_PER_WORD] |= (1ULL << (ix % BITS_PER_WORD)); }
+
+		template <StencilNeighbourhood N>
+		std::array<Index, static_cast<size_t>(N)> neighbourOffsets() const;
+
+		template <StencilNeighbourhood N>
+		std::array<T, static_cast<size_t>(N)> sampleNeighbours(const T* src, TCoord x, TCoord y) const;
+
+		template <typename TChunkFn>
+		void executeStep(TChunkFn chunk_fn, ThreadPool& pool);
+
+		void copyChunk(const T* src, T* dst, TCoord cx, TCoord cy) const;
+
+		template <StencilNeighbourhood N>
+		bool diffuseChunk(const T* src, T* dst, TCoord cx, TCoord cy, T rate) const;
+
+	private:
+
+		Vec2<TCoord>			m_size;
+		Vec2<TCoord>			m_chunks;
+		size_t					m_chunk_total;
+
+		std::array<TGrid, 2>	m_buffers;
+		int						m_current;
+		T						m_boundary;
+		T						m_settle_threshold;
+
+		std::vector<uint64_t>	m_active;		// Bitmap of chunks to be evaluated in the next step
+		std::vector<uint8_t>	m_changed;		// Per-chunk change flags for the step in progress; one writer per element
+	};
+
+
+	// ==================================================================================
+
+	template <typename T, typename TCoord>
+	Stencil<T, TCoord>::Stencil(Vec2<TCoord> size, T initial, T boundary)
+		:
+		m_size(size),
+		m_chunks((size.x + CHUNK_SIZE - 1) / CHUNK_SIZE, (size.y + CHUNK_SIZE - 1) / CHUNK_SIZE),
+		m_chunk_total(size_t(m_chunks.x) * size_t(m_chunks.y)),
+		m_buffers{ { TGrid(size, initial, boundary), TGrid(size, initial, boundary) } },
+		m_current(0),
+		m_boundary(boundary),
+		m_settle_threshold(T()),
+		m_active((m_chunk_total + BITS_PER_WORD - 1) / BITS_PER_WORD, 0U),
+		m_changed(m_chunk_total, 0U)
+	{
+		// All chunks are evaluated at least once, since we cannot know whether the initial state is stable
+		activateAll();
+	}
+
+	template <typename T, typename TCoord>
+	void Stencil<T, TCoord>::set(Vec2<TCoord> location, T value)
+	{
+		m_buffers[m_current].set(location, value);
+		activate(location);
+	}
+
+	// Marks the chunk containing this location, plus all adjacent chunks, for evaluation in the next step
+	template <typename T, typename TCoord>
+	void Stencil<T, TCoord>::activate(Vec2<TCoord> location)
+	{
+		ASS(m_buffers[m_current].isValidLocation(location), "Invalid stencil location " << location);
+
+		const TCoord cx = location.x / CHUNK_SIZE, cy = location.y / CHUNK_SIZE;
+		for (TCoord y = std::max<TCoord>(cy - 1, 0); y <= std::min<TCoord>(cy + 1, m_chunks.y - 1); ++y)
+		{
+			for (TCoord x = std::max<TCoord>(cx - 1, 0); x <= std::min<TCoord>(cx + 1, m_chunks.x - 1); ++x)
+			{
+				setBit(m_active, chunkIndex(x, y));
+			}
+		}
+	}
+
+	template <typename T, typename TCoord>
+	void Stencil<T, TCoord>::activateAll()
+	{
+		for (size_t i = 0; i < m_chunk_total; ++i)
+		{
+			setBit(m_active, i);
+		}
+	}
+
+	template <typename T, typename TCoord>
+	size_t Stencil<T, TCoord>::getActiveChunkCount() const
+	{
+		size_t count = 0U;
+		for (size_t i = 0; i < m_chunk_total; ++i)
+		{
+			if (testBit(m_active, i)) ++count;
+		}
+
+		return count;
+	}
+
+	template <typename T, typename TCoord>
+	bool Stencil<T, TCoord>::isChunkActive(Vec2<TCoord> chunk) const
+	{
+		return testBit(m_active, chunkIndex(chunk.x, chunk.y));
+	}
+
+	// Index offsets of each neighbour from a cell, in Dir4 or Dir8 order.  Only valid for cells not on the grid edge
+	template <typename T, typename TCoord>
+	template <StencilNeighbourhood N>
+	std::array<typename Stencil<T, TCoord>::Index, static_cast<size_t>(N)> Stencil<T, TCoord>::neighbourOffsets() const
+	{
+		const Index w = Index(m_size.x);
+		if constexpr (N == StencilNeighbourhood::Four)
+		{
+			return { w, Index(1), Index(0) - w, Index(0) - Index(1) };
+		}
+		else
+		{
+			return { w, w + 1, Index(1), Index(0) - w + 1, Index(0) - w, Index(0) - w - 1, Index(0) - Index(1), w - 1 };
+		}
+	}
+
+	template <typename T, typename TCoord>
+	template <StencilNeighbourhood N>
+	std::array<T, static_cast<size_t>(N)> Stencil<T, TCoord>::sampleNeighbours(const T* src, TCoord x, TCoord y) const
+	{
+		std::array<T, static_cast<size_t>(N)> result;
+		const bool interior = (x > 0 && y > 0 && x < m_size.x - 1 && y < m_size.y - 1);
+
+		if (interior)
+		{
+			const Index ix = Index(x) + (Index(y) * Index(m_size.x));
+			const auto offsets = neighbourOffsets<N>();
+			for (size_t i = 0; i < result.size(); ++i)
+			{
+				result[i] = src[ix + offsets[i]];
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < result.size(); ++i)
+			{
+				const auto n = (N == StencilNeighbourhood::Four
+					? Direction::getNeighbour(x, y, static_cast<Dir4>(i))
+					: Direction::getNeighbour(x, y, static_cast<Dir8>(i)));
+
+				result[i] = (m_buffers[m_current].isValidLocation(n.x, n.y)
+					? src[Index(n.x) + (Index(n.y) * Index(m_size.x))]
+					: m_boundary);
+			}
+		}
+
+		return result;
+	}
+
+	template <typename T, typename TCoord>
+	template <StencilNeighbourhood N, typename TKernel>
+	void Stencil<T, TCoord>::step(TKernel kernel, ThreadPool& pool)
+	{
+		executeStep([this, &kernel](const T* src, T* dst, TCoord cx, TCoord cy)
+		{
+			const TCoord x0 = cx * CHUNK_SIZE, x1 = std::min<TCoord>(x0 + CHUNK_SIZE, m_size.x);
+			const TCoord y0 = cy * CHUNK_SIZE, y1 = std::min<TCoord>(y0 + CHUNK_SIZE, m_size.y);
+
+			bool changed = false;
+			for (TCoord y = y0; y < y1; ++y)
+			{
+				const Index row = Index(y) * Index(m_size.x);
+				for (TCoord x = x0; x < x1; ++x)
+				{
+					const T centre = src[row + x];
+					const T value = kernel(centre, sampleNeighbours<N>(src, x, y));
+
+					changed |= (value != centre);
+					dst[row + x] = value;
+				}
+			}
+
+			return changed;
+		}, pool);
+	}
+
+	template <typename T, typename TCoord>
+	template <StencilNeighbourhood N>
+	void Stencil<T, TCoord>::diffuse(T rate, ThreadPool& pool)
+	{
+		static_assert(std::is_floating_point<T>::value, "Diffusion is only supported for floating-point stencils");
+
+		executeStep([this, rate](const T* src, T* dst, TCoord cx, TCoord cy)
+		{
+			return diffuseChunk<N>(src, dst, cx, cy, rate);
+		}, pool);
+	}
+
+	// Distributes each row of chunks as a separate task.  The chunk function evaluates one chunk from src into dst
+	// and returns whether any cell changed
+	template <typename T, typename TCoord>
+	template <typename TChunkFn>
+	void Stencil<T, TCoord>::executeStep(TChunkFn chunk_fn, ThreadPool& pool)
+	{
+		const T* src = m_buffers[m_current].data();
+		T* dst = m_buffers[1 - m_current].data();
+
+		std::fill(m_changed.begin(), m_changed.end(), uint8_t(0U));
+
+		pool.parallelFor(size_t(m_chunks.y), [this, src, dst, &chunk_fn](size_t stripe)
+		{
+			const TCoord cy = TCoord(stripe);
+			for (TCoord cx = 0; cx < m_chunks.x; ++cx)
+			{
+				const auto ix = chunkIndex(cx, cy);
+				if (!testBit(m_active, ix)) continue;
+
+				m_changed[ix] = (chunk_fn(src, dst, cx, cy) ? 1U : 0U);
+			}
+		});
+
+		// Chunks which were evaluated but did not change are now settled; copy their result into the outgoing
+		// buffer so that both buffers agree and the chunk can be skipped until something disturbs it
+		std::vector<uint64_t> next_active(m_active.size(), 0U);
+		T* outgoing = m_buffers[m_current].data();
+		for (TCoord cy = 0; cy < m_chunks.y; ++cy)
+		{
+			for (TCoord cx = 0; cx < m_chunks.x; ++cx)
+			{
+				const auto ix = chunkIndex(cx, cy);
+				if (!testBit(m_active, ix)) continue;
+
+				if (m_changed[ix] == 0U)
+				{
+					copyChunk(dst, outgoing, cx, cy);
+					continue;
+				}
+
+				// Changes may propagate into any adjacent chunk during the next step
+				for (TCoord y = std::max<TCoord>(cy - 1, 0); y <= std::min<TCoord>(cy + 1, m_chunks.y - 1); ++y)
+				{
+					for (TCoord x = std::max<TCoord>(cx - 1, 0); x <= std::min<TCoord>(cx + 1, m_chunks.x - 1); ++x)
+					{
+						setBit(next_active, chunkIndex(x, y));
+					}
+				}
+			}
+		}
+
+		m_active = std::move(next_active);
+		m_current = 1 - m_current;
+	}
+
+	template <typename T, typename TCoord>
+	void Stencil<T, TCoord>::copyChunk(const T* src, T* dst, TCoord cx, TCoord cy) const
+	{
+		const TCoord x0 = cx * CHUNK_SIZE, x1 = std::min<TCoord>(x0 + CHUNK_SIZE, m_size.x);
+		const TCoord y0 = cy * CHUNK_SIZE, y1 = std::min<TCoord>(y0 + CHUNK_SIZE, m_size.y);
+
+		for (TCoord y = y0; y < y1; ++y)
+		{
+			const Index start = Index(x0) + (Index(y) * Index(m_size.x));
+			std::copy(src + start, src + start + Index(x1 - x0), dst + start);
+		}
+	}
+
+	template <typename T, typename TCoord>
+	template <StencilNeighbourhood N>
+	bool Stencil<T, TCoord>::diffuseChunk(const T* src, T* dst, TCoord cx, TCoord cy, T rate) const
+	{
+		static constexpr T NEIGHBOURS = T(static_cast<int>(N));
+		const TCoord w = m_size.x;
+		const TCoord x0 = cx * CHUNK_SIZE, x1 = std::min<TCoord>(x0 + CHUNK_SIZE, m_size.x);
+		const TCoord y0 = cy * CHUNK_SIZE, y1 = std::min<TCoord>(y0 + CHUNK_SIZE, m_size.y);
+
+		const auto scalarCell = [this, src, dst, rate](TCoord x, TCoord y)
+		{
+			const Index ix = Index(x) + (Index(y) * Index(m_size.x));
+			const auto neighbours = sampleNeighbours<N>(src, x, y);
+
+			T sum = T(0);
+			for (const T n : neighbours) sum += n;
+
+			const T centre = src[ix];
+			const T value = centre + rate * (sum - (NEIGHBOURS * centre));
+			dst[ix] = value;
+
+			return (std::abs(value - centre) > m_settle_threshold);
+		};
+
+		bool changed = false;
+		for (TCoord y = y0; y < y1; ++y)
+		{
+			// Grid edge rows and columns always take the scalar path, since they need boundary handling
+			TCoord x = x0;
+			const TCoord inner_end = ((y == 0 || y == m_size.y - 1) ? x0 : std::min<TCoord>(x1, w - 1));
+			for (; x < x1 && x < 1; ++x) changed |= scalarCell(x, y);
+
+#			if ORION_SIMD_SSE
+			if constexpr (std::is_same<T, float>::value)
+			{
+				const __m128 v_rate = _mm_set1_ps(rate);
+				const __m128 v_count = _mm_set1_ps(NEIGHBOURS);
+				const __m128 v_threshold = _mm_set1_ps(m_settle_threshold);
+				const __m128 v_absmask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+				__m128 v_changed = _mm_setzero_ps();
+
+				const float* up = src + (Index(y + 1) * Index(w));
+				const float* row = src + (Index(y) * Index(w));
+				const float* down = src + (Index(y - 1) * Index(w));
+				float* out = dst + (Index(y) * Index(w));
+
+				for (; x + Simd::WIDTH <= inner_end; x += Simd::WIDTH)
+				{
+					const __m128 c = _mm_loadu_ps(row + x);
+					__m128 sum = _mm_add_ps(
+						_mm_add_ps(_mm_loadu_ps(up + x), _mm_loadu_ps(down + x)),
+						_mm_add_ps(_mm_loadu_ps(row + x - 1), _mm_loadu_ps(row + x + 1)));
+
+					if constexpr (N == StencilNeighbourhood::Eight)
+					{
+						sum = _mm_add_ps(sum, _mm_add_ps(
+							_mm_add_ps(_mm_loadu_ps(up + x - 1), _mm_loadu_ps(up + x + 1)),
+							_mm_add_ps(_mm_loadu_ps(down + x - 1), _mm_loadu_ps(down + x + 1))));
+					}
+
+					const __m128 value = _mm_add_ps(c, _mm_mul_ps(v_rate, _mm_sub_ps(sum, _mm_mul_ps(v_count, c))));
+					_mm_storeu_ps(out + x, value);
+
+					const __m128 delta = _mm_and_ps(_mm_sub_ps(value, c), v_absmask);
+					v_changed = _mm_or_ps(v_changed, _mm_cmpgt_ps(delta, v_threshold));
+				}
+
+				changed |= (_mm_movemask_ps(v_changed) != 0);
+			}
+#			endif
+
+			for (; x < inner_end; ++x) changed |= scalarCell(x, y);
+			for (; x < x1; ++x) changed |= scalarCell(x, y);
+		}
+
+		return changed;
+	}
+}
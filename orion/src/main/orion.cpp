@@ -1,3 +1,8 @@
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <thread>
 #include <bx/uint32_t.h>
 #include <entry/input.h>
 #include "common.h"
@@ -8,7 +13,9 @@
 #include "../engine/renderer/geometry/geometry_manager.h"
 #include "../engine/renderer/shader/shader_manager.h"
 #include "../engine/renderer/texture/texture_manager.h"
+#include "../engine/renderer/particles/particle_effects.h"
 #include "../util/log.h"
+#include "../benchmark/benchmarks.h"
 
 #include "orion.h"
 
@@ -22,9 +29,17 @@ namespace Orion
         m_debug(0U),
         m_reset(0U),
 		m_renderer(),
+		m_input(),
+		m_input_state(),
+		m_simulation(),
+		m_frame_interval(Clock::duration::zero()),
+		m_next_frame(),
+		m_tile_defs(),
 
 		tmp_data(Vec2<Container::Coord>(10, 10)),
-		tmp_pos({ 0,0 })
+		tmp_debug_toggles(0U),
+		tmp_tile_regions_generation(0U),
+		tmp_tile_atlas(nullptr)
     {
     }
 
@@ -35,8 +50,23 @@ namespace Orion
 
         Args args(argc, argv);
 
+		// Micro-benchmarks are run in place of the application when requested
+		if (std::any_of(argv, argv + argc, [](const char* arg) { return std::string(arg) == "--benchmark"; }))
+		{
+			const auto result = Benchmarks::runAll();
+			exit(ResultCodes::isError(result) ? 1 : 0);
+		}
+
+		// Rendering is synchronised to the display unless disabled, in which case it runs uncapped or at a maximum rate
+		const bool vsync = std::none_of(argv, argv + argc, [](const char* arg) { return std::string(arg) == "--no-vsync"; });
+		const auto max_fps = std::find_if(argv, argv + argc, [](const char* arg) { return std::string(arg) == "--max-fps"; });
+		if (max_fps < (argv + argc - 1) && std::atof(*(max_fps + 1)) > 0.0)
+		{
+			m_frame_interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::atof(*(max_fps + 1))));
+		}
+
 		const uint32_t debug = BGFX_DEBUG_TEXT;
-		const uint32_t reset = BGFX_RESET_VSYNC;
+		const uint32_t reset = (vsync ? BGFX_RESET_VSYNC : BGFX_RESET_NONE);
 
 		const auto rendererInit = m_renderer.initialise(width, height, debug, RENDERER_RUNTIME_DEBUG_ENABLED, reset, args);
 		if (ResultCodes::isError(rendererInit))
@@ -45,7 +75,43 @@ namespace Orion
 			exit(1);
 		}
 
+		const auto inputInit = m_input.initialise();
+		if (ResultCodes::isError(inputInit))
+		{
+			LOG_ERROR("Fatal error initialising input (" << inputInit << "), cannot continue");
+			exit(1);
+		}
+		_bindTemporaryInput();
+
 		// Temporary
+		// Simulation begins from the initial camera placement, and is the sole consumer of input from here on
+		const auto & camera = m_renderer.getCamera();
+		const SimulationState initial_state = { camera.getTopDownCameraPos(), camera.getTopDownCameraHeight(), 0U, false };
+		const auto simulationInit = m_simulation.start(SIMULATION_TICK_RATE, initial_state,
+			[this](SimulationState& state, float dt, Clock::time_point time) { _simulateTemporaryTick(state, dt, time); });
+		if (ResultCodes::isError(simulationInit))
+		{
+			LOG_ERROR("Fatal error starting simulation (" << simulationInit << "), cannot continue");
+			exit(1);
+		}
+
+		const auto tileDefsInit = m_tile_defs.load("data/tiles.def");
+		if (ResultCodes::isError(tileDefsInit))
+		{
+			LOG_ERROR("Fatal error loading tile definitions (" << tileDefsInit << "), cannot continue");
+			exit(1);
+		}
+		m_tile_defs.watch(m_renderer.getFileWatcher());
+
+		// Temporary
+		// Resources are resolved to IDs once, so that no name lookups are required per frame
+		tmp_colour_program = m_renderer.getShaderManager().getProgramId("colour");
+		tmp_atlas_program = m_renderer.getShaderManager().getProgramId("inst_atlas_lit");
+		tmp_sampler_uniform = m_renderer.getShaderManager().getUniformId("s_texColor");
+		tmp_cube_mesh = m_renderer.getGeometryManager().getMeshId("cube");
+		tmp_quad_mesh = m_renderer.getGeometryManager().getMeshId("quad");
+		tmp_tile_atlas = &m_renderer.getTextureManager().getAtlas("tiles");
+
 		const auto tiles = std::vector<Tile>({
 			Tile(1, Dir4::UP, { 1,1 }),
 			Tile(1, Dir4::UP, { 2,1 }),
@@ -54,18 +120,49 @@ namespace Orion
 			Tile(1, Dir4::UP, { 3,3 }),
 			Tile(1, Dir4::UP, { 4,3 }),
 			Tile(1, Dir4::UP, { 5,3 }),
+			Tile(1, Dir4::RIGHT, { 6,5 }, { 1,3 }),
 		});
 
 		std::for_each(tiles.cbegin(), tiles.cend(), [&](const Tile& tile) {
-			ASS(tmp_data.addTile(tile), "Add failed");
+			if (!tmp_data.addTile(tile))
+			{
+				LOG_ERROR("Failed to add temporary tile " << tile.getDefinition() << " at " << tile.getLocation().x << "," << tile.getLocation().y);
+			}
 		});
 //		tmp_data.addTileUnchecked(Tile(12, Dir4::RIGHT, { 4,4 }));
 
+		// Temporary
+		// Lights are bounded by the container, whose cells are centred at 20 unit spacing
+		auto & lighting = m_renderer.getLightingManager();
+		lighting.setBounds({ -10.0f, -10.0f }, { float(tmp_data.getSize().x) * 20.0f - 10.0f, float(tmp_data.getSize().y) * 20.0f - 10.0f });
+		lighting.addLight(PointLight{ { 20.0f, 20.0f }, 60.0f, 1.5f, { 1.0f, 0.85f, 0.6f } });
+		lighting.addLight(PointLight{ { 100.0f, 60.0f }, 50.0f, 2.0f, { 1.0f, 0.2f, 0.1f } });
+		lighting.addLight(PointLight{ { 120.0f, 110.0f }, 80.0f, 1.0f, { 0.4f, 0.6f, 1.0f } });
+
+		// Temporary particle effects; atmosphere venting from a breach, and a single explosion
+		auto & particles = m_renderer.getParticleManager();
+		particles.addEmitter(ParticleEffects::venting({ 120.0f, 20.0f, 0.0f }, { 1.0f, 0.2f }, 2000.0f));
+		particles.addEmitter(ParticleEffects::explosion({ 60.0f, 60.0f, 0.0f }, 20000U));
+
+		// Temporary labels naming the definition of each tile, centred on its footprint
+		auto & text = m_renderer.getTextManager();
+		const FontId font = text.getFontId("default");
+		for (const auto& tile : tiles)
+		{
+			const auto footprint = tile.getFootprint();
+			const Vec2<float> centre((float(tile.getLocation().x) + float(footprint.x - 1) * 0.5f) * 20.0f,
+									 (float(tile.getLocation().y) + float(footprint.y - 1) * 0.5f) * 20.0f);
+			text.addLabel(font, "Tile " + std::to_string(tile.getDefinition()), centre, 4.0f);
+		}
+		text.addScreenText(font, "Orion", { 10.0f, 150.0f });
+
     }
 
     int Orion::shutdown()
     {
 		// Shutdown primary components
+		m_simulation.stop();
+		m_input.shutdown();
 		m_renderer.shutdown();
 
         return 0;
@@ -78,14 +175,18 @@ namespace Orion
 			RendererInputState renderState;
 			renderState.width = m_width;
 			renderState.height = m_height;
+			renderState.frame_ms = float(m_renderer.getRenderStats().getFrameMs());
 			renderState.mouse_state = &m_mouseState;
-			
-			if (!_captureTemporaryInput(renderState)) return false;
-			
+
+			// Each frame displays the simulation as of the current time, interpolated between its last two ticks
+			if (!_applyTemporarySimulationState(m_simulation.getFrame())) return false;
+
 			_renderTemporaryCube();
 			_renderTemporaryTiles(renderState);
+			_renderTemporaryDebugOverlays();
 						
 			m_renderer.frame(renderState);
+			_throttleFrame();
 
             return true;
         }
@@ -94,46 +195,115 @@ namespace Orion
     }
 
 	// Temporary
-	bool Orion::_captureTemporaryInput(const RendererInputState& state)
+	void Orion::_bindTemporaryInput()
+	{
+		typedef InputController::ActionBinding::Source Source;
+		const InputController::ActionBinding bindings[] = {
+			{ Source::Key, entry::Key::Esc, 0U, InputAction::Quit },
+			{ Source::Key, entry::Key::KeyW, 0U, InputAction::MoveUp },
+			{ Source::Key, entry::Key::KeyS, 0U, InputAction::MoveDown },
+			{ Source::Key, entry::Key::KeyA, 0U, InputAction::MoveLeft },
+			{ Source::Key, entry::Key::KeyD, 0U, InputAction::MoveRight },
+			{ Source::Modifier, entry::Modifier::LeftShift, 0U, InputAction::MoveFast },
+			{ Source::MouseWheel, +1, 0U, InputAction::ZoomIn },
+			{ Source::MouseWheel, -1, 0U, InputAction::ZoomOut },
+			{ Source::Key, entry::Key::F3, 0U, InputAction::ToggleDebugDraw }
+		};
+
+		for (const auto& binding : bindings) m_input.bind(binding);
+	}
+
+	// Temporary
+	// Runs on the simulation thread, and so may only modify the simulation state and consume input
+	void Orion::_simulateTemporaryTick(SimulationState& state, float dt, Clock::time_point time)
 	{
-		if (inputGetKeyState(entry::Key::Esc, nullptr)) return false;
+		// Only input which arrived before the end of this tick is applied to it
+		m_input.sample(m_input_state, time);
+		const auto & input = m_input_state;
+		if (input.wasPressed(InputAction::Quit)) state.quit = true;
 
 		const float BASE_MOVE = 100000.0f;
 		const float BASE_ZOOM = 10.0f;
 
-		uint8_t modifiers;
-		Vec2<float> delta(0.0f, 0.0f);
+		const float move = BASE_MOVE * (input.isHeld(InputAction::MoveFast) ? 10.0f : 1.0f) * dt;
+		if (input.isHeld(InputAction::MoveUp)) state.camera_pos += Vec2<float>(0.0f, +1.0f * move);
+		if (input.isHeld(InputAction::MoveDown)) state.camera_pos += Vec2<float>(0.0f, -1.0f * move);
+		if (input.isHeld(InputAction::MoveLeft)) state.camera_pos += Vec2<float>(-1.0f * move, 0.0f);
+		if (input.isHeld(InputAction::MoveRight)) state.camera_pos += Vec2<float>(+1.0f * move, 0.0f);
+
+		// Debug overlays are toggled on release of F3
+		if (input.wasReleased(InputAction::ToggleDebugDraw)) ++state.debug_toggles;
+
+		const auto zoom_steps = int32_t(input.getPressCount(InputAction::ZoomOut)) - int32_t(input.getPressCount(InputAction::ZoomIn));
+		state.camera_height = std::max(state.camera_height + (float(zoom_steps) * BASE_ZOOM), BASE_ZOOM);
+	}
+
+	// Temporary
+	bool Orion::_applyTemporarySimulationState(const SimulationLoop<SimulationState>::Frame& frame)
+	{
+		const SimulationState& previous = frame.previous, & current = frame.current;
+		if (current.quit) return false;
+
+		const Vec2<float> alpha(frame.alpha, frame.alpha);
+		auto & camera = m_renderer.getCamera();
+		camera.setTopDownCameraPos(previous.camera_pos + ((current.camera_pos - previous.camera_pos) * alpha));
+		camera.setTopDownCameraHeight(previous.camera_height + ((current.camera_height - previous.camera_height) * frame.alpha));
+
+		// Discrete events are applied once, as soon as they are visible in the current state
+		if (((current.debug_toggles - tmp_debug_toggles) & 1U) != 0U)
+		{
+			auto & debug_draw = m_renderer.getDebugDrawManager();
+			debug_draw.setEnabled(!debug_draw.isEnabled());
+		}
+		tmp_debug_toggles = current.debug_toggles;
 
-		if (inputGetKeyState(entry::Key::KeyW, &modifiers)) delta += Vec2<float>(0.0f, +1.0f * _getTemporaryMoveDelta(BASE_MOVE, modifiers));
-		if (inputGetKeyState(entry::Key::KeyS, &modifiers)) delta += Vec2<float>(0.0f, -1.0f * _getTemporaryMoveDelta(BASE_MOVE, modifiers));
-		if (inputGetKeyState(entry::Key::KeyA, &modifiers)) delta += Vec2<float>(-1.0f * _getTemporaryMoveDelta(BASE_MOVE, modifiers), 0.0f);
-		if (inputGetKeyState(entry::Key::KeyD, &modifiers)) delta += Vec2<float>(+1.0f * _getTemporaryMoveDelta(BASE_MOVE, modifiers), 0.0f);
-		
-		tmp_pos += delta;
-		m_renderer.getCamera().moveTopDownCamera(delta);
-
-		static int32_t last_mouse_wheel = 0;
-		auto wheel_delta = state.mouse_state->m_mz - last_mouse_wheel;
-		if (wheel_delta > 0) m_renderer.getCamera().adjustTopDownCameraHeight(-1.0f * BASE_ZOOM);
-		if (wheel_delta < 0) m_renderer.getCamera().adjustTopDownCameraHeight(+1.0f * BASE_ZOOM);
-		last_mouse_wheel = state.mouse_state->m_mz;
-		
 		return true;
 	}
 
-	float Orion::_getTemporaryMoveDelta(float base, uint8_t modifiers)
+	// Frames are throttled to the maximum frame rate, if one is set, without accumulating delay from slow frames
+	void Orion::_throttleFrame()
 	{
-		const float frame_pc = float(m_renderer.getRenderStats().getFrameMs()) * (1.0f / 1000.0f);
-		const float speed_mult = (modifiers & entry::Modifier::LeftShift ? 10.0f : 1.0f);
+		if (m_frame_interval == Clock::duration::zero()) return;
 
-		return base * speed_mult * frame_pc;
+		const Clock::time_point now = Clock::now();
+		m_next_frame = std::max(m_next_frame + m_frame_interval, now);
+		std::this_thread::sleep_until(m_next_frame);
+	}
+
+	// Temporary
+	void Orion::_renderTemporaryDebugOverlays()
+	{
+		auto & debug_draw = m_renderer.getDebugDrawManager();
+		if (!debug_draw.isEnabled()) return;
+
+		// Cells are centred at 20 unit spacing; occupied cells are tinted, and each tile footprint is outlined
+		debug_draw.addGrid(tmp_data.getGrid(), { -10.0f, -10.0f }, 20.0f, [](Container::Index tile)
+		{
+			return (tile == Container::NO_INDEX ? 0U : 0x4000c0ffU);
+		});
+
+		std::vector<Vec2<float>> path;
+		for (const auto & tile : tmp_data.getTiles())
+		{
+			const auto location = tile.getLocation(), footprint = tile.getFootprint();
+			const Vec2<float> min_bounds(float(location.x) * 20.0f - 10.0f, float(location.y) * 20.0f - 10.0f);
+			const Vec2<float> max_bounds(min_bounds.x + float(footprint.x) * 20.0f, min_bounds.y + float(footprint.y) * 20.0f);
+
+			debug_draw.addBounds(min_bounds, max_bounds, 0xff00ffffU);
+			path.push_back(Vec2<float>((min_bounds.x + max_bounds.x) * 0.5f, (min_bounds.y + max_bounds.y) * 0.5f));
+		}
+		debug_draw.addPath(path, 0xffff8000U);
+
+		const auto & lighting = m_renderer.getLightingManager();
+		const auto query_stats = lighting.getQueryStats();
+		debug_draw.addQuadtree(lighting.getTree(), &query_stats);
 	}
 
 	// Temporary
 	void Orion::_renderTemporaryCube()
 	{
-		const auto shader = m_renderer.getShaderManager().getProgram("colour");
-		const auto mesh = m_renderer.getGeometryManager().getMesh("cube");
+		const auto shader = m_renderer.getShaderManager().getProgram(tmp_colour_program);
+		const auto & mesh = m_renderer.getGeometryManager().getMesh(tmp_cube_mesh);
 
 		static float timeRot = 0.0f;
 		timeRot += float(bgfx::getStats()->cpuTimeFrame) * (1000.0f / float(bgfx::getStats()->cpuTimerFreq)) * 0.001f;
@@ -145,22 +315,43 @@ namespace Orion
 		bx::mtxScale(scale, 8.0f);
 		bx::mtxMul(world, scale, rot);
 
-		m_renderer.submitImmediate(RenderConfig(shader, mesh.vertex_buffer, mesh.index_buffer, state), world);
+		m_renderer.submitImmediate(RenderConfig(shader, mesh, state), world);
 	}
 
 	// Temporary
 	void Orion::_renderTemporaryTiles(const RendererInputState & renderer_state)
 	{
-		const auto shader = m_renderer.getShaderManager().getProgram("inst_textured");
-		const auto mesh = m_renderer.getGeometryManager().getMesh("quad");
-		const auto uniform = m_renderer.getShaderManager().getUniform("s_texColor");
-		const auto texture = m_renderer.getTextureManager().getTexture("fieldstone");
+		const auto shader = m_renderer.getShaderManager().getProgram(tmp_atlas_program);
+		const auto & mesh = m_renderer.getGeometryManager().getMesh(tmp_quad_mesh);
+		const auto uniform = m_renderer.getShaderManager().getUniform(tmp_sampler_uniform);
+		const auto & atlas = *tmp_tile_atlas;
+		auto & textures = m_renderer.getTextureManager();
+		if (atlas.getPageCount() == 0U) return;
+
+		// Tile types on the same atlas page share its streamed texture and therefore a single render slot.  Page
+		// textures are resolved each frame, since their handles change as detail is streamed in and out
 		uint64_t state = BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_LESS | BGFX_STATE_CULL_CW | BGFX_STATE_MSAA;
-		RenderConfig config(shader, mesh.vertex_buffer, mesh.index_buffer, state, RenderConfig::Textures(TextureUniformBinding(texture, uniform)));
+		tmp_tile_configs.clear();
+		for (uint16_t page = 0U; page < atlas.getPageCount(); ++page)
+		{
+			tmp_tile_configs.emplace_back(shader, mesh, state, m_renderer.getLightingManager().getTextures(TextureUniformBinding(textures.getTexture(atlas.getPageTexture(page)), uniform)), RenderConfig::Uniforms::Lighting);
+		}
+
+		// The atlas region of each definition is resolved once per definition reload rather than per tile
+		if (tmp_tile_regions_generation != m_tile_defs.getGeneration())
+		{
+			tmp_tile_regions.assign(m_tile_defs.getTableSize(), { 0.0f, 0.0f, 1.0f, 1.0f, 0U });
+			for (TileDefRegistry::DefId id = 0U; id < m_tile_defs.getTableSize(); ++id)
+			{
+				const auto region = atlas.find(m_tile_defs.getTexture(id));
+				if (region != TextureAtlas::NO_REGION) tmp_tile_regions[id] = atlas.getRegion(region);
+			}
+
+			tmp_tile_regions_generation = m_tile_defs.getGeneration();
+		}
 
-		InstanceData inst;
+		AtlasInstanceData inst;
 		float scale[16], trans[16];
-		bx::mtxScale(scale, 10.0f);
 
 		if (renderer_state.width == 121212121) std::cout << "";
 
@@ -173,13 +364,37 @@ namespace Orion
 		//	m_renderer.queue().primary().submit(config, inst);
 		//}
 
+		// Atlas pages are requested at the detail needed by the nearest tile drawn from each page
+		const auto camera_pos = m_renderer.getCamera().getTopDownCameraPos();
+		const auto camera_height = m_renderer.getCamera().getTopDownCameraHeight();
+		tmp_tile_distances.assign(atlas.getPageCount(), std::numeric_limits<float>::max());
+
 		const auto & tiles = tmp_data.getTiles();
 		for (const auto& tile : tiles)
 		{
-			bx::mtxTranslate(trans, (float(tile.getLocation().x) * 20.0f), (float(tile.getLocation().y) * 20.0f), 0.0f);
+			// Multi-cell tiles are drawn as a single quad centred on their footprint
+			const auto footprint = tile.getFootprint();
+			bx::mtxScale(scale, 10.0f * float(footprint.x), 10.0f * float(footprint.y), 10.0f);
+			bx::mtxTranslate(trans, (float(tile.getLocation().x) + float(footprint.x - 1) * 0.5f) * 20.0f, (float(tile.getLocation().y) + float(footprint.y - 1) * 0.5f) * 20.0f, 0.0f);
 			bx::mtxMul(inst.transform, scale, trans);
 
-			m_renderer.queue().primary().submit(config, inst);
+			const auto definition = (tile.getDefinition() < tmp_tile_regions.size() ? tile.getDefinition() : TileDefRegistry::NULL_DEF);
+			const auto & region = tmp_tile_regions[definition];
+			memcpy(inst.uv_rect, &region, sizeof(inst.uv_rect));
+
+			const float dx = (float(tile.getLocation().x) * 20.0f) - camera_pos.x;
+			const float dy = (float(tile.getLocation().y) * 20.0f) - camera_pos.y;
+			tmp_tile_distances[region.page] = std::min(tmp_tile_distances[region.page], std::sqrt(dx * dx + dy * dy + camera_height * camera_height));
+
+			m_renderer.queue().atlas().submit(tmp_tile_configs[region.page], inst);
+		}
+
+		for (uint16_t page = 0U; page < atlas.getPageCount(); ++page)
+		{
+			if (tmp_tile_distances[page] != std::numeric_limits<float>::max())
+			{
+				textures.requestTextureDetail(atlas.getPageTexture(page), tmp_tile_distances[page]);
+			}
 		}
 	}
 }
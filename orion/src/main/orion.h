@@ -2,6 +2,9 @@
 
 #include "common.h"
 #include "../engine/renderer/core/renderer.h"
+#include "../engine/input/input_controller.h"
+#include "../engine/simulation/simulation_loop.h"
+#include "../tile/tile_def_registry.h"
 
 // Temporary
 #include "../container/container.h"
@@ -17,6 +20,10 @@ namespace Orion
 		static const bool RENDERER_RUNTIME_DEBUG_ENABLED = false;
 #		endif
 
+		static constexpr float SIMULATION_TICK_RATE = 60.0f;
+
+		typedef std::chrono::steady_clock Clock;
+
         Orion(const char* name, const char* description, const char* url);
 
         void init(int32_t argc, const char* const* argv, uint32_t width, uint32_t height) override;
@@ -27,10 +34,23 @@ namespace Orion
 
 	private:
 
-		bool _captureTemporaryInput(const RendererInputState& state);
-		float _getTemporaryMoveDelta(float base, uint8_t modifiers);
+		// Temporary
+		// State advanced by the simulation thread, from which each rendered frame is interpolated
+		struct SimulationState
+		{
+			Vec2<float> camera_pos;
+			float camera_height;
+			uint32_t debug_toggles;				// Number of debug overlay toggles requested
+			bool quit;
+		};
+
+		void _bindTemporaryInput();
+		void _simulateTemporaryTick(SimulationState& state, float dt, Clock::time_point time);
+		bool _applyTemporarySimulationState(const SimulationLoop<SimulationState>::Frame& frame);
+		void _throttleFrame();
 		void _renderTemporaryCube();
 		void _renderTemporaryTiles(const RendererInputState & state);
+		void _renderTemporaryDebugOverlays();
 
     private:
 
@@ -42,9 +62,26 @@ namespace Orion
         uint32_t m_reset;
 
 		Renderer m_renderer;
+		InputController m_input;
+		InputController::ActionState m_input_state;		// Owned by the simulation thread
+		SimulationLoop<SimulationState> m_simulation;
+
+		Clock::duration m_frame_interval;					// Minimum time between frames, if throttled
+		Clock::time_point m_next_frame;
+		TileDefRegistry m_tile_defs;
 
 		// Temporary
 		Container tmp_data;
-		Vec2<float> tmp_pos;
+		uint32_t tmp_debug_toggles;
+		std::vector<TextureAtlas::Region> tmp_tile_regions;
+		uint32_t tmp_tile_regions_generation;
+		std::vector<float> tmp_tile_distances;			// Indexed by atlas page
+		std::vector<RenderConfig> tmp_tile_configs;		// Indexed by atlas page
+		const TextureAtlas * tmp_tile_atlas;
+		ProgramId tmp_colour_program;
+		ProgramId tmp_atlas_program;
+		UniformId tmp_sampler_uniform;
+		MeshId tmp_cube_mesh;
+		MeshId tmp_quad_mesh;
     };
 };
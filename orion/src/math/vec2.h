@@ -16,7 +16,7 @@ namespace Orion
 		Vec2();
 		Vec2(T _x, T _y);
 
-		Vec2<T>& operator=(const Vec2<T>& other);
+		Vec2<T>& operator=(const Vec2<T>& other) = default;
 		bool operator==(const Vec2<T>& other);
 		bool operator!=(const Vec2<T>& other);
 		bool operator<(const Vec2<T>& other);
@@ -49,14 +49,6 @@ namespace Orion
 	}
 
 
-	template <typename T>
-	Vec2<T>& Vec2<T>::operator=(const Vec2<T>& other)
-	{
-		x = other.x;
-		y = other.y;
-		return *this;
-	}
-
 	template <typename T>
 	bool Vec2<T>::operator==(const Vec2<T>& other)
 	{
@@ -2,11 +2,12 @@
 
 namespace Orion
 {
-    Tile::Tile(DefId def, Dir4 rotation, Vec2<Coord> location)
+    Tile::Tile(DefId def, Dir4 rotation, Vec2<Coord> location, Vec2<Coord> size)
 		:
 		m_definition(def),
 		m_rotation(rotation),
-		m_location(location)
+		m_location(location),
+		m_size(size)
     {
     }
 }
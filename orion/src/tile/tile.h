@@ -4,6 +4,7 @@
 #include <vector>
 #include "../math/vec2.h"
 #include "../grid/dir4.h"
+#include "../grid/rotation.h"
 
 namespace Orion
 {
@@ -15,11 +16,17 @@ namespace Orion
 		typedef int Coord;
 		typedef std::vector<Tile> Collection;
 
-		Tile(DefId def, Dir4 rotation, Vec2<Coord> location);
+		// Location is the minimum corner of the tile footprint.  Size is the unrotated footprint size of the tile definition
+		Tile(DefId def, Dir4 rotation, Vec2<Coord> location, Vec2<Coord> size = Vec2<Coord>(1, 1));
 
 		inline DefId getDefinition() const { return m_definition; }
 		inline Dir4 getRotation() const { return m_rotation; }
 		inline Vec2<Coord> getLocation() const { return m_location; }
+		inline Vec2<Coord> getSize() const { return m_size; }
+
+		// Extent of the area covered by this tile once its rotation is applied
+		inline Vec2<Coord> getFootprint() const { return Rotation::rotateExtent(m_size, m_rotation); }
+		inline bool isMultiCell() const { return m_size.x != 1 || m_size.y != 1; }
 
 
 
@@ -28,6 +35,7 @@ namespace Orion
 		DefId m_definition;
 		Dir4 m_rotation;
 		Vec2<Coord> m_location;
+		Vec2<Coord> m_size;
 
 	};
 }
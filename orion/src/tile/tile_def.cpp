@@ -2,5 +2,15 @@
 
 namespace Orion
 {
-
+	TileDef::TileDef()
+		:
+		name(),
+		size(1, 1),
+		flags(0U),
+		mesh(),
+		texture(),
+		move_cost(1.0f),
+		conductivity(0.0f)
+	{
+	}
 }
@@ -1,17 +1,33 @@
 #pragma once
 
+#include <stdint.h>
+#include <string>
 #include "../math/vec2.h"
 
 namespace Orion
 {
-	class TileDef
+	// Definition of a single tile type, as read from data.  This is the cold, load-time representation; at
+	// runtime definitions are held by TileDefRegistry in per-property tables indexed directly by DefId
+	struct TileDef
 	{
-	public:
+		enum Flags : uint8_t
+		{
+			Defined = (1U << 0),
+			Walkable = (1U << 1),
+			BlocksLight = (1U << 2)
+		};
 
+		TileDef();
 
-	private:
-		Vec2<int> m_size;
+		std::string							name;
+		Vec2<int>							size;
 
+		uint8_t								flags;
 
+		std::string							mesh;
+		std::string							texture;
+
+		float								move_cost;
+		float								conductivity;
 	};
 }
@@ -0,0 +1,181 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "../util/log.h"
+#include "../util/file_watcher.h"
+
+#include "tile_def_registry.h"
+
+namespace Orion
+{
+	TileDefRegistry::TileDefRegistry()
+		:
+		m_generation(0U)
+	{
+		rebuildTables({});
+	}
+
+	ResultCode TileDefRegistry::load(const std::string& path)
+	{
+		std::vector<std::pair<DefId, TileDef>> definitions;
+		RETURN_ON_ERROR(parse(path, definitions));
+
+		m_path = path;
+
+		rebuildTables(definitions);
+		++m_generation;
+
+		LOG_INFO("Loaded " << definitions.size() << " tile definitions from \"" << path << "\"");
+		return ResultCodes::Success;
+	}
+
+	void TileDefRegistry::watch(FileWatcher& watcher)
+	{
+		if (m_path.empty()) return;
+
+		watcher.watch(m_path, [this](const std::string&) { reload(); });
+	}
+
+	ResultCode TileDefRegistry::reload()
+	{
+		std::vector<std::pair<DefId, TileDef>> definitions;
+		const auto result = parse(m_path, definitions);
+		if (ResultCodes::isError(result))
+		{
+			LOG_WARN("Failed to reload tile definitions from \"" << m_path << "\" (" << result << "), retaining existing definitions");
+			return result;
+		}
+
+		rebuildTables(definitions);
+		++m_generation;
+
+		LOG_INFO("Reloaded " << definitions.size() << " tile definitions from \"" << m_path << "\"");
+		return ResultCodes::Success;
+	}
+
+	TileDefRegistry::DefId TileDefRegistry::find(const std::string& name) const
+	{
+		const auto it = m_name_lookup.find(name);
+		return (it != m_name_lookup.end() ? it->second : NULL_DEF);
+	}
+
+	ResultCode TileDefRegistry::parse(const std::string& path, std::vector<std::pair<DefId, TileDef>>& outDefinitions)
+	{
+		std::ifstream in(path);
+		if (!in.is_open())
+		{
+			RETURN_LOG_ERROR("Failed to open tile definitions \"" << path << "\"", ResultCodes::FailedToOpenFile);
+		}
+
+		std::vector<std::pair<DefId, TileDef>> definitions;
+		std::string line;
+		int line_number = 0;
+
+		while (std::getline(in, line))
+		{
+			++line_number;
+
+			const auto comment = line.find('#');
+			if (comment != std::string::npos) line.erase(comment);
+
+			std::istringstream tokens(line);
+			std::string key;
+			if (!(tokens >> key)) continue;
+
+			bool valid = true;
+			if (key == "tile")
+			{
+				uint64_t id;
+				TileDef def;
+				valid = static_cast<bool>(tokens >> id >> def.name);
+
+				if (valid && (id == NULL_DEF || id > MAX_DEF_ID))
+				{
+					RETURN_LOG_ERROR("Tile definition id " << id << " is out of range (" << path << ":" << line_number << ")", ResultCodes::TileDefinitionIdOutOfRange);
+				}
+
+				const auto duplicate = std::find_if(definitions.cbegin(), definitions.cend(), [&](const auto& entry) {
+					return entry.first == id || entry.second.name == def.name;
+				});
+				if (valid && duplicate != definitions.cend())
+				{
+					RETURN_LOG_ERROR("Duplicate tile definition " << id << " \"" << def.name << "\" (" << path << ":" << line_number << ")", ResultCodes::DuplicateTileDefinition);
+				}
+
+				def.flags = TileDef::Defined;
+				definitions.push_back({ static_cast<DefId>(id), def });
+			}
+			else if (definitions.empty())
+			{
+				valid = false;
+			}
+			else
+			{
+				auto& def = definitions.back().second;
+				if (key == "size")
+				{
+					valid = static_cast<bool>(tokens >> def.size.x >> def.size.y) && def.size.x > 0 && def.size.y > 0;
+				}
+				else if (key == "walkable" || key == "blocks_light")
+				{
+					int value;
+					valid = static_cast<bool>(tokens >> value);
+
+					const uint8_t flag = (key == "walkable" ? TileDef::Walkable : TileDef::BlocksLight);
+					def.flags = static_cast<uint8_t>(value != 0 ? (def.flags | flag) : (def.flags & ~flag));
+				}
+				else if (key == "mesh") valid = static_cast<bool>(tokens >> def.mesh);
+				else if (key == "texture") valid = static_cast<bool>(tokens >> def.texture);
+				else if (key == "move_cost") valid = static_cast<bool>(tokens >> def.move_cost);
+				else if (key == "conductivity") valid = static_cast<bool>(tokens >> def.conductivity);
+				else valid = false;
+			}
+
+			if (!valid)
+			{
+				RETURN_LOG_ERROR("Invalid tile definition data \"" << line << "\" (" << path << ":" << line_number << ")", ResultCodes::InvalidTileDefinitionData);
+			}
+		}
+
+		outDefinitions = std::move(definitions);
+		return ResultCodes::Success;
+	}
+
+	void TileDefRegistry::rebuildTables(const std::vector<std::pair<DefId, TileDef>>& definitions)
+	{
+		DefId max_id = NULL_DEF;
+		for (const auto& entry : definitions) max_id = std::max(max_id, entry.first);
+
+		// Entry zero is always present and undefined, so that NULL_DEF can be used as a table index
+		const size_t table_size = static_cast<size_t>(max_id) + 1U;
+		const TileDef undefined;
+
+		m_flags.assign(table_size, undefined.flags);
+		m_sizes.assign(table_size, undefined.size);
+		m_move_costs.assign(table_size, undefined.move_cost);
+		m_conductivities.assign(table_size, undefined.conductivity);
+		m_names.assign(table_size, undefined.name);
+		m_meshes.assign(table_size, undefined.mesh);
+		m_textures.assign(table_size, undefined.texture);
+
+		m_ids.clear();
+		m_name_lookup.clear();
+
+		for (const auto& entry : definitions)
+		{
+			const auto id = entry.first;
+			const auto& def = entry.second;
+
+			m_flags[id] = def.flags;
+			m_sizes[id] = def.size;
+			m_move_costs[id] = def.move_cost;
+			m_conductivities[id] = def.conductivity;
+			m_names[id] = def.name;
+			m_meshes[id] = def.mesh;
+			m_textures[id] = def.texture;
+
+			m_ids.push_back(id);
+			m_name_lookup[def.name] = id;
+		}
+	}
+}
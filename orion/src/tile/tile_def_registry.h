@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../util/result_code.h"
+#include "tile.h"
+#include "tile_def.h"
+
+namespace Orion
+{
+	class FileWatcher;
+
+	// Registry of all tile definitions, loaded from a data file.  Each property is held in its own contiguous table
+	// indexed directly by DefId, so hot loops (rendering, pathfinding, simulation) resolve a property with a single
+	// array access.  DefIds are assigned explicitly in data so that they remain stable across reloads and saved games.
+	//
+	// Definitions file format; one definition per block, "#" begins a comment:
+	//
+	//   tile <id> <name>
+	//       size <x> <y>
+	//       walkable <0|1>
+	//       blocks_light <0|1>
+	//       mesh <mesh name>
+	//       texture <texture name>
+	//       move_cost <float>
+	//       conductivity <float>
+	//
+	class TileDefRegistry
+	{
+	public:
+
+		typedef Tile::DefId DefId;
+
+		static const DefId NULL_DEF = 0U;
+		static const DefId MAX_DEF_ID = 65535U;
+
+		TileDefRegistry();
+
+		ResultCode load(const std::string& path);
+
+		// Reloads definitions whenever the source file is modified, as detected by the watcher.  Existing definitions
+		// are retained if the new data is invalid
+		void watch(FileWatcher& watcher);
+
+		// Incremented each time definitions are (re)loaded, allowing consumers to detect when cached data is stale
+		inline uint32_t getGeneration() const { return m_generation; }
+
+		// Size of each table; all valid DefIds are less than this value
+		inline size_t getTableSize() const { return m_flags.size(); }
+		inline size_t getDefinitionCount() const { return m_ids.size(); }
+
+		DefId find(const std::string& name) const;
+
+		// Creates a tile instance with the footprint of the given definition
+		inline Tile createTile(DefId id, Dir4 rotation, Vec2<Tile::Coord> location) const { return Tile(id, rotation, location, m_sizes[id]); }
+
+		inline bool isDefined(DefId id) const { return id < m_flags.size() && (m_flags[id] & TileDef::Defined) != 0U; }
+
+		// Unchecked property access; the caller must ensure that the id is within the table
+		inline uint8_t getFlags(DefId id) const { return m_flags[id]; }
+		inline bool isWalkable(DefId id) const { return (m_flags[id] & TileDef::Walkable) != 0U; }
+		inline bool blocksLight(DefId id) const { return (m_flags[id] & TileDef::BlocksLight) != 0U; }
+		inline Vec2<int> getSize(DefId id) const { return m_sizes[id]; }
+		inline float getMoveCost(DefId id) const { return m_move_costs[id]; }
+		inline float getConductivity(DefId id) const { return m_conductivities[id]; }
+
+		inline const std::string& getName(DefId id) const { return m_names[id]; }
+		inline const std::string& getMesh(DefId id) const { return m_meshes[id]; }
+		inline const std::string& getTexture(DefId id) const { return m_textures[id]; }
+
+		// Direct table access for bulk processing
+		inline const uint8_t* getFlagsTable() const { return m_flags.data(); }
+		inline const float* getMoveCostTable() const { return m_move_costs.data(); }
+		inline const float* getConductivityTable() const { return m_conductivities.data(); }
+
+	private:
+
+		ResultCode reload();
+		static ResultCode parse(const std::string& path, std::vector<std::pair<DefId, TileDef>>& outDefinitions);
+		void rebuildTables(const std::vector<std::pair<DefId, TileDef>>& definitions);
+
+	private:
+
+		std::string									m_path;
+		uint32_t									m_generation;
+
+		// Hot tables
+		std::vector<uint8_t>						m_flags;
+		std::vector<Vec2<int>>						m_sizes;
+		std::vector<float>							m_move_costs;
+		std::vector<float>							m_conductivities;
+
+		// Cold tables
+		std::vector<std::string>					m_names;
+		std::vector<std::string>					m_meshes;
+		std::vector<std::string>					m_textures;
+
+		std::vector<DefId>							m_ids;
+		std::unordered_map<std::string, DefId>		m_name_lookup;
+	};
+}
@@ -0,0 +1,186 @@
+#include <sys/stat.h>
+#ifdef __linux__
+#	include <unistd.h>
+#	include <sys/inotify.h>
+#endif
+#include "log.h"
+
+#include "file_watcher.h"
+
+namespace Orion
+{
+	FileWatcher::FileWatcher()
+		:
+		m_last_scan(Clock::now())
+#		ifdef __linux__
+		, m_fd(-1)
+#		endif
+	{
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		shutdown();
+	}
+
+	ResultCode FileWatcher::initialise()
+	{
+#		ifdef __linux__
+		m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_fd < 0)
+		{
+			// Not fatal; changes will be detected by modification time instead
+			LOG_WARN("Failed to initialise inotify, falling back to periodic file checks");
+		}
+#		endif
+
+		return ResultCodes::Success;
+	}
+
+	void FileWatcher::watch(const std::string& path, Callback&& callback)
+	{
+		auto& file = m_files[path];
+		file.callbacks.push_back(std::move(callback));
+		if (file.callbacks.size() != 1U) return;
+
+		file.pending = false;
+		file.polled = true;
+		if (!getModifiedTime(path, file.modified_time)) file.modified_time = 0;
+
+#		ifdef __linux__
+		// Directories are watched rather than files, since many tools replace a file rather than writing it in place
+		if (m_fd >= 0)
+		{
+			const auto directory = getDirectory(path);
+			auto watch = m_directory_watches.find(directory);
+			if (watch == m_directory_watches.end())
+			{
+				const int wd = inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+				if (wd < 0)
+				{
+					LOG_WARN("Failed to watch directory \"" << directory << "\" for changes, falling back to periodic file checks");
+				}
+				else
+				{
+					m_directories[wd] = directory;
+				}
+
+				watch = m_directory_watches.emplace(directory, wd).first;
+			}
+
+			// Files in directories which could not be watched are checked by modification time instead
+			file.polled = (watch->second < 0);
+		}
+#		endif
+	}
+
+	void FileWatcher::poll()
+	{
+		detectChanges();
+
+		// Collect settled changes before notifying, since callbacks may register further watches
+		const auto now = Clock::now();
+		std::vector<std::string> changed;
+		for (auto& entry : m_files)
+		{
+			auto& file = entry.second;
+			if (file.pending && (now - file.changed) >= std::chrono::milliseconds(SETTLE_TIME_MS))
+			{
+				file.pending = false;
+				changed.push_back(entry.first);
+			}
+		}
+
+		for (const auto& path : changed)
+		{
+			LOG_INFO("Detected modification of \"" << path << "\"");
+
+			const auto callbacks = m_files[path].callbacks;
+			for (const auto& callback : callbacks) callback(path);
+		}
+	}
+
+	void FileWatcher::detectChanges()
+	{
+#		ifdef __linux__
+		if (m_fd >= 0)
+		{
+			alignas(struct inotify_event) char buffer[4096];
+			while (true)
+			{
+				const auto length = read(m_fd, buffer, sizeof(buffer));
+				if (length <= 0) break;
+
+				for (ssize_t offset = 0; offset < length; )
+				{
+					const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+					offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+
+					const auto directory = m_directories.find(event->wd);
+					if (directory == m_directories.end() || event->len == 0U) continue;
+
+					markChanged(directory->second == "." ? std::string(event->name) : (directory->second + "/" + event->name));
+				}
+			}
+		}
+#		endif
+
+		const auto now = Clock::now();
+		if ((now - m_last_scan) < std::chrono::milliseconds(SCAN_INTERVAL_MS)) return;
+		m_last_scan = now;
+
+		for (auto& entry : m_files)
+		{
+			if (!entry.second.polled) continue;
+
+			int64_t modified_time;
+			if (getModifiedTime(entry.first, modified_time) && modified_time != entry.second.modified_time)
+			{
+				entry.second.modified_time = modified_time;
+				markChanged(entry.first);
+			}
+		}
+	}
+
+	void FileWatcher::markChanged(const std::string& path)
+	{
+		const auto it = m_files.find(path);
+		if (it == m_files.end()) return;
+
+		// Further changes within the settling period defer notification
+		it->second.pending = true;
+		it->second.changed = Clock::now();
+	}
+
+	bool FileWatcher::getModifiedTime(const std::string& path, int64_t& outTime)
+	{
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0) return false;
+
+		outTime = static_cast<int64_t>(info.st_mtime);
+		return true;
+	}
+
+	std::string FileWatcher::getDirectory(const std::string& path)
+	{
+		const auto separator = path.find_last_of("/\\");
+		return (separator == std::string::npos ? std::string(".") : path.substr(0U, separator));
+	}
+
+	void FileWatcher::shutdown()
+	{
+#		ifdef __linux__
+		if (m_fd >= 0)
+		{
+			for (const auto& directory : m_directories) inotify_rm_watch(m_fd, directory.first);
+			close(m_fd);
+			m_fd = -1;
+		}
+
+		m_directories.clear();
+		m_directory_watches.clear();
+#		endif
+
+		m_files.clear();
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include "result_code.h"
+
+namespace Orion
+{
+	// Watches individual files for modification.  Changes are detected via inotify on Linux, and by periodic
+	// modification-time checks on other platforms or for directories which inotify cannot watch.  poll() never blocks, and callbacks are invoked on the polling
+	// thread once a file has been unchanged for a short settling period, so partially-written files are not reported
+	class FileWatcher
+	{
+	public:
+
+		typedef std::function<void(const std::string&)> Callback;
+
+		static const uint32_t SETTLE_TIME_MS = 100U;
+		static const uint32_t SCAN_INTERVAL_MS = 500U;		// Modification-time checks only
+
+		FileWatcher();
+		~FileWatcher();
+
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		ResultCode initialise();
+
+		// Callback is invoked with the path as given here.  A path may be watched by any number of callbacks
+		void watch(const std::string& path, Callback&& callback);
+
+		void poll();
+
+		void shutdown();
+
+	private:
+
+		typedef std::chrono::steady_clock Clock;
+
+		struct WatchedFile
+		{
+			std::vector<Callback>		callbacks;
+			int64_t						modified_time;
+			bool						pending;
+			bool						polled;					// Checked by modification time rather than inotify
+			Clock::time_point			changed;
+		};
+
+		void detectChanges();
+		void markChanged(const std::string& path);
+		static bool getModifiedTime(const std::string& path, int64_t& outTime);
+		static std::string getDirectory(const std::string& path);
+
+	private:
+
+		std::unordered_map<std::string, WatchedFile>	m_files;
+		Clock::time_point								m_last_scan;
+
+#		ifdef __linux__
+		int												m_fd;
+		std::unordered_map<int, std::string>			m_directories;			// Watch descriptor -> directory
+		std::unordered_map<std::string, int>			m_directory_watches;		// -1 where the directory could not be watched
+#		endif
+	};
+}
@@ -0,0 +1,121 @@
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+#include "log.h"
+
+#include "mapped_file.h"
+
+namespace Orion
+{
+	MappedFile::MappedFile()
+		:
+		m_data(nullptr),
+		m_size(0U),
+#		ifdef _WIN32
+		m_file(INVALID_HANDLE_VALUE),
+		m_mapping(nullptr)
+#		else
+		m_fd(-1)
+#		endif
+	{
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+#	ifdef _WIN32
+
+	ResultCode MappedFile::open(const std::string& path)
+	{
+		close();
+
+		m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+		{
+			RETURN_LOG_ERROR("Failed to open file \"" << path << "\" for mapping", ResultCodes::FailedToOpenFile);
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+		{
+			close();
+			RETURN_LOG_ERROR("Cannot map empty or unreadable file \"" << path << "\"", ResultCodes::FailedToMapFile);
+		}
+
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		const void* view = (m_mapping != nullptr ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr);
+		if (view == nullptr)
+		{
+			close();
+			RETURN_LOG_ERROR("Failed to map file \"" << path << "\"", ResultCodes::FailedToMapFile);
+		}
+
+		m_data = static_cast<const uint8_t*>(view);
+		m_size = static_cast<size_t>(size.QuadPart);
+		return ResultCodes::Success;
+	}
+
+	void MappedFile::close()
+	{
+		if (m_data != nullptr) UnmapViewOfFile(m_data);
+		if (m_mapping != nullptr) CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+
+		m_data = nullptr;
+		m_size = 0U;
+		m_mapping = nullptr;
+		m_file = INVALID_HANDLE_VALUE;
+	}
+
+#	else
+
+	ResultCode MappedFile::open(const std::string& path)
+	{
+		close();
+
+		m_fd = ::open(path.c_str(), O_RDONLY);
+		if (m_fd < 0)
+		{
+			RETURN_LOG_ERROR("Failed to open file \"" << path << "\" for mapping", ResultCodes::FailedToOpenFile);
+		}
+
+		struct stat st;
+		if (fstat(m_fd, &st) != 0 || st.st_size == 0)
+		{
+			close();
+			RETURN_LOG_ERROR("Cannot map empty or unreadable file \"" << path << "\"", ResultCodes::FailedToMapFile);
+		}
+
+		void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, m_fd, 0);
+		if (view == MAP_FAILED)
+		{
+			close();
+			RETURN_LOG_ERROR("Failed to map file \"" << path << "\"", ResultCodes::FailedToMapFile);
+		}
+
+		m_data = static_cast<const uint8_t*>(view);
+		m_size = static_cast<size_t>(st.st_size);
+		return ResultCodes::Success;
+	}
+
+	void MappedFile::close()
+	{
+		if (m_data != nullptr) munmap(const_cast<uint8_t*>(m_data), m_size);
+		if (m_fd >= 0) ::close(m_fd);
+
+		m_data = nullptr;
+		m_size = 0U;
+		m_fd = -1;
+	}
+
+#	endif
+}
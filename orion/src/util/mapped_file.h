@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "result_code.h"
+
+namespace Orion
+{
+	// Read-only memory mapping of an entire file.  Mapped data remains valid until the file is closed or the object destroyed
+	class MappedFile
+	{
+	public:
+
+		MappedFile();
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		ResultCode open(const std::string& path);
+		void close();
+
+		inline bool isOpen() const { return m_data != nullptr; }
+		inline const uint8_t* data() const { return m_data; }
+		inline size_t size() const { return m_size; }
+
+	private:
+
+		const uint8_t*		m_data;
+		size_t				m_size;
+
+#		ifdef _WIN32
+		void*				m_file;
+		void*				m_mapping;
+#		else
+		int					m_fd;
+#		endif
+	};
+}
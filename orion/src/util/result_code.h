@@ -25,6 +25,34 @@ namespace Orion
 		add(110, FailedToCreateMesh);
 		add(111, CannotLoadDuplicateTexture);
 		add(112, CannotAllocateSufficientlyLargeInstanceBuffer);
+		add(113, TextureAtlasFull);
+		add(114, CannotModifyBuiltTextureAtlas);
+		add(115, CannotLoadDuplicateTextureAtlas);
+		add(116, InvalidShaderArchive);
+		add(117, ShaderNotFoundInArchive);
+		add(118, InvalidMeshFile);
+		add(119, FailedToLoadMeshResource);
+		add(120, InvalidRenderGraph);
+		add(121, FailedToCreateRenderTarget);
+		add(122, FailedToInitialiseLighting);
+		add(123, FailedToInitialiseParticles);
+		add(124, FailedToLoadFont);
+		add(125, FailedToInitialiseText);
+		add(126, FailedToInitialiseGui);
+		add(127, FailedToStartSimulation);
+
+		add(200, FailedToOpenFile);
+		add(201, FailedToMapFile);
+		add(202, FailedToWriteFile);
+		add(203, InvalidContainerFileFormat);
+		add(204, UnsupportedContainerFileVersion);
+		add(205, ContainerFileTruncated);
+		add(206, ContainerDeltaMismatch);
+		add(207, ContainerFileCorrupt);
+
+		add(300, InvalidTileDefinitionData);
+		add(301, DuplicateTileDefinition);
+		add(302, TileDefinitionIdOutOfRange);
 		
 
 
@@ -0,0 +1,24 @@
+#pragma once
+
+// Determine whether SSE intrinsics are available for the current compilation target.  All SIMD paths
+// must provide a scalar fallback when ORION_SIMD_SSE is not set
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define ORION_SIMD_SSE 1
+#	include <emmintrin.h>
+#else
+#	define ORION_SIMD_SSE 0
+#endif
+
+namespace Orion
+{
+	class Simd
+	{
+	public:
+
+		// Number of 32-bit lanes processed by each SIMD operation
+		static constexpr int WIDTH = 4;
+
+		// Returns the number of elements in [0, count) which can be processed in whole SIMD-width blocks
+		inline static constexpr int alignedCount(int count) { return count & ~(WIDTH - 1); }
+	};
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+#include <array>
+#include <atomic>
+
+namespace Orion
+{
+	// Fixed-capacity lock-free queue for one producer thread and one consumer thread.  Push fails rather than blocks
+	// when the queue is full, so the producer is never stalled by a slow consumer
+	template <typename T, size_t Capacity>
+	class SpscQueue
+	{
+	public:
+
+		static_assert(Capacity != 0U && (Capacity & (Capacity - 1U)) == 0U, "Queue capacity must be a power of two");
+
+		SpscQueue() : m_items(), m_head(0U), m_tail(0U) { }
+
+		// Producer only
+		bool push(const T& item)
+		{
+			const size_t tail = m_tail.load(std::memory_order_relaxed);
+			if ((tail - m_head.load(std::memory_order_acquire)) == Capacity) return false;
+
+			m_items[tail & (Capacity - 1U)] = item;
+			m_tail.store(tail + 1U, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer only.  The item remains valid until it is popped
+		const T* front() const
+		{
+			const size_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_tail.load(std::memory_order_acquire)) return nullptr;
+
+			return &m_items[head & (Capacity - 1U)];
+		}
+
+		// Consumer only
+		bool pop(T& item)
+		{
+			const T* next = front();
+			if (!next) return false;
+
+			item = *next;
+			pop();
+			return true;
+		}
+
+		// Consumer only.  Discards the front item, which must exist
+		void pop()
+		{
+			m_head.store(m_head.load(std::memory_order_relaxed) + 1U, std::memory_order_release);
+		}
+
+		// Approximate when called while either thread is active
+		inline size_t size() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+		inline constexpr size_t capacity() const { return Capacity; }
+
+	private:
+
+		std::array<T, Capacity>					m_items;
+
+		// Each index is written by a single thread, and is kept on its own cache line
+		alignas(64) std::atomic<size_t>			m_head;
+		alignas(64) std::atomic<size_t>			m_tail;
+	};
+}
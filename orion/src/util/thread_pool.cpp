@@ -0,0 +1,397 @@
+#include <memory>
+#include <algorithm>
+#include "log.h"
+
+#include "thread_pool.h"
+
+namespace Orion
+{
+	// Queue index used by threads which are not workers of the pool
+	static const size_t NO_WORKER = static_cast<size_t>(-1);
+
+	// Pool and queue of the worker running on this thread, if any
+	static thread_local const ThreadPool * t_pool = nullptr;
+	static thread_local size_t t_worker = NO_WORKER;
+
+	ThreadPool::ThreadPool(size_t thread_count)
+		:
+		m_requested_threads(thread_count),
+		m_main_thread(),
+		m_next_queue(0U),
+		m_pending(0U),
+		m_active(0U),
+		m_sleeping(0U),
+		m_stopping(false),
+		m_executed(0U),
+		m_stolen(0U)
+	{
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		shutdown();
+	}
+
+	ResultCode ThreadPool::initialise()
+	{
+		const size_t hardware_threads = static_cast<size_t>(std::thread::hardware_concurrency());
+		const size_t count = (m_requested_threads != 0U ? m_requested_threads : std::max<size_t>(hardware_threads, 2U) - 1U);
+
+		LOG_INFO("Initialising thread pool with " << count << " worker threads");
+
+		m_main_thread = std::this_thread::get_id();
+		m_stopping = false;
+
+		// All queues must exist before any worker is able to steal from them
+		m_queues.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			m_queues.push_back(std::make_unique<WorkQueue>());
+		}
+
+		m_threads.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			m_threads.emplace_back([this, i]() { workerLoop(i); });
+		}
+
+		return ResultCodes::Success;
+	}
+
+	void ThreadPool::enqueue(Task&& task, JobCounter* counter)
+	{
+		if (counter) counter->m_count.fetch_add(1U, std::memory_order_acq_rel);
+
+		push({ std::move(task), counter });
+	}
+
+	void ThreadPool::enqueueAfter(JobCounter& dependency, Task&& task, JobCounter* counter)
+	{
+		if (counter) counter->m_count.fetch_add(1U, std::memory_order_acq_rel);
+
+		{
+			std::lock_guard<std::mutex> lock(dependency.m_mutex);
+			if (dependency.m_count.load(std::memory_order_acquire) != 0U)
+			{
+				dependency.m_dependents.emplace_back(std::move(task), counter);
+				return;
+			}
+		}
+
+		push({ std::move(task), counter });
+	}
+
+	void ThreadPool::enqueueMain(Task&& task, JobCounter* counter)
+	{
+		if (counter) counter->m_count.fetch_add(1U, std::memory_order_acq_rel);
+
+		{
+			std::lock_guard<std::mutex> lock(m_main_mutex);
+			m_main_jobs.push_back({ std::move(task), counter });
+		}
+
+		// The main thread may be sleeping in a wait on the pool
+		wakeSleepers(true);
+	}
+
+	void ThreadPool::runMainThreadTasks()
+	{
+		// Only tasks queued before this call are run, so that a task which requeues itself cannot stall the caller
+		std::deque<Job> jobs;
+		{
+			std::lock_guard<std::mutex> lock(m_main_mutex);
+			jobs.swap(m_main_jobs);
+		}
+
+		for (Job& job : jobs) execute(job);
+	}
+
+	void ThreadPool::wait(JobCounter& counter)
+	{
+		const bool main_thread = (std::this_thread::get_id() == m_main_thread);
+		while (!counter.isComplete())
+		{
+			if (runPendingJob()) continue;
+
+			// Sleep alongside idle workers until the counter completes, or a job is queued which this thread could run
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_sleeping.fetch_add(1U);
+			m_task_available.wait(lock, [this, &counter, main_thread]()
+			{
+				return counter.m_count.load() == 0U || m_pending.load() != 0U || (main_thread && hasMainThreadJobs());
+			});
+			m_sleeping.fetch_sub(1U);
+		}
+
+		// The final job releases the counter lock after reaching zero; the counter may be destroyed once it is acquired
+		std::lock_guard<std::mutex> lock(counter.m_mutex);
+	}
+
+	void ThreadPool::parallelFor(size_t count, const IndexedTask& fn)
+	{
+		parallelForRange(count, 1U, [&fn](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i) fn(i);
+		});
+	}
+
+	void ThreadPool::parallelForRange(size_t count, size_t grain, const RangeTask& fn)
+	{
+		if (count == 0U) return;
+		grain = std::max<size_t>(grain, 1U);
+
+		// Shared state is reference-counted since helper tasks may only be dequeued after all work is complete
+		struct State
+		{
+			std::atomic<size_t> next;
+			std::atomic<size_t> remaining;
+			const RangeTask* fn;
+			size_t count;
+			size_t grain;
+
+			std::mutex mutex;
+			std::condition_variable done;
+		};
+
+		auto state = std::make_shared<State>();
+		state->next = 0U;
+		state->remaining = count;
+		state->fn = &fn;
+		state->count = count;
+		state->grain = grain;
+
+		const auto run = [](State& s)
+		{
+			size_t begin;
+			while ((begin = s.next.fetch_add(s.grain)) < s.count)
+			{
+				const size_t end = std::min(begin + s.grain, s.count);
+				(*s.fn)(begin, end);
+				if (s.remaining.fetch_sub(end - begin) == (end - begin))
+				{
+					std::lock_guard<std::mutex> lock(s.mutex);
+					s.done.notify_all();
+				}
+			}
+		};
+
+		// Wake at most one helper per range beyond the first, which is always taken by the calling thread
+		const size_t helpers = std::min(m_threads.size(), ((count + grain - 1U) / grain) - 1U);
+		for (size_t i = 0; i < helpers; ++i)
+		{
+			enqueue([state, run]() { run(*state); });
+		}
+
+		run(*state);
+
+		// Ranges may still be executing on other workers.  All ranges have been claimed at this point, so the caller
+		// does not take on unrelated jobs which could delay its return
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->done.wait(lock, [&state]() { return state->remaining.load() == 0U; });
+	}
+
+	void ThreadPool::waitIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_idle.wait(lock, [this]() { return m_pending.load() == 0U && m_active.load() == 0U; });
+	}
+
+	void ThreadPool::workerLoop(size_t index)
+	{
+		t_pool = this;
+		t_worker = index;
+
+		for (;;)
+		{
+			Job job;
+			if (takeJob(index, job))
+			{
+				execute(job);
+				finishJob();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_stopping && m_pending.load() == 0U) return;
+
+			m_sleeping.fetch_add(1U);
+			m_task_available.wait(lock, [this]() { return m_stopping || m_pending.load() != 0U; });
+			m_sleeping.fetch_sub(1U);
+		}
+	}
+
+	void ThreadPool::push(Job&& job)
+	{
+		// Jobs are executed immediately by a pool which has not been initialised or has been shut down
+		if (m_queues.empty())
+		{
+			execute(job);
+			return;
+		}
+
+		// The job is counted as pending before it becomes visible, so that the count can never be decremented by a
+		// thread taking the job before it has been incremented here
+		m_pending.fetch_add(1U);
+
+		const size_t target = (t_pool == this ? t_worker : m_next_queue.fetch_add(1U, std::memory_order_relaxed) % m_queues.size());
+		{
+			WorkQueue& queue = *m_queues[target];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(std::move(job));
+		}
+
+		wakeSleepers(false);
+	}
+
+	// Sleeping threads only need to be woken if any are waiting.  Either this thread observes a thread about to
+	// sleep, or that thread observes the new job or counter state before sleeping
+	void ThreadPool::wakeSleepers(bool all)
+	{
+		if (m_sleeping.load() == 0U) return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+		}
+
+		if (all) m_task_available.notify_all(); else m_task_available.notify_one();
+	}
+
+	bool ThreadPool::hasMainThreadJobs()
+	{
+		std::lock_guard<std::mutex> lock(m_main_mutex);
+		return !m_main_jobs.empty();
+	}
+
+	// Jobs are taken newest-first from the home queue of a worker, for locality, and otherwise stolen oldest-first
+	bool ThreadPool::takeJob(size_t home, Job& job)
+	{
+		const size_t count = m_queues.size();
+		const auto take = [this, &job](WorkQueue& queue, bool newest)
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.jobs.empty()) return false;
+
+			job = std::move(newest ? queue.jobs.back() : queue.jobs.front());
+			if (newest) queue.jobs.pop_back(); else queue.jobs.pop_front();
+
+			// Active before no longer pending, so that the pool is never briefly seen as idle
+			m_active.fetch_add(1U);
+			m_pending.fetch_sub(1U);
+			return true;
+		};
+
+		if (home < count && take(*m_queues[home], true)) return true;
+
+		const size_t start = (home < count ? home + 1U : m_next_queue.load(std::memory_order_relaxed));
+		for (size_t i = 0U; i < count; ++i)
+		{
+			const size_t victim = (start + i) % count;
+			if (victim == home || !take(*m_queues[victim], false)) continue;
+
+			if (home < count) m_stolen.fetch_add(1U, std::memory_order_relaxed);
+			return true;
+		}
+
+		return false;
+	}
+
+	// Executes one queued job on the calling thread, if any is available.  The main thread gives priority to its
+	// own jobs, since no other thread can run them
+	bool ThreadPool::runPendingJob()
+	{
+		if (std::this_thread::get_id() == m_main_thread)
+		{
+			Job job;
+			{
+				std::lock_guard<std::mutex> lock(m_main_mutex);
+				if (!m_main_jobs.empty())
+				{
+					job = std::move(m_main_jobs.front());
+					m_main_jobs.pop_front();
+				}
+			}
+
+			if (job.task)
+			{
+				execute(job);
+				return true;
+			}
+		}
+
+		Job job;
+		if (!takeJob(t_pool == this ? t_worker : NO_WORKER, job)) return false;
+
+		execute(job);
+		finishJob();
+		return true;
+	}
+
+	void ThreadPool::execute(Job& job)
+	{
+		job.task();
+		if (job.counter) complete(*job.counter);
+
+		m_executed.fetch_add(1U, std::memory_order_relaxed);
+	}
+
+	// Called once a job taken from a worker queue has been executed
+	void ThreadPool::finishJob()
+	{
+		if (m_active.fetch_sub(1U) == 1U && m_pending.load() == 0U)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_idle.notify_all();
+		}
+	}
+
+	void ThreadPool::complete(JobCounter& counter)
+	{
+		// Counts above one are decremented without locking.  The transition to zero is made under the lock, so that
+		// dependents are never missed and a waiter cannot destroy the counter while it is still in use here
+		size_t count = counter.m_count.load(std::memory_order_acquire);
+		while (count > 1U)
+		{
+			if (counter.m_count.compare_exchange_weak(count, count - 1U, std::memory_order_acq_rel)) return;
+		}
+
+		std::vector<std::pair<Task, JobCounter*>> dependents;
+		{
+			std::lock_guard<std::mutex> lock(counter.m_mutex);
+			if (counter.m_count.fetch_sub(1U) != 1U) return;
+
+			dependents.swap(counter.m_dependents);
+		}
+
+		// Threads waiting on the counter may be sleeping; the counter itself must not be accessed from this point
+		wakeSleepers(true);
+
+		for (auto& dependent : dependents)
+		{
+			push({ std::move(dependent.first), dependent.second });
+		}
+	}
+
+	void ThreadPool::shutdown()
+	{
+		if (m_threads.empty()) return;
+
+		LOG_INFO("Shutting down thread pool");
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+
+		m_task_available.notify_all();
+		std::for_each(m_threads.begin(), m_threads.end(), [](std::thread& thread) { thread.join(); });
+		m_threads.clear();
+		m_queues.clear();
+
+		std::lock_guard<std::mutex> lock(m_main_mutex);
+		if (!m_main_jobs.empty())
+		{
+			LOG_WARN("Discarding " << m_main_jobs.size() << " main-thread tasks at shutdown");
+			m_main_jobs.clear();
+		}
+	}
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "result_code.h"
+
+namespace Orion
+{
+	class ThreadPool;
+
+	// Number of outstanding jobs in a group.  Jobs queued against a counter increment it and decrement it once
+	// complete, and jobs may be queued to start only once a counter reaches zero.  A counter must be waited on
+	// through its pool before it is destroyed or reused
+	class JobCounter
+	{
+	public:
+
+		JobCounter() : m_count(0U), m_mutex(), m_dependents() { }
+
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		inline size_t getCount() const { return m_count.load(std::memory_order_acquire); }
+		inline bool isComplete() const { return getCount() == 0U; }
+
+	private:
+
+		friend class ThreadPool;
+
+		std::atomic<size_t>										m_count;
+
+		// Guards the transition to zero, and the jobs which will be queued at that point
+		std::mutex												m_mutex;
+		std::vector<std::pair<std::function<void()>, JobCounter*>>	m_dependents;
+	};
+
+
+	// Job scheduler with one worker per hardware thread.  Each worker owns a queue; jobs queued from a worker are
+	// pushed to its own queue and executed newest-first, while idle workers steal the oldest jobs from other queues.
+	// Jobs queued from any other thread are distributed across the worker queues.  Jobs which must run on the main
+	// thread, such as bgfx resource calls, are held separately until the main thread runs them
+	class ThreadPool
+	{
+	public:
+
+		typedef std::function<void()> Task;
+		typedef std::function<void(size_t)> IndexedTask;
+		typedef std::function<void(size_t, size_t)> RangeTask;
+
+		struct Stats
+		{
+			size_t		executed;				// Jobs executed by workers or by threads waiting on the pool
+			size_t		stolen;					// Jobs taken from the queue of another worker
+		};
+
+		// Thread count of zero will use one worker per hardware thread, excluding the calling thread
+		ThreadPool(size_t thread_count = 0U);
+		~ThreadPool();
+
+		// The calling thread is taken to be the main thread
+		ResultCode initialise();
+
+		inline size_t getThreadCount() const { return m_threads.size(); }
+
+		// Queue a task for asynchronous execution on any worker thread
+		void enqueue(Task&& task, JobCounter* counter = nullptr);
+
+		// Queue a task for execution once all jobs counted by the dependency have completed
+		void enqueueAfter(JobCounter& dependency, Task&& task, JobCounter* counter = nullptr);
+
+		// Queue a task for execution on the main thread, the next time it runs main-thread tasks or waits on the pool
+		void enqueueMain(Task&& task, JobCounter* counter = nullptr);
+
+		// Executes all main-thread tasks queued so far.  Main thread only
+		void runMainThreadTasks();
+
+		// Blocks until all jobs counted have completed, executing other queued jobs in the meantime and otherwise sleeping
+		void wait(JobCounter& counter);
+
+		// Executes fn(i) for all i in [0, count) across the pool, blocking until all have completed.  The calling
+		// thread participates in execution, so this is safe to call from within a task running on the pool
+		void parallelFor(size_t count, const IndexedTask& fn);
+
+		// As parallelFor, executing fn(begin, end) over ranges of at most grain items
+		void parallelForRange(size_t count, size_t grain, const RangeTask& fn);
+
+		// Blocks until no worker job is queued or executing.  Main-thread tasks are not included
+		void waitIdle();
+
+		inline Stats getStats() const { return { m_executed.load(std::memory_order_relaxed), m_stolen.load(std::memory_order_relaxed) }; }
+
+		void shutdown();
+
+	private:
+
+		struct Job
+		{
+			Task			task;
+			JobCounter *	counter = nullptr;
+		};
+
+		struct alignas(64) WorkQueue
+		{
+			std::mutex			mutex;
+			std::deque<Job>		jobs;
+		};
+
+		void workerLoop(size_t index);
+
+		void push(Job&& job);
+		bool takeJob(size_t home, Job& job);
+		bool runPendingJob();
+		void execute(Job& job);
+		void finishJob();
+		void complete(JobCounter& counter);
+		void wakeSleepers(bool all);
+		bool hasMainThreadJobs();
+
+	private:
+
+		size_t										m_requested_threads;
+		std::vector<std::thread>					m_threads;
+		std::thread::id								m_main_thread;
+
+		std::vector<std::unique_ptr<WorkQueue>>		m_queues;			// Indexed by worker
+		std::atomic<size_t>							m_next_queue;		// Target for the next job queued by a non-worker
+
+		std::atomic<size_t>							m_pending;			// Jobs held in worker queues
+		std::atomic<size_t>							m_active;			// Jobs currently executing
+		std::atomic<size_t>							m_sleeping;			// Workers and waiting threads sleeping until jobs are queued
+
+		// Guards sleeping and waking of workers and waiting threads, and idle notification
+		std::mutex									m_mutex;
+		std::condition_variable						m_task_available;
+		std::condition_variable						m_idle;
+		bool										m_stopping;
+
+		std::mutex									m_main_mutex;
+		std::deque<Job>								m_main_jobs;
+
+		std::atomic<size_t>							m_executed;
+		std::atomic<size_t>							m_stolen;
+	};
+}
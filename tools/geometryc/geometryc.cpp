@@ -151,12 +151,16 @@ struct Mesh
 };
 
 static uint32_t s_obbSteps = 17;
+static uint32_t s_lodCount = 0;
+static float s_lodError = 0.01f;
 
 constexpr uint32_t kChunkVertexBuffer           = BX_MAKEFOURCC('V', 'B', ' ', 0x1);
 constexpr uint32_t kChunkVertexBufferCompressed = BX_MAKEFOURCC('V', 'B', 'C', 0x0);
 constexpr uint32_t kChunkIndexBuffer            = BX_MAKEFOURCC('I', 'B', ' ', 0x0);
 constexpr uint32_t kChunkIndexBufferCompressed  = BX_MAKEFOURCC('I', 'B', 'C', 0x1);
 constexpr uint32_t kChunkPrimitive              = BX_MAKEFOURCC('P', 'R', 'I', 0x0);
+constexpr uint32_t kChunkLod                    = BX_MAKEFOURCC('L', 'O', 'D', 0x0);
+constexpr uint32_t kChunkLodCompressed          = BX_MAKEFOURCC('L', 'O', 'C', 0x0);
 
 void optimizeVertexCache(uint16_t* _indices, uint32_t _numIndices, uint32_t _numVertices)
 {
@@ -166,6 +170,16 @@ void optimizeVertexCache(uint16_t* _indices, uint32_t _numIndices, uint32_t _num
 	delete[] newIndexList;
 }
 
+void optimizeOverdraw(uint16_t* _indices, uint32_t _numIndices, const uint8_t* _vertexData, uint32_t _numVertices, const bgfx::VertexLayout& _layout)
+{
+	// Reorders triangles within the vertex cache optimised order, allowing up to 5% cache efficiency loss
+	const float* positions = (const float*)(_vertexData + _layout.getOffset(bgfx::Attrib::Position) );
+	uint16_t* newIndexList = new uint16_t[_numIndices];
+	meshopt_optimizeOverdraw(newIndexList, _indices, _numIndices, positions, _numVertices, _layout.getStride(), 1.05f);
+	bx::memCopy(_indices, newIndexList, _numIndices * 2);
+	delete[] newIndexList;
+}
+
 uint32_t optimizeVertexFetch(uint16_t* _indices, uint32_t _numIndices, uint8_t* _vertexData, uint32_t _numVertices, uint16_t _stride)
 {
 	unsigned char* newVertices = (unsigned char*)malloc(_numVertices * _stride );
@@ -331,6 +345,16 @@ void write(bx::WriterI* _writer, const void* _vertices, uint32_t _numVertices, u
 	bx::write(_writer, obb);
 }
 
+void writeLods(
+	  bx::WriterI* _writer
+	, const uint8_t* _vertices
+	, uint32_t _numVertices
+	, const bgfx::VertexLayout& _layout
+	, const uint16_t* _indices
+	, uint32_t _numIndices
+	, bool _compress
+	);
+
 void write(
 	  bx::WriterI* _writer
 	, const uint8_t* _vertices
@@ -382,6 +406,11 @@ void write(
 		write(_writer, _indices, _numIndices*2);
 	}
 
+	if (0 < s_lodCount)
+	{
+		writeLods(_writer, _vertices, _numVertices, _layout, _indices, _numIndices, _compress);
+	}
+
 	write(_writer, kChunkPrimitive);
 	uint16_t nameLen = uint16_t(_material.size() );
 	write(_writer, nameLen);
@@ -401,6 +430,62 @@ void write(
 	}
 }
 
+void writeLods(
+	  bx::WriterI* _writer
+	, const uint8_t* _vertices
+	, uint32_t _numVertices
+	, const bgfx::VertexLayout& _layout
+	, const uint16_t* _indices
+	, uint32_t _numIndices
+	, bool _compress
+	)
+{
+	using namespace bx;
+
+	// Each level is simplified from the full index list, targeting half the triangles of the previous level and
+	// allowing twice the error. Where the simplifier cannot reach the target, the closest result is written so that
+	// every group has the same number of levels.
+	const float* positions = (const float*)(_vertices + _layout.getOffset(bgfx::Attrib::Position) );
+	uint16_t* lodIndices = new uint16_t[_numIndices];
+	uint16_t* simplified = new uint16_t[_numIndices];
+	bx::memCopy(lodIndices, _indices, _numIndices * 2);
+	uint32_t numLodIndices = _numIndices;
+	float error = s_lodError;
+
+	write(_writer, _compress ? kChunkLodCompressed : kChunkLod);
+	write(_writer, uint8_t(s_lodCount) );
+	for (uint32_t ii = 0; ii < s_lodCount; ++ii)
+	{
+		const size_t target = (numLodIndices / 6) * 3;
+		const size_t numSimplified = meshopt_simplify(simplified, _indices, _numIndices, positions, _numVertices, _layout.getStride(), target, error);
+		if (0 < numSimplified
+		&&  numSimplified < numLodIndices)
+		{
+			numLodIndices = uint32_t(numSimplified);
+			bx::memCopy(lodIndices, simplified, numLodIndices * 2);
+		}
+
+		optimizeVertexCache(lodIndices, numLodIndices, _numVertices);
+		optimizeOverdraw(lodIndices, numLodIndices, _vertices, _numVertices, _layout);
+		error *= 2.0f;
+
+		bx::printf("LOD %d: %d triangles\n", ii + 1, numLodIndices / 3);
+
+		write(_writer, numLodIndices);
+		if (_compress)
+		{
+			writeCompressedIndices(_writer, lodIndices, numLodIndices, _numVertices);
+		}
+		else
+		{
+			write(_writer, lodIndices, numLodIndices*2);
+		}
+	}
+
+	delete[] simplified;
+	delete[] lodIndices;
+}
+
 inline uint32_t rgbaToAbgr(uint8_t _r, uint8_t _g, uint8_t _b, uint8_t _a)
 {
 	return (uint32_t(_r)<<0)
@@ -934,6 +1019,9 @@ void help(const char* _error = NULL)
 		  "      --tangent            Calculate tangent vectors (packing mode is the same as normal).\n"
 		  "      --barycentric        Adds barycentric vertex attribute (packed in bgfx::Attrib::Color1).\n"
 		  "  -c, --compress           Compress indices.\n"
+		  "      --lod <num>          Number of simplified LOD levels to generate, each with half the triangles of the last.\n"
+		  "      --loderror <num>     Maximum simplification error of the first LOD, relative to mesh extents.\n"
+		  "           Default value is 0.01, and is doubled for each subsequent level.\n"
 		  "      --[l/r]h-up+[y/z]	  Coordinate system. Default is '--lh-up+y' Left-Handed +Y is up.\n"
 
 		  "\n"
@@ -991,6 +1079,10 @@ int main(int _argc, const char* _argv[])
 	cmdLine.hasArg(s_obbSteps, '\0', "obb");
 	s_obbSteps = bx::uint32_min(bx::uint32_max(s_obbSteps, 1), 90);
 
+	cmdLine.hasArg(s_lodCount, '\0', "lod");
+	s_lodCount = bx::uint32_min(s_lodCount, 8);
+	cmdLine.hasArg(s_lodError, '\0', "loderror");
+
 	uint32_t packNormal = 0;
 	cmdLine.hasArg(packNormal, '\0', "packnormal");
 
@@ -1255,6 +1347,7 @@ int main(int _argc, const char* _argv[])
 				{
 					const Primitive& prim1 = *primIt;
 					optimizeVertexCache(indexData + prim1.m_startIndex, prim1.m_numIndices, numVertices);
+					optimizeOverdraw(indexData + prim1.m_startIndex, prim1.m_numIndices, vertexData, numVertices, layout);
 				}
 				numVertices = optimizeVertexFetch(indexData, numIndices, vertexData, numVertices, uint16_t(stride) );
 